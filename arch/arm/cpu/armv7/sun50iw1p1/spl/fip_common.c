@@ -26,13 +26,30 @@
 */
 
 
-int toc1_flash_read(u32 start_sector, u32 blkcnt, void *buff)
+/*
+ * the boot package was read to CONFIG_BOOTPKG_STORE_IN_DRAM_BASE by the
+ * storage loader, items are copied out of it. a loader that reads items
+ * straight from the flash overrides these three: toc1_flash_read() may then
+ * return before the data is there, toc1_flash_sync() waits for it and
+ * toc1_flash_finish() also checks the package sum once all items are read.
+ */
+int __attribute__((weak)) toc1_flash_read(u32 start_sector, u32 blkcnt, void *buff)
 {
 	memcpy_align16(buff, (void *)(CONFIG_BOOTPKG_STORE_IN_DRAM_BASE + 512 * start_sector), 512 * blkcnt);
 
 	return blkcnt;
 }
 
+int __attribute__((weak)) toc1_flash_sync(void)
+{
+	return 0;
+}
+
+int __attribute__((weak)) toc1_flash_finish(void)
+{
+	return 0;
+}
+
 #if 0
 /*
 ************************************************************************************************************
@@ -155,10 +172,16 @@ int load_fip(int *use_monitor)
 		{
 			toc1_flash_read(toc1_item->data_offset/512, CONFIG_SYS_SRAMA2_SIZE/512, (void *)SCP_SRAM_BASE);
 			toc1_flash_read((toc1_item->data_offset+0x18000)/512, SCP_DRAM_SIZE/512, (void *)SCP_DRAM_BASE);
+			toc1_flash_sync();
 			sunxi_deassert_arisc();
 		}
 
 	}
+	//the header below is patched, so the read has to be checked first
+	if(toc1_flash_finish())
+	{
+		return -1;
+	}
 	if(*use_monitor)
 	{
 		struct spare_boot_head_t* header;
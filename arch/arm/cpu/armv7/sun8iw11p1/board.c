@@ -60,6 +60,7 @@ void s_init(void)
 
 void reset_cpu(ulong addr)
 {
+	serial_flush();
 	watchdog_enable();
 	while(1);
 }
@@ -361,6 +362,8 @@ void sunxi_board_close_source(void)
 #ifdef CONFIG_SUNXI_KEY_SUPPORT
 	sunxi_key_exit();
 #endif
+	//empty the console output buffer before the interrupts go off
+	serial_flush();
 	disable_interrupts();
 	interrupt_exit();
 	return ;
@@ -398,6 +401,7 @@ int sunxi_board_shutdown(void)
 #endif
 	sunxi_flash_exit(1);
 	sunxi_sprite_exit(1);
+	serial_flush();
 	disable_interrupts();
 	interrupt_exit();
 
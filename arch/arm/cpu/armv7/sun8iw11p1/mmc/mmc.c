@@ -369,6 +369,96 @@ mmc_bread(int dev_num, unsigned long start, unsigned blkcnt, void *dst)
 	return blkcnt;
 }
 
+unsigned long mmc_async_wait(int dev_num);
+
+/*
+ * issue a multiple block read whose data phase runs in the background on
+ * the host dma, the caller may work on other data until mmc_async_wait()
+ * collects it. hosts without send_cmd_start and reads the host can not
+ * take in one go are done at once.
+ */
+int mmc_bread_start(int dev_num, unsigned long start, unsigned blkcnt, void *dst)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+	struct mmc_cmd *cmd;
+	struct mmc_data *data;
+
+	if (!mmc){
+		mmcinfo("Can not find mmc dev %d\n",dev_num);
+		return -1;
+	}
+	if (mmc->async_busy)
+		mmc_async_wait(dev_num);
+
+	if (!mmc->send_cmd_start || (blkcnt < 2) || (blkcnt > mmc->b_max)) {
+		mmc->async_result = mmc_bread(dev_num, start, blkcnt, dst);
+		return (mmc->async_result == blkcnt) ? 0 : -1;
+	}
+
+	mmc->async_result = 0;
+	if ((start + blkcnt) > mmc->lba) {
+		mmcinfo("mmc %d: block number 0x%x exceeds max(0x%x)\n",mmc->control_num,
+			(unsigned int)(start + blkcnt), (unsigned int)mmc->lba);
+		return -1;
+	}
+	if (mmc_set_blocklen(mmc, mmc->read_bl_len)){
+		mmcinfo("mmc %d Set block len failed\n",mmc->control_num);
+		return -1;
+	}
+
+	cmd = &mmc->async_cmd;
+	data = &mmc->async_data;
+
+	cmd->cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+	if (mmc->high_capacity)
+		cmd->cmdarg = start;
+	else
+		cmd->cmdarg = start * mmc->read_bl_len;
+	cmd->resp_type = MMC_RSP_R1;
+	cmd->flags = 0;
+
+	data->b.dest = dst;
+	data->blocks = blkcnt;
+	data->blocksize = mmc->read_bl_len;
+	data->flags = MMC_DATA_READ;
+
+	if (mmc->send_cmd_start(mmc, cmd, data)) {
+		mmcinfo("mmc %d async read failed\n",mmc->control_num);
+		return -1;
+	}
+	mmc->async_busy = 1;
+
+	return 0;
+}
+
+/*
+ * finish the read started by mmc_bread_start(),
+ * returns the number of blocks read like mmc_bread()
+ */
+unsigned long mmc_async_wait(int dev_num)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+	unsigned long blkcnt;
+
+	if (!mmc)
+		return 0;
+	if (!mmc->async_busy)
+		return mmc->async_result;
+
+	mmc->async_busy = 0;
+	blkcnt = mmc->async_data.blocks;
+	if (mmc->send_cmd_wait(mmc, &mmc->async_cmd, &mmc->async_data)) {
+		mmcinfo("mmc %d async read failed\n",mmc->control_num);
+		return 0;
+	}
+	/* auto stop was sent by the host, wait for the card like mmc_read_blocks() */
+	mmc_send_status(mmc, 1000);
+
+	mmc->async_result = blkcnt;
+
+	return blkcnt;
+}
+
 int mmc_go_idle(struct mmc* mmc)
 {
 	struct mmc_cmd cmd;
@@ -365,6 +365,14 @@ struct mmc {
 	void (*set_ios)(struct mmc *mmc);
 	int (*init)(struct mmc *mmc);
 	int (*update_phase)(struct mmc *mmc);
+	/*
+		optional, split a read in two halves so the dma can run in
+		the background, see mmc_bread_start()
+	*/
+	int (*send_cmd_start)(struct mmc *mmc,
+			struct mmc_cmd *cmd, struct mmc_data *data);
+	int (*send_cmd_wait)(struct mmc *mmc,
+			struct mmc_cmd *cmd, struct mmc_data *data);
 #if 0
 	struct tuning_sdly sdly_tuning;
 #else
@@ -376,6 +384,12 @@ struct mmc {
 	char revision[8+1];	/* CID:  PRV */
 
     uint speed_mode;
+
+	/* outstanding read started by mmc_bread_start() */
+	struct mmc_cmd async_cmd;
+	struct mmc_data async_data;
+	unsigned long async_result;
+	int async_busy;
 };
 
 #define mmc_host_is_spi(mmc)	((mmc)->host_caps & MMC_MODE_SPI)
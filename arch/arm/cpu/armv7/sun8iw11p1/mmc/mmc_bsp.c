@@ -968,25 +968,18 @@ static int mmc_trans_data_by_dma(struct mmc *mmc, struct mmc_data *data)
 	return 0;
 }
 
-static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
-			struct mmc_data *data)
+/*
+ * first half of a command: load it and start the data phase. with dma the
+ * data keeps moving after this returns, mmc_send_cmd_complete() waits for it
+ */
+static int mmc_send_cmd_issue(struct mmc *mmc, struct mmc_cmd *cmd,
+			struct mmc_data *data, unsigned int *usedma)
 {
 	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
 	unsigned int cmdval = 0x80000000;
-	unsigned int timeout = 0;
 	int error = 0;
-	unsigned int status = 0;
-	unsigned int usedma = 0;
-	unsigned int bytecnt = 0;
 
-	if (mmchost->fatal_err){
-		mmcinfo("mmc %d Found fatal err,so no send cmd\n",mmchost ->mmc_no);
-		return -1;
-	}
-	if (cmd->resp_type & MMC_RSP_BUSY)
-		mmcdbg("mmc %d cmd %d check rsp busy\n",mmchost ->mmc_no, cmd->cmdidx);
-	if (cmd->cmdidx == 12)
-		return 0;
+	*usedma = 0;
 	/*
 	 * CMDREG
 	 * CMD[5:0]	: Command index
@@ -1014,8 +1007,7 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 	if (data) {
 		if ((u32)data->b.dest & 0x3) {
 			mmcinfo("mmc %d dest is not 4 byte align\n",mmchost ->mmc_no);
-			error = -1;
-			goto out;
+			return -1;
 		}
 
 		cmdval |= (1 << 9) | (1 << 13);
@@ -1039,14 +1031,14 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 	 */
 	if (data) {
 		int ret = 0;
-		bytecnt = data->blocksize * data->blocks;
+		unsigned int bytecnt = data->blocksize * data->blocks;
 		mmcdbg("mmc %d trans data %d bytes\n",mmchost ->mmc_no, bytecnt);
 #ifdef MMC_TRANS_BY_DMA
 		if (bytecnt > 512) {
 #else
 		if (0) {
 #endif
-			usedma = 1;
+			*usedma = 1;
 			writel(readl(&mmchost->reg->gctrl)&(~0x80000000), &mmchost->reg->gctrl);
 			ret = mmc_trans_data_by_dma(mmc, data);
 			writel(cmdval|cmd->cmdidx, &mmchost->reg->cmd);
@@ -1060,10 +1052,28 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			error = readl(&mmchost->reg->rint) & 0xbbc2;
 			if(!error)
 				error = 0xffffffff;
-			goto out;
 		}
 	}
 
+	return error;
+}
+
+/*
+ * second half: wait for the response and the end of the data phase, then
+ * release the dma and clear the interrupt status. @error comes from
+ * mmc_send_cmd_issue(), only the cleanup is done when it is set
+ */
+static int mmc_send_cmd_complete(struct mmc *mmc, struct mmc_cmd *cmd,
+			struct mmc_data *data, unsigned int usedma, int error)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+	unsigned int timeout = 0;
+	unsigned int status = 0;
+	unsigned int bytecnt = data ? data->blocksize * data->blocks : 0;
+
+	if (error)
+		goto out;
+
 	timeout = 0xffffff;
 	do {
 		status = readl(&mmchost->reg->rint);
@@ -1172,6 +1182,65 @@ out:
 		return 0;
 }
 
+static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+			struct mmc_data *data)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+	unsigned int usedma = 0;
+	int error;
+
+	if (mmchost->fatal_err){
+		mmcinfo("mmc %d Found fatal err,so no send cmd\n",mmchost ->mmc_no);
+		return -1;
+	}
+	if (cmd->resp_type & MMC_RSP_BUSY)
+		mmcdbg("mmc %d cmd %d check rsp busy\n",mmchost ->mmc_no, cmd->cmdidx);
+	if (cmd->cmdidx == 12)
+		return 0;
+
+	error = mmc_send_cmd_issue(mmc, cmd, data, &usedma);
+
+	return mmc_send_cmd_complete(mmc, cmd, data, usedma, error);
+}
+
+#ifdef MMC_TRANS_BY_DMA
+/*
+ * asynchronous read: only the issue phase is run here, the idma keeps
+ * filling the buffer until mmc_send_cmd_wait() is called. nothing else may
+ * be sent to this host in between.
+ */
+static int mmc_send_cmd_start(struct mmc *mmc, struct mmc_cmd *cmd,
+			struct mmc_data *data)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+
+	if (mmchost->fatal_err){
+		mmcinfo("mmc %d Found fatal err,so no send cmd\n",mmchost ->mmc_no);
+		return -1;
+	}
+	if (!data || (data->blocksize * data->blocks <= 512)) {
+		mmcinfo("mmc %d async cmd %d needs a dma data phase\n", mmchost->mmc_no, cmd->cmdidx);
+		return -1;
+	}
+
+	mmchost->async_error = mmc_send_cmd_issue(mmc, cmd, data, &mmchost->async_usedma);
+	if (mmchost->async_error)
+		return mmc_send_cmd_complete(mmc, cmd, data,
+			mmchost->async_usedma, mmchost->async_error);
+
+	return 0;
+}
+
+static int mmc_send_cmd_wait(struct mmc *mmc, struct mmc_cmd *cmd,
+			struct mmc_data *data)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+
+	return mmc_send_cmd_complete(mmc, cmd, data,
+			mmchost->async_usedma, mmchost->async_error);
+}
+#endif
+
 int sunxi_mmc_init(int sdc_no, unsigned bus_width, const normal_gpio_cfg *gpio_info, int offset ,void *extra_data)
 {
 	struct mmc *mmc;
@@ -1198,6 +1267,10 @@ int sunxi_mmc_init(int sdc_no, unsigned bus_width, const normal_gpio_cfg *gpio_i
 	strcpy(mmc->name, "SUNXI SD/MMC");
 	mmc->priv = &mmc_host[sdc_no];
 	mmc->send_cmd = mmc_send_cmd;
+#ifdef MMC_TRANS_BY_DMA
+	mmc->send_cmd_start = mmc_send_cmd_start;
+	mmc->send_cmd_wait = mmc_send_cmd_wait;
+#endif
 	mmc->set_ios = mmc_set_ios;
 	mmc->init = mmc_core_init;
 	mmc->update_phase = mmc_update_phase;
@@ -42,6 +42,9 @@ struct sunxi_mmc_host {
 	u32 mod_clk;
 	u32 clock;
 
+	/* state of the data command started by send_cmd_start */
+	unsigned int async_usedma;
+	int async_error;
 };
 
 
@@ -0,0 +1,131 @@
+/*
+ * (C) Copyright 2007-2016
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * Second cpu core for the boot-time jobs (include/cpu_job.h)
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <cpu_job.h>
+#include <asm/io.h>
+#include <asm/armv7.h>
+#include <asm/arch/platform.h>
+
+#define SUNXI_JOB_CPU			1
+
+#define CPUCFG_CPU_RST(cpu)		(SUNXI_CPUCFG_BASE + 0x40 + (cpu) * 0x40)
+#define CPUCFG_CPU_STATUS(cpu)		(SUNXI_CPUCFG_BASE + 0x48 + (cpu) * 0x40)
+#define CPUCFG_PWROFF			(SUNXI_CPUCFG_BASE + 0x110)
+#define CPUCFG_PWR_CLAMP(cpu)		(SUNXI_CPUCFG_BASE + 0x120 + (cpu) * 4)
+#define CPUCFG_GEN_CTRL			(SUNXI_CPUCFG_BASE + 0x184)
+#define CPUCFG_DBG_CTRL1		(SUNXI_CPUCFG_BASE + 0x1e4)
+#define SRAMC_SOFT_ENTRY		(SUNXI_SYSCRL_BASE + 0xbc)
+
+#define CPU_STATUS_STANDBYWFI		(1 << 2)
+
+extern int sunxi_probe_secure_monitor(void);
+
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  cpu_job_arch_boot
+*
+*    parmeters     :  main: 副核的C入口, stack_top: 副核的栈顶
+*
+*    return        :  0: 副核已经放开复位, 其它: 没有副核可用
+*
+*    note          :  副核和主核使用同一套页表, 所以要求主核已经打开了MMU和dcache,
+*                     并且ACTLR.SMP已经置位(CONFIG_ARMV7_SET_CORTEX_SMPEN).
+*                     有secure monitor的时候uboot运行在非安全态, 不能操作cpucfg.
+*
+************************************************************************************************************
+*/
+int cpu_job_arch_boot(void (*main)(void), void *stack_top)
+{
+	int cpu = SUNXI_JOB_CPU;
+
+	if (sunxi_probe_secure_monitor() || !dcache_status())
+		return -1;
+
+	armv7_secondary_prepare(main, stack_top);
+	if (!(armv7_secondary_args[ARMV7_SEC_ACTLR] & ARMV7_ACTLR_SMP))
+	{
+		debug("cpu job: boot cpu is not coherent, no second core\n");
+		return -1;
+	}
+	/* 副核在关MMU的状态下读参数 */
+	flush_dcache_range((ulong)armv7_secondary_args,
+			   (ulong)armv7_secondary_args + ARCH_DMA_MINALIGN);
+
+	writel((u32)armv7_secondary_entry, SRAMC_SOFT_ENTRY);
+
+	/* assert reset, L1 invalidated on reset, no debug access */
+	writel(0, CPUCFG_CPU_RST(cpu));
+	clrbits_le32(CPUCFG_GEN_CTRL, 1 << cpu);
+	clrbits_le32(CPUCFG_DBG_CTRL1, 1 << cpu);
+
+	/* release the power clamp step by step, then power on */
+	writel(0xff, CPUCFG_PWR_CLAMP(cpu));
+	udelay(10);
+	writel(0xfe, CPUCFG_PWR_CLAMP(cpu));
+	udelay(10);
+	writel(0xf8, CPUCFG_PWR_CLAMP(cpu));
+	udelay(10);
+	writel(0xf0, CPUCFG_PWR_CLAMP(cpu));
+	udelay(10);
+	writel(0x00, CPUCFG_PWR_CLAMP(cpu));
+	udelay(10);
+	clrbits_le32(CPUCFG_PWROFF, 1 << cpu);
+	udelay(10);
+
+	/* deassert core and power-on reset */
+	writel(3, CPUCFG_CPU_RST(cpu));
+	setbits_le32(CPUCFG_DBG_CTRL1, 1 << cpu);
+
+	return 0;
+}
+
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  cpu_job_arch_off
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  等副核退出一致性并进入WFI, 然后复位并关掉它的电源,
+*                     内核启动副核的时候看到的就是上电时的状态.
+*
+************************************************************************************************************
+*/
+void cpu_job_arch_off(void)
+{
+	int cpu = SUNXI_JOB_CPU;
+	ulong start = get_timer(0);
+
+	while (!(readl(CPUCFG_CPU_STATUS(cpu)) & CPU_STATUS_STANDBYWFI))
+	{
+		if (get_timer(start) > 10)
+		{
+			printf("cpu job: cpu%d does not reach wfi\n", cpu);
+			break;
+		}
+	}
+
+	writel(0, CPUCFG_CPU_RST(cpu));
+	setbits_le32(CPUCFG_PWROFF, 1 << cpu);
+	writel(0xff, CPUCFG_PWR_CLAMP(cpu));
+}
+
+/* uboot重定位并初始化堆之后, 在这里把副核拉起来 */
+void cpu_secondary_init_r(void)
+{
+	cpu_job_start();
+}
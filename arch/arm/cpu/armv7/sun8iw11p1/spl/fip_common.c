@@ -11,13 +11,30 @@ extern void * memset(void * s, int c, size_t count);
 extern int strncmp(const char * cs,const char * ct,size_t count);
 
 
-int toc1_flash_read(u32 start_sector, u32 blkcnt, void *buff)
+/*
+ * the boot package was read to CONFIG_BOOTPKG_STORE_IN_DRAM_BASE by the
+ * storage loader, items are copied out of it. a loader that reads items
+ * straight from the flash overrides these three: toc1_flash_read() may then
+ * return before the data is there, toc1_flash_sync() waits for it and
+ * toc1_flash_finish() also checks the package sum once all items are read.
+ */
+int __attribute__((weak)) toc1_flash_read(u32 start_sector, u32 blkcnt, void *buff)
 {
 	memcpy(buff, (void *)(CONFIG_BOOTPKG_STORE_IN_DRAM_BASE + 512 * start_sector), 512 * blkcnt);
 
 	return blkcnt;
 }
 
+int __attribute__((weak)) toc1_flash_sync(void)
+{
+	return 0;
+}
+
+int __attribute__((weak)) toc1_flash_finish(void)
+{
+	return 0;
+}
+
 uint toc1_item_read(struct sbrom_toc1_item_info *p_toc_item, void * p_dest, u32 buff_len)
 {
 	u32 to_read_blk_start = 0;
@@ -104,5 +121,5 @@ int load_fip(int *use_monitor)
 
 	}
 	
-	return 0;
+	return toc1_flash_finish();
 }
\ No newline at end of file
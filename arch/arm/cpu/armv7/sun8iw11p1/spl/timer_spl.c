@@ -125,3 +125,11 @@ void timer_exit(void)
 	;
 }
 
+/* microseconds since timer_init(), the time base of the bootstage records */
+unsigned long timer_get_us(void)
+{
+	struct sunxi_timer_reg *timer_reg = (struct sunxi_timer_reg *)SUNXI_TIMER_BASE;
+
+	return timer_reg->avs.cnt1;
+}
+
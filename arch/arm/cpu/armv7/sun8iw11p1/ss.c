@@ -23,123 +23,24 @@
 #include "asm/arch/ccmu.h"
 #include "asm/arch/ss.h"
 #include "asm/arch/mmu.h"
-/*
-************************************************************************************************************
-*
-*                                             function
-*
-*    name          :
-*
-*    parmeters     :
-*
-*    return        :
-*
-*    note          :
-*
-*
-************************************************************************************************************
-*/
-static u32 __aw_endian4(u32 data)
-{
-	u32 d1, d2, d3, d4;
-	d1= (data&0xff)<<24;
-	d2= (data&0xff00)<<8;
-	d3= (data&0xff0000)>>8;
-	d4= (data&0xff000000)>>24;
+#include <malloc.h>
+#include <aes.h>
+#include <hash.h>
+#include <hw_sha.h>
+#include <hw_aes.h>
+#include <u-boot/sha1.h>
 
-	return (d1|d2|d3|d4);
-}
-/*
-************************************************************************************************************
-*
-*                                             function
-*
-*    name          :
-*
-*    parmeters     :
-*
-*    return        :
-*
-*    note          :
-*
-*
-************************************************************************************************************
-*/
-static u32 __sha256_padding(u32 data_size, u8* text)
-{
-	u32 i;
-	u32 k, q;
-	u32 size;
-	u32 padding_buf[16];
-    u8 *ptext;
-
-	k = data_size/64;
-	q = data_size%64;
-
-	ptext = (u8*)padding_buf;
-	if(q==0){
-		for(i=0; i<16; i++){
-			padding_buf[i] = 0x0;
-		}
-		padding_buf[0] = 0x00000080;
-
-		padding_buf[14] = data_size>>29;
-		padding_buf[15] = data_size<<3;
-		padding_buf[14] = __aw_endian4(padding_buf[14]);
-		padding_buf[15] = __aw_endian4(padding_buf[15]);
+#define SS_METHOD_AES			(0)
+#define SS_METHOD_SHA1			(17)
+#define SS_METHOD_SHA256		(19)
+#define SS_HASH_IV_INPUT		(0x1 << 16)		//hash的初始值从iv_descriptor读入
+#define SS_DIR_DECRYPT			(0x1 << 8)		//common_ctl: 0加密，1解密
 
-		for(i=0; i<64; i++){
-			text[k*64 + i] = ptext[i];
-		}
-		size = (k + 1)*64;
-	}else if(q<56){
-		for(i=0; i<16; i++){
-			padding_buf[i] = 0x0;
-		}
-		for(i=0; i<q; i++){
-			ptext[i] = text[k*64 + i];
-		}
-		ptext[q] = 0x80;
-
-
-		padding_buf[14] = data_size>>29;
-		padding_buf[15] = data_size<<3;
-		padding_buf[14] = __aw_endian4(padding_buf[14]);
-		padding_buf[15] = __aw_endian4(padding_buf[15]);
-
-		for(i=0; i<64; i++){
-			text[k*64 + i] = ptext[i];
-		}
-		size = (k + 1)*64;
-	}else{
-		for(i=0; i<16; i++){
-			padding_buf[i] = 0x0;
-		}
-		for(i=0; i<q; i++){
-			ptext[i] = text[k*64 + i];
-		}
-		ptext[q] = 0x80;
-		for(i=0; i<64; i++){
-			text[k*64 + i] = ptext[i];
-		}
-
-		//send last 512-bits text to SHA1/MD5
-		for(i=0; i<16; i++){
-			padding_buf[i] = 0x0;
-		}
-		padding_buf[14] = data_size>>29;
-		padding_buf[15] = data_size<<3;
-		padding_buf[14] = __aw_endian4(padding_buf[14]);
-		padding_buf[15] = __aw_endian4(padding_buf[15]);
+#define SS_AES_KEY_SIZE(len)	((len) / 8 - 2)	//symmetric_ctl[1:0]: 0 128bit, 1 192bit, 2 256bit
+#define SS_AES_CTR_WIDTH_128	(0x3 << 2)
+#define SS_AES_OP_MODE(mode)	((mode) << 8)	//0 ECB, 1 CBC, 2 CTR
 
-		for(i=0; i<64; i++){
-			text[(k + 1)*64 + i] = ptext[i];
-		}
-		size = (k + 2)*64;
-	}
-
-	return size;
-}
+#define SS_AES_BOUNCE_SIZE		(64 * 1024)
 /*
 ************************************************************************************************************
 *
@@ -253,7 +154,237 @@ void sunxi_ss_open(void)
 void sunxi_ss_close(void)
 {
 }
-//src_addr		//32B 对齐
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  __ss_task_run
+*
+*    parmeters     :  task : 填好的描述符，数据已经flush
+*
+*    return        :
+*
+*    note          :  把一个task交给SS并等它做完
+*
+*
+************************************************************************************************************
+*/
+static void __ss_task_run(task_queue *task)
+{
+	u32 reg_val;
+
+	flush_cache((uint)task, sizeof(task_queue));
+
+	writel((uint)task, SS_S_TDQ); //descriptor address
+	//enable SS end interrupt
+	writel(0x1<<(task->task_id), SS_S_ICR);
+	//start SS
+	writel(0x1, SS_S_TLR);
+	//wait end
+	__ss_encry_decry_end(task->task_id);
+	//clear pending
+	reg_val = readl(SS_S_ISR);
+	if((reg_val&(0x01<<task->task_id))==(0x01<<task->task_id))
+	{
+	   reg_val &= ~(0x0f);
+	   reg_val |= (0x01<<task->task_id);
+	}
+	writel(reg_val, SS_S_ISR);
+	//SS engie exit
+	writel(readl(SS_S_TLR) & (~0x1), SS_S_TLR);
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  __ss_hash_task
+*
+*    parmeters     :  src : 数据段，长度以word为单位，总长度是block的整数倍
+*
+*    return        :
+*
+*    note          :  用一个task把最多8段不连续的数据送进SS，接着ctx->state继续计算
+*
+*
+************************************************************************************************************
+*/
+static int __ss_hash_task(sunxi_sha_ctx_t *ctx, const sg *src, int src_nr)
+{
+	task_queue task0 __aligned(ARCH_DMA_MINALIGN);
+	int i;
+
+	memset(&task0, 0, sizeof(task_queue));
+	task0.task_id = 0;
+	task0.common_ctl = ctx->method | (1U << 31);
+	if(ctx->started)
+	{
+		task0.common_ctl |= SS_HASH_IV_INPUT;
+		task0.iv_descriptor = (uint)ctx->state;
+	}
+	for(i=0;i<src_nr;i++)
+	{
+		task0.source[i] = src[i];
+		task0.data_len += src[i].length;
+		flush_cache(src[i].addr, src[i].length * 4);
+	}
+	task0.destination[0].addr = (uint)ctx->state;
+	task0.destination[0].length = ctx->digest_len/4;
+	task0.next_descriptor = 0;
+	flush_cache((uint)ctx->state, sizeof(ctx->state));
+
+	__ss_task_run(&task0);
+	invalidate_dcache_range((uint)ctx->state, (uint)ctx->state + sizeof(ctx->state));
+	ctx->started = 1;
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_sha_init
+*
+*    parmeters     :  mode : SHA1_160_MODE 或者 SHA2_256_MODE
+*
+*    return        :
+*
+*    note          :
+*
+*
+************************************************************************************************************
+*/
+int sunxi_sha_init(sunxi_sha_ctx_t *ctx, int mode)
+{
+	sunxi_ss_open();
+
+	ctx->block_len = 0;
+	ctx->started   = 0;
+	ctx->total     = 0;
+	if(mode == SHA1_160_MODE)
+	{
+		ctx->method     = SS_METHOD_SHA1;
+		ctx->digest_len = 20;
+	}
+	else
+	{
+		ctx->method     = SS_METHOD_SHA256;
+		ctx->digest_len = 32;
+	}
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_sha_update
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  上次留下的不完整block和本次数据的整块部分放在同一个task里，
+*                     剩下不足一个block的数据拷到ctx->block。源数据不要求连续，
+*                     也不会被改写
+*
+*
+************************************************************************************************************
+*/
+int sunxi_sha_update(sunxi_sha_ctx_t *ctx, const u8 *src_addr, u32 src_len)
+{
+	sg   src[2];
+	int  src_nr = 0;
+	u32  len;
+
+	ctx->total += src_len;
+	if(ctx->block_len)
+	{
+		len = min(SS_SHA_BLOCK_SIZE - ctx->block_len, src_len);
+		memcpy(ctx->block + ctx->block_len, src_addr, len);
+		ctx->block_len += len;
+		src_addr += len;
+		src_len  -= len;
+		if(ctx->block_len < SS_SHA_BLOCK_SIZE)
+		{
+			return 0;
+		}
+		src[src_nr].addr   = (uint)ctx->block;
+		src[src_nr].length = SS_SHA_BLOCK_SIZE/4;
+		src_nr ++;
+		ctx->block_len = 0;
+	}
+	len = src_len & ~(SS_SHA_BLOCK_SIZE - 1);
+	if(len && !((uint)src_addr & 3))
+	{
+		src[src_nr].addr   = (uint)src_addr;
+		src[src_nr].length = len/4;
+		src_nr ++;
+		src_addr += len;
+		src_len  -= len;
+	}
+	if(src_nr)
+	{
+		__ss_hash_task(ctx, src, src_nr);
+	}
+	//SS只能按word取数据，不对齐的数据逐个block拷出来算
+	while(src_len >= SS_SHA_BLOCK_SIZE)
+	{
+		memcpy(ctx->block, src_addr, SS_SHA_BLOCK_SIZE);
+		src[0].addr   = (uint)ctx->block;
+		src[0].length = SS_SHA_BLOCK_SIZE/4;
+		__ss_hash_task(ctx, src, 1);
+		src_addr += SS_SHA_BLOCK_SIZE;
+		src_len  -= SS_SHA_BLOCK_SIZE;
+	}
+	memcpy(ctx->block, src_addr, src_len);
+	ctx->block_len = src_len;
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_sha_final
+*
+*    parmeters     :  dst_addr : 存放摘要，SHA1为20字节，SHA256为32字节
+*
+*    return        :
+*
+*    note          :  在ctx->block中补padding和长度，算完最后一个task
+*
+*
+************************************************************************************************************
+*/
+int sunxi_sha_final(sunxi_sha_ctx_t *ctx, u8 *dst_addr)
+{
+	sg   src;
+	u64  bits = ctx->total << 3;
+	u32  n = ctx->block_len;
+	u32  pad_len;
+	int  i;
+
+	ctx->block[n++] = 0x80;
+	pad_len = (n > SS_SHA_BLOCK_SIZE - 8) ? SS_SHA_BLOCK_SIZE * 2 : SS_SHA_BLOCK_SIZE;
+	memset(ctx->block + n, 0, pad_len - n);
+	for(i=0;i<8;i++)
+	{
+		ctx->block[pad_len - 1 - i] = (u8)(bits >> (i * 8));
+	}
+	src.addr   = (uint)ctx->block;
+	src.length = pad_len/4;
+	__ss_hash_task(ctx, &src, 1);
+
+	memcpy(dst_addr, ctx->state, ctx->digest_len);
+	ctx->block_len = 0;
+
+	return 0;
+}
 /*
 ************************************************************************************************************
 *
@@ -265,7 +396,7 @@ void sunxi_ss_close(void)
 *
 *    return        :
 *
-*    note          :
+*    note          :  一次算完整个buffer的SHA256，不再改写源数据后面的内存
 *
 *
 ************************************************************************************************************
@@ -273,66 +404,404 @@ void sunxi_ss_close(void)
 int  sunxi_sha_calc(u8 *dst_addr, u32 dst_len,
 					u8 *src_addr, u32 src_len)
 {
-	u32 reg_val = 0;
-	u32 total_len = 0;
-	u32 md_size = 32;
-	s32 i = 0;
-	u8  sign_buff[32 + 32], *p_sign;
-	task_queue task0;
+	sunxi_sha_ctx_t ctx;
+	u8  digest[32];
+
+	sunxi_sha_init(&ctx, SHA2_256_MODE);
+	sunxi_sha_update(&ctx, src_addr, src_len);
+	sunxi_sha_final(&ctx, digest);
+	memcpy(dst_addr, digest, min(dst_len, (u32)32));
+
+	return 0;
+}
+#ifdef CONFIG_SHA_HW_ACCEL
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  common/hash.c的硬件加速接口
+*
+*
+************************************************************************************************************
+*/
+void hw_sha256(const uchar *in_addr, uint buflen,
+			uchar *out_addr, uint chunk_size)
+{
+	sunxi_sha_ctx_t ctx;
 
-	memset(sign_buff, 0, sizeof(sign_buff));
-	p_sign =  (u8 *)(((u32)sign_buff + 31)&(~31));
+	sunxi_sha_init(&ctx, SHA2_256_MODE);
+	sunxi_sha_update(&ctx, in_addr, buflen);
+	sunxi_sha_final(&ctx, out_addr);
+}
 
-	total_len = __sha256_padding(src_len, (u8 *)src_addr)/4;	//计算明文长度
+void hw_sha1(const uchar *in_addr, uint buflen,
+			uchar *out_addr, uint chunk_size)
+{
+	sunxi_sha_ctx_t ctx;
 
-    task0.task_id = 0;
-	task0.common_ctl = (19)|(1U << 31);
-	task0.symmetric_ctl = 0;
-	task0.asymmetric_ctl = 0;
-	task0.key_descriptor = 0;
-	task0.iv_descriptor = 0;
-	task0.ctr_descriptor = 0;
-	task0.data_len = total_len;
+	sunxi_sha_init(&ctx, SHA1_160_MODE);
+	sunxi_sha_update(&ctx, in_addr, buflen);
+	sunxi_sha_final(&ctx, out_addr);
+}
+#ifdef CONFIG_SHA_PROG_HW_ACCEL
+int hw_sha_init(struct hash_algo *algo, void **ctxp)
+{
+	sunxi_sha_ctx_t *ctx;
 
-	//task0.source[0].addr = va2pa((uint)src_addr);
-	task0.source[0].addr = (uint)src_addr;
-	task0.source[0].length = total_len;
+	ctx = memalign(ARCH_DMA_MINALIGN, sizeof(sunxi_sha_ctx_t));
+	if(!ctx)
+	{
+		return -1;
+	}
+	sunxi_sha_init(ctx, (algo->digest_size == SHA1_SUM_LEN) ? SHA1_160_MODE : SHA2_256_MODE);
+	*ctxp = ctx;
 
-	for(i=1;i<8;i++)
-		task0.source[i].length = 0;
+	return 0;
+}
 
-	task0.destination[0].addr = (uint)p_sign;
-	task0.destination[0].length = 32/4;
-	for(i=1;i<8;i++)
-		 task0.destination[i].length = 0;
+int hw_sha_update(struct hash_algo *algo, void *ctx, const void *buf,
+			unsigned int size, int is_last)
+{
+	return sunxi_sha_update((sunxi_sha_ctx_t *)ctx, buf, size);
+}
+
+int hw_sha_finish(struct hash_algo *algo, void *ctx, void *dest_buf,
+			int size)
+{
+	if(size < algo->digest_size)
+	{
+		return -1;
+	}
+	sunxi_sha_final((sunxi_sha_ctx_t *)ctx, dest_buf);
+	free(ctx);
+
+	return 0;
+}
+#endif
+#endif
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  __ss_aes_task
+*
+*    parmeters     :  len : 字节数，16的整数倍；dst按cache line对齐
+*
+*    return        :
+*
+*    note          :  ECB/CBC/CTR一次做完一段数据，iv不在这里推进
+*
+*
+************************************************************************************************************
+*/
+static void __ss_aes_task(const u8 *key, uint key_len, uint mode, uint decrypt,
+						  u8 *iv, const u8 *src, u8 *dst, u32 len)
+{
+	task_queue task0 __aligned(ARCH_DMA_MINALIGN);
+
+	memset(&task0, 0, sizeof(task_queue));
+	task0.task_id = 0;
+	task0.common_ctl = SS_METHOD_AES | (1U << 31);
+	if(decrypt)
+	{
+		task0.common_ctl |= SS_DIR_DECRYPT;
+	}
+	task0.symmetric_ctl = SS_AES_KEY_SIZE(key_len) | SS_AES_OP_MODE(mode);
+	task0.key_descriptor = (uint)key;
+	if(mode != SS_AES_MODE_ECB)
+	{
+		task0.iv_descriptor = (uint)iv;
+		flush_cache((uint)iv, SS_AES_BLOCK_SIZE);
+	}
+	if(mode == SS_AES_MODE_CTR)
+	{
+		task0.symmetric_ctl |= SS_AES_CTR_WIDTH_128;
+		task0.ctr_descriptor = (uint)iv;
+	}
+	task0.data_len = len/4;
+	task0.source[0].addr = (uint)src;
+	task0.source[0].length = len/4;
+	task0.destination[0].addr = (uint)dst;
+	task0.destination[0].length = len/4;
 	task0.next_descriptor = 0;
+	flush_cache((uint)key, key_len);
+	flush_cache((uint)src, len);
+	if(dst != src)
+	{
+		flush_cache((uint)dst, len);
+	}
 
-	writel((uint)&task0, SS_S_TDQ); //descriptor address
-	//enable SS end interrupt
-	writel(0x1<<(task0.task_id), SS_S_ICR);
-	//start SS
-	writel(0x1, SS_S_TLR);
-	//wait end
-	__ss_encry_decry_end(task0.task_id);
+	__ss_task_run(&task0);
+	invalidate_dcache_range((uint)dst, (uint)dst + ALIGN(len, ARCH_DMA_MINALIGN));
+}
+//XTS的tweak乘以GF(2^128)的alpha，小端
+static void __xts_mul_alpha(u8 *t)
+{
+	u8  carry = 0, c;
+	int i;
 
-	//copy data
-	for(i=0; i< md_size; i++)
+	for(i=0;i<SS_AES_BLOCK_SIZE;i++)
 	{
-	    dst_addr[i] = p_sign[i];   //从目的地址读生成的消息摘要
+		c    = t[i] >> 7;
+		t[i] = (t[i] << 1) | carry;
+		carry = c;
 	}
-	//clear pending
-	reg_val = readl(SS_S_ISR);
-	if((reg_val&(0x01<<task0.task_id))==(0x01<<task0.task_id))
+	if(carry)
 	{
-	   reg_val &= ~(0x0f);
-	   reg_val |= (0x01<<task0.task_id);
+		t[0] ^= 0x87;
 	}
-	writel(reg_val, SS_S_ISR);
-	//SS engie exit
-	writel(readl(SS_S_TLR) & (~0x1), SS_S_TLR);
+}
+//XTS: 每个块异或上自己的tweak，t推进到最后一块的下一个
+static void __xts_xor_tweak(u8 *t, const u8 *src, u8 *dst, u32 len)
+{
+	int i;
+
+	for(;len;len-=SS_AES_BLOCK_SIZE)
+	{
+		for(i=0;i<SS_AES_BLOCK_SIZE;i++)
+		{
+			dst[i] = src[i] ^ t[i];
+		}
+		__xts_mul_alpha(t);
+		src += SS_AES_BLOCK_SIZE;
+		dst += SS_AES_BLOCK_SIZE;
+	}
+}
+//CTR: 大端的128bit计数器加n
+static void __ctr_add(u8 *ctr, u32 n)
+{
+	int i;
+
+	for(i=SS_AES_BLOCK_SIZE-1;(i>=0) && n;i--)
+	{
+		n += ctr[i];
+		ctr[i] = (u8)n;
+		n >>= 8;
+	}
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  __aes_crypt
+*
+*    parmeters     :  src, dst : 按cache line对齐，可以是同一块buffer
+*
+*    return        :
+*
+*    note          :  做一段数据并把ctx->iv推进到下一段
+*
+*
+************************************************************************************************************
+*/
+static void __aes_crypt(sunxi_aes_ctx_t *ctx, const u8 *src, u8 *dst, u32 len)
+{
+	u8  next_iv[SS_AES_BLOCK_SIZE];
+	u8  tweak[SS_AES_BLOCK_SIZE];
+
+	switch(ctx->mode)
+	{
+		case SS_AES_MODE_CBC:
+			//原地解密时最后一个密文块会被覆盖，先留下来
+			if(ctx->decrypt)
+			{
+				memcpy(next_iv, src + len - SS_AES_BLOCK_SIZE, SS_AES_BLOCK_SIZE);
+			}
+			__ss_aes_task(ctx->key, ctx->key_len, SS_AES_MODE_CBC, ctx->decrypt,
+						  ctx->iv, src, dst, len);
+			if(!ctx->decrypt)
+			{
+				memcpy(next_iv, dst + len - SS_AES_BLOCK_SIZE, SS_AES_BLOCK_SIZE);
+			}
+			memcpy(ctx->iv, next_iv, SS_AES_BLOCK_SIZE);
+			break;
+
+		case SS_AES_MODE_CTR:
+			__ss_aes_task(ctx->key, ctx->key_len, SS_AES_MODE_CTR, 0,
+						  ctx->iv, src, dst, len);
+			__ctr_add(ctx->iv, len / SS_AES_BLOCK_SIZE);
+			break;
+
+		case SS_AES_MODE_XTS:
+			//tweak的异或在CPU上做，中间的ECB交给SS
+			memcpy(tweak, ctx->iv, SS_AES_BLOCK_SIZE);
+			__xts_xor_tweak(ctx->iv, src, dst, len);
+			__ss_aes_task(ctx->key, ctx->key_len, SS_AES_MODE_ECB, ctx->decrypt,
+						  NULL, dst, dst, len);
+			__xts_xor_tweak(tweak, dst, dst, len);
+			break;
+
+		default:
+			__ss_aes_task(ctx->key, ctx->key_len, SS_AES_MODE_ECB, ctx->decrypt,
+						  NULL, src, dst, len);
+			break;
+	}
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_aes_init
+*
+*    parmeters     :  mode    : SS_AES_MODE_ECB/CBC/CTR/XTS
+*                     decrypt : SS_AES_ENCRYPT 或者 SS_AES_DECRYPT，CTR两者一样
+*                     key_len : 16/24/32，XTS是两个key连在一起的长度32/48/64
+*                     iv      : 16字节，ECB可以是NULL
+*
+*    return        :  0: 成功  -1: 参数不支持
+*
+*    note          :
+*
+*
+************************************************************************************************************
+*/
+int sunxi_aes_init(sunxi_aes_ctx_t *ctx, int mode, int decrypt,
+				   const u8 *key, u32 key_len, const u8 *iv)
+{
+	u32  half = (mode == SS_AES_MODE_XTS) ? key_len / 2 : key_len;
+
+	if((mode < SS_AES_MODE_ECB) || (mode > SS_AES_MODE_XTS))
+	{
+		return -1;
+	}
+	if((half != 16) && (half != 24) && (half != 32))
+	{
+		return -1;
+	}
+	sunxi_ss_open();
+
+	memcpy(ctx->key, key, key_len);
+	ctx->key_len = half;
+	ctx->mode    = mode;
+	ctx->decrypt = decrypt;
+	memset(ctx->iv, 0, sizeof(ctx->iv));
+
+	return iv ? sunxi_aes_set_iv(ctx, iv) : 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_aes_set_iv
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  换一个IV/计数器接着用同一个key，XTS在这里用tweak key加密数据单元号
+*
+*
+************************************************************************************************************
+*/
+int sunxi_aes_set_iv(sunxi_aes_ctx_t *ctx, const u8 *iv)
+{
+	memcpy(ctx->iv, iv, SS_AES_BLOCK_SIZE);
+	if(ctx->mode == SS_AES_MODE_XTS)
+	{
+		__ss_aes_task(ctx->key + ctx->key_len, ctx->key_len, SS_AES_MODE_ECB, 0,
+					  NULL, ctx->iv, ctx->iv, SS_AES_BLOCK_SIZE);
+	}
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_aes_update
+*
+*    parmeters     :  len : 16的整数倍
+*
+*    return        :  0: 成功  -1: 失败，dst没有被改写
+*
+*    note          :  src和dst可以相同。没有按cache line对齐的数据经过一个对齐的缓冲区，
+*                     SS不会碰到用户buffer之外的cache line
+*
+*
+************************************************************************************************************
+*/
+int sunxi_aes_update(sunxi_aes_ctx_t *ctx, const u8 *src_addr, u8 *dst_addr, u32 len)
+{
+	u8  *bounce;
+	u32  this_len;
+
+	if(len & (SS_AES_BLOCK_SIZE - 1))
+	{
+		return -1;
+	}
+	if(!(((uint)src_addr | (uint)dst_addr | len) & (ARCH_DMA_MINALIGN - 1)))
+	{
+		if(len)
+		{
+			__aes_crypt(ctx, src_addr, dst_addr, len);
+		}
+
+		return 0;
+	}
+
+	bounce = malloc_pool(SS_AES_BOUNCE_SIZE);
+	if(!bounce)
+	{
+		return -1;
+	}
+	while(len)
+	{
+		this_len = min(len, (u32)SS_AES_BOUNCE_SIZE);
+		memcpy(bounce, src_addr, this_len);
+		__aes_crypt(ctx, bounce, bounce, this_len);
+		memcpy(dst_addr, bounce, this_len);
+		src_addr += this_len;
+		dst_addr += this_len;
+		len      -= this_len;
+	}
+	free_pool(bounce);
 
 	return 0;
 }
+#ifdef CONFIG_AES_HW_ACCEL
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  lib/aes.c的硬件加速接口，key_exp开头就是原始的128bit key
+*
+*
+************************************************************************************************************
+*/
+int hw_aes_cbc_crypt(u8 *key_exp, u8 *src, u8 *dst, u32 num_aes_blocks, int enc)
+{
+	sunxi_aes_ctx_t ctx;
+	u8  iv[SS_AES_BLOCK_SIZE];
+
+	memset(iv, 0, sizeof(iv));
+	if(sunxi_aes_init(&ctx, SS_AES_MODE_CBC, enc ? SS_AES_ENCRYPT : SS_AES_DECRYPT,
+					  key_exp, AES_KEY_LENGTH, iv))
+	{
+		return -1;
+	}
+
+	return sunxi_aes_update(&ctx, src, dst, num_aes_blocks * AES_BLOCK_LENGTH);
+}
+#endif
 /*
 ************************************************************************************************************
 *
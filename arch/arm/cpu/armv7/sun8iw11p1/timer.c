@@ -141,21 +141,33 @@ ulong get_timer_masked(void)
 /* delay x useconds */
 void __usdelay(unsigned long usec)
 {
-	u32 t1, t2;
+	u32 t1;
 	struct sunxi_timer_reg *timer_reg = (struct sunxi_timer_reg *)SUNXI_TIMER_BASE;
-	timer_reg->avs.cnt1 = 0;
 
+	/* 计数器不清零, 两个核可以同时延时 */
 	t1 = timer_reg->avs.cnt1;
-	t2 = t1 + usec;
-	do
+	while(timer_reg->avs.cnt1 - t1 <= usec)
 	{
-		t1 = timer_reg->avs.cnt1;
+		;
 	}
-	while(t2 >= t1);
 
 	return ;
 }
 
+/* avs cnt1 counts microseconds since boot0 started it */
+unsigned long timer_get_us(void)
+{
+	struct sunxi_timer_reg *timer_reg = (struct sunxi_timer_reg *)SUNXI_TIMER_BASE;
+
+	return timer_reg->avs.cnt1;
+}
+
+/* boot0 stashes its bootstage records against the same counter */
+ulong timer_get_boot_us(void)
+{
+	return timer_get_us();
+}
+
 /* delay x mseconds */
 void __msdelay(unsigned long msec)
 {
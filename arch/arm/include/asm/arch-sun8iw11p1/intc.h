@@ -28,6 +28,7 @@
 #ifndef FPGA_PLATFORM	//chip irq mapping
 
 #define AW_IRQ_NMI                     32
+#define AW_IRQ_UART0                   33
 #define AW_IRQ_TIMER0                  54 
 #define AW_IRQ_TIMER1                  55
 
@@ -67,6 +68,7 @@
 #define GIC_SRC_SPI(_n)                (32 + (_n))
 
 #define AW_IRQ_NMI                     32
+#define AW_IRQ_UART0                   33
 #define AW_IRQ_TIMER0                  36 
 #define AW_IRQ_TIMER1                  37
 
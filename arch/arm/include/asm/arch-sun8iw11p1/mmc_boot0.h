@@ -3,6 +3,8 @@
 
 void set_mmc_para(int smc_no,void *sdly_addr );
 unsigned long mmc_bread(int dev_num, unsigned long start, unsigned blkcnt, void *dst);
+int mmc_bread_start(int dev_num, unsigned long start, unsigned blkcnt, void *dst);
+unsigned long mmc_async_wait(int dev_num);
 int sunxi_mmc_init(int sdc_no, unsigned bus_width, const normal_gpio_cfg *gpio_info, int offset ,void *extra_data);
 int sunxi_mmc_exit(int sdc_no, const normal_gpio_cfg *gpio_info, int offset);
 
@@ -50,6 +50,7 @@
 #define SUNXI_USBOTG_BASE                            (0x01c13000L)
 #define SUNXI_USB0HOST_BASE                          (0x01c14000L)
 #define SUNXI_CE_BASE                                (0x01c15000L)
+#define SUNXI_SS_BASE                                SUNXI_CE_BASE
 #define SUNXI_SPI2_BASE                              (0x01c17000L)
 #define SUNXI_SATA_BASE                              (0x01c18000L)
 
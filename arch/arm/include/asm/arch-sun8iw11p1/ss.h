@@ -65,6 +65,18 @@
 #define		SHA1_160_MODE	0
 #define		SHA2_256_MODE	1
 
+#define		SS_SHA_BLOCK_SIZE	64
+
+#define		SS_AES_BLOCK_SIZE	16
+
+#define		SS_AES_MODE_ECB		0
+#define		SS_AES_MODE_CBC		1
+#define		SS_AES_MODE_CTR		2
+#define		SS_AES_MODE_XTS		3
+
+#define		SS_AES_ENCRYPT		0
+#define		SS_AES_DECRYPT		1
+
 typedef struct sg
 {
    uint addr;
@@ -87,11 +99,50 @@ typedef struct descriptor_queue
 	uint reserved[3];
 }task_queue;
 
+/*
+ * 增量hash的上下文。state放SS输出的中间摘要，下一个task把它作为IV；
+ * 不足一个block的数据留在block里，final时在这里补padding。
+ * 结构体要按cache line对齐(memalign或者栈上定义)，state会被SS直接写
+ */
+typedef struct sunxi_sha_ctx
+{
+	u8   state[ARCH_DMA_MINALIGN] __aligned(ARCH_DMA_MINALIGN);
+	u8   block[SS_SHA_BLOCK_SIZE * 2] __aligned(ARCH_DMA_MINALIGN);
+	uint block_len;
+	uint method;
+	uint digest_len;
+	uint started;
+	u64  total;
+}sunxi_sha_ctx_t;
+
+/*
+ * AES流式加解密的上下文。iv是下一次update用的IV/计数器/tweak，每次update后
+ * 由CPU推进(CBC取最后一个密文块，CTR加上块数，XTS乘以alpha)，不依赖SS回写。
+ * XTS的key前半是数据key，后半是tweak key，iv是数据单元号(小端)，
+ * 每个数据单元(扇区)开始时用sunxi_aes_set_iv重新设置
+ */
+typedef struct sunxi_aes_ctx
+{
+	u8   key[64] __aligned(ARCH_DMA_MINALIGN);
+	u8   iv[ARCH_DMA_MINALIGN] __aligned(ARCH_DMA_MINALIGN);
+	uint key_len;
+	uint mode;
+	uint decrypt;
+}sunxi_aes_ctx_t;
+
 
 void sunxi_ss_open(void);
 void sunxi_ss_close(void);
 int  sunxi_sha_calc(u8 *dst_addr, u32 dst_len,
 					u8 *src_addr, u32 src_len);
+int  sunxi_sha_init(sunxi_sha_ctx_t *ctx, int mode);
+int  sunxi_sha_update(sunxi_sha_ctx_t *ctx, const u8 *src_addr, u32 src_len);
+int  sunxi_sha_final(sunxi_sha_ctx_t *ctx, u8 *dst_addr);
+
+int  sunxi_aes_init(sunxi_aes_ctx_t *ctx, int mode, int decrypt,
+					const u8 *key, u32 key_len, const u8 *iv);
+int  sunxi_aes_set_iv(sunxi_aes_ctx_t *ctx, const u8 *iv);
+int  sunxi_aes_update(sunxi_aes_ctx_t *ctx, const u8 *src_addr, u8 *dst_addr, u32 len);
 
 s32 sunxi_rsa_calc(u8 * n_addr,   u32 n_len,
 				   u8 * e_addr,   u32 e_len,
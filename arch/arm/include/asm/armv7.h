@@ -56,6 +56,20 @@
 #define ARMV7_CLIDR_CTYPE_INSTRUCTION_DATA	3
 #define ARMV7_CLIDR_CTYPE_UNIFIED		4
 
+/* armv7_secondary_args[] words, see smp_entry.S */
+#define ARMV7_SEC_MAIN		0
+#define ARMV7_SEC_SP		1
+#define ARMV7_SEC_GD		2
+#define ARMV7_SEC_ACTLR		3
+#define ARMV7_SEC_SCTLR		4
+#define ARMV7_SEC_TTBR0		5
+#define ARMV7_SEC_DACR		6
+#define ARMV7_SEC_VBAR		7
+#define ARMV7_SEC_ARGS		8
+
+/* ACTLR.SMP on Cortex-A7/A9/A15: take part in the cache coherency */
+#define ARMV7_ACTLR_SMP		(1 << 6)
+
 #ifndef __ASSEMBLY__
 #include <linux/types.h>
 
@@ -87,6 +101,17 @@ void _smp_pen(void);
 void _switch_to_hyp(void);
 #endif /* CONFIG_ARMV7_NONSEC || CONFIG_ARMV7_VIRT */
 
+/* defined in add_sum_neon.S */
+extern int arm_neon_state;
+int arm_neon_init(void);
+
+#ifdef CONFIG_CPU_JOB
+/* defined in smp_entry.S */
+extern u32 armv7_secondary_args[ARMV7_SEC_ARGS];
+void armv7_secondary_prepare(void (*main)(void), void *stack_top);
+void armv7_secondary_entry(void);
+#endif
+
 #endif /* ! __ASSEMBLY__ */
 
 #endif
@@ -187,6 +187,9 @@ enum dcache_option {
 	DCACHE_WRITEBACK = 0x1e,
 };
 
+/* or'ed into the above: shareable, kept coherent between the cores */
+#define TTB_SECT_S_MASK		(1 << 16)
+
 /* Size of an MMU section */
 enum {
 	MMU_SECTION_SHIFT	= 20,
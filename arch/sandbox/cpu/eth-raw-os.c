@@ -0,0 +1,117 @@
+/*
+ * Sandbox Ethernet on the host's loopback interface
+ *
+ * Loopback has no link layer, so IP packets go through a raw socket and
+ * drivers/net/sandbox-raw.c adds and strips the Ethernet header.  This
+ * lets U-Boot talk to servers running on the host, a tftpd for example.
+ * Raw sockets need CAP_NET_RAW.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#include <asm/eth-raw-os.h>
+
+/* room for a window of large TFTP blocks */
+#define RAW_RCVBUF	(4 << 20)
+
+int sandbox_eth_raw_os_start(struct eth_sandbox_raw_priv *priv)
+{
+	int one = 1;
+	int size = RAW_RCVBUF;
+
+	priv->bind_sd = -1;
+	priv->bind_port = 0;
+
+	/* UDP only: ICMP does not reach us, so ping will not work */
+	priv->sd = socket(AF_INET, SOCK_RAW, IPPROTO_UDP);
+	if (priv->sd < 0)
+		return -errno;
+
+	/* we build the IP header, the host fills in id and checksum */
+	if (setsockopt(priv->sd, IPPROTO_IP, IP_HDRINCL, &one, sizeof(one)) ||
+	    fcntl(priv->sd, F_SETFL, fcntl(priv->sd, F_GETFL, 0) | O_NONBLOCK)) {
+		int err = -errno;
+
+		close(priv->sd);
+		priv->sd = -1;
+		return err;
+	}
+	setsockopt(priv->sd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+	return 0;
+}
+
+/* Hold the UDP port we send from with an ordinary socket */
+static void bind_source_port(const struct iphdr *ip, const struct udphdr *udp,
+			     struct eth_sandbox_raw_priv *priv)
+{
+	struct sockaddr_in addr;
+
+	if (priv->bind_sd >= 0 && priv->bind_port == udp->source)
+		return;
+	if (priv->bind_sd >= 0)
+		close(priv->bind_sd);
+
+	priv->bind_sd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	priv->bind_port = udp->source;
+	if (priv->bind_sd < 0)
+		return;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = ip->saddr;
+	addr.sin_port = udp->source;
+	bind(priv->bind_sd, (struct sockaddr *)&addr, sizeof(addr));
+}
+
+int sandbox_eth_raw_os_send(const void *packet, int length,
+			    struct eth_sandbox_raw_priv *priv)
+{
+	const struct iphdr *ip = packet;
+	struct sockaddr_in addr;
+	int ret;
+
+	if (length < (int)(sizeof(*ip) + sizeof(struct udphdr)))
+		return -EINVAL;
+	bind_source_port(ip, packet + sizeof(*ip), priv);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = ip->daddr;
+	ret = sendto(priv->sd, packet, length, 0, (struct sockaddr *)&addr,
+		     sizeof(addr));
+
+	return ret < 0 ? -errno : ret;
+}
+
+int sandbox_eth_raw_os_recv(void *packet, int length,
+			    struct eth_sandbox_raw_priv *priv)
+{
+	int ret;
+
+	ret = recv(priv->sd, packet, length, 0);
+	if (ret < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -errno;
+
+	return ret;
+}
+
+void sandbox_eth_raw_os_stop(struct eth_sandbox_raw_priv *priv)
+{
+	if (priv->bind_sd >= 0)
+		close(priv->bind_sd);
+	if (priv->sd >= 0)
+		close(priv->sd);
+	priv->bind_sd = -1;
+	priv->sd = -1;
+}
@@ -0,0 +1,61 @@
+/*
+ * Host side of the sandbox Ethernet device, see drivers/net/sandbox-raw.c
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __ETH_RAW_OS_H
+#define __ETH_RAW_OS_H
+
+/**
+ * struct eth_sandbox_raw_priv - raw socket session
+ *
+ * sd: raw socket, IP packets in and out
+ * bind_sd: UDP socket holding our source port, so that the host does not
+ *	answer the server with ICMP port unreachable
+ * bind_port: the port bind_sd holds, network order
+ */
+struct eth_sandbox_raw_priv {
+	int sd;
+	int bind_sd;
+	unsigned short bind_port;
+};
+
+/**
+ * Open the raw socket on the host's loopback interface
+ *
+ * @priv:	session to start
+ * @return 0 if OK, -errno on error (-EPERM without CAP_NET_RAW)
+ */
+int sandbox_eth_raw_os_start(struct eth_sandbox_raw_priv *priv);
+
+/**
+ * Send an IP packet, with its IP and UDP headers
+ *
+ * @packet:	the packet
+ * @length:	its length in bytes
+ * @priv:	session
+ * @return bytes sent, or -errno
+ */
+int sandbox_eth_raw_os_send(const void *packet, int length,
+			    struct eth_sandbox_raw_priv *priv);
+
+/**
+ * Receive an IP packet without waiting
+ *
+ * @packet:	buffer for the packet
+ * @length:	size of the buffer
+ * @priv:	session
+ * @return length of the packet, 0 if there is none, or -errno
+ */
+int sandbox_eth_raw_os_recv(void *packet, int length,
+			    struct eth_sandbox_raw_priv *priv);
+
+/**
+ * Close the sockets
+ *
+ * @priv:	session to stop
+ */
+void sandbox_eth_raw_os_stop(struct eth_sandbox_raw_priv *priv);
+
+#endif
@@ -6,6 +6,7 @@
 #include <common.h>
 #include <cros_ec.h>
 #include <dm.h>
+#include <netdev.h>
 #include <os.h>
 #include <asm/u-boot-sandbox.h>
 
@@ -65,6 +66,13 @@ int arch_early_init_r(void)
 	return 0;
 }
 
+#ifdef CONFIG_SANDBOX_ETH_RAW
+int board_eth_init(bd_t *bis)
+{
+	return sandbox_eth_raw_initialize(bis);
+}
+#endif
+
 #ifdef CONFIG_BOARD_LATE_INIT
 int board_late_init(void)
 {
@@ -26,6 +26,7 @@
 #include <sys_config.h>
 #include <mmc.h>
 #include <power/sunxi/axp.h>
+#include <asm/armv7.h>
 #include <asm/io.h>
 #include <power/sunxi/pmu.h>
 
@@ -70,6 +71,8 @@ int board_init(void)
 	reg_val &= ~(0x1<<0);
 	writel(reg_val, 0x1c202c4);
 
+	//NEON在启动核上只打开一次，校验和/哈希的NEON版本之后直接使用
+	arm_neon_init();
 	return 0;
 }
 /*
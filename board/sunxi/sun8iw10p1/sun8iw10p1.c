@@ -23,6 +23,7 @@
  */
 #include <common.h>
 #include <malloc.h>
+#include <asm/armv7.h>
 #include <asm/io.h>
 #include <fastboot.h>
 
@@ -78,6 +79,8 @@ int board_init(void)
 	}
 	//set smp bit before mmu&dcache enable.
 	enable_smp();
+	//NEON在启动核上只打开一次，校验和/哈希的NEON版本之后直接使用
+	arm_neon_init();
 	return 0;
 }
 /*
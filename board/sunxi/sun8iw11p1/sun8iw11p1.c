@@ -26,6 +26,7 @@
 #include <sys_config.h>
 #include <mmc.h>
 #include <power/sunxi/axp.h>
+#include <asm/armv7.h>
 #include <asm/io.h>
 #include <power/sunxi/pmu.h>
 
@@ -80,6 +81,8 @@ int board_init(void)
 	//we should open this bit before cache&mmu enable.
 	//the cache is useless if smp bit is not set,although cache has been enabled.
 	enable_smp();
+	//NEON在启动核上只打开一次，校验和/哈希的NEON版本之后直接使用
+	arm_neon_init();
 	return 0;
 }
 /*
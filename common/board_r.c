@@ -12,6 +12,9 @@
 
 #include <common.h>
 /* TODO: can we just include all these headers whether needed or not? */
+#ifdef CONFIG_CPU_JOB
+#include <cpu_job.h>
+#endif
 #if defined(CONFIG_CMD_BEDBUG)
 #include <bedbug/type.h>
 #endif
@@ -207,6 +210,26 @@ static int initr_malloc(void)
 	return 0;
 }
 
+#ifdef CONFIG_BOOTSTAGE_UNSTASH
+/*
+ * Take over the records the boot stage before U-Boot left at
+ * CONFIG_BOOTSTAGE_STASH; bootstage_relocate() copies their names out of
+ * the stash.  The magic is cleared after that, so that a stash still in
+ * memory after a warm reset is not taken a second time.
+ */
+static int initr_bootstage_unstash(void)
+{
+	struct bootstage_hdr *hdr;
+
+	hdr = map_sysmem(CONFIG_BOOTSTAGE_STASH, CONFIG_BOOTSTAGE_STASH_SIZE);
+	if (!bootstage_unstash(hdr, CONFIG_BOOTSTAGE_STASH_SIZE))
+		hdr->magic = 0;
+	unmap_sysmem(hdr);
+
+	return 0;
+}
+#endif
+
 __weak int power_init_board(void)
 {
 #ifdef CONFIG_SUNXI_AXP
@@ -398,6 +421,52 @@ static int initr_sunxi_flash(void)
 	return ret;
 
 }
+
+#ifdef CONFIG_CPU_JOB
+/*
+ * Card/NAND bring-up and the partition scan run on the second core
+ * while this one brings up the display.  The two use different
+ * controllers, pin banks and clock gates, and the display keeps its
+ * interrupts on this cpu.  Not when the display reads the HDCP key
+ * from the secure storage, which lives in the flash.
+ */
+#if defined(CONFIG_SUNXI) && !defined(CONFIG_SUNXI_HDCP_IN_SECURESTORAGE)
+#define SUNXI_FLASH_JOB
+#endif
+
+#ifdef SUNXI_FLASH_JOB
+static struct cpu_job flash_job;
+
+static int flash_job_run(void *arg)
+{
+	return initr_sunxi_flash();
+}
+
+static int initr_sunxi_flash_start(void)
+{
+	/* the display reads the FDT meanwhile, the card tuning waits */
+	mmc_defer_fdt_update(1);
+	cpu_job_submit(&flash_job, "flash", flash_job_run, NULL);
+	return 0;
+}
+
+static int initr_sunxi_flash_wait(void)
+{
+	int ret = cpu_job_wait(&flash_job);
+
+	mmc_defer_fdt_update(0);
+	return ret;
+}
+#endif
+
+/* all jobs are done and the second core is back in reset */
+static int initr_cpu_job_stop(void)
+{
+	cpu_job_stop();
+	return 0;
+}
+#endif
+
 static int platform_dma_init(void)
 {
 #ifdef CONFIG_SUNXI_DMA
@@ -446,6 +515,9 @@ init_fnc_t init_sequence_r[] = {
 	initr_announce,
 	initr_malloc,
 	script_init,
+#ifdef CONFIG_BOOTSTAGE_UNSTASH
+	initr_bootstage_unstash,
+#endif
 	bootstage_relocate,
 	power_init_board,
 	initr_secondary_cpu,
@@ -456,13 +528,23 @@ init_fnc_t init_sequence_r[] = {
 #if defined(CONFIG_ARM) || defined(CONFIG_x86)
 	initr_enable_interrupts,
 #endif
+#ifdef CONFIG_SYS_NS16550_TX_BUFFER
+	ns16550_tx_buffer_init,
+#endif
 #ifdef CONFIG_SUNXI
 	platform_dma_init,
 	//sunxi_arisc_probe,   //call this func here for optimize boot time
+#ifdef SUNXI_FLASH_JOB
+	initr_sunxi_flash_start,
+#endif
 #ifdef CONFIG_SUNXI_DISPLAY
 	initr_sunxi_display,
 #endif
+#ifdef SUNXI_FLASH_JOB
+	initr_sunxi_flash_wait,
+#else
 	initr_sunxi_flash,
+#endif
 	sunxi_burn_key,
 	initr_env,
 	initr_sunxi_base,
@@ -473,6 +555,9 @@ init_fnc_t init_sequence_r[] = {
 	PowerCheck,
 #endif
 	usb_net_init,
+#ifdef CONFIG_CPU_JOB
+	initr_cpu_job_stop,
+#endif
 	run_main_loop,
 };
 
@@ -0,0 +1,114 @@
+/*
+ * Block cache statistics and geometry
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <part.h>
+
+static int do_blkcache_show(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	struct block_cache_stats stats;
+	unsigned long total;
+
+	blkcache_get_stats(&stats);
+	total = stats.hits + stats.misses;
+
+	printf("sets %u, ways %u, max read %u, read-ahead %u blocks",
+	       stats.sets, stats.ways, stats.max_read, stats.window);
+	if (stats.blksz)
+		printf(", %lu byte blocks", stats.blksz);
+	printf("\n");
+	printf("hits          %lu", stats.hits);
+	if (total)
+		printf(" (%lu%%)", stats.hits * 100 / total);
+	printf("\n");
+	printf("misses        %lu\n", stats.misses);
+	printf("read-ahead    %lu\n", stats.readahead);
+	printf("bypassed      %lu\n", stats.bypass);
+	printf("invalidations %lu\n", stats.invalidations);
+
+	return 0;
+}
+
+static int do_blkcache_configure(cmd_tbl_t *cmdtp, int flag, int argc,
+				 char * const argv[])
+{
+	struct block_cache_stats stats;
+	unsigned int sets, ways, max_read, window;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+
+	blkcache_get_stats(&stats);
+	sets = simple_strtoul(argv[1], NULL, 0);
+	ways = simple_strtoul(argv[2], NULL, 0);
+	max_read = argc > 3 ? simple_strtoul(argv[3], NULL, 0) :
+		stats.max_read;
+	window = argc > 4 ? simple_strtoul(argv[4], NULL, 0) : stats.window;
+
+	if (blkcache_configure(sets, ways, max_read, window)) {
+		printf("sets must be a power of two, ways and max read not 0\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+static int do_blkcache_invalidate(cmd_tbl_t *cmdtp, int flag, int argc,
+				  char * const argv[])
+{
+	int if_type;
+
+	for (if_type = 0; if_type < IF_TYPE_MAX; if_type++)
+		blkcache_invalidate(if_type, -1);
+
+	return 0;
+}
+
+static int do_blkcache_clear(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	blkcache_clear_stats();
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_blkcache_sub[] = {
+	U_BOOT_CMD_MKENT(show, 1, 1, do_blkcache_show, "", ""),
+	U_BOOT_CMD_MKENT(configure, 5, 0, do_blkcache_configure, "", ""),
+	U_BOOT_CMD_MKENT(invalidate, 1, 0, do_blkcache_invalidate, "", ""),
+	U_BOOT_CMD_MKENT(clear, 1, 0, do_blkcache_clear, "", ""),
+};
+
+static int do_blkcache(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	/* Strip off leading 'blkcache' command argument */
+	argc--;
+	argv++;
+	if (!argc)
+		return do_blkcache_show(cmdtp, flag, argc, argv);
+
+	c = find_cmd_tbl(argv[0], cmd_blkcache_sub,
+			 ARRAY_SIZE(cmd_blkcache_sub));
+
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+	else
+		return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(blkcache, 6, 1, do_blkcache,
+	"block device cache",
+	"show                 - hit/miss counters and geometry\n"
+	"blkcache configure <sets> <ways> [<max read> [<read-ahead>]]\n"
+	"                              - resize the cache, in blocks\n"
+	"blkcache invalidate           - drop all cached blocks\n"
+	"blkcache clear                - reset the counters"
+);
@@ -42,12 +42,38 @@
 #include <sunxi_board.h>
 #include <power/sunxi/pmu.h>
 #include <smc.h>
+#include <sys_partition.h>
+#include <sunxi_flash.h>
+#include <hash.h>
+#include <malloc.h>
+#include <u-boot/sha256.h>
+#include <decomp_stream.h>
+#include <asm/errno.h>
 
 
 #ifndef CFG_ANDROID_IMAGE_PAGE_SIZE
 	#define CFG_ANDROID_IMAGE_PAGE_SIZE 2048
 #endif
 
+/* bytes read from the partition to get the android header */
+#define BOOTA_HEADER_READ_SIZE	ALIGN(sizeof(struct andr_img_hdr), 512)
+
+/*
+ * where the signed part of the image is gathered when it must be verified
+ * and there is no progressive sha256 to hash it piece by piece
+ */
+#ifndef CONFIG_BOOTA_STAGING_ADDR
+	#define CONFIG_BOOTA_STAGING_ADDR	(CONFIG_SYS_SDRAM_BASE + 0x0007f800)
+#endif
+
+/* largest kernel a compressed one may unpack to, as for bootm */
+#ifndef CONFIG_SYS_BOOTM_LEN
+	#define CONFIG_SYS_BOOTM_LEN	0x800000
+#endif
+
+/* flash read per step while a compressed kernel is unpacked */
+#define BOOTA_STREAM_CHUNK	(256 * 1024)
+
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -92,6 +118,8 @@ void do_nonsec_virt_switch(void)
 
  void announce_and_cleanup(int fake)
 {
+	/* before sunxi_board_close_source(), which stops the timer */
+	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_HANDOFF, "start_kernel");
 	printf("prepare for kernel\n");
 	axp_set_next_poweron_status(PMU_PRE_SYS_MODE);
 #ifdef CONFIG_SUNXI_DISPLAY
@@ -106,6 +134,11 @@ void do_nonsec_virt_switch(void)
 #ifdef CONFIG_BOOTSTAGE_REPORT
 	bootstage_report();
 #endif
+#ifdef CONFIG_BOOTSTAGE_STASH
+	/* for tools/bootstage_report.py, read it back from Linux */
+	bootstage_stash((void *)CONFIG_BOOTSTAGE_STASH,
+			CONFIG_BOOTSTAGE_STASH_SIZE);
+#endif
 
 #ifdef CONFIG_USB_DEVICE
 	udc_disconnect();
@@ -193,6 +226,341 @@ void * memcpy2(void * dest,const void * src,__kernel_size_t n)
 	return dest;
 }
 
+/*
+ * read one section of the boot image from flash straight to its load
+ * address. sections start on a page boundary so only the last partial
+ * sector goes through a bounce buffer, nothing past @size is touched.
+ */
+static int boota_read_section(u32 start, u32 offset, u32 size, ulong load_addr)
+{
+	u32 sectors = size / 512;
+	ALLOC_CACHE_ALIGN_BUFFER(char, tail, 512);
+
+	start += offset / 512;
+	if (sectors && !sunxi_flash_read(start, sectors, (void *)load_addr))
+		return -1;
+	if (size & 511) {
+		if (!sunxi_flash_read(start + sectors, 1, tail))
+			return -1;
+		memcpy((void *)(load_addr + sectors * 512), tail, size & 511);
+	}
+
+	return 0;
+}
+
+/*
+ * room for the unpacked kernel at its load address: it must not run into
+ * the ramdisk, which is loaded after it.
+ */
+static ulong boota_kernel_room(struct andr_img_hdr *hdr)
+{
+	ulong room = CONFIG_SYS_BOOTM_LEN;
+
+	if (hdr->ramdisk_size && hdr->ramdisk_addr > hdr->kernel_addr)
+		room = min(room, (ulong)(hdr->ramdisk_addr - hdr->kernel_addr));
+
+	return room;
+}
+
+#ifdef CONFIG_DECOMP_STREAM
+/*
+ * compression of the kernel section, from its first sector. only gzip
+ * and lzop can be told by their magic, anything else is taken as it is.
+ */
+static int boota_kernel_comp(u32 start, struct andr_img_hdr *hdr)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(char, head, 512);
+
+	if (!hdr->kernel_size ||
+	    !sunxi_flash_read(start + hdr->page_size / 512, 1, head))
+		return IH_COMP_NONE;
+
+	return decomp_stream_detect(head, min(hdr->kernel_size, 512U));
+}
+
+/*
+ * unpack a compressed kernel on its way from flash to its load address.
+ * the section goes through two chunk buffers: while one is decompressed,
+ * the asynchronous flash interface reads the next one into the other, so
+ * reading and decompressing overlap and the compressed kernel is never
+ * in DRAM as a whole. @padded bytes are read, and passed to the hash when
+ * @algo is given; the first kernel_size of them are the kernel.
+ */
+static int boota_stream_kernel(u32 start, struct andr_img_hdr *hdr, int comp,
+			       u32 padded, struct hash_algo *algo, void *ctx)
+{
+	struct decomp_stream *ds;
+	char *buf, *cur;
+	u32 sectors = DIV_ROUND_UP(padded, 512);
+	u32 done = 0, n, next, pos, feed;
+	ulong len;
+	int i = 0, unpack_err = 0, ret = -1;
+
+	buf = malloc_pool(2 * BOOTA_STREAM_CHUNK);
+	ds = decomp_stream_start(comp, (void *)(ulong)hdr->kernel_addr,
+				 boota_kernel_room(hdr));
+	if (!buf || !ds)
+		goto out;
+
+	n = min(sectors, (u32)(BOOTA_STREAM_CHUNK / 512));
+	if (sunxi_flash_submit_read(start, n, buf))
+		goto out;
+	while (n) {
+		cur = buf + i * BOOTA_STREAM_CHUNK;
+		if (sunxi_flash_complete() != n)
+			goto out;
+		pos = done * 512;
+		done += n;
+		next = min(sectors - done, (u32)(BOOTA_STREAM_CHUNK / 512));
+		if (next && sunxi_flash_submit_read(start + done, next,
+						    buf + (i ^ 1) * BOOTA_STREAM_CHUNK))
+			goto out;
+
+		feed = pos < hdr->kernel_size ? min(n * 512, hdr->kernel_size - pos) : 0;
+		if ((algo && algo->hash_update(algo, ctx, cur, n * 512, 0)) ||
+		    (feed && (unpack_err = decomp_stream_write(ds, cur, feed)))) {
+			if (next)
+				sunxi_flash_complete();
+			goto out;
+		}
+		n = next;
+		i ^= 1;
+	}
+	ret = 0;
+out:
+	if (ds) {
+		/* a read error is reported by the caller */
+		int err = decomp_stream_finish(ds, &len);
+
+		if (err && (!ret || unpack_err))
+			printf("boota: unpacking the %s kernel failed (%d)\n",
+			       genimg_get_comp_name(comp), err);
+		else if (!ret)
+			tick_printf("boota: %s kernel, %d bytes unpacked to %lu\n",
+				    genimg_get_comp_name(comp), hdr->kernel_size, len);
+		if (err)
+			ret = -1;
+	}
+	if (buf)
+		free_pool(buf);
+
+	return ret;
+}
+
+/*
+ * the copying path: a compressed kernel is unpacked from the image in
+ * memory to its load address. the image must not be in the way.
+ */
+static int boota_copy_kernel(struct andr_img_hdr *hdr, ulong data, ulong len)
+{
+	struct decomp_stream *ds;
+	ulong load = hdr->kernel_addr, room, out;
+	int comp, ret;
+
+	comp = decomp_stream_detect((void *)data, len);
+	if (comp == IH_COMP_NONE) {
+		memcpy2((void *)load, (const void *)data, len);
+		return 0;
+	}
+
+	room = boota_kernel_room(hdr);
+	if ((ulong)hdr >= load)
+		room = min(room, (ulong)hdr - load);
+	else if ((ulong)hdr + android_image_get_end(hdr) > load)
+		room = 0;
+
+	ds = decomp_stream_start(comp, (void *)load, room);
+	ret = ds ? decomp_stream_write(ds, (void *)data, len) : -ENOMEM;
+	if (decomp_stream_finish(ds, &out) && !ret)
+		ret = -EINVAL;
+	if (ret) {
+		printf("boota: unpacking the %s kernel failed (%d)\n",
+		       genimg_get_comp_name(comp), ret);
+		return -1;
+	}
+	tick_printf("boota: %s kernel, %lu bytes unpacked to %lu\n",
+		    genimg_get_comp_name(comp), len, out);
+
+	return 0;
+}
+#else
+static int boota_kernel_comp(u32 start, struct andr_img_hdr *hdr)
+{
+	return IH_COMP_NONE;
+}
+
+static int boota_stream_kernel(u32 start, struct andr_img_hdr *hdr, int comp,
+			       u32 padded, struct hash_algo *algo, void *ctx)
+{
+	return -1;
+}
+
+static int boota_copy_kernel(struct andr_img_hdr *hdr, ulong data, ulong len)
+{
+	memcpy2((void *)(ulong)hdr->kernel_addr, (const void *)data, len);
+
+	return 0;
+}
+#endif /* CONFIG_DECOMP_STREAM */
+
+/*
+ * load kernel and ramdisk in place and compute the sha256 of the signed
+ * part of the image: header page, kernel and ramdisk, each padded to a
+ * page. the padding is read with the last partial sector into a page
+ * sized bounce buffer. the whole sectors of a section are read through
+ * the asynchronous flash interface, so the previous section is hashed
+ * while the next one is in flight. a compressed kernel (@comp) is hashed
+ * as it is unpacked.
+ * returns 1 when no progressive sha256 is available.
+ */
+static int boota_load_hashed(u32 start, struct andr_img_hdr *hdr, int comp,
+			     u8 *digest)
+{
+	struct hash_algo *algo;
+	void *ctx;
+	char *bounce;
+	u32 size[2] = { hdr->kernel_size, hdr->ramdisk_size };
+	ulong addr[2] = { hdr->kernel_addr, hdr->ramdisk_addr };
+	u32 head[2], tail[2];
+	u32 offset = hdr->page_size;
+	int i, ret = -1;
+
+	if (hash_lookup_algo("sha256", &algo) || !algo->hash_init)
+		return 1;
+	bounce = memalign(ARCH_DMA_MINALIGN, hdr->page_size);
+	if (!bounce)
+		return 1;
+	if (algo->hash_init(algo, &ctx)) {
+		free(bounce);
+		return 1;
+	}
+
+	if (!sunxi_flash_read(start, hdr->page_size / 512, bounce) ||
+	    algo->hash_update(algo, ctx, bounce, hdr->page_size, 0))
+		goto out;
+	for (i = 0; i < 2; i++) {
+		if (!i && comp != IH_COMP_NONE) {
+			head[0] = tail[0] = 0;
+			if (boota_stream_kernel(start + offset / 512, hdr, comp,
+						ALIGN(size[0], hdr->page_size),
+						algo, ctx))
+				goto out;
+			offset += ALIGN(size[0], hdr->page_size);
+			continue;
+		}
+		head[i] = size[i] & ~511;
+		tail[i] = ALIGN(size[i], hdr->page_size) - head[i];
+		if (head[i] && sunxi_flash_submit_read(start + offset / 512,
+						       head[i] / 512, (void *)addr[i]))
+			goto out;
+		if (i && (algo->hash_update(algo, ctx, (void *)addr[0], head[0], 0) ||
+			  algo->hash_update(algo, ctx, bounce, tail[0], 0)))
+			goto out;
+		if (head[i] && sunxi_flash_complete() != head[i] / 512)
+			goto out;
+		if (tail[i]) {
+			if (!sunxi_flash_read(start + (offset + head[i]) / 512,
+					      tail[i] / 512, bounce))
+				goto out;
+			memcpy((void *)(addr[i] + head[i]), bounce, size[i] - head[i]);
+		}
+		offset += head[i] + tail[i];
+	}
+	if (algo->hash_update(algo, ctx, (void *)addr[1], head[1], 0) ||
+	    algo->hash_update(algo, ctx, bounce, tail[1], 1))
+		goto out;
+	ret = 0;
+out:
+	algo->hash_finish(algo, ctx, digest, SHA256_SUM_LEN);
+	free(bounce);
+
+	return ret;
+}
+
+/*
+ * load a boot image from partition @name. only the header is read first;
+ * kernel, ramdisk and second stage then go from flash directly to the
+ * addresses in the header and *in_place is set. when @digest is given the
+ * signed part of the image is hashed on the way and *hashed is set; if
+ * that is not possible the signed part is read in one piece to
+ * CONFIG_BOOTA_STAGING_ADDR and the normal copying path is used.
+ * returns the address of the header, 0 on failure.
+ */
+static ulong boota_load_partition(const char *name, char *hdr_buf, u8 *digest,
+				  int *hashed, int *in_place)
+{
+	struct andr_img_hdr *hdr = (struct andr_img_hdr *)hdr_buf;
+	u32 start, part_sectors, offset;
+	int comp, ret;
+
+	*in_place = 0;
+	*hashed = 0;
+	start = sunxi_partition_get_offset_byname(name);
+	part_sectors = sunxi_partition_get_size_byname(name);
+	if (!start || !part_sectors) {
+		printf("boota: cant find part named %s\n", name);
+		return 0;
+	}
+	if (!sunxi_flash_read(start, BOOTA_HEADER_READ_SIZE / 512, hdr_buf)) {
+		printf("boota: read header of %s failed\n", name);
+		return 0;
+	}
+	if (android_image_check_header(hdr)) {
+		puts("boota: bad boot image magic, maybe not a boot.img?\n");
+		return 0;
+	}
+	if (!hdr->page_size || (hdr->page_size & 511) ||
+	    android_image_get_end(hdr) > (ulong)part_sectors * 512) {
+		printf("boota: bad boot image layout in %s\n", name);
+		return 0;
+	}
+
+	comp = boota_kernel_comp(start, hdr);
+	offset = hdr->page_size;
+	if (digest) {
+		ret = boota_load_hashed(start, hdr, comp, digest);
+		if (ret < 0)
+			goto read_fail;
+		if (ret > 0) {
+			u32 total = hdr->page_size + ALIGN(hdr->kernel_size, hdr->page_size) +
+				    ALIGN(hdr->ramdisk_size, hdr->page_size);
+
+			if (!sunxi_flash_read(start, total / 512, (void *)CONFIG_BOOTA_STAGING_ADDR))
+				goto read_fail;
+			return CONFIG_BOOTA_STAGING_ADDR;
+		}
+		*hashed = 1;
+	} else {
+		if (comp != IH_COMP_NONE)
+			ret = boota_stream_kernel(start + offset / 512, hdr, comp,
+						  hdr->kernel_size, NULL, NULL);
+		else
+			ret = boota_read_section(start, offset, hdr->kernel_size,
+						 hdr->kernel_addr);
+		if (ret)
+			goto read_fail;
+		if (hdr->ramdisk_size &&
+		    boota_read_section(start, offset + ALIGN(hdr->kernel_size, hdr->page_size),
+				       hdr->ramdisk_size, hdr->ramdisk_addr))
+			goto read_fail;
+	}
+	offset += ALIGN(hdr->kernel_size, hdr->page_size);
+	offset += ALIGN(hdr->ramdisk_size, hdr->page_size);
+	if (hdr->second_size &&
+	    boota_read_section(start, offset, hdr->second_size, hdr->second_addr))
+		goto read_fail;
+
+	tick_printf("boota: loaded %s in place, kernel %d bytes, ramdisk %d bytes\n",
+		    name, hdr->kernel_size, hdr->ramdisk_size);
+	*in_place = 1;
+
+	return (ulong)hdr_buf;
+
+read_fail:
+	printf("boota: read %s failed\n", name);
+	return 0;
+}
+
 void update_bootargs(void)
 {
 	char *str;
@@ -236,15 +604,44 @@ int do_boota (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	ulong os_load_addr;
 	ulong os_data = 0,os_len = 0;
-	ulong rd_data,rd_len;
+	ulong rd_data,rd_len = 0;
 	struct  andr_img_hdr *fb_hdr = NULL;
 	void *dtb_base = (void*)CONFIG_SUNXI_FDT_ADDR;
 	char efuse_hash[32] , all_zero[32];
+	char *end;
+	int in_place = 0, hashed = 0;
+#ifdef CONFIG_SUNXI_SECURE_SYSTEM
+	u8 digest[SHA256_SUM_LEN];
+#endif
+	ALLOC_CACHE_ALIGN_BUFFER(char, hdr_buf, BOOTA_HEADER_READ_SIZE);
 
 	if (argc < 2)
 		return cmd_usage(cmdtp);
 
-	os_load_addr = simple_strtoul(argv[1], NULL, 16);
+	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_START, "boota");
+	/*
+	 * the partition table is asked first, names such as "cafe" would
+	 * also parse as a hex address
+	 */
+	if (sunxi_partition_get_partno_byname(argv[1]) >= 0) {
+		u8 *want_digest = NULL;
+
+#ifdef CONFIG_SUNXI_SECURE_SYSTEM
+		if (gd->securemode)
+			want_digest = digest;
+#endif
+		os_load_addr = boota_load_partition(argv[1], hdr_buf, want_digest,
+						    &hashed, &in_place);
+		if (!os_load_addr)
+			return -1;
+	} else {
+		os_load_addr = simple_strtoul(argv[1], &end, 16);
+		if (*end || end == argv[1]) {
+			printf("boota: %s is neither a partition nor an address\n",
+			       argv[1]);
+			return -1;
+		}
+	}
 	fb_hdr = (struct andr_img_hdr *)os_load_addr;
 
 	if(android_image_check_header(fb_hdr))
@@ -262,7 +659,14 @@ int do_boota (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 		printf("total_len=%d\n", (unsigned int)total_len);
 		//Ϊǩ飬֪ǰ
-		int ret = sunxi_verify_signature((void *)os_load_addr, (unsigned int)total_len, argv[2]);
+		int ret;
+
+		bootstage_start(BOOTSTAGE_ID_ACCUM_VERIFY, "verify_signature");
+		if (hashed)
+			ret = sunxi_verify_hash(digest, argv[2]);
+		else
+			ret = sunxi_verify_signature((void *)os_load_addr, (unsigned int)total_len, argv[2]);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_VERIFY);
 		setenv("verifiedbootstate", "green");
 		if(ret)
 		{
@@ -297,10 +701,15 @@ int do_boota (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 #endif
 
 	android_image_get_kernel(fb_hdr,0,&os_data,&os_len);
-	android_image_get_ramdisk(fb_hdr,&rd_data,&rd_len);
+	if (in_place) {
+		rd_len = fb_hdr->ramdisk_size;
+	} else {
+		android_image_get_ramdisk(fb_hdr,&rd_data,&rd_len);
 
-	memcpy2((void*) (long)fb_hdr->kernel_addr, (const void *)os_data, os_len);
-	memcpy2((void*) (long)fb_hdr->ramdisk_addr, (const void *)rd_data, rd_len);
+		if (boota_copy_kernel(fb_hdr, os_data, os_len))
+			return -1;
+		memcpy2((void*) (long)fb_hdr->ramdisk_addr, (const void *)rd_data, rd_len);
+	}
 
 #ifdef SYS_CONFIG_MEMBASE
 	debug("moving sysconfig.bin from %lx to: %lx, size 0x%lx\n", 
@@ -315,6 +724,12 @@ int do_boota (cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	//update fdt bootargs from env config
 	fdt_chosen(working_fdt);
 	fdt_initrd(working_fdt,(ulong)fb_hdr->ramdisk_addr, (ulong)(fb_hdr->ramdisk_addr+rd_len));
+#ifdef CONFIG_BOOTSTAGE_STASH
+	/* the boot-stage records stashed just before the jump stay intact */
+	if (fdt_add_mem_rsv(working_fdt, CONFIG_BOOTSTAGE_STASH,
+			    CONFIG_BOOTSTAGE_STASH_SIZE))
+		printf("boota: can not reserve the bootstage stash\n");
+#endif
 	debug("moving platform.dtb from %lx to: %lx, size 0x%lx\n",
 		(ulong)dtb_base,
 		(ulong)(gd->fdt_blob),gd->fdt_size);
@@ -342,5 +757,6 @@ U_BOOT_CMD(
 	"boota   - boot android bootimg from memory\n",
 	"<addr>\n    - boot application image stored in memory\n"
 	"\t'addr' should be the address of boot image which is kernel+ramdisk.img\n"
+	"boota <partition>\n    - load the boot image sections from flash to their load address and boot\n"
 );
 #endif
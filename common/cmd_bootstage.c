@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <asm/io.h>
 
 #ifndef CONFIG_BOOTSTAGE_STASH
 #define CONFIG_BOOTSTAGE_STASH		-1UL
@@ -44,6 +45,7 @@ static int do_bootstage_stash(cmd_tbl_t *cmdtp, int flag, int argc,
 			      char * const argv[])
 {
 	ulong base, size;
+	void *buf;
 	int ret;
 
 	if (get_base_size(argc, argv, &base, &size))
@@ -53,10 +55,12 @@ static int do_bootstage_stash(cmd_tbl_t *cmdtp, int flag, int argc,
 		return 1;
 	}
 
+	buf = map_sysmem(base, size);
 	if (0 == strcmp(argv[0], "stash"))
-		ret = bootstage_stash((void *)base, size);
+		ret = bootstage_stash(buf, size);
 	else
-		ret = bootstage_unstash((void *)base, size);
+		ret = bootstage_unstash(buf, size);
+	unmap_sysmem(buf);
 	if (ret)
 		return 1;
 
@@ -11,6 +11,9 @@
 #include <common.h>
 #include <command.h>
 #include <stdio_dev.h>
+#ifdef CONFIG_SYS_NS16550_TX_BUFFER
+#include <ns16550.h>
+#endif
 
 extern void _do_coninfo (void);
 static int do_coninfo(cmd_tbl_t *cmd, int flag, int argc, char * const argv[])
@@ -41,6 +44,16 @@ static int do_coninfo(cmd_tbl_t *cmd, int flag, int argc, char * const argv[])
 		}
 		putc ('\n');
 	}
+#ifdef NS16550_TX_BUFFERED
+	{
+		struct ns16550_tx_stats st;
+
+		NS16550_tx_stats(&st);
+		printf("serial output buffer: %u bytes, peak %u, %lu bytes "
+		       "buffered, %lu waits for room\n",
+		       st.size, st.peak, st.bytes, st.stalls);
+	}
+#endif
 	return 0;
 }
 
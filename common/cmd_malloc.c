@@ -0,0 +1,93 @@
+/*
+ * Heap and I/O buffer pool statistics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+
+static int do_malloc_info(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	struct malloc_pool_info pool;
+#ifdef CONFIG_SYS_MALLOC_STATS
+	struct malloc_stats_info stats;
+
+	malloc_get_stats(&stats);
+
+	printf("heap          %lu KiB, peak %lu KiB taken\n",
+	       stats.heap_size >> 10, stats.heap_peak >> 10);
+	printf("in use        %lu KiB\n", stats.in_use >> 10);
+	printf("free          %lu KiB in %lu chunks and top, largest %lu KiB",
+	       stats.free >> 10, stats.free_chunks, stats.largest_free >> 10);
+	if (stats.free)
+		printf(" (%lu%% fragmented)", 100 -
+		       (unsigned long)((u64)stats.largest_free * 100 /
+				       stats.free));
+	printf("\n");
+	printf("malloc        %lu calls, %lu us, %lu failed\n",
+	       stats.mallocs, stats.malloc_us, stats.failures);
+	printf("free          %lu calls, %lu us\n", stats.frees,
+	       stats.free_us);
+#endif
+
+	malloc_pool_get_info(&pool);
+	printf("pool          %u buffers (%u busy), %lu KiB, peak %lu KiB\n",
+	       pool.slabs, pool.busy, pool.bytes >> 10, pool.peak >> 10);
+	printf("pool requests %lu reused, %lu new, %lu untracked\n",
+	       pool.reused, pool.allocated, pool.untracked);
+
+	return 0;
+}
+
+static int do_malloc_clear(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+#ifdef CONFIG_SYS_MALLOC_STATS
+	malloc_clear_stats();
+#endif
+
+	return 0;
+}
+
+static int do_malloc_release(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	malloc_pool_release();
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_malloc_sub[] = {
+	U_BOOT_CMD_MKENT(info, 1, 1, do_malloc_info, "", ""),
+	U_BOOT_CMD_MKENT(clear, 1, 0, do_malloc_clear, "", ""),
+	U_BOOT_CMD_MKENT(release, 1, 0, do_malloc_release, "", ""),
+};
+
+static int do_malloc(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	/* Strip off leading 'malloc' command argument */
+	argc--;
+	argv++;
+	if (!argc)
+		return do_malloc_info(cmdtp, flag, argc, argv);
+
+	c = find_cmd_tbl(argv[0], cmd_malloc_sub, ARRAY_SIZE(cmd_malloc_sub));
+
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+	else
+		return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(malloc, 2, 1, do_malloc,
+	"heap and I/O buffer pool statistics",
+	"info                   - heap usage, call counts and time spent\n"
+	"malloc clear                  - reset the call counters\n"
+	"malloc release                - give idle pool buffers back to the heap"
+);
@@ -183,29 +183,31 @@ int sunxi_bmp_display(char *name)
         sunxi_bmp_store_t bmp_info;
 	char  bmp_name[32];
 	char  bmp_addr[32] = {0};
+	char  bmp_len[32] = {0};
 	char*  bmp_buff = NULL;
 	int  ret = -1;
-	//const size_t bmp_buff_len = 10<<20; //10M
+	const size_t bmp_buff_len = 10<<20; //10M
 	//size_t file_size = 0;
-	char * bmp_argv[6] = { "fatload", "sunxi_flash", "0:0", "00000000", bmp_name, NULL };
+	char * bmp_argv[7] = { "fatload", "sunxi_flash", "0:0", "00000000", bmp_name, "00000000", NULL };
 
-	// free() function  will  take a long time,so not use malloc memory
-	bmp_buff = (char*)CONFIG_SYS_SDRAM_BASE; 
+	// a pool buffer, the pool is trimmed again once the logo is shown
+	bmp_buff = (char*)malloc_pool(bmp_buff_len);
 	if(bmp_buff == NULL)
 	{
 		printf("sunxi bmp: alloc buffer for %s fail\n", name);
 		return -1;
 	}
-	//set bmp decode addr is CONFIG_SYS_SDRAM_BASE
 	sprintf(bmp_addr,"%lx", (ulong)bmp_buff);
 	bmp_argv[3] = bmp_addr;
+	sprintf(bmp_len,"%lx", (ulong)bmp_buff_len);
+	bmp_argv[5] = bmp_len;
 
 	memset(bmp_name, 0, 32);
 	strcpy(bmp_name, name);
-	if(do_fat_fsload(0, 0, 5, bmp_argv))
+	if(do_fat_fsload(0, 0, 6, bmp_argv))
 	{
 		printf("sunxi bmp info error : unable to open logo file %s\n", bmp_argv[4]);
-		return -1;
+		goto out;
 	}
 	//file_size = simple_strtoul(getenv("filesize"), NULL, 16);
 
@@ -220,6 +222,10 @@ int sunxi_bmp_display(char *name)
 		debug("decode bmp ok\n");
 		ret = sunxi_bmp_show(bmp_info);
 	}
+out:
+	// the 10M buffer is not needed again, give it back to malloc
+	free_pool(bmp_buff);
+	malloc_pool_release();
 	return ret;
 
 }
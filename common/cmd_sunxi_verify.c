@@ -53,10 +53,6 @@ int sunxi_verify_signature(void *buff, uint len, const char *cert_name)
 {
 	u8 hash_of_file[32];
 	int ret;
-	struct sbrom_toc1_head_info  *toc1_head;
-	struct sbrom_toc1_item_info  *toc1_item;
-	sunxi_certif_info_t  sub_certif;
-	int i;
 
 	memset(hash_of_file, 0, 32);
 	sunxi_ss_open();
@@ -69,8 +65,34 @@ int sunxi_verify_signature(void *buff, uint len, const char *cert_name)
 		return -1;
 	}
 	//sunxi_ss_close();
+
+	return sunxi_verify_hash(hash_of_file, cert_name);
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_verify_hash
+*
+*    parmeters     :  hash_of_file : sha256 of the image, computed by the caller
+*
+*    return        :  0 if it matches the certif named cert_name in toc1
+*
+*    note          :  lets callers hash an image which is not contiguous in dram
+*
+*
+************************************************************************************************************
+*/
+int sunxi_verify_hash(const u8 *hash_of_file, const char *cert_name)
+{
+	struct sbrom_toc1_head_info  *toc1_head;
+	struct sbrom_toc1_item_info  *toc1_item;
+	sunxi_certif_info_t  sub_certif;
+	int i;
+
 	printf("show hash of file\n");
-	sunxi_dump(hash_of_file, 32);
+	sunxi_dump((void *)hash_of_file, 32);
 	//ȡtoc1֤
 	toc1_head = (struct sbrom_toc1_head_info *)CONFIG_TOC1_STORE_IN_DRAM_BASE;
 	toc1_item = (struct sbrom_toc1_item_info *)(CONFIG_TOC1_STORE_IN_DRAM_BASE + sizeof(struct sbrom_toc1_head_info));
@@ -96,7 +118,7 @@ int sunxi_verify_signature(void *buff, uint len, const char *cert_name)
 				{
 					printf("hash compare is not correct\n");
 					printf(">>>>>>>hash of file<<<<<<<<<<\n");
-					sunxi_dump(hash_of_file, 32);
+					sunxi_dump((void *)hash_of_file, 32);
 					printf(">>>>>>>hash in certif<<<<<<<<<<\n");
 					sunxi_dump(sub_certif.extension.value[0], 32);
 
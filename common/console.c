@@ -13,9 +13,13 @@
 #include <stdio_dev.h>
 #include <exports.h>
 #include <environment.h>
+#include <cpu_job.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* output from a job on the second core does not interleave mid-string */
+static struct cpu_job_lock console_lock = CPU_JOB_LOCK_INIT;
+
 static int on_console(const char *name, const char *value, enum env_op op,
 	int flags)
 {
@@ -435,6 +439,7 @@ void putc(const char c)
 	if (!gd->have_console)
 		return pre_console_putc(c);
 
+	cpu_job_lock(&console_lock);
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Send to the standard output */
 		fputc(stdout, c);
@@ -442,6 +447,7 @@ void putc(const char c)
 		/* Send directly to the handler */
 		serial_putc(c);
 	}
+	cpu_job_unlock(&console_lock);
 }
 
 void puts(const char *s)
@@ -466,6 +472,7 @@ void puts(const char *s)
 	if (!gd->have_console)
 		return pre_console_puts(s);
 
+	cpu_job_lock(&console_lock);
 	if (gd->flags & GD_FLG_DEVINIT) {
 		/* Send to the standard output */
 		fputs(stdout, s);
@@ -473,6 +480,7 @@ void puts(const char *s)
 		/* Send directly to the handler */
 		serial_puts(s);
 	}
+	cpu_job_unlock(&console_lock);
 }
 
 int printf(const char *fmt, ...)
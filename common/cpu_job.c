@@ -0,0 +1,233 @@
+/*
+ * Boot-time jobs on a second cpu core, see include/cpu_job.h
+ *
+ * The boot cpu is the only producer and the second core the only
+ * consumer of a small ring of job pointers, so the ring itself needs no
+ * lock, just the barriers that order the slot against the indices.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <cpu_job.h>
+#include <malloc.h>
+#include <asm/errno.h>
+
+#ifndef CONFIG_CPU_JOB_STACK_SIZE
+#define CONFIG_CPU_JOB_STACK_SIZE	(64 << 10)
+#endif
+
+/* how long the second core gets to show up, ms */
+#define CPU_JOB_BOOT_TIMEOUT	100
+
+enum {
+	CPU_JOB_OFF,
+	CPU_JOB_BOOTING,
+	CPU_JOB_RUNNING,
+};
+
+static struct cpu_job *cpu_job_ring[CPU_JOB_RING];
+static volatile unsigned int cpu_job_head;	/* next slot to fill */
+static volatile unsigned int cpu_job_tail;	/* next job to run */
+static volatile int cpu_job_state = CPU_JOB_OFF;
+static volatile int cpu_job_exit;
+static void *cpu_job_stack;
+
+/* non-zero while the second core runs: the locks are taken then */
+static volatile int cpu_job_smp;
+
+#ifdef CONFIG_ARM
+#define cpu_job_dmb()	asm volatile("dmb" : : : "memory")
+#define cpu_job_dsb()	asm volatile("dsb" : : : "memory")
+#define cpu_job_sev()	asm volatile("dsb\n\tsev" : : : "memory")
+#define cpu_job_wfe()	asm volatile("wfe" : : : "memory")
+
+static inline int cpu_job_this_cpu(void)
+{
+	unsigned int mpidr;
+
+	asm volatile("mrc p15, 0, %0, c0, c0, 5" : "=r" (mpidr));
+	return mpidr & 0xff;
+}
+#else
+#define cpu_job_dmb()	__sync_synchronize()
+#define cpu_job_dsb()	__sync_synchronize()
+#define cpu_job_sev()	__sync_synchronize()
+#define cpu_job_wfe()	do { } while (0)
+
+static inline int cpu_job_this_cpu(void)
+{
+	return 0;
+}
+#endif
+
+__weak int cpu_job_arch_boot(void (*main)(void), void *stack_top)
+{
+	return -ENODEV;
+}
+
+__weak void cpu_job_arch_off(void)
+{
+}
+
+void cpu_job_lock(struct cpu_job_lock *lock)
+{
+	int cpu;
+
+	if (!cpu_job_smp)
+		return;
+
+	cpu = cpu_job_this_cpu();
+	if (lock->owner == cpu) {
+		lock->depth++;
+		return;
+	}
+	while (__sync_val_compare_and_swap(&lock->owner, -1, cpu) != -1)
+		;
+	lock->depth = 1;
+}
+
+void cpu_job_unlock(struct cpu_job_lock *lock)
+{
+	/* not ours when it was skipped before the second core started */
+	if (lock->owner != cpu_job_this_cpu())
+		return;
+
+	if (--lock->depth == 0) {
+		cpu_job_dmb();
+		lock->owner = -1;
+	}
+}
+
+static void cpu_job_run(struct cpu_job *job)
+{
+	ulong start = timer_get_us();
+
+	job->ret = job->fn(job->arg);
+	job->time_us = timer_get_us() - start;
+	debug("cpu%d: job %s returned %d after %lu us\n", cpu_job_this_cpu(),
+	      job->name, job->ret, job->time_us);
+	cpu_job_dmb();
+	job->done = 1;
+}
+
+/* the second core, until cpu_job_stop() */
+static void cpu_job_main(void)
+{
+	unsigned int tail;
+
+	cpu_job_state = CPU_JOB_RUNNING;
+	cpu_job_sev();
+
+	for (;;) {
+		tail = cpu_job_tail;
+		if (tail == cpu_job_head) {
+			if (cpu_job_exit)
+				break;
+			cpu_job_wfe();
+			continue;
+		}
+		cpu_job_dmb();
+		cpu_job_run(cpu_job_ring[tail & (CPU_JOB_RING - 1)]);
+		cpu_job_tail = tail + 1;
+		cpu_job_sev();
+	}
+}
+
+int cpu_job_start(void)
+{
+	ulong start;
+
+	if (cpu_job_state == CPU_JOB_RUNNING)
+		return 0;
+
+	cpu_job_stack = memalign(ARCH_DMA_MINALIGN, CONFIG_CPU_JOB_STACK_SIZE);
+	if (!cpu_job_stack)
+		return -ENOMEM;
+
+	cpu_job_head = cpu_job_tail = 0;
+	cpu_job_exit = 0;
+	cpu_job_state = CPU_JOB_BOOTING;
+	cpu_job_dsb();
+	if (cpu_job_arch_boot(cpu_job_main,
+			      cpu_job_stack + CONFIG_CPU_JOB_STACK_SIZE))
+		goto fail;
+
+	start = get_timer(0);
+	while (cpu_job_state != CPU_JOB_RUNNING) {
+		if (get_timer(start) > CPU_JOB_BOOT_TIMEOUT) {
+			printf("cpu job: second core did not start\n");
+			cpu_job_arch_off();
+			goto fail;
+		}
+	}
+	cpu_job_smp = 1;
+
+	return 0;
+
+fail:
+	cpu_job_state = CPU_JOB_OFF;
+	free(cpu_job_stack);
+	cpu_job_stack = NULL;
+
+	return -ENODEV;
+}
+
+void cpu_job_stop(void)
+{
+	if (cpu_job_state != CPU_JOB_RUNNING)
+		return;
+
+	cpu_job_join();
+	cpu_job_exit = 1;
+	cpu_job_sev();
+	cpu_job_arch_off();
+
+	cpu_job_smp = 0;
+	cpu_job_state = CPU_JOB_OFF;
+	free(cpu_job_stack);
+	cpu_job_stack = NULL;
+}
+
+void cpu_job_submit(struct cpu_job *job, const char *name, cpu_job_fn fn,
+		    void *arg)
+{
+	unsigned int head = cpu_job_head;
+
+	job->name = name;
+	job->fn = fn;
+	job->arg = arg;
+	job->ret = 0;
+	job->time_us = 0;
+	job->done = 0;
+
+	if (cpu_job_state != CPU_JOB_RUNNING) {
+		cpu_job_run(job);
+		return;
+	}
+
+	/* the ring is full: wait for the second core to take one */
+	while (head - cpu_job_tail >= CPU_JOB_RING)
+		cpu_job_wfe();
+
+	cpu_job_ring[head & (CPU_JOB_RING - 1)] = job;
+	cpu_job_dmb();
+	cpu_job_head = head + 1;
+	cpu_job_sev();
+}
+
+int cpu_job_wait(struct cpu_job *job)
+{
+	while (!job->done)
+		cpu_job_wfe();
+	cpu_job_dmb();
+
+	return job->ret;
+}
+
+void cpu_job_join(void)
+{
+	while (cpu_job_tail != cpu_job_head)
+		cpu_job_wfe();
+	cpu_job_dmb();
+}
@@ -615,8 +615,18 @@ struct mallinfo {
 #define M_MMAP_MAX          -4
 
 
+/*
+ * U-Boot: the heap is a fixed area and sbrk() clears what is given back
+ * (MORECORE_CLEARS), so trimming from free() buys nothing and makes the
+ * free of a large buffer next to top memset all of it.  Never trim
+ * unless the board asks for it; the memory above brk stays zero from
+ * mem_malloc_init().  malloc_trim() can still be called explicitly.
+ */
+#if !defined(DEFAULT_TRIM_THRESHOLD) && defined(CONFIG_SYS_MALLOC_TRIM_THRESHOLD)
+#define DEFAULT_TRIM_THRESHOLD CONFIG_SYS_MALLOC_TRIM_THRESHOLD
+#endif
 #ifndef DEFAULT_TRIM_THRESHOLD
-#define DEFAULT_TRIM_THRESHOLD (128 * 1024)
+#define DEFAULT_TRIM_THRESHOLD ((unsigned long)-1)
 #endif
 
 /*
@@ -930,6 +940,42 @@ struct mallinfo mALLINFo();
 #endif	/* 0 */			/* Moved to malloc.h */
 
 #include <malloc.h>
+
+#ifdef CONFIG_CPU_JOB
+/*
+  With a second core running boot jobs (see cpu_job.h) the public
+  routines take malloc_lock and call the ones below, which are the
+  routines of this file under other names.  Calls between them, such
+  as memalign() into malloc(), do not take the lock again.
+*/
+#include <cpu_job.h>
+
+#undef mALLOc
+#undef fREe
+#undef rEALLOc
+#undef mEMALIGn
+#undef vALLOc
+#undef pvALLOc
+#undef cALLOc
+#define mALLOc		malloc_unlocked
+#define fREe		free_unlocked
+#define rEALLOc		realloc_unlocked
+#define mEMALIGn	memalign_unlocked
+#define vALLOc		valloc_unlocked
+#define pvALLOc		pvalloc_unlocked
+#define cALLOc		calloc_unlocked
+
+static Void_t* mALLOc(size_t);
+static void    fREe(Void_t*);
+static Void_t* rEALLOc(Void_t*, size_t);
+static Void_t* mEMALIGn(size_t, size_t);
+static Void_t* vALLOc(size_t);
+static Void_t* pvALLOc(size_t);
+static Void_t* cALLOc(size_t, size_t);
+
+static struct cpu_job_lock malloc_lock = CPU_JOB_LOCK_INIT;
+#endif	/* CONFIG_CPU_JOB */
+
 #ifdef DEBUG
 #if __STD_C
 static void malloc_update_mallinfo (void);
@@ -1613,6 +1659,11 @@ static unsigned long max_total_mem = 0;
 /* internal working copy of mallinfo */
 static struct mallinfo current_mallinfo = {  0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
+#ifdef CONFIG_SYS_MALLOC_STATS
+/* call counts and time spent, see malloc_get_stats() */
+static struct malloc_stats_info malloc_counters;
+#endif
+
 /* The total memory obtained from system via sbrk */
 #define sbrked_mem  (current_mallinfo.arena)
 
@@ -2152,7 +2203,29 @@ static void malloc_extend_top(nb) INTERNAL_SIZE_T nb;
 
 */
 
-#if __STD_C
+#ifdef CONFIG_SYS_MALLOC_STATS
+static Void_t* malloc_body(size_t bytes);
+
+Void_t* mALLOc(size_t bytes)
+{
+  ulong start;
+  Void_t* mem;
+
+  /* not initialized yet */
+  if ((mem_malloc_start == 0) && (mem_malloc_end == 0))
+    return NULL;
+
+  start = timer_get_us();
+  mem = malloc_body(bytes);
+  malloc_counters.mallocs++;
+  if (!mem && bytes)
+    malloc_counters.failures++;
+  malloc_counters.malloc_us += timer_get_us() - start;
+  return mem;
+}
+
+static Void_t* malloc_body(size_t bytes)
+#elif __STD_C
 Void_t* mALLOc(size_t bytes)
 #else
 Void_t* mALLOc(bytes) size_t bytes;
@@ -2183,6 +2256,7 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   nb = request2size(bytes);  /* padded request size; */
 
+retry:
   /* Check for exact match in a bin */
 
   if (is_small_request(nb))  /* Faster version for small requests */
@@ -2382,7 +2456,12 @@ Void_t* mALLOc(bytes) size_t bytes;
     /* Try to extend */
     malloc_extend_top(nb);
     if ( (remainder_size = chunksize(top) - nb) < (long)MINSIZE)
+    {
+      /* U-Boot: give the idle malloc_pool() buffers back and try again */
+      if (malloc_pool_release())
+	goto retry;
       return NULL; /* propagate failure */
+    }
   }
 
   victim = top;
@@ -2419,7 +2498,24 @@ Void_t* mALLOc(bytes) size_t bytes;
 */
 
 
-#if __STD_C
+#ifdef CONFIG_SYS_MALLOC_STATS
+static void free_body(Void_t* mem);
+
+void fREe(Void_t* mem)
+{
+  ulong start;
+
+  if (mem == NULL)
+    return;
+
+  start = timer_get_us();
+  free_body(mem);
+  malloc_counters.frees++;
+  malloc_counters.free_us += timer_get_us() - start;
+}
+
+static void free_body(Void_t* mem)
+#elif __STD_C
 void fREe(Void_t* mem)
 #else
 void fREe(mem) Void_t* mem;
@@ -2974,6 +3070,83 @@ void cfree(mem) Void_t *mem;
 }
 #endif
 
+#ifdef CONFIG_CPU_JOB
+#undef mALLOc
+#undef fREe
+#undef rEALLOc
+#undef mEMALIGn
+#undef vALLOc
+#undef pvALLOc
+#undef cALLOc
+
+Void_t* malloc(size_t bytes)
+{
+  Void_t* mem;
+
+  cpu_job_lock(&malloc_lock);
+  mem = malloc_unlocked(bytes);
+  cpu_job_unlock(&malloc_lock);
+  return mem;
+}
+
+void free(Void_t* mem)
+{
+  cpu_job_lock(&malloc_lock);
+  free_unlocked(mem);
+  cpu_job_unlock(&malloc_lock);
+}
+
+Void_t* realloc(Void_t* oldmem, size_t bytes)
+{
+  Void_t* mem;
+
+  cpu_job_lock(&malloc_lock);
+  mem = realloc_unlocked(oldmem, bytes);
+  cpu_job_unlock(&malloc_lock);
+  return mem;
+}
+
+Void_t* memalign(size_t alignment, size_t bytes)
+{
+  Void_t* mem;
+
+  cpu_job_lock(&malloc_lock);
+  mem = memalign_unlocked(alignment, bytes);
+  cpu_job_unlock(&malloc_lock);
+  return mem;
+}
+
+Void_t* valloc(size_t bytes)
+{
+  Void_t* mem;
+
+  cpu_job_lock(&malloc_lock);
+  mem = valloc_unlocked(bytes);
+  cpu_job_unlock(&malloc_lock);
+  return mem;
+}
+
+Void_t* pvalloc(size_t bytes)
+{
+  Void_t* mem;
+
+  cpu_job_lock(&malloc_lock);
+  mem = pvalloc_unlocked(bytes);
+  cpu_job_unlock(&malloc_lock);
+  return mem;
+}
+
+Void_t* calloc(size_t n, size_t elem_size)
+{
+  Void_t* mem;
+
+  cpu_job_lock(&malloc_lock);
+  mem = calloc_unlocked(n, elem_size);
+  cpu_job_unlock(&malloc_lock);
+  return mem;
+}
+#endif	/* CONFIG_CPU_JOB */
+
 
 
 /*
@@ -3181,6 +3354,57 @@ struct mallinfo mALLINFo()
 }
 #endif	/* DEBUG */
 
+/*
+  malloc_get_stats fills in the heap usage, walking the bins for the
+  free space, and the counters kept by malloc() and free().
+*/
+
+#ifdef CONFIG_SYS_MALLOC_STATS
+void malloc_get_stats(struct malloc_stats_info *info)
+{
+  int i;
+  mbinptr b;
+  mchunkptr p;
+  INTERNAL_SIZE_T sz;
+
+#ifdef CONFIG_CPU_JOB
+  cpu_job_lock(&malloc_lock);
+#endif
+  *info = malloc_counters;
+  info->heap_size = mem_malloc_end - mem_malloc_start;
+  info->heap_top = sbrked_mem;
+  info->heap_peak = max_sbrked_mem;
+
+  info->free = info->largest_free = chunksize(top);
+  info->free_chunks = 0;
+  for (i = 1; i < NAV; ++i)
+  {
+    b = bin_at(i);
+    for (p = last(b); p != b; p = p->bk)
+    {
+      sz = chunksize(p);
+      info->free += sz;
+      info->free_chunks++;
+      if (sz > info->largest_free)
+	info->largest_free = sz;
+    }
+  }
+  info->in_use = sbrked_mem - info->free;
+  /* what is past brk is free too, and contiguous with top */
+  info->free += mem_malloc_end - mem_malloc_brk;
+  if (chunksize(top) + mem_malloc_end - mem_malloc_brk > info->largest_free)
+    info->largest_free = chunksize(top) + mem_malloc_end - mem_malloc_brk;
+#ifdef CONFIG_CPU_JOB
+  cpu_job_unlock(&malloc_lock);
+#endif
+}
+
+void malloc_clear_stats(void)
+{
+  memset(&malloc_counters, 0, sizeof(malloc_counters));
+}
+#endif	/* CONFIG_SYS_MALLOC_STATS */
+
 
 
 
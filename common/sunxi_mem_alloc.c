@@ -22,6 +22,8 @@
  * MA 02111-1307 USA
  */
 #include <common.h>
+#include <malloc.h>
+#include <cpu_job.h>
 
 struct alloc_struct_t
 {
@@ -147,3 +149,199 @@ void  free_noncache(void *p)
 
     return ;
 }
+
+/*
+ * 大块的临时IO缓冲区(烧写、校验、解包等)。dlmalloc每次释放都要合并空闲块，
+ * 反复申请释放几MB的缓冲区代价较大，这里把释放的缓冲区留下来给下一次申请用，
+ * 不再还给dlmalloc，除非调用malloc_pool_release()或者堆空间不够。
+ */
+#define SUNXI_POOL_SLABS               32
+#define SUNXI_POOL_ALIGN(x)            ( ( (x) + 0xffff) & ~0xffff)         /* alloc based on 64k byte */
+
+struct pool_slab_t
+{
+    void  *buf;                         //缓冲区地址，NULL表示空表项
+    uint   size;                        //缓冲区大小
+    uint   busy;                        //是否已分配给用户
+};
+
+static struct pool_slab_t pool_slab[SUNXI_POOL_SLABS];
+static struct malloc_pool_info pool_info;
+static struct cpu_job_lock pool_lock = CPU_JOB_LOCK_INIT;     /* 副核跑初始化任务时用 */
+/*
+*********************************************************************************************************
+*                       MALLOC BUFFER FROM POOL
+*
+* Description: malloc a cache line aligned buffer for dma, reuse a released one if it is big enough.
+*
+* Aguments   : num_bytes    the size of the buffer need malloc;
+*
+* Returns    : the pointer to buffer, NULL if no memory.
+*********************************************************************************************************
+*/
+static void *pool_reuse(uint size)
+{
+    struct pool_slab_t *slab, *best = NULL;
+    int    i;
+
+    for (i = 0, slab = pool_slab; i < SUNXI_POOL_SLABS; i++, slab++)
+    {
+        if (slab->buf && !slab->busy && slab->size >= size)
+        {
+            if (!best || slab->size < best->size)   /* 够用的里面最小的一个 */
+                best = slab;
+        }
+    }
+
+    if (!best)
+        return NULL;
+
+    best->busy = 1;
+    pool_info.busy++;
+    pool_info.reused++;
+
+    return best->buf;
+}
+
+static void pool_add(void *buf, uint size)
+{
+    struct pool_slab_t *slab;
+    int    i;
+
+    for (i = 0, slab = pool_slab; i < SUNXI_POOL_SLABS; i++, slab++)
+    {
+        if (!slab->buf)
+            break;
+    }
+
+    if (i == SUNXI_POOL_SLABS)
+    {
+        /* 表满了，这块释放时直接还给dlmalloc */
+        pool_info.untracked++;
+
+        return;
+    }
+
+    slab->buf  = buf;
+    slab->size = size;
+    slab->busy = 1;
+    pool_info.slabs++;
+    pool_info.busy++;
+    pool_info.allocated++;
+    pool_info.bytes += size;
+    if (pool_info.bytes > pool_info.peak)
+        pool_info.peak = pool_info.bytes;
+}
+
+void *malloc_pool(uint num_bytes)
+{
+    uint   size;
+    void  *buf;
+
+    if (!num_bytes) return NULL;
+
+    size = SUNXI_POOL_ALIGN(num_bytes);
+    cpu_job_lock(&pool_lock);
+    buf = pool_reuse(size);
+    cpu_job_unlock(&pool_lock);
+    if (buf)
+        return buf;
+
+    /*
+     * 不持有pool_lock调用memalign：堆不够时malloc会自己调用malloc_pool_release()，
+     * 把空闲的缓冲区还回去合并后再试，两把锁总是先malloc_lock后pool_lock
+     */
+    buf = memalign(ARCH_DMA_MINALIGN, size);
+    if (!buf)
+        return NULL;
+
+    cpu_job_lock(&pool_lock);
+    pool_add(buf, size);
+    cpu_job_unlock(&pool_lock);
+
+    return buf;
+}
+/*
+*********************************************************************************************************
+*                       FREE BUFFER TO POOL
+*
+* Description: give a buffer from malloc_pool() back, it is kept for the next malloc_pool().
+*
+* Aguments   : p    the pointer to the buffer which need be free.
+*
+* Returns    : none
+*********************************************************************************************************
+*/
+void free_pool(void *p)
+{
+    struct pool_slab_t *slab;
+    int    i;
+
+    if (p == NULL)
+        return;
+
+    cpu_job_lock(&pool_lock);
+    for (i = 0, slab = pool_slab; i < SUNXI_POOL_SLABS; i++, slab++)
+    {
+        if (slab->buf == p)
+        {
+            if (slab->busy)
+            {
+                slab->busy = 0;
+                pool_info.busy--;
+            }
+            cpu_job_unlock(&pool_lock);
+
+            return;
+        }
+    }
+    cpu_job_unlock(&pool_lock);
+
+    free(p);                    /* 不在表里，是表满时直接申请的 */
+}
+/*
+*********************************************************************************************************
+*                       RELEASE POOL
+*
+* Description: give the idle buffers of the pool back to dlmalloc, malloc() calls it when the heap is
+*              out of memory.
+*
+* Aguments   : none
+*
+* Returns    : the bytes given back.
+*********************************************************************************************************
+*/
+ulong malloc_pool_release(void)
+{
+    struct pool_slab_t *slab;
+    void  *idle[SUNXI_POOL_SLABS];
+    ulong  bytes = 0;
+    int    i, count = 0;
+
+    cpu_job_lock(&pool_lock);
+    for (i = 0, slab = pool_slab; i < SUNXI_POOL_SLABS; i++, slab++)
+    {
+        if (slab->buf && !slab->busy)
+        {
+            idle[count++] = slab->buf;
+            bytes += slab->size;
+            pool_info.slabs--;
+            pool_info.bytes -= slab->size;
+            slab->buf  = NULL;
+            slab->size = 0;
+        }
+    }
+    cpu_job_unlock(&pool_lock);
+
+    for (i = 0; i < count; i++)
+        free(idle[i]);
+
+    return bytes;
+}
+
+void malloc_pool_get_info(struct malloc_pool_info *info)
+{
+    cpu_job_lock(&pool_lock);
+    *info = pool_info;
+    cpu_job_unlock(&pool_lock);
+}
@@ -0,0 +1,288 @@
+/*
+ * Block device read cache
+ *
+ * Small, set associative cache of device blocks sitting under the
+ * filesystem and partition code (see block_dread()).  Only short reads
+ * are cached, which keeps out file data and keeps superblocks, group
+ * descriptors, inodes, FAT and directory blocks.  Writes are never
+ * cached: block_dwrite() and the drivers drop the lines of a device
+ * before they change it.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <part.h>
+#include <asm/errno.h>
+
+#ifndef CONFIG_BLOCK_CACHE_SETS
+#define CONFIG_BLOCK_CACHE_SETS		64
+#endif
+#ifndef CONFIG_BLOCK_CACHE_WAYS
+#define CONFIG_BLOCK_CACHE_WAYS		4
+#endif
+/* reads longer than this many blocks bypass the cache */
+#ifndef CONFIG_BLOCK_CACHE_MAX_READ
+#define CONFIG_BLOCK_CACHE_MAX_READ	8
+#endif
+/* blocks read ahead when a read continues the previous one */
+#ifndef CONFIG_BLOCK_CACHE_READAHEAD
+#define CONFIG_BLOCK_CACHE_READAHEAD	8
+#endif
+
+struct blkcache_line {
+	int		if_type;
+	int		dev;
+	lbaint_t	blknr;
+	unsigned long	stamp;		/* last use, 0 when the line is empty */
+	char		*data;
+};
+
+static struct blkcache {
+	struct blkcache_line	*lines;		/* sets * ways */
+	char			*data;
+	char			*stage;		/* max_read + window blocks */
+	unsigned long		blksz;		/* 0 until the lines are set up */
+	unsigned long		clock;
+	unsigned int		sets;
+	unsigned int		ways;
+	unsigned int		max_read;
+	unsigned int		window;
+	/* end of the last cached read, to spot sequential access */
+	int			last_if_type;
+	int			last_dev;
+	lbaint_t		last_end;
+	struct block_cache_stats stats;
+} blkcache = {
+	.sets		= CONFIG_BLOCK_CACHE_SETS,
+	.ways		= CONFIG_BLOCK_CACHE_WAYS,
+	.max_read	= CONFIG_BLOCK_CACHE_MAX_READ,
+	.window		= CONFIG_BLOCK_CACHE_READAHEAD,
+	.last_if_type	= -1,
+};
+
+static void blkcache_free(void)
+{
+	free(blkcache.lines);
+	free(blkcache.data);
+	free(blkcache.stage);
+	blkcache.lines = NULL;
+	blkcache.data = NULL;
+	blkcache.stage = NULL;
+	blkcache.blksz = 0;
+	blkcache.last_if_type = -1;
+}
+
+/* size the lines for blksz, 0 when the cache can be used */
+static int blkcache_setup(unsigned long blksz)
+{
+	unsigned int nlines = blkcache.sets * blkcache.ways;
+	unsigned int i;
+
+	if (blksz == blkcache.blksz)
+		return 0;
+
+	/* one block size at a time, a device with another one starts over */
+	blkcache_free();
+	if (!nlines || !blksz)
+		return -EINVAL;
+
+	blkcache.lines = calloc(nlines, sizeof(struct blkcache_line));
+	blkcache.data = memalign(ARCH_DMA_MINALIGN, nlines * blksz);
+	blkcache.stage = memalign(ARCH_DMA_MINALIGN,
+				  (blkcache.max_read + blkcache.window) *
+				  blksz);
+	if (!blkcache.lines || !blkcache.data || !blkcache.stage) {
+		printf("blkcache: out of memory\n");
+		blkcache_free();
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < nlines; i++)
+		blkcache.lines[i].data = blkcache.data + i * blksz;
+	blkcache.blksz = blksz;
+
+	return 0;
+}
+
+static struct blkcache_line *blkcache_set(int if_type, int dev,
+					  lbaint_t blknr)
+{
+	unsigned int set;
+
+	/* consecutive blocks land in consecutive sets */
+	set = ((unsigned int)blknr ^ (dev << 4) ^ (if_type << 8)) &
+		(blkcache.sets - 1);
+
+	return &blkcache.lines[set * blkcache.ways];
+}
+
+static struct blkcache_line *blkcache_find(int if_type, int dev,
+					   lbaint_t blknr)
+{
+	struct blkcache_line *line = blkcache_set(if_type, dev, blknr);
+	unsigned int way;
+
+	for (way = 0; way < blkcache.ways; way++, line++) {
+		if (line->stamp && line->blknr == blknr &&
+		    line->dev == dev && line->if_type == if_type)
+			return line;
+	}
+
+	return NULL;
+}
+
+static void blkcache_insert(int if_type, int dev, lbaint_t blknr,
+			    const void *data)
+{
+	struct blkcache_line *line = blkcache_find(if_type, dev, blknr);
+	struct blkcache_line *victim;
+	unsigned int way;
+
+	if (!line) {
+		/* an empty way, otherwise the least recently used one */
+		victim = line = blkcache_set(if_type, dev, blknr);
+		for (way = 0; way < blkcache.ways; way++, line++) {
+			if (line->stamp < victim->stamp)
+				victim = line;
+		}
+		line = victim;
+		line->if_type = if_type;
+		line->dev = dev;
+		line->blknr = blknr;
+	}
+
+	memcpy(line->data, data, blkcache.blksz);
+	line->stamp = ++blkcache.clock;
+}
+
+unsigned long blkcache_read(block_dev_desc_t *dev_desc, lbaint_t start,
+			    lbaint_t blkcnt, void *buffer)
+{
+	struct blkcache_line *line;
+	unsigned long blksz = dev_desc->blksz;
+	int if_type = dev_desc->if_type;
+	int dev = dev_desc->dev;
+	char *dst = buffer;
+	lbaint_t i, miss, ahead = 0;
+	unsigned long n;
+
+	if (!blkcnt || blkcnt > blkcache.max_read || blkcache_setup(blksz)) {
+		blkcache.stats.bypass += blkcnt;
+		return dev_desc->block_read(dev, start, blkcnt, buffer);
+	}
+
+	/* leading blocks already in the cache */
+	for (i = 0; i < blkcnt; i++, dst += blksz) {
+		line = blkcache_find(if_type, dev, start + i);
+		if (!line)
+			break;
+		memcpy(dst, line->data, blksz);
+		line->stamp = ++blkcache.clock;
+	}
+	blkcache.stats.hits += i;
+
+	if (i < blkcnt) {
+		miss = blkcnt - i;
+
+		/* the read carries on where the last one stopped */
+		if (if_type == blkcache.last_if_type &&
+		    dev == blkcache.last_dev && start == blkcache.last_end &&
+		    dev_desc->lba > start + blkcnt)
+			ahead = min(dev_desc->lba - (start + blkcnt),
+				    (lbaint_t)blkcache.window);
+
+		n = dev_desc->block_read(dev, start + i, miss + ahead,
+					 blkcache.stage);
+		if (n != miss + ahead && ahead) {
+			/* may have run into a bad area, try without */
+			ahead = 0;
+			n = dev_desc->block_read(dev, start + i, miss,
+						 blkcache.stage);
+		}
+		if (n != miss + ahead)
+			return 0;
+
+		for (n = 0; n < miss + ahead; n++)
+			blkcache_insert(if_type, dev, start + i + n,
+					blkcache.stage + n * blksz);
+		memcpy(dst, blkcache.stage, miss * blksz);
+
+		blkcache.stats.misses += miss;
+		blkcache.stats.readahead += ahead;
+	}
+
+	blkcache.last_if_type = if_type;
+	blkcache.last_dev = dev;
+	blkcache.last_end = start + blkcnt;
+
+	return blkcnt;
+}
+
+static void blkcache_drop(int if_type, int dev)
+{
+	unsigned int i, nlines = blkcache.sets * blkcache.ways;
+	struct blkcache_line *line = blkcache.lines;
+
+	for (i = 0; i < nlines; i++, line++) {
+		if (line->stamp && line->if_type == if_type &&
+		    (dev < 0 || line->dev == dev))
+			line->stamp = 0;
+	}
+	if (blkcache.last_if_type == if_type)
+		blkcache.last_if_type = -1;
+}
+
+/* drop the cached blocks of a device, of all devices of if_type if dev < 0 */
+void blkcache_invalidate(int if_type, int dev)
+{
+	if (!blkcache.blksz)
+		return;
+
+	blkcache_drop(if_type, dev);
+	/*
+	 * The sunxi_flash device is the boot card (or the nand) seen through
+	 * another driver, so a change on one side drops the other as well.
+	 */
+	if (if_type == IF_TYPE_MMC)
+		blkcache_drop(IF_TYPE_SUNXI_FLASH, -1);
+	else if (if_type == IF_TYPE_SUNXI_FLASH)
+		blkcache_drop(IF_TYPE_MMC, -1);
+
+	blkcache.stats.invalidations++;
+}
+
+/*
+ * Change the geometry; sets must be a power of two, 0 sets turns the
+ * cache off.  The contents are dropped.
+ */
+int blkcache_configure(unsigned int sets, unsigned int ways,
+		       unsigned int max_read, unsigned int window)
+{
+	if ((sets & (sets - 1)) || (sets && (!ways || !max_read)))
+		return -EINVAL;
+
+	blkcache_free();
+	blkcache.sets = sets;
+	blkcache.ways = ways;
+	blkcache.max_read = max_read;
+	blkcache.window = window;
+
+	return 0;
+}
+
+void blkcache_get_stats(struct block_cache_stats *stats)
+{
+	*stats = blkcache.stats;
+	stats->sets = blkcache.sets;
+	stats->ways = blkcache.ways;
+	stats->max_read = blkcache.max_read;
+	stats->window = blkcache.window;
+	stats->blksz = blkcache.blksz;
+}
+
+void blkcache_clear_stats(void)
+{
+	memset(&blkcache.stats, 0, sizeof(blkcache.stats));
+}
@@ -29,6 +29,7 @@
 #include <asm/arch/ccmu.h>
 #include <asm/io.h>
 #include <asm/arch/clock.h>
+#include <cpu_job.h>
 
 #define SUNXI_DMA_MAX     16
 
@@ -92,6 +93,7 @@ sunxi_dma_source;
 
 static int    dma_int_count = 0;
 static sunxi_dma_source   dma_channal_source[SUNXI_DMA_MAX];
+static struct cpu_job_lock dma_channal_lock = CPU_JOB_LOCK_INIT;     /* flashʼʱҲͨ */
 
 extern void *malloc_noncache(uint num_bytes);
 
@@ -267,16 +269,19 @@ ulong sunxi_dma_request(uint dmatype)
 {
     int   i;
 
+	cpu_job_lock(&dma_channal_lock);
 	for(i=0;i<SUNXI_DMA_MAX;i++)
     {
         if(dma_channal_source[i].used == 0)
         {
             dma_channal_source[i].used = 1;
             dma_channal_source[i].channal_count = i;
+            cpu_job_unlock(&dma_channal_lock);
 
             return (ulong)&dma_channal_source[i];
         }
     }
+	cpu_job_unlock(&dma_channal_lock);
 
     return 0;
 }
@@ -308,7 +313,9 @@ int sunxi_dma_release(ulong hdma)
 	sunxi_dma_free_int(hdma);
 
 	dma_channal->channal->enable = 0;
+	cpu_job_lock(&dma_channal_lock);
 	dma_channal->used   = 0;
+	cpu_job_unlock(&dma_channal_lock);
 
     return 0;
 }
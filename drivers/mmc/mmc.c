@@ -71,10 +71,16 @@ int board_mmc_getcd(struct mmc *mmc)__attribute__((weak,
 int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
 	int ret;
-
 #ifdef CONFIG_MMC_TRACE
 	int i;
 	u8 *ptr;
+#endif
+
+	/* collect a background read before the host is used for anything else */
+	if (mmc->async_busy)
+		mmc_async_wait(mmc->block_dev.dev);
+
+#ifdef CONFIG_MMC_TRACE
 
 	MMCDBG("CMD_SEND:%d\n", cmd->cmdidx);
 	MMCDBG("\t\tARG\t\t\t 0x%08X\n", cmd->cmdarg);
@@ -332,6 +338,279 @@ ulong mmc_bread(int dev_num, lbaint_t start, lbaint_t blkcnt, void *dst)
 	return blkcnt;
 }
 
+/*
+ * one command over the pieces of a scatter-gather list, blkcnt is their
+ * total and must fit the host (b_max, MMC_SG_MAX)
+ */
+static ulong mmc_sg_blocks(struct mmc *mmc, lbaint_t start,
+			const struct mmc_sg *sg, lbaint_t blkcnt, int write)
+{
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+	uint bl_len = write ? mmc->write_bl_len : mmc->read_bl_len;
+
+	if (blkcnt > 1)
+		cmd.cmdidx = write ? MMC_CMD_WRITE_MULTIPLE_BLOCK
+				: MMC_CMD_READ_MULTIPLE_BLOCK;
+	else
+		cmd.cmdidx = write ? MMC_CMD_WRITE_SINGLE_BLOCK
+				: MMC_CMD_READ_SINGLE_BLOCK;
+
+	if (mmc->high_capacity)
+		cmd.cmdarg = start;
+	else
+		cmd.cmdarg = start * bl_len;
+
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.flags = 0;
+
+	data.sg = sg;
+	data.blocks = blkcnt;
+	data.blocksize = bl_len;
+	data.flags = (write ? MMC_DATA_WRITE : MMC_DATA_READ) | MMC_DATA_SG;
+
+	if (mmc_send_cmd(mmc, &cmd, &data)) {
+		MMCMSG(mmc, "sg %s failed, %s %d\n", write ? "write" : "read",
+			__FUNCTION__, __LINE__);
+		return 0;
+	}
+	if (blkcnt > 1) {
+		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		cmd.cmdarg = 0;
+		cmd.resp_type = MMC_RSP_R1b;
+		cmd.flags = 0;
+		if (mmc_send_cmd(mmc, &cmd, NULL)) {
+			MMCINFO("mmc fail to send stop cmd\n");
+			return 0;
+		}
+	}
+	if (mmc_send_status(mmc, 1000) && write)
+		return 0;
+
+	return blkcnt;
+}
+
+/*
+ * move consecutive blocks from/to a list of buffers. hosts with MMC_MODE_SG
+ * get as many pieces per command as b_max and MMC_SG_MAX allow, other hosts
+ * one request per piece. returns the number of blocks moved
+ */
+static ulong mmc_sg_xfer(int dev_num, lbaint_t start, const struct mmc_sg *sg,
+			uint sg_len, int write)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+	lbaint_t total = 0, done = 0, blocks, ret;
+	uint i, cnt;
+
+	if (!mmc) {
+		MMCINFO("Can not find mmc dev\n");
+		return 0;
+	}
+
+	for (i = 0; i < sg_len; i++)
+		total += sg[i].blocks;
+	if ((start + total) > mmc->block_dev.lba) {
+		MMCINFO("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
+			start + total, mmc->block_dev.lba);
+		return 0;
+	}
+	if (write)
+		block_dev_invalidate(IF_TYPE_MMC, dev_num);
+
+	if (mmc->cfg->host_caps & MMC_MODE_SG) {
+		if (mmc_set_blocklen(mmc, write ? mmc->write_bl_len : mmc->read_bl_len)) {
+			MMCMSG(mmc, "Set block len failed\n");
+			return 0;
+		}
+	}
+
+	i = 0;
+	while (i < sg_len) {
+		cnt = 0;
+		blocks = 0;
+		if (mmc->cfg->host_caps & MMC_MODE_SG) {
+			while ((i + cnt < sg_len) && (cnt < MMC_SG_MAX)
+				&& (blocks + sg[i + cnt].blocks <= mmc->cfg->b_max))
+				blocks += sg[i + cnt++].blocks;
+		}
+
+		if (blocks) {
+			ret = mmc_sg_blocks(mmc, start, &sg[i], blocks, write);
+		} else {
+			/* no sg on this host, or one piece over b_max */
+			cnt = 1;
+			blocks = sg[i].blocks;
+			if (!blocks)
+				ret = 0;
+			else if (write)
+				ret = mmc_bwrite(dev_num, start, blocks, sg[i].buf);
+			else
+				ret = mmc_bread(dev_num, start, blocks, sg[i].buf);
+		}
+		if (ret != blocks)
+			break;
+
+		done += blocks;
+		start += blocks;
+		i += cnt;
+	}
+
+	return done;
+}
+
+ulong mmc_bread_sg(int dev_num, lbaint_t start, const struct mmc_sg *sg, uint sg_len)
+{
+	return mmc_sg_xfer(dev_num, start, sg, sg_len, 0);
+}
+
+ulong mmc_bwrite_sg(int dev_num, lbaint_t start, const struct mmc_sg *sg, uint sg_len)
+{
+	return mmc_sg_xfer(dev_num, start, sg, sg_len, 1);
+}
+
+/*
+ * issue a multiple block command whose data phase runs in the background
+ * on the host dma, the caller may drive other devices until
+ * mmc_async_wait() collects it. hosts without send_cmd_start and requests
+ * the host can not take in one go are done at once.
+ */
+static int mmc_async_start(int dev_num, lbaint_t start, lbaint_t blkcnt,
+				void *buf, int write)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+	struct mmc_cmd *cmd;
+	struct mmc_data *data;
+	uint bl_len;
+
+	if (!mmc) {
+		MMCINFO("Can not find mmc dev\n");
+		return -1;
+	}
+	if (mmc->async_busy)
+		mmc_async_wait(dev_num);
+	if (write)
+		block_dev_invalidate(IF_TYPE_MMC, dev_num);
+
+	if (!mmc->cfg->ops->send_cmd_start || (blkcnt < 2)
+		|| (blkcnt > mmc->cfg->b_max)) {
+		if (write)
+			mmc->async_result = mmc_bwrite(dev_num, start, blkcnt, buf);
+		else
+			mmc->async_result = mmc_bread(dev_num, start, blkcnt, buf);
+		return (mmc->async_result == blkcnt) ? 0 : -1;
+	}
+
+	mmc->async_result = 0;
+	if ((start + blkcnt) > mmc->block_dev.lba) {
+		MMCINFO("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
+			start + blkcnt, mmc->block_dev.lba);
+		return -1;
+	}
+	bl_len = write ? mmc->write_bl_len : mmc->read_bl_len;
+	if (mmc_set_blocklen(mmc, bl_len)) {
+		MMCMSG(mmc, "Set block len failed\n");
+		return -1;
+	}
+
+	cmd = &mmc->async_cmd;
+	data = &mmc->async_data;
+
+	cmd->cmdidx = write ? MMC_CMD_WRITE_MULTIPLE_BLOCK
+			: MMC_CMD_READ_MULTIPLE_BLOCK;
+	if (mmc->high_capacity)
+		cmd->cmdarg = start;
+	else
+		cmd->cmdarg = start * bl_len;
+	cmd->resp_type = MMC_RSP_R1;
+	cmd->flags = 0;
+
+	if (write) {
+		data->src = buf;
+		data->flags = MMC_DATA_WRITE;
+	} else {
+		data->dest = buf;
+		data->flags = MMC_DATA_READ;
+	}
+	data->blocks = blkcnt;
+	data->blocksize = bl_len;
+
+	if (mmc->cfg->ops->send_cmd_start(mmc, cmd, data)) {
+		MMCMSG(mmc, "%s block failed, %s %d\n", write ? "write" : "read",
+			__FUNCTION__, __LINE__);
+		return -1;
+	}
+	mmc->async_busy = 1;
+
+	return 0;
+}
+
+int mmc_bread_start(int dev_num, lbaint_t start, lbaint_t blkcnt, void *dst)
+{
+	return mmc_async_start(dev_num, start, blkcnt, dst, 0);
+}
+
+int mmc_bwrite_start(int dev_num, lbaint_t start, lbaint_t blkcnt, const void *src)
+{
+	return mmc_async_start(dev_num, start, blkcnt, (void *)src, 1);
+}
+
+/*
+ * poll the transfer started by mmc_bread_start()/mmc_bwrite_start(),
+ * returns 1 once mmc_async_wait() would not have to wait for the data phase
+ */
+int mmc_async_done(int dev_num)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+
+	if (!mmc || !mmc->async_busy)
+		return 1;
+	if (!mmc->cfg->ops->send_cmd_done)
+		return 0;
+
+	return mmc->cfg->ops->send_cmd_done(mmc, &mmc->async_cmd, &mmc->async_data);
+}
+
+/*
+ * finish the transfer started by mmc_bread_start()/mmc_bwrite_start(),
+ * returns the number of blocks moved like mmc_bread()/mmc_bwrite()
+ */
+ulong mmc_async_wait(int dev_num)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+	struct mmc_cmd cmd;
+	ulong blkcnt;
+
+	if (!mmc)
+		return 0;
+	if (!mmc->async_busy)
+		return mmc->async_result;
+
+	mmc->async_busy = 0;
+	blkcnt = mmc->async_data.blocks;
+	if (mmc->cfg->ops->send_cmd_wait(mmc, &mmc->async_cmd, &mmc->async_data)) {
+		MMCMSG(mmc, "block %s failed, %s %d\n",
+			(mmc->async_data.flags & MMC_DATA_WRITE) ? "write" : "read",
+			__FUNCTION__, __LINE__);
+		return 0;
+	}
+
+	cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+	cmd.cmdarg = 0;
+	cmd.resp_type = MMC_RSP_R1b;
+	cmd.flags = 0;
+	if (mmc_send_cmd(mmc, &cmd, NULL)) {
+		MMCINFO("mmc fail to send stop cmd\n");
+		return 0;
+	}
+	/* a write is only done once the card has left the programming state */
+	if (mmc_send_status(mmc, 1000))
+		return 0;
+
+	mmc->async_result = blkcnt;
+
+	return blkcnt;
+}
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -639,6 +918,10 @@ int mmc_decode_ext_csd(struct mmc *mmc,
 
 	/* eMMC v4.5 or later */
 	if (dec_ext_csd->rev >= 6) {
+		dec_ext_csd->max_packed_writes =
+			ext_csd[EXT_CSD_MAX_PACKED_WRITES];
+		dec_ext_csd->max_packed_reads =
+			ext_csd[EXT_CSD_MAX_PACKED_READS];
 		dec_ext_csd->generic_cmd6_time = 10 *
 			ext_csd[EXT_CSD_GENERIC_CMD6_TIME];
 		dec_ext_csd->power_off_longtime = 10 *
@@ -1475,6 +1758,8 @@ int mmc_switch_part(int dev_num, unsigned int part_num)
 		MMCINFO("can not find mmc device\n");
 		return -1;
 	}
+	/* the same block numbers now address another hardware partition */
+	block_dev_invalidate(IF_TYPE_MMC, dev_num);
 
 	part_config = (mmc->part_config & ~PART_ACCESS_MASK)
 			  					| (part_num & PART_ACCESS_MASK);
@@ -2559,6 +2844,23 @@ __ERROR_END:
 	return ;
 }
 
+/*
+ * While the card is brought up on the second core, the boot cpu reads
+ * the FDT, so the tuning results are only written into it once the
+ * boot cpu ends the deferral.
+ */
+static int mmc_fdt_defer;
+static struct mmc *mmc_fdt_pending;
+
+void mmc_defer_fdt_update(int defer)
+{
+	mmc_fdt_defer = defer;
+	if (!defer && mmc_fdt_pending) {
+		mmc_update_sdly_to_sysconfig(mmc_fdt_pending);
+		mmc_fdt_pending = NULL;
+	}
+}
+
 static void _mmc_life_time_est(u8 est_val)
 {
 	if (est_val == 0)
@@ -2674,8 +2976,12 @@ int mmc_init_boot(struct mmc *mmc)
 		err = mmc_complete_init(mmc);
 
 	if((work_mode == WORK_MODE_BOOT)
-		&& (mmc->cfg->platform_caps.sample_mode == AUTO_SAMPLE_MODE))
-		mmc_update_sdly_to_sysconfig(mmc);
+		&& (mmc->cfg->platform_caps.sample_mode == AUTO_SAMPLE_MODE)) {
+		if (mmc_fdt_defer)
+			mmc_fdt_pending = mmc;
+		else
+			mmc_update_sdly_to_sysconfig(mmc);
+	}
 
 	/* update some feature */
 	if (mmc->cfg->platform_caps.drv_wipe_feature & DRV_PARA_DISABLE_EMMC_SANITIZE)
@@ -2839,6 +3145,9 @@ int mmc_init(struct mmc *mmc)
 		return 0;
 	}
 
+	/* rescan: the card may have been swapped */
+	block_dev_invalidate(IF_TYPE_MMC, mmc->block_dev.dev);
+
 	start = get_timer(0);
 	MMCDBG("==================== work mode: %d %d, sample_mode:%d\n", \
 		work_mode, WORK_MODE_BOOT, mmc->cfg->platform_caps.sample_mode);
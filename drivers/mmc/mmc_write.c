@@ -187,6 +187,8 @@ int mmc_launch_erase(struct mmc *mmc, unsigned int erase_arg)
 	cmd.cmdarg = erase_arg;
 	cmd.flags = 0;
 
+	block_dev_invalidate(IF_TYPE_MMC, mmc->block_dev.dev);
+
 	return mmc_send_cmd(mmc, &cmd, NULL);
 }
 
@@ -466,8 +468,13 @@ int mmc_erase(struct mmc *mmc, unsigned int from,
 			}
 		}
 
-		MMCINFO("erase from: %d, to: %d, cnt: %d, erase_group: %d\n",
-			from, from+nr-1, nr, mmc->erase_grp_size);
+		/* trim is issued once per sparse fill chunk while flashing */
+		if (erase_arg == MMC_TRIM_ARG)
+			MMCDBG("trim from: %d, to: %d, cnt: %d\n",
+				from, from+nr-1, nr);
+		else
+			MMCINFO("erase from: %d, to: %d, cnt: %d, erase_group: %d\n",
+				from, from+nr-1, nr, mmc->erase_grp_size);
 		ret = mmc_do_erase(mmc, from, from+nr-1, erase_arg);
 		if (ret) {
 			ret = -1;
@@ -998,6 +1005,8 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		return 0;
 	}
 
+	block_dev_invalidate(IF_TYPE_MMC, mmc->block_dev.dev);
+
 	if (blkcnt == 0)
 		return 0;
 	else if (blkcnt == 1)
@@ -1075,6 +1084,116 @@ ulong mmc_bwrite(int dev_num, lbaint_t start, lbaint_t blkcnt, const void *src)
 	return blkcnt;
 }
 
+/*
+ * how many runs one packed write may carry on this card, 0 when packed
+ * commands can not be used (sd card, eMMC before 4.5, host without sg,
+ * 4K native sectors: the header and the counts below are in 512 byte
+ * sectors)
+ */
+int mmc_packed_write_max(int dev_num)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+	ALLOC_CACHE_ALIGN_BUFFER(char, ext_csd, MMC_MAX_BLOCK_LEN);
+	struct mmc_ext_csd mmc_ext_csd;
+
+	if (!mmc || IS_SD(mmc) || !(mmc->cfg->host_caps & MMC_MODE_SG)
+		|| (mmc->write_bl_len != 512))
+		return 0;
+
+	if (mmc_send_ext_csd(mmc, ext_csd)) {
+		MMCINFO("send ext_csd failed\n");
+		return 0;
+	}
+	if (ext_csd[EXT_CSD_DATA_SECTOR_SIZE] & 0x1)
+		return 0;
+	memset(&mmc_ext_csd, 0, sizeof(mmc_ext_csd));
+	if (mmc_decode_ext_csd(mmc, &mmc_ext_csd, ext_csd)
+		|| (mmc_ext_csd.rev < 6) || (mmc_ext_csd.max_packed_writes < 2))
+		return 0;
+
+	/* the header block is one sg piece */
+	return min((int)mmc_ext_csd.max_packed_writes, MMC_SG_MAX - 1);
+}
+
+/*
+ * eMMC 4.5 packed write: @count runs (start[i], run[i]) go out in one
+ * CMD23/CMD25, led by a header block listing each run's address and size.
+ * count must not exceed mmc_packed_write_max(). returns 0 when all runs
+ * are written, the caller may then fall back to plain writes
+ */
+int mmc_bwrite_packed(int dev_num, const lbaint_t *start,
+			const struct mmc_sg *run, uint count)
+{
+	struct mmc *mmc = find_mmc_device(dev_num);
+	ALLOC_CACHE_ALIGN_BUFFER(u32, hdr, MMC_MAX_BLOCK_LEN / 4);
+	struct mmc_sg sg[MMC_SG_MAX];
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+	lbaint_t blocks = 1;
+	uint i;
+
+	if (!mmc || !count || (count > MMC_SG_MAX - 1)
+		|| (mmc->write_bl_len != 512))
+		return -1;
+
+	memset(hdr, 0, MMC_MAX_BLOCK_LEN);
+	hdr[0] = (count << 16) | (2 << 8) | 1;	/* entries, write, version 1 */
+	sg[0].buf = hdr;
+	sg[0].blocks = 1;
+	for (i = 0; i < count; i++) {
+		if ((start[i] + run[i].blocks) > mmc->block_dev.lba)
+			return -1;
+		hdr[(i + 1) * 2] = run[i].blocks;
+		hdr[(i + 1) * 2 + 1] = mmc->high_capacity ? start[i]
+				: start[i] * mmc->write_bl_len;
+		sg[i + 1] = run[i];
+		blocks += run[i].blocks;
+	}
+	if ((blocks > 0xffff) || (blocks > mmc->cfg->b_max))
+		return -1;
+
+	block_dev_invalidate(IF_TYPE_MMC, mmc->block_dev.dev);
+
+	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
+		return -1;
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = (1 << 30) | blocks;	/* packed */
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.flags = 0;
+	if (mmc_send_cmd(mmc, &cmd, NULL)) {
+		MMCINFO("mmc packed cmd23 failed\n");
+		return -1;
+	}
+
+	/* the count is preset, the host must not auto-stop */
+	cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
+	cmd.cmdarg = hdr[3];
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.flags = MMC_CMD_MANUAL;
+
+	data.sg = sg;
+	data.blocks = blocks;
+	data.blocksize = mmc->write_bl_len;
+	data.flags = MMC_DATA_WRITE | MMC_DATA_SG;
+
+	if (mmc_send_cmd(mmc, &cmd, &data)) {
+		MMCINFO("mmc packed write failed\n");
+		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		cmd.cmdarg = 0;
+		cmd.resp_type = MMC_RSP_R1b;
+		cmd.flags = 0;
+		mmc_send_cmd(mmc, &cmd, NULL);
+		mmc_send_status(mmc, 1000);
+		return -1;
+	}
+
+	if (mmc_send_status(mmc, 1000))
+		return -1;
+
+	return 0;
+}
+
 ulong mmc_berase(int dev_num, lbaint_t start, lbaint_t blkcnt)
 {
 	int err = 0;
@@ -832,52 +832,74 @@ static int mmc_trans_data_by_dma(struct mmc *mmc, struct mmc_data *data)
 	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
 	struct mmc_reg_v4p1 *reg = (struct mmc_reg_v4p1 *)mmchost->reg;
 	struct mmc_des_v4p1 *pdes =(struct mmc_des_v4p1 *)mmchost->pdes;
-	unsigned byte_cnt = data->blocksize * data->blocks;
+	const struct mmc_sg *sg;
+	struct mmc_sg whole;
+	unsigned blocks_todo = data->blocks;
 	unsigned char *buff;
 	unsigned des_idx = 0;
-	unsigned buff_frag_num = 0;
-	unsigned remain;
-	unsigned i, rval;
-
-	buff = data->flags & MMC_DATA_READ ?
-			(unsigned char *)data->dest : (unsigned char *)data->src;
-	buff_frag_num = byte_cnt >> SDXC_DES_NUM_SHIFT;
-	remain = byte_cnt & (SDXC_DES_BUFFER_MAX_LEN-1);
-	if (remain)
-		buff_frag_num ++;
-	else
-		remain = SDXC_DES_BUFFER_MAX_LEN;
-
-	flush_cache((unsigned long)buff, (unsigned long)byte_cnt);
-	for (i=0; i < buff_frag_num; i++, des_idx++) {
-		memset((void*)&pdes[des_idx], 0, sizeof(struct mmc_des_v4p1));
-		pdes[des_idx].des_chain = 1;
-		pdes[des_idx].own = 1;
-		pdes[des_idx].dic = 1;
-		if (buff_frag_num > 1 && i != buff_frag_num-1)
-			pdes[des_idx].data_buf1_sz = SDXC_DES_BUFFER_MAX_LEN;
-		else
-			pdes[des_idx].data_buf1_sz = remain;
+	unsigned remain, len;
+	unsigned rval;
 
-		pdes[des_idx].buf_addr_ptr1 = (ulong)buff + i * SDXC_DES_BUFFER_MAX_LEN;
-		if (i==0)
-			pdes[des_idx].first_des = 1;
+	/* a plain request is a scatter-gather list of one piece */
+	if (data->flags & MMC_DATA_SG) {
+		sg = data->sg;
+	} else {
+		whole.buf = data->flags & MMC_DATA_READ ?
+			(void *)data->dest : (void *)data->src;
+		whole.blocks = data->blocks;
+		sg = &whole;
+	}
 
-		if (i == buff_frag_num-1) {
-			pdes[des_idx].dic = 0;
-			pdes[des_idx].last_des = 1;
-			pdes[des_idx].end_of_ring = 1;
-			pdes[des_idx].buf_addr_ptr2 = 0;
-		} else {
+	for (; blocks_todo; sg++) {
+		if (sg->blocks > blocks_todo) {
+			MMCINFO("mmc %d sg list longer than the request\n", mmchost->mmc_no);
+			return -1;
+		}
+		buff = (unsigned char *)sg->buf;
+		remain = sg->blocks * data->blocksize;
+		blocks_todo -= sg->blocks;
+		if ((ulong)buff & 0x3) {
+			MMCINFO("mmc %d sg buffer is not 4 byte align: 0x%08lx\n",
+				mmchost->mmc_no, (ulong)buff);
+			return -1;
+		}
+
+		flush_cache((unsigned long)buff, (unsigned long)remain);
+		while (remain) {
+			if (des_idx == mmchost->des_num) {
+				MMCINFO("mmc %d request needs more than %d descriptors\n",
+					mmchost->mmc_no, mmchost->des_num);
+				return -1;
+			}
+			len = min(remain, (unsigned)SDXC_DES_BUFFER_MAX_LEN);
+
+			memset((void*)&pdes[des_idx], 0, sizeof(struct mmc_des_v4p1));
+			pdes[des_idx].des_chain = 1;
+			pdes[des_idx].own = 1;
+			pdes[des_idx].dic = 1;
+			pdes[des_idx].data_buf1_sz = len;
+			pdes[des_idx].buf_addr_ptr1 = (ulong)buff;
 			pdes[des_idx].buf_addr_ptr2 = (ulong)&pdes[des_idx+1];
+			MMCDBG("len %d, des[%d](%08x): "
+				"[0] = %08x, [1] = %08x, [2] = %08x, [3] = %08x\n",
+				len, des_idx, (u32)&pdes[des_idx],
+				(u32)((u32*)&pdes[des_idx])[0], (u32)((u32*)&pdes[des_idx])[1],
+				(u32)((u32*)&pdes[des_idx])[2], (u32)((u32*)&pdes[des_idx])[3]);
+
+			buff += len;
+			remain -= len;
+			des_idx++;
 		}
-		MMCDBG("frag %d, remain %d, des[%d](%08x): "
-			"[0] = %08x, [1] = %08x, [2] = %08x, [3] = %08x\n",
-			i, remain, des_idx, (u32)&pdes[des_idx],
-			(u32)((u32*)&pdes[des_idx])[0], (u32)((u32*)&pdes[des_idx])[1],
-			(u32)((u32*)&pdes[des_idx])[2], (u32)((u32*)&pdes[des_idx])[3]);
 	}
-	flush_cache((unsigned long)pdes, sizeof(struct mmc_des_v4p1) * (des_idx+1));
+	if (!des_idx)
+		return -1;
+
+	pdes[0].first_des = 1;
+	pdes[des_idx-1].dic = 0;
+	pdes[des_idx-1].last_des = 1;
+	pdes[des_idx-1].end_of_ring = 1;
+	pdes[des_idx-1].buf_addr_ptr2 = 0;
+	flush_cache((unsigned long)pdes, sizeof(struct mmc_des_v4p1) * des_idx);
 	__asm("DSB");
 	__asm("ISB");
 
@@ -915,8 +937,13 @@ static int mmc_trans_data_by_dma(struct mmc *mmc, struct mmc_data *data)
 	return 0;
 }
 
-static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
-				struct mmc_data *data)
+/*
+ * issue phase of a command: program the controller, kick off the data
+ * transfer and wait for the command done interrupt. the data phase is
+ * finished by mmc_send_cmd_complete().
+ */
+static int mmc_send_cmd_issue(struct mmc *mmc, struct mmc_cmd *cmd,
+				struct mmc_data *data, unsigned int *usedma)
 {
 	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
 	struct mmc_reg_v4p1 *reg = (struct mmc_reg_v4p1 *)mmchost->reg;
@@ -924,30 +951,9 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 	signed int timeout = 0;
 	int error = 0;
 	unsigned int status = 0;
-	unsigned int usedma = 0;
 	unsigned int bytecnt = 0;
 
-	if (mmchost->fatal_err) {
-		MMCINFO("mmc %d Found fatal err,so no send cmd\n",mmchost->mmc_no);
-		return -1;
-	}
-
-	if (cmd->resp_type & MMC_RSP_BUSY)
-		MMCDBG("mmc %d mmc cmd %d check rsp busy\n", mmchost->mmc_no,cmd->cmdidx);
-	if ((cmd->cmdidx == 12)&&!(cmd->flags&MMC_CMD_MANUAL)){
-		MMCDBG("note we don't send stop cmd,only check busy here\n");
-		timeout = 500*1000;
-		do {
-			status = readl(&reg->status);
-			if (!timeout--) {
-				error = -1;
-				MMCINFO("mmc %d cmd12 busy timeout\n",mmchost->mmc_no);
-				goto out;
-			}
-			__usdelay(1);
-		} while (status & (1 << 9));
-		return 0;
-	}
+	*usedma = 0;
 	/*
 	 * CMDREG
 	 * CMD[5:0]	: Command index
@@ -975,8 +981,7 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 	if (data) {
 		if ((ulong)data->dest & 0x3) {
 			MMCINFO("mmc %d dest is not 4 byte align: 0x%08lx\n",mmchost->mmc_no, (ulong)data->dest);
-			error = -1;
-			goto out;
+			return -1;
 		}
 
 		cmdval |= (1 << 9) | (1 << 13);
@@ -1015,7 +1020,7 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 #else
 		if (0) {
 #endif
-			usedma = 1;
+			*usedma = 1;
 			writel(readl(&reg->gctrl)&(~0x80000000), &reg->gctrl);
 			ret = mmc_trans_data_by_dma(mmc, data);
 			writel(cmdval|cmd->cmdidx, &reg->cmd);
@@ -1029,7 +1034,7 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			error = readl(&reg->rint) & 0xbfc2;
 			if(!error)
 				error = 0xffffffff;
-			goto out;
+			return error;
 		}
 	}
 
@@ -1041,11 +1046,33 @@ static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			if(!error)
 				error = 0xffffffff;//represet software timeout
 			MMCMSG(mmc, "mmc %d cmd %d timeout, err %x\n",mmchost->mmc_no, cmd->cmdidx, error);
-			goto out;
+			return error;
 		}
 		__usdelay(1);
 	} while (!(status&0x4));
 
+	return 0;
+}
+
+/*
+ * completion phase of a command: wait for the data transfer and the busy
+ * signal, fetch the response and release the dma. @error is the result of
+ * the issue phase, on error only the cleanup and recovery is done.
+ */
+static int mmc_send_cmd_complete(struct mmc *mmc, struct mmc_cmd *cmd,
+				struct mmc_data *data, unsigned int usedma, int error)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+	struct mmc_reg_v4p1 *reg = (struct mmc_reg_v4p1 *)mmchost->reg;
+	signed int timeout = 0;
+	unsigned int status = 0;
+	unsigned int bytecnt = 0;
+
+	if (data)
+		bytecnt = data->blocksize * data->blocks;
+	if (error)
+		goto out;
+
 	if (data) {
 		unsigned done = 0;
 		timeout = usedma ? (50*bytecnt/25) : 0xffffff;//0.04us(25M)*2(4bit width)*25()
@@ -1189,11 +1216,23 @@ out:
 	writel(0xffffffff, &reg->rint);
 
 	if (data && (data->flags&MMC_DATA_READ)) {
-        unsigned char *buff = (unsigned char *)data->dest;
-        unsigned byte_cnt = data->blocksize * data->blocks;
-        flush_cache((unsigned long)buff, (unsigned long)byte_cnt);
-        MMCDBG("invald cache after read complete\n");
-    }
+		/* data->dest and data->sg share a union */
+		if (data->flags & MMC_DATA_SG) {
+			const struct mmc_sg *sg = data->sg;
+			unsigned blocks_todo = data->blocks;
+
+			for (; blocks_todo && sg->blocks <= blocks_todo; sg++) {
+				flush_cache((unsigned long)sg->buf,
+					(unsigned long)(sg->blocks * data->blocksize));
+				blocks_todo -= sg->blocks;
+			}
+		} else {
+			unsigned char *buff = (unsigned char *)data->dest;
+			unsigned byte_cnt = data->blocksize * data->blocks;
+			flush_cache((unsigned long)buff, (unsigned long)byte_cnt);
+		}
+		MMCDBG("invald cache after read complete\n");
+	}
 
 	if (error)
 		return -1;
@@ -1201,6 +1240,110 @@ out:
 		return 0;
 }
 
+static int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+	struct mmc_reg_v4p1 *reg = (struct mmc_reg_v4p1 *)mmchost->reg;
+	signed int timeout = 0;
+	int error = 0;
+	unsigned int status = 0;
+	unsigned int usedma = 0;
+
+	if (mmchost->fatal_err) {
+		MMCINFO("mmc %d Found fatal err,so no send cmd\n",mmchost->mmc_no);
+		return -1;
+	}
+
+	if (cmd->resp_type & MMC_RSP_BUSY)
+		MMCDBG("mmc %d mmc cmd %d check rsp busy\n", mmchost->mmc_no,cmd->cmdidx);
+	if ((cmd->cmdidx == 12)&&!(cmd->flags&MMC_CMD_MANUAL)){
+		MMCDBG("note we don't send stop cmd,only check busy here\n");
+		timeout = 500*1000;
+		do {
+			status = readl(&reg->status);
+			if (!timeout--) {
+				error = -1;
+				MMCINFO("mmc %d cmd12 busy timeout\n",mmchost->mmc_no);
+				return mmc_send_cmd_complete(mmc, cmd, data, usedma, error);
+			}
+			__usdelay(1);
+		} while (status & (1 << 9));
+		return 0;
+	}
+
+	error = mmc_send_cmd_issue(mmc, cmd, data, &usedma);
+
+	return mmc_send_cmd_complete(mmc, cmd, data, usedma, error);
+}
+
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+/*
+ * asynchronous data command: only the issue phase is run here, the idma
+ * keeps moving data in the background until mmc_send_cmd_wait() is called.
+ * nothing else may be sent to this host in between.
+ */
+static int mmc_send_cmd_start(struct mmc *mmc, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+
+	if (mmchost->fatal_err) {
+		MMCINFO("mmc %d Found fatal err,so no send cmd\n",mmchost->mmc_no);
+		return -1;
+	}
+	if (!data || (data->blocksize * data->blocks <= 64)) {
+		MMCINFO("mmc %d async cmd %d needs a dma data phase\n", mmchost->mmc_no, cmd->cmdidx);
+		return -1;
+	}
+
+	mmchost->async_error = mmc_send_cmd_issue(mmc, cmd, data, &mmchost->async_usedma);
+	if (mmchost->async_error)
+		return mmc_send_cmd_complete(mmc, cmd, data,
+			mmchost->async_usedma, mmchost->async_error);
+
+	return 0;
+}
+
+static int mmc_send_cmd_wait(struct mmc *mmc, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+
+	return mmc_send_cmd_complete(mmc, cmd, data,
+			mmchost->async_usedma, mmchost->async_error);
+}
+
+/*
+ * non-blocking look at the transfer started by mmc_send_cmd_start(),
+ * an error also counts as done, mmc_send_cmd_wait() reports it
+ */
+static int mmc_send_cmd_done(struct mmc *mmc, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct sunxi_mmc_host* mmchost = (struct sunxi_mmc_host *)mmc->priv;
+	struct mmc_reg_v4p1 *reg = (struct mmc_reg_v4p1 *)mmchost->reg;
+	unsigned int status;
+	unsigned int done_bit;
+
+	if (mmchost->async_error)
+		return 1;
+
+	status = readl(&reg->rint);
+	if (status & 0xbfc2)
+		return 1;
+
+	if ((data->blocks > 1) && !(cmd->flags & MMC_CMD_MANUAL))
+		done_bit = 1 << 14;
+	else
+		done_bit = 1 << 3;
+	if (!(status & done_bit))
+		return 0;
+
+	return mmchost->async_usedma ? ((readl(&reg->idst) & 0x3) ? 1 : 0) : 1;
+}
+#endif
+
 
 static int sunxi_decide_rty(struct mmc *mmc, int err_no, uint rst_cnt)
 {
@@ -1302,5 +1445,10 @@ const struct mmc_ops sunxi_mmc_ops = {
 	.decide_retry 		= sunxi_decide_rty,
 	.get_detail_errno 	= sunxi_detail_errno,
 	.update_phase 		= mmc_update_phase,
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	.send_cmd_start		= mmc_send_cmd_start,
+	.send_cmd_wait		= mmc_send_cmd_wait,
+	.send_cmd_done		= mmc_send_cmd_done,
+#endif
 };
 
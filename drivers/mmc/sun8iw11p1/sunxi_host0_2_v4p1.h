@@ -69,6 +69,15 @@ struct mmc_des_v4p1 {
 
 #define SDXC_DES_NUM_SHIFT 12  /* smhc2!! */
 #define SDXC_DES_BUFFER_MAX_LEN	(1 << SDXC_DES_NUM_SHIFT)
+/*
+ * descriptors in the ring of each host: enough for a 64M request on
+ * the eMMC, less on the card slot. b_max leaves one spare descriptor
+ * for every piece of a scatter-gather request, whose tails may each
+ * take a short descriptor of their own
+ */
+#define SDXC_DES_RING_NUM_EMMC	(16384)
+#define SDXC_DES_RING_NUM_CARD	(2048)
+#define SDXC_DES_RING_BLKS(num)	(((num) - MMC_SG_MAX) * (SDXC_DES_BUFFER_MAX_LEN >> 9))
 	u32	data_buf1_sz	:16,
 		data_buf2_sz	:16;
 
@@ -43,6 +43,10 @@
 extern char *spd_name[];
 struct sunxi_mmc_host mmc_host[3];
 struct mmc_reg_v4p1 mmc_host_reg_bak[3];
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+/* idma descriptor rings, allocated on the first init of a host and kept across re-init */
+static struct mmc_des_v4p1 *mmc_host_des[3];
+#endif
 
 static u8 ext_odly_spd_freq[MAX_SPD_MD_NUM*MAX_CLK_FREQ_NUM];
 static u8 ext_sdly_spd_freq[MAX_SPD_MD_NUM*MAX_CLK_FREQ_NUM];
@@ -996,7 +1000,22 @@ int sunxi_sun8iw11p1_mmc_init(int sdc_no)
 		| MMC_VDD_30_31 | MMC_VDD_31_32 | MMC_VDD_34_35
 		| MMC_VDD_35_36;
 
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	host->des_num = (sdc_no == 2) ? SDXC_DES_RING_NUM_EMMC : SDXC_DES_RING_NUM_CARD;
+	if (!mmc_host_des[sdc_no]) {
+		mmc_host_des[sdc_no] = memalign(ARCH_DMA_MINALIGN,
+				host->des_num * sizeof(struct mmc_des_v4p1));
+		if (!mmc_host_des[sdc_no]) {
+			MMCINFO("mmc %d fail to alloc descriptor ring\n", sdc_no);
+			return -1;
+		}
+	}
+	host->pdes = mmc_host_des[sdc_no];
+	/* no CMD23 is used, the request size is only bounded by the descriptor ring */
+	host->cfg.b_max = SDXC_DES_RING_BLKS(host->des_num);
+#else
 	host->cfg.b_max = CONFIG_SYS_MMC_MAX_BLK_COUNT;
+#endif
 
 	if (sdc_no == 0) {
 		host->cfg.f_min = 400000;
@@ -1019,12 +1038,6 @@ int sunxi_sun8iw11p1_mmc_init(int sdc_no)
 	else if ((sdc_no == 2))
 		host->timing_mode = SUNXI_MMC_TIMING_MODE_4;
 
-	host->pdes = malloc(256 * 1024);
-	if (host->pdes == NULL) {
-		MMCINFO("%s: get mem for descriptor failed\n", __FUNCTION__);
-		return -1;
-	}
-
 	mmc_clear_timing_para(sdc_no);
 	mmc_init_default_timing_para(sdc_no);
 	mmc_get_para_from_fex(sdc_no);
@@ -1035,6 +1048,9 @@ int sunxi_sun8iw11p1_mmc_init(int sdc_no)
 
 	host->cfg.host_caps = MMC_MODE_4BIT | MMC_MODE_HS | MMC_MODE_HC \
 							| MMC_MODE_HS_52MHz | MMC_MODE_DDR_52MHz;
+#ifdef CONFIG_MMC_SUNXI_USE_DMA
+	host->cfg.host_caps |= MMC_MODE_SG;
+#endif
 	if (host->cfg.host_no == 2)
 		host->cfg.host_caps |= MMC_MODE_8BIT;
 	if (host->cfg.platform_caps.io_is_1v8) {
@@ -106,6 +106,7 @@ struct sunxi_mmc_host {
 	void *reg;//struct sunxi_mmc *reg;		
 	void *reg_bak;//struct sunxi_mmc *reg_bak;
 	void *pdes;//struct sunxi_mmc_des* pdes;	
+	u32 des_num; /* descriptors in the ring at @pdes */
 
 	/*sample delay and output deley setting*/
 	u32 timing_mode;
@@ -123,6 +124,10 @@ struct sunxi_mmc_host {
 	/*sample delay and output deley setting*/
 	u32 raw_int_bak;
 	u32 sample_mode;
+
+	/* state of the data command started by send_cmd_start */
+	u32 async_usedma;
+	int async_error;
 };
 
 
@@ -0,0 +1,201 @@
+/*
+ * Sandbox Ethernet device on the host's loopback interface
+ *
+ * The host side (arch/sandbox/cpu/eth-raw-os.c) only moves IP packets.
+ * Here they are made to look like Ethernet: ARP requests are answered
+ * on the host's behalf, and datagrams that the host hands over already
+ * reassembled are split again into fragments no larger than a frame, so
+ * that large TFTP blocks go through CONFIG_IP_DEFRAG as on a real wire.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <net.h>
+#include <netdev.h>
+#include <asm/errno.h>
+#include <asm/eth-raw-os.h>
+
+/* largest IP packet in one of our frames */
+#define SB_ETH_MTU		1500
+/* largest datagram from the host */
+#define SB_ETH_BUF_SIZE		65536
+/* datagrams passed on per call, about a window of TFTP blocks */
+#define SB_ETH_RX_BURST		64
+
+static const uchar sb_eth_addr[6] = { 0x02, 0x00, 0x5b, 0x00, 0x00, 0x01 };
+/* the address our ARP requests get as the answer */
+static const uchar sb_eth_host_addr[6] = { 0x02, 0x00, 0x5b, 0x00, 0x00, 0x02 };
+
+struct sb_eth_raw {
+	struct eth_sandbox_raw_priv os;
+	int arp_reply;		/* an ARP request waits for its reply */
+	IPaddr_t arp_ip;	/* the address asked for */
+	IPaddr_t arp_sender;	/* and who asked */
+	uchar *buf;		/* datagram from the host */
+};
+
+static int sb_eth_raw_init(struct eth_device *dev, bd_t *bis)
+{
+	struct sb_eth_raw *priv = dev->priv;
+	int ret;
+
+	ret = sandbox_eth_raw_os_start(&priv->os);
+	if (ret) {
+		printf("%s: no raw socket (%d), CAP_NET_RAW is needed\n",
+		       dev->name, ret);
+		return -1;
+	}
+	priv->arp_reply = 0;
+
+	return 0;
+}
+
+static void sb_eth_raw_halt(struct eth_device *dev)
+{
+	struct sb_eth_raw *priv = dev->priv;
+
+	sandbox_eth_raw_os_stop(&priv->os);
+}
+
+static int sb_eth_raw_send(struct eth_device *dev, void *packet, int length)
+{
+	struct sb_eth_raw *priv = dev->priv;
+	struct ethernet_hdr *eth = packet;
+	struct arp_hdr *arp;
+	int ret;
+
+	switch (ntohs(eth->et_protlen)) {
+	case PROT_ARP:
+		/* loopback has no link layer to ask, answer it ourselves */
+		arp = packet + ETHER_HDR_SIZE;
+		if (ntohs(arp->ar_op) == ARPOP_REQUEST) {
+			priv->arp_ip = NetReadIP(&arp->ar_tpa);
+			priv->arp_sender = NetReadIP(&arp->ar_spa);
+			priv->arp_reply = 1;
+		}
+		return 0;
+	case PROT_IP:
+		ret = sandbox_eth_raw_os_send(packet + ETHER_HDR_SIZE,
+					      length - ETHER_HDR_SIZE,
+					      &priv->os);
+		return ret < 0 ? ret : 0;
+	default:
+		return 0;
+	}
+}
+
+static void sb_eth_raw_arp_reply(struct eth_device *dev)
+{
+	struct sb_eth_raw *priv = dev->priv;
+	uchar *pkt = NetRxPackets[0];
+	struct ethernet_hdr *eth = (struct ethernet_hdr *)pkt;
+	struct arp_hdr *arp = (struct arp_hdr *)(pkt + ETHER_HDR_SIZE);
+
+	memcpy(eth->et_dest, dev->enetaddr, 6);
+	memcpy(eth->et_src, sb_eth_host_addr, 6);
+	eth->et_protlen = htons(PROT_ARP);
+
+	arp->ar_hrd = htons(ARP_ETHER);
+	arp->ar_pro = htons(PROT_IP);
+	arp->ar_hln = ARP_HLEN;
+	arp->ar_pln = ARP_PLEN;
+	arp->ar_op = htons(ARPOP_REPLY);
+	memcpy(&arp->ar_sha, sb_eth_host_addr, ARP_HLEN);
+	NetWriteIP(&arp->ar_spa, priv->arp_ip);
+	memcpy(&arp->ar_tha, dev->enetaddr, ARP_HLEN);
+	NetWriteIP(&arp->ar_tpa, priv->arp_sender);
+
+	priv->arp_reply = 0;
+	NetReceive(pkt, ETHER_HDR_SIZE + ARP_HDR_SIZE);
+}
+
+/* Pass a datagram on in frames of at most SB_ETH_MTU */
+static void sb_eth_raw_frames(struct eth_device *dev, int len)
+{
+	struct sb_eth_raw *priv = dev->priv;
+	struct ip_hdr *ip = (struct ip_hdr *)priv->buf;
+	uchar *pkt = NetRxPackets[0];
+	struct ethernet_hdr *eth = (struct ethernet_hdr *)pkt;
+	struct ip_hdr *frag = (struct ip_hdr *)(pkt + ETHER_HDR_SIZE);
+	int hlen, data, step, done, chunk;
+	ushort off, flags;
+
+	hlen = (ip->ip_hl_v & 0x0f) * 4;
+	if (len < IP_HDR_SIZE || hlen < IP_HDR_SIZE || hlen > len)
+		return;
+	data = min((int)ntohs(ip->ip_len), len) - hlen;
+	if (data <= 0)
+		return;
+	off = ntohs(ip->ip_off);
+	flags = off & IP_FLAGS & ~IP_FLAGS_DFRAG;
+	step = (SB_ETH_MTU - hlen) & ~7;
+
+	memcpy(eth->et_dest, dev->enetaddr, 6);
+	memcpy(eth->et_src, sb_eth_host_addr, 6);
+	eth->et_protlen = htons(PROT_IP);
+
+	for (done = 0; done < data; done += chunk) {
+		chunk = min(data - done, step);
+		memcpy(frag, ip, hlen);
+		memcpy((uchar *)frag + hlen, (uchar *)ip + hlen + done, chunk);
+		frag->ip_len = htons(hlen + chunk);
+		frag->ip_off = htons(flags | ((off & IP_OFFS) + done / 8) |
+				     (done + chunk < data ? IP_FLAGS_MFRAG : 0));
+		frag->ip_sum = 0;
+		frag->ip_sum = ~NetCksum((uchar *)frag, hlen / 2);
+		NetReceive(pkt, ETHER_HDR_SIZE + hlen + chunk);
+	}
+}
+
+static int sb_eth_raw_recv(struct eth_device *dev)
+{
+	struct sb_eth_raw *priv = dev->priv;
+	int count, len;
+
+	if (priv->arp_reply)
+		sb_eth_raw_arp_reply(dev);
+
+	for (count = 0; count < SB_ETH_RX_BURST; count++) {
+		if (net_state != NETLOOP_CONTINUE)
+			break;
+		len = sandbox_eth_raw_os_recv(priv->buf, SB_ETH_BUF_SIZE,
+					      &priv->os);
+		if (len <= 0)
+			break;
+		sb_eth_raw_frames(dev, len);
+	}
+
+	return count;
+}
+
+int sandbox_eth_raw_initialize(bd_t *bis)
+{
+	struct eth_device *dev;
+	struct sb_eth_raw *priv;
+
+	dev = calloc(1, sizeof(*dev));
+	priv = calloc(1, sizeof(*priv));
+	if (priv)
+		priv->buf = malloc(SB_ETH_BUF_SIZE);
+	if (!dev || !priv || !priv->buf) {
+		if (priv)
+			free(priv->buf);
+		free(priv);
+		free(dev);
+		return -ENOMEM;
+	}
+
+	priv->os.sd = -1;
+	priv->os.bind_sd = -1;
+	memcpy(dev->enetaddr, sb_eth_addr, 6);
+	dev->priv = priv;
+	dev->init = sb_eth_raw_init;
+	dev->halt = sb_eth_raw_halt;
+	dev->send = sb_eth_raw_send;
+	dev->recv = sb_eth_raw_recv;
+	strcpy(dev->name, "sb_eth_raw");
+
+	return eth_register(dev);
+}
@@ -9,6 +9,10 @@
 #include <watchdog.h>
 #include <linux/types.h>
 #include <asm/io.h>
+#ifdef NS16550_TX_BUFFERED
+#include <common.h>
+#include <cpu_job.h>
+#endif
 
 #define UART_LCRVAL UART_LCR_8N1		/* 8 data, 1 stop, no parity */
 #define UART_MCRVAL (UART_MCR_DTR | \
@@ -45,6 +49,130 @@
 #define CONFIG_SYS_NS16550_IER  0x00
 #endif /* CONFIG_SYS_NS16550_IER */
 
+static inline void ns16550_putc_poll(NS16550_t com_port, char c)
+{
+	while ((serial_in(&com_port->lsr) & UART_LSR_THRE) == 0)
+		;
+	serial_out(c, &com_port->thr);
+}
+
+#ifdef NS16550_TX_BUFFERED
+/*
+ * Buffered output: NS16550_putc() queues the bytes for the buffered port
+ * in a ring and the THR empty interrupt moves them to the FIFO a burst at
+ * a time, so printing costs the caller a copy instead of the time on the
+ * wire.  When the ring is full the writer waits for room, nothing is
+ * dropped.  With interrupts off nobody drains the ring, so such writes
+ * (and writes from the second core) empty it first and go out directly.
+ */
+#ifndef CONFIG_SYS_NS16550_TX_FIFO
+#define CONFIG_SYS_NS16550_TX_FIFO	16
+#endif
+
+#define TX_RING_SIZE	CONFIG_SYS_NS16550_TX_BUFFER	/* power of two */
+
+static char tx_ring[TX_RING_SIZE];
+static unsigned int tx_head;		/* next byte to queue */
+static unsigned int tx_tail;		/* next byte to send */
+static NS16550_t tx_port;
+static struct ns16550_tx_stats tx_stats;
+static struct cpu_job_lock tx_lock = CPU_JOB_LOCK_INIT;
+
+/* a FIFO's worth once the transmitter asks for more */
+static void ns16550_tx_fill(NS16550_t com_port)
+{
+	int n = CONFIG_SYS_NS16550_TX_FIFO;
+
+	if (!(serial_in(&com_port->lsr) & UART_LSR_THRE))
+		return;
+	while (n-- && tx_tail != tx_head)
+		serial_out(tx_ring[tx_tail++ & (TX_RING_SIZE - 1)],
+			   &com_port->thr);
+}
+
+/* empty the ring by polling, the interrupt is not needed after that */
+static void ns16550_tx_drain(NS16550_t com_port)
+{
+	while (tx_tail != tx_head)
+		ns16550_tx_fill(com_port);
+	serial_out(CONFIG_SYS_NS16550_IER, &com_port->ier);
+}
+
+static void ns16550_tx_queue(NS16550_t com_port, char c)
+{
+	int irq = disable_interrupts();
+	unsigned int queued;
+
+	cpu_job_lock(&tx_lock);
+	if (!irq) {
+		ns16550_tx_drain(com_port);
+		ns16550_putc_poll(com_port, c);
+		goto out;
+	}
+
+	if (tx_head - tx_tail == TX_RING_SIZE) {
+		tx_stats.stalls++;
+		while (tx_head - tx_tail == TX_RING_SIZE)
+			ns16550_tx_fill(com_port);
+	}
+	tx_ring[tx_head++ & (TX_RING_SIZE - 1)] = c;
+	tx_stats.bytes++;
+	queued = tx_head - tx_tail;
+	if (queued > tx_stats.peak)
+		tx_stats.peak = queued;
+
+	/* start the transmitter if it is idle, the interrupt does the rest */
+	ns16550_tx_fill(com_port);
+	if (tx_tail != tx_head)
+		serial_out(CONFIG_SYS_NS16550_IER | UART_IER_THRI,
+			   &com_port->ier);
+out:
+	cpu_job_unlock(&tx_lock);
+	if (irq)
+		enable_interrupts();
+}
+
+void NS16550_tx_buffer(NS16550_t com_port)
+{
+	tx_port = com_port;
+}
+
+/* THR empty interrupt of the buffered port */
+void NS16550_tx_interrupt(NS16550_t com_port)
+{
+	cpu_job_lock(&tx_lock);
+	serial_in(&com_port->iir);
+	ns16550_tx_fill(com_port);
+	if (tx_tail == tx_head)
+		serial_out(CONFIG_SYS_NS16550_IER, &com_port->ier);
+	cpu_job_unlock(&tx_lock);
+}
+
+/* send everything queued and wait until it has left the shift register */
+void NS16550_flush(NS16550_t com_port)
+{
+	int irq;
+
+	if (com_port != tx_port)
+		return;
+
+	irq = disable_interrupts();
+	cpu_job_lock(&tx_lock);
+	ns16550_tx_drain(com_port);
+	while (!(serial_in(&com_port->lsr) & UART_LSR_TEMT))
+		;
+	cpu_job_unlock(&tx_lock);
+	if (irq)
+		enable_interrupts();
+}
+
+void NS16550_tx_stats(struct ns16550_tx_stats *stats)
+{
+	*stats = tx_stats;
+	stats->size = TX_RING_SIZE;
+}
+#endif /* NS16550_TX_BUFFERED */
+
 void NS16550_init(NS16550_t com_port, int baud_divisor)
 {
 #if (defined(CONFIG_SPL_BUILD) && defined(CONFIG_OMAP34XX))
@@ -96,6 +224,10 @@ void NS16550_init(NS16550_t com_port, int baud_divisor)
 #ifndef CONFIG_NS16550_MIN_FUNCTIONS
 void NS16550_reinit(NS16550_t com_port, int baud_divisor)
 {
+#ifdef NS16550_TX_BUFFERED
+	/* the old rate for what was queued before */
+	NS16550_flush(com_port);
+#endif
 	serial_out(CONFIG_SYS_NS16550_IER, &com_port->ier);
 	serial_out(UART_LCR_BKSE | UART_LCRVAL, &com_port->lcr);
 	serial_out(0, &com_port->dll);
@@ -112,9 +244,12 @@ void NS16550_reinit(NS16550_t com_port, int baud_divisor)
 
 void NS16550_putc(NS16550_t com_port, char c)
 {
-	while ((serial_in(&com_port->lsr) & UART_LSR_THRE) == 0)
-		;
-	serial_out(c, &com_port->thr);
+#ifdef NS16550_TX_BUFFERED
+	if (com_port == tx_port)
+		ns16550_tx_queue(com_port, c);
+	else
+#endif
+	ns16550_putc_poll(com_port, c);
 
 	/*
 	 * Call watchdog_reset() upon newline. This is done here in putc
@@ -478,6 +478,17 @@ void default_serial_puts(const char *s)
 		dev->putc(*s++);
 }
 
+/**
+ * serial_flush() - Wait until queued console output has been sent
+ *
+ * Only drivers that buffer their output have to provide this, for the
+ * others every character is on its way when putc() returns. It is called
+ * before resets and before handing over to an OS.
+ */
+__weak void serial_flush(void)
+{
+}
+
 #if CONFIG_POST & CONFIG_SYS_POST_UART
 static const int bauds[] = CONFIG_SYS_BAUDRATE_TABLE;
 
@@ -276,6 +276,38 @@ __weak struct serial_device *default_serial_console(void)
 #endif
 }
 
+#ifdef NS16550_TX_BUFFERED
+#ifndef CONFIG_SYS_NS16550_TX_IRQ
+#error "CONFIG_SYS_NS16550_TX_BUFFER needs CONFIG_SYS_NS16550_TX_IRQ"
+#endif
+
+/* the board config names the irq from here, and irq_enable() */
+#include <asm/arch/intc.h>
+
+#define TX_BUFFER_PORT	serial_ports[CONFIG_CONS_INDEX - 1]
+
+static void ns16550_tx_isr(void *data)
+{
+	NS16550_tx_interrupt(data);
+}
+
+/* Buffer the console output, once interrupts are enabled */
+int ns16550_tx_buffer_init(void)
+{
+	irq_install_handler(CONFIG_SYS_NS16550_TX_IRQ, ns16550_tx_isr,
+			    TX_BUFFER_PORT);
+	irq_enable(CONFIG_SYS_NS16550_TX_IRQ);
+	NS16550_tx_buffer(TX_BUFFER_PORT);
+
+	return 0;
+}
+
+void serial_flush(void)
+{
+	NS16550_flush(TX_BUFFER_PORT);
+}
+#endif
+
 void ns16550_serial_initialize(void)
 {
 #if defined(CONFIG_SYS_NS16550_COM1)
@@ -11,6 +11,10 @@ extern int (* sunxi_flash_exit_pt) (int force);
 extern int (* sunxi_flash_flush_pt) (void);
 extern int (* sunxi_flash_phyread_pt) (unsigned int start_block, unsigned int nblock, void *buffer);
 extern int (* sunxi_flash_phywrite_pt)(unsigned int start_block, unsigned int nblock, void *buffer);
+extern int (* sunxi_flash_submit_read_pt) (uint start_block, uint nblock, void *buffer);
+extern int (* sunxi_flash_submit_write_pt)(uint start_block, uint nblock, void *buffer);
+extern int (* sunxi_flash_query_pt)(void);
+extern int (* sunxi_flash_complete_pt)(void);
 
 extern int (* sunxi_sprite_init_pt)(int stage) ;
 extern int (* sunxi_sprite_read_pt) (uint start_block, uint nblock, void *buffer) ;
@@ -19,9 +23,15 @@ extern int (* sunxi_sprite_erase_pt)(int erase, void *mbr_buffer);
 extern uint (* sunxi_sprite_size_pt)(void);
 extern int (* sunxi_sprite_exit_pt) (int force) ;
 extern int (* sunxi_sprite_flush_pt)(void);
+extern int (* sunxi_sprite_sync_pt)(void);
 extern int (* sunxi_sprite_force_erase_pt)(void)  ;
+extern int (* sunxi_sprite_discard_pt)(uint start_block, uint nblock, uint *skip_space);
 extern int (* sunxi_sprite_phyread_pt) (unsigned int start_block, unsigned int nblock, void *buffer);
 extern int (* sunxi_sprite_phywrite_pt)(unsigned int start_block, unsigned int nblock, void *buffer);
+extern int (* sunxi_sprite_submit_read_pt) (uint start_block, uint nblock, void *buffer);
+extern int (* sunxi_sprite_submit_write_pt)(uint start_block, uint nblock, void *buffer);
+extern int (* sunxi_sprite_query_pt)(void);
+extern int (* sunxi_sprite_complete_pt)(void);
 
 
 extern int  nand_init_for_boot(int workmode);
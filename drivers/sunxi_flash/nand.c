@@ -5,8 +5,66 @@
 #include <boot_type.h>
 #include <sunxi_board.h>
 #include <sunxi_nand.h>
+#include <malloc.h>
 #include "flash_interface.h"
 
+//量产整片擦除后，逻辑区按1MB一位记录哪些地方已经写过
+#define NAND_WRITTEN_SHIFT		11
+
+static int    nand_sprite_erased;
+static uchar *nand_written_map;
+static uint   nand_written_bits;
+
+static void
+nand_mark_written(uint start_block, uint nblock)
+{
+	uint first, last;
+
+	if(!nand_sprite_erased || !nblock)
+	{
+		return;
+	}
+	if(!nand_written_map)
+	{
+		nand_written_bits = (nand_uboot_get_flash_size() >> NAND_WRITTEN_SHIFT) + 1;
+		nand_written_map = calloc((nand_written_bits + 7) / 8, 1);
+		if(!nand_written_map)
+		{
+			//记录不了就当作没有擦除过，全部由调用者写0
+			nand_sprite_erased = 0;
+			return;
+		}
+	}
+	first = start_block >> NAND_WRITTEN_SHIFT;
+	last  = (start_block + nblock - 1) >> NAND_WRITTEN_SHIFT;
+	for(; first <= last && first < nand_written_bits; first++)
+	{
+		nand_written_map[first >> 3] |= 1 << (first & 7);
+	}
+}
+
+static int
+nand_range_written(uint start_block, uint nblock)
+{
+	uint first, last;
+
+	if(!nand_written_map)
+	{
+		return 0;
+	}
+	first = start_block >> NAND_WRITTEN_SHIFT;
+	last  = (start_block + nblock - 1) >> NAND_WRITTEN_SHIFT;
+	for(; first <= last; first++)
+	{
+		if((first >= nand_written_bits) || (nand_written_map[first >> 3] & (1 << (first & 7))))
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
 static int
 sunxi_flash_nand_read(uint start_block, uint nblock, void *buffer)
 {
@@ -17,6 +75,7 @@ sunxi_flash_nand_read(uint start_block, uint nblock, void *buffer)
 static int
 sunxi_flash_nand_write(uint start_block, uint nblock, void *buffer)
 {
+	nand_mark_written(start_block, nblock);
 
 	return nand_uboot_write(start_block, nblock, buffer);
 
@@ -25,7 +84,30 @@ sunxi_flash_nand_write(uint start_block, uint nblock, void *buffer)
 static int
 sunxi_flash_nand_erase(int erase, void *mbr_buffer)
 {
-	return nand_uboot_erase(erase);
+	int ret;
+
+	ret = nand_uboot_erase(erase);
+	//只有整片擦除(返回1)后逻辑区才是空的，重新开始记录写过的区域
+	if(nand_written_map)
+	{
+		free(nand_written_map);
+		nand_written_map = NULL;
+	}
+	nand_sprite_erased = (ret > 0);
+
+	return ret;
+}
+
+static int
+sunxi_flash_nand_discard(uint start_block, uint nblock, uint *skip_space)
+{
+	//整片擦除后没有写过的区域直接跳过，否则由调用者写0
+	if(!nand_sprite_erased || !nblock || nand_range_written(start_block, nblock))
+	{
+		return -1;
+	}
+
+	return 0;
 }
 
 static uint
@@ -97,6 +179,7 @@ int nand_init_for_sprite(int workmode)
 	sunxi_sprite_size_pt  = sunxi_flash_nand_size;
 	sunxi_sprite_flush_pt = sunxi_flash_nand_flush;
 	sunxi_sprite_force_erase_pt = sunxi_flash_nand_force_erase;
+	sunxi_sprite_discard_pt = sunxi_flash_nand_discard;
 	debug("sunxi sprite has installed nand function\n");
 	uboot_spare_head.boot_data.storage_type = 0;
 	if(workmode == 0x30)
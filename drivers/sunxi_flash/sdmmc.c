@@ -4,9 +4,14 @@
 #include <boot_type.h>
 #include <sunxi_board.h>
 #include <mmc.h>
+#include <malloc.h>
 #include "flash_interface.h"
 
 static struct mmc *mmc_boot,*mmc_sprite;
+//擦除后读出的值，-1表示还没有从EXT_CSD读取
+static int mmc_sprite_erased_mem = -1;
+
+extern int mmc_send_ext_csd(struct mmc *mmc, char *ext_csd);
 
 //-------------------------------------noraml interface--------------------------------------------
 static int
@@ -28,6 +33,36 @@ sunxi_flash_mmc_write(unsigned int start_block, unsigned int nblock, void *buffe
 					nblock, buffer);
 }
 
+static int
+sunxi_flash_mmc_submit_read(unsigned int start_block, unsigned int nblock, void *buffer)
+{
+	debug("mmcboot submit read: start 0x%x, sector 0x%x\n", start_block, nblock);
+
+	return mmc_bread_start(mmc_boot->block_dev.dev, start_block + CONFIG_MMC_LOGICAL_OFFSET,
+					nblock, buffer);
+}
+
+static int
+sunxi_flash_mmc_submit_write(unsigned int start_block, unsigned int nblock, void *buffer)
+{
+	debug("mmcboot submit write: start 0x%x, sector 0x%x\n", start_block, nblock);
+
+	return mmc_bwrite_start(mmc_boot->block_dev.dev, start_block + CONFIG_MMC_LOGICAL_OFFSET,
+					nblock, buffer);
+}
+
+static int
+sunxi_flash_mmc_query(void)
+{
+	return mmc_async_done(mmc_boot->block_dev.dev);
+}
+
+static int
+sunxi_flash_mmc_complete(void)
+{
+	return mmc_async_wait(mmc_boot->block_dev.dev);
+}
+
 static uint
 sunxi_flash_mmc_size(void){
 
@@ -57,12 +92,141 @@ int sunxi_flash_mmc_phywrite(unsigned int start_block, unsigned int nblock, void
 }
 
 
+//-------------------------------------sprite write combine--------------------------------------------
+#ifdef CONFIG_SUNXI_SPRITE_WRITE_COMBINE
+/*
+ * 小块写先拷进缓存，相邻或只隔一点的写拼成一段，不相邻的最多攒
+ * MMC_COMBINE_RUN_MAX段，卡支持packed命令时一条命令写完。
+ * sunxi_sprite_flush/sunxi_sprite_sync、读卡以及其它直接访问卡的接口之前都会先写回。
+ * 进了缓存的写直接返回成功，真正的写卡结果由sunxi_sprite_sync返回，
+ * 所以调用者写完一段数据(分区、擦除、efex校验前)都要检查它
+ */
+#define MMC_COMBINE_BUFF_SECTORS	(4096)			//2M缓存
+#define MMC_COMBINE_RUN_MAX		(MMC_SG_MAX - 1)
+#define MMC_COMBINE_GAP_SECTORS		(8)			//不超过4K的空洞读回来补齐
+#define MMC_COMBINE_DIRECT_SECTORS	(1024)			//512K以上的写直接下发
+
+static char *mmc_combine_buff;
+static uint  mmc_combine_used;					//缓存里已用的扇区数
+static uint  mmc_combine_runs;
+static int   mmc_combine_packed;				//一条packed命令的段数，0表示不支持
+static lbaint_t      mmc_combine_start[MMC_COMBINE_RUN_MAX];	//每段的物理起始扇区
+static struct mmc_sg mmc_combine_run[MMC_COMBINE_RUN_MAX];
+
+static int
+sunxi_sprite_mmc_combine_flush(void)
+{
+	int  dev = mmc_sprite->block_dev.dev;
+	uint i, j, count;
+	int  ret = 0;
+
+	for (i=0; i<mmc_combine_runs; i+=count) {
+		count = min(mmc_combine_runs - i, (uint)max(mmc_combine_packed, 1));
+		if ((count > 1) && !mmc_bwrite_packed(dev, &mmc_combine_start[i], &mmc_combine_run[i], count))
+			continue;
+
+		//不支持packed或者packed失败，逐段写
+		for (j=i; j<i+count; j++) {
+			if (mmc_sprite->block_dev.block_write(dev, mmc_combine_start[j], mmc_combine_run[j].blocks,
+				mmc_combine_run[j].buf) != mmc_combine_run[j].blocks) {
+				printf("sunxi sprite error: combined write at 0x%lx, 0x%x sectors failed\n",
+					(ulong)mmc_combine_start[j], mmc_combine_run[j].blocks);
+				ret = -1;
+			}
+		}
+	}
+	mmc_combine_used = 0;
+	mmc_combine_runs = 0;
+
+	return ret;
+}
+
+static int
+sunxi_sprite_mmc_combine_overlap(lbaint_t start, lbaint_t end)
+{
+	uint i;
+
+	for (i=0; i<mmc_combine_runs; i++)
+		if ((start < mmc_combine_start[i] + mmc_combine_run[i].blocks) && (end > mmc_combine_start[i]))
+			return 1;
+
+	return 0;
+}
+
+static int
+sunxi_sprite_mmc_combine_write(unsigned int start_block, unsigned int nblock, void *buffer)
+{
+	int  dev = mmc_sprite->block_dev.dev;
+	lbaint_t start = start_block + CONFIG_MMC_LOGICAL_OFFSET;
+	lbaint_t last_end;
+	struct mmc_sg *last;
+	uint gap;
+
+	if (!mmc_combine_buff) {
+		mmc_combine_buff = memalign(ARCH_DMA_MINALIGN, MMC_COMBINE_BUFF_SECTORS * 512);
+		if (!mmc_combine_buff)
+			return mmc_sprite->block_dev.block_write(dev, start, nblock, buffer);
+		mmc_combine_packed = mmc_packed_write_max(dev);
+		printf("sprite write combine: packed write %d\n", mmc_combine_packed);
+	}
+
+	if ((nblock >= MMC_COMBINE_DIRECT_SECTORS) || sunxi_sprite_mmc_combine_overlap(start, start + nblock)) {
+		if (sunxi_sprite_mmc_combine_flush())
+			return 0;
+		if (nblock >= MMC_COMBINE_DIRECT_SECTORS)
+			return mmc_sprite->block_dev.block_write(dev, start, nblock, buffer);
+	}
+
+	//接在上一段后面
+	if (mmc_combine_runs) {
+		last = &mmc_combine_run[mmc_combine_runs - 1];
+		last_end = mmc_combine_start[mmc_combine_runs - 1] + last->blocks;
+		gap = start - last_end;
+		if ((start >= last_end) && (gap <= MMC_COMBINE_GAP_SECTORS)
+			&& (mmc_combine_used + gap + nblock <= MMC_COMBINE_BUFF_SECTORS)
+			&& (!gap || (!sunxi_sprite_mmc_combine_overlap(last_end, start)
+				&& (mmc_sprite->block_dev.block_read(dev, last_end, gap,
+					mmc_combine_buff + mmc_combine_used * 512) == gap)))) {
+			memcpy(mmc_combine_buff + (mmc_combine_used + gap) * 512, buffer, nblock * 512);
+			mmc_combine_used += gap + nblock;
+			last->blocks += gap + nblock;
+
+			return nblock;
+		}
+	}
+
+	//新开一段
+	if ((mmc_combine_runs == MMC_COMBINE_RUN_MAX)
+		|| (mmc_combine_used + nblock > MMC_COMBINE_BUFF_SECTORS)) {
+		if (sunxi_sprite_mmc_combine_flush())
+			return 0;
+	}
+	mmc_combine_start[mmc_combine_runs]      = start;
+	mmc_combine_run[mmc_combine_runs].buf    = mmc_combine_buff + mmc_combine_used * 512;
+	mmc_combine_run[mmc_combine_runs].blocks = nblock;
+	mmc_combine_runs ++;
+	memcpy(mmc_combine_buff + mmc_combine_used * 512, buffer, nblock * 512);
+	mmc_combine_used += nblock;
+
+	return nblock;
+}
+#else
+static inline int
+sunxi_sprite_mmc_combine_flush(void)
+{
+	return 0;
+}
+#endif
+
 //-------------------------------------sprite interface--------------------------------------------
 static int
 sunxi_sprite_mmc_read(unsigned int start_block, unsigned int nblock, void *buffer)
 {
 	debug("mmcsprite read: start 0x%x, sector 0x%x\n", start_block, nblock);
 
+	if (sunxi_sprite_mmc_combine_flush())
+		return 0;
+
 	return mmc_sprite->block_dev.block_read(mmc_sprite->block_dev.dev, start_block + CONFIG_MMC_LOGICAL_OFFSET,
 					nblock, buffer);
 }
@@ -72,13 +236,57 @@ sunxi_sprite_mmc_write(unsigned int start_block, unsigned int nblock, void *buff
 {
 	debug("mmcsprite write: start 0x%x, sector 0x%x\n", start_block, nblock);
 
+#ifdef CONFIG_SUNXI_SPRITE_WRITE_COMBINE
+	return sunxi_sprite_mmc_combine_write(start_block, nblock, buffer);
+#else
 	return mmc_sprite->block_dev.block_write(mmc_sprite->block_dev.dev, start_block + CONFIG_MMC_LOGICAL_OFFSET,
 					nblock, buffer);
+#endif
+}
+
+//逻辑区从CONFIG_MMC_LOGICAL_OFFSET开始，不会落到安全存储区，可以直接走异步接口
+static int
+sunxi_sprite_mmc_submit_read(unsigned int start_block, unsigned int nblock, void *buffer)
+{
+	debug("mmcsprite submit read: start 0x%x, sector 0x%x\n", start_block, nblock);
+
+	if (sunxi_sprite_mmc_combine_flush())
+		return -1;
+
+	return mmc_bread_start(mmc_sprite->block_dev.dev, start_block + CONFIG_MMC_LOGICAL_OFFSET,
+					nblock, buffer);
+}
+
+static int
+sunxi_sprite_mmc_submit_write(unsigned int start_block, unsigned int nblock, void *buffer)
+{
+	debug("mmcsprite submit write: start 0x%x, sector 0x%x\n", start_block, nblock);
+
+	if (sunxi_sprite_mmc_combine_flush())
+		return -1;
+
+	return mmc_bwrite_start(mmc_sprite->block_dev.dev, start_block + CONFIG_MMC_LOGICAL_OFFSET,
+					nblock, buffer);
+}
+
+static int
+sunxi_sprite_mmc_query(void)
+{
+	return mmc_async_done(mmc_sprite->block_dev.dev);
+}
+
+static int
+sunxi_sprite_mmc_complete(void)
+{
+	return mmc_async_wait(mmc_sprite->block_dev.dev);
 }
 
 static int
 sunxi_sprite_mmc_erase(int erase, void *mbr_buffer)
 {
+	if (sunxi_sprite_mmc_combine_flush())
+		return -1;
+
 	return card_erase(erase, mbr_buffer);
 }
 
@@ -95,22 +303,36 @@ sunxi_sprite_mmc_init(int stage){
 
 static int
 sunxi_sprite_mmc_exit(int force){
-	return 0;
+	return sunxi_sprite_mmc_combine_flush();
+}
+
+static int
+sunxi_sprite_mmc_flush(void)
+{
+	return sunxi_sprite_mmc_combine_flush();
 }
 
 
 int sunxi_sprite_mmc_phyread(unsigned int start_block, unsigned int nblock, void *buffer)
 {
+	if (sunxi_sprite_mmc_combine_flush())
+		return 0;
+
 	return mmc_sprite->block_dev.block_read_mass_pro(mmc_sprite->block_dev.dev, start_block, nblock, buffer);
 }
 
 int sunxi_sprite_mmc_phywrite(unsigned int start_block, unsigned int nblock, void *buffer)
 {
+	if (sunxi_sprite_mmc_combine_flush())
+		return 0;
+
 	return mmc_sprite->block_dev.block_write_mass_pro(mmc_sprite->block_dev.dev, start_block, nblock, buffer);
 }
 
 int sunxi_sprite_mmc_phyerase(unsigned int start_block, unsigned int nblock, void *skip)
 {
+	if (sunxi_sprite_mmc_combine_flush())
+		return -1;
 	if (nblock == 0) {
 		printf("%s: @nr is 0, erase from @from to end\n", __FUNCTION__);
 		nblock = mmc_sprite->block_dev.lba - start_block - 1;
@@ -120,6 +342,8 @@ int sunxi_sprite_mmc_phyerase(unsigned int start_block, unsigned int nblock, voi
 
 int sunxi_sprite_mmc_phywipe(unsigned int start_block, unsigned int nblock, void *skip)
 {
+	if (sunxi_sprite_mmc_combine_flush())
+		return -1;
 	if (nblock == 0) {
 		printf("%s: @nr is 0, wipe from @from to end\n", __FUNCTION__);
 		nblock = mmc_sprite->block_dev.lba - start_block - 1;
@@ -132,6 +356,31 @@ int sunxi_sprite_mmc_force_erase(void)
     return 0;
 }
 
+static int
+sunxi_sprite_mmc_discard(uint start_block, uint nblock, uint *skip_space)
+{
+	if (mmc_sprite_erased_mem < 0) {
+		ALLOC_CACHE_ALIGN_BUFFER(char, ext_csd, MMC_MAX_BLOCK_LEN);
+
+		if (IS_SD(mmc_sprite) || mmc_send_ext_csd(mmc_sprite, ext_csd))
+			mmc_sprite_erased_mem = 1;
+		else
+			mmc_sprite_erased_mem = ext_csd[EXT_CSD_ERASED_MEM_CONT] & 0x1;
+	}
+	//擦除后不是全0，或者不支持TRIM，只能写0
+	if (mmc_sprite_erased_mem || !(mmc_sprite->secure_feature & EXT_CSD_SEC_GB_CL_EN))
+		return -1;
+	if (sunxi_sprite_mmc_combine_flush())
+		return -1;
+
+	//整段只发一次普通TRIM，按扇区寻址不用对齐擦除组，也不会走secure erase/sanitize
+	if (mmc_sprite->block_dev.block_mmc_trim(mmc_sprite->block_dev.dev,
+			start_block + CONFIG_MMC_LOGICAL_OFFSET, nblock))
+		return -1;
+
+	return 0;
+}
+
 //-----------------------------secure interface---------------------------------------
 int sunxi_flash_mmc_secread( int item, unsigned char *buf, unsigned int nblock)
 {
@@ -200,12 +449,20 @@ int sdmmc_init_for_boot(int workmode, int card_no)
 	sunxi_flash_exit_pt  = sunxi_flash_mmc_exit;
 	sunxi_flash_phyread_pt  = sunxi_flash_mmc_phyread;
 	sunxi_flash_phywrite_pt = sunxi_flash_mmc_phywrite;
+	sunxi_flash_submit_read_pt  = sunxi_flash_mmc_submit_read;
+	sunxi_flash_submit_write_pt = sunxi_flash_mmc_submit_write;
+	sunxi_flash_query_pt    = sunxi_flash_mmc_query;
+	sunxi_flash_complete_pt = sunxi_flash_mmc_complete;
 	
 	//for fastboot
 	sunxi_sprite_phyread_pt  = sunxi_flash_mmc_phyread;
 	sunxi_sprite_phywrite_pt = sunxi_flash_mmc_phywrite;
 	sunxi_sprite_read_pt  = sunxi_flash_read_pt;
 	sunxi_sprite_write_pt = sunxi_flash_write_pt;
+	sunxi_sprite_submit_read_pt  = sunxi_flash_submit_read_pt;
+	sunxi_sprite_submit_write_pt = sunxi_flash_submit_write_pt;
+	sunxi_sprite_query_pt    = sunxi_flash_query_pt;
+	sunxi_sprite_complete_pt = sunxi_flash_complete_pt;
 
 	return 0;
 	
@@ -253,6 +510,13 @@ int sdmmc_init_for_sprite(int workmode)
 	sunxi_sprite_phyread_pt  = sunxi_sprite_mmc_phyread;
 	sunxi_sprite_phywrite_pt = sunxi_sprite_mmc_phywrite;
 	sunxi_sprite_force_erase_pt = sunxi_sprite_mmc_force_erase;
+	sunxi_sprite_discard_pt = sunxi_sprite_mmc_discard;
+	sunxi_sprite_flush_pt = sunxi_sprite_mmc_flush;
+	sunxi_sprite_sync_pt  = sunxi_sprite_mmc_flush;
+	sunxi_sprite_submit_read_pt  = sunxi_sprite_mmc_submit_read;
+	sunxi_sprite_submit_write_pt = sunxi_sprite_mmc_submit_write;
+	sunxi_sprite_query_pt    = sunxi_sprite_mmc_query;
+	sunxi_sprite_complete_pt = sunxi_sprite_mmc_complete;
 	debug("sunxi sprite has installed sdcard2 function\n");
 	
 	return 0;
@@ -286,6 +550,10 @@ int sdmmc_init_card0_for_sprite(void)
 	sunxi_flash_phyread_pt  = sunxi_flash_mmc_phyread;
 	sunxi_flash_phywrite_pt = sunxi_flash_mmc_phywrite;
 	sunxi_flash_exit_pt  = sunxi_flash_mmc_exit;
+	sunxi_flash_submit_read_pt  = sunxi_flash_mmc_submit_read;
+	sunxi_flash_submit_write_pt = sunxi_flash_mmc_submit_write;
+	sunxi_flash_query_pt    = sunxi_flash_mmc_query;
+	sunxi_flash_complete_pt = sunxi_flash_mmc_complete;
 	
 	return 0;
 }
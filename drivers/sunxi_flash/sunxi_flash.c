@@ -85,6 +85,11 @@ sunxi_null_force_erase(void){
     return 0;
 }
 
+static int
+sunxi_null_discard(uint start_block, uint nblock, uint *skip_space){
+	return -1;
+}
+
 #ifdef CONFIG_SUNXI_SPINOR
 static int
 sunxi_null_datafinish(void){
@@ -92,6 +97,57 @@ sunxi_null_datafinish(void){
 }
 #endif
 
+/*
+ * submit/complete fallback for backends without background transfers
+ * (nand library, spinor), the data is moved at submit time, query always
+ * reports done and complete hands out the count
+ */
+static int sunxi_flash_sync_result;
+static int sunxi_sprite_sync_result;
+
+static int
+sunxi_flash_sync_submit_read(uint start_block, uint nblock, void *buffer){
+	sunxi_flash_sync_result = sunxi_flash_read_pt(start_block, nblock, buffer);
+
+	return (sunxi_flash_sync_result == nblock) ? 0 : -1;
+}
+
+static int
+sunxi_flash_sync_submit_write(uint start_block, uint nblock, void *buffer){
+	sunxi_flash_sync_result = sunxi_flash_write_pt(start_block, nblock, buffer);
+
+	return (sunxi_flash_sync_result == nblock) ? 0 : -1;
+}
+
+static int
+sunxi_flash_sync_complete(void){
+	return sunxi_flash_sync_result;
+}
+
+static int
+sunxi_sprite_sync_submit_read(uint start_block, uint nblock, void *buffer){
+	sunxi_sprite_sync_result = sunxi_sprite_read_pt(start_block, nblock, buffer);
+
+	return (sunxi_sprite_sync_result == nblock) ? 0 : -1;
+}
+
+static int
+sunxi_sprite_sync_submit_write(uint start_block, uint nblock, void *buffer){
+	sunxi_sprite_sync_result = sunxi_sprite_write_pt(start_block, nblock, buffer);
+
+	return (sunxi_sprite_sync_result == nblock) ? 0 : -1;
+}
+
+static int
+sunxi_sprite_sync_complete(void){
+	return sunxi_sprite_sync_result;
+}
+
+static int
+sunxi_sync_query(void){
+	return 1;
+}
+
 
 /************************************************************************************************************
  *
@@ -156,6 +212,10 @@ int (* sunxi_flash_exit_pt) (int force) = sunxi_null_exit;
 int (* sunxi_flash_flush_pt) (void) = sunxi_null_flush;
 int (* sunxi_flash_phyread_pt) (unsigned int start_block, unsigned int nblock, void *buffer) = sunxi_null_op;
 int (* sunxi_flash_phywrite_pt)(unsigned int start_block, unsigned int nblock, void *buffer) = sunxi_null_op;
+int (* sunxi_flash_submit_read_pt) (uint start_block, uint nblock, void *buffer) = sunxi_flash_sync_submit_read;
+int (* sunxi_flash_submit_write_pt)(uint start_block, uint nblock, void *buffer) = sunxi_flash_sync_submit_write;
+int (* sunxi_flash_query_pt)(void) = sunxi_sync_query;
+int (* sunxi_flash_complete_pt)(void) = sunxi_flash_sync_complete;
 
 int (* sunxi_sprite_init_pt)(int stage) = sunxi_null_init;
 int (* sunxi_sprite_read_pt) (uint start_block, uint nblock, void *buffer) = sunxi_null_op;
@@ -164,9 +224,15 @@ int (* sunxi_sprite_erase_pt)(int erase, void *mbr_buffer) = sunxi_null_erase;
 uint (* sunxi_sprite_size_pt)(void) = sunxi_null_size;
 int (* sunxi_sprite_exit_pt) (int force) = sunxi_null_exit;
 int (* sunxi_sprite_flush_pt)(void) = sunxi_null_flush;
+int (* sunxi_sprite_sync_pt)(void) = sunxi_null_flush;
 int (* sunxi_sprite_force_erase_pt)(void)  = sunxi_null_force_erase;
+int (* sunxi_sprite_discard_pt)(uint start_block, uint nblock, uint *skip_space) = sunxi_null_discard;
 int (* sunxi_sprite_phyread_pt) (unsigned int start_block, unsigned int nblock, void *buffer) = sunxi_null_op;
 int (* sunxi_sprite_phywrite_pt)(unsigned int start_block, unsigned int nblock, void *buffer) = sunxi_null_op;
+int (* sunxi_sprite_submit_read_pt) (uint start_block, uint nblock, void *buffer) = sunxi_sprite_sync_submit_read;
+int (* sunxi_sprite_submit_write_pt)(uint start_block, uint nblock, void *buffer) = sunxi_sprite_sync_submit_write;
+int (* sunxi_sprite_query_pt)(void) = sunxi_sync_query;
+int (* sunxi_sprite_complete_pt)(void) = sunxi_sprite_sync_complete;
 #ifdef CONFIG_SUNXI_SPINOR
 int (* sunxi_sprite_datafinish_pt) (void) = sunxi_null_datafinish;
 #endif
@@ -174,15 +240,64 @@ int (* sunxi_sprite_datafinish_pt) (void) = sunxi_null_datafinish;
 
 
 //-------------------------------------noraml interface start--------------------------------------------
+#ifdef CONFIG_BOOTSTAGE
+/* one bootstage accumulator for all reads, its name carries the byte count */
+static ulong flash_read_bytes;
+static char flash_read_name[40];
+#endif
+
 int sunxi_flash_read (uint start_block, uint nblock, void *buffer)
 {
+	int ret;
+
 	debug("sunxi flash read : start %d, sector %d\n", start_block, nblock);
-	return sunxi_flash_read_pt(start_block, nblock, buffer);
+#ifdef CONFIG_BOOTSTAGE
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FLASH_READ, flash_read_name);
+#endif
+	ret = sunxi_flash_read_pt(start_block, nblock, buffer);
+#ifdef CONFIG_BOOTSTAGE
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FLASH_READ);
+	flash_read_bytes += (ulong)nblock * 512;
+	snprintf(flash_read_name, sizeof(flash_read_name),
+		 "sunxi_flash_read %lu bytes", flash_read_bytes);
+#endif
+	return ret;
+}
+
+/*
+ * queue one transfer on the medium and return at once, 0 when it was
+ * accepted. the buffer belongs to the transfer until sunxi_flash_complete()
+ * returns the number of sectors moved; only one transfer is outstanding,
+ * any other flash access first completes it
+ */
+int sunxi_flash_submit_read(uint start_block, uint nblock, void *buffer)
+{
+	debug("sunxi flash submit read : start %d, sector %d\n", start_block, nblock);
+	return sunxi_flash_submit_read_pt(start_block, nblock, buffer);
+}
+
+int sunxi_flash_submit_write(uint start_block, uint nblock, void *buffer)
+{
+	debug("sunxi flash submit write : start %d, sector %d\n", start_block, nblock);
+	block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
+	return sunxi_flash_submit_write_pt(start_block, nblock, buffer);
+}
+
+/* 1 when sunxi_flash_complete() would not block */
+int sunxi_flash_query(void)
+{
+	return sunxi_flash_query_pt();
+}
+
+int sunxi_flash_complete(void)
+{
+	return sunxi_flash_complete_pt();
 }
 
 int sunxi_flash_write(uint start_block, uint nblock, void *buffer)
 {
 	debug("sunxi flash write : start %d, sector %d\n", start_block, nblock);
+	block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
 	return sunxi_flash_write_pt(start_block, nblock, buffer);
 }
 
@@ -208,6 +323,7 @@ int sunxi_flash_phyread (uint start_block, uint nblock, void *buffer)
 
 int sunxi_flash_phywrite(uint start_block, uint nblock, void *buffer)
 {
+	block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
 	return sunxi_flash_phywrite_pt(start_block, nblock, buffer);
 }
 //-----------------------------------noraml interface end---------------------------------------------------
@@ -226,11 +342,13 @@ int sunxi_sprite_read (uint start_block, uint nblock, void *buffer)
 
 int sunxi_sprite_write(uint start_block, uint nblock, void *buffer)
 {
+	block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
 	return sunxi_sprite_write_pt(start_block, nblock, buffer);
 }
 
 int sunxi_sprite_erase(int erase, void *mbr_buffer)
 {
+	block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
 	return sunxi_sprite_erase_pt(erase, mbr_buffer);
 }
 
@@ -249,6 +367,16 @@ int sunxi_sprite_flush(void)
 	return sunxi_sprite_flush_pt();
 }
 
+/*
+ * write back what the driver still holds for earlier sprite writes and
+ * return their status. unlike sunxi_sprite_flush() this does not flush
+ * the medium itself, so it is cheap to call after every item
+ */
+int sunxi_sprite_sync(void)
+{
+	return sunxi_sprite_sync_pt();
+}
+
 int sunxi_sprite_phyread (uint start_block, uint nblock, void *buffer)
 {
 	return sunxi_sprite_phyread_pt(start_block, nblock, buffer);
@@ -256,13 +384,49 @@ int sunxi_sprite_phyread (uint start_block, uint nblock, void *buffer)
 
 int sunxi_sprite_phywrite(uint start_block, uint nblock, void *buffer)
 {
+	block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
 	return sunxi_sprite_phywrite_pt(start_block, nblock, buffer);
 }
 
 int sunxi_sprite_force_erase(void)
 {
+    block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
     return sunxi_sprite_force_erase_pt();
 }
+
+/*
+ * make the blocks read back as zero without writing them.
+ * return 0 when done, 1 when the sectors listed in skip_space
+ * (same layout as sunxi_sprite_mmc_phyerase) still need zeros,
+ * -1 when the medium can not do it and the caller has to write
+ */
+int sunxi_sprite_discard(uint start_block, uint nblock, uint *skip_space)
+{
+	block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
+	return sunxi_sprite_discard_pt(start_block, nblock, skip_space);
+}
+
+/* same contract as sunxi_flash_submit_read() and friends */
+int sunxi_sprite_submit_read(uint start_block, uint nblock, void *buffer)
+{
+	return sunxi_sprite_submit_read_pt(start_block, nblock, buffer);
+}
+
+int sunxi_sprite_submit_write(uint start_block, uint nblock, void *buffer)
+{
+	block_dev_invalidate(IF_TYPE_SUNXI_FLASH, -1);
+	return sunxi_sprite_submit_write_pt(start_block, nblock, buffer);
+}
+
+int sunxi_sprite_query(void)
+{
+	return sunxi_sprite_query_pt();
+}
+
+int sunxi_sprite_complete(void)
+{
+	return sunxi_sprite_complete_pt();
+}
 //-------------------------------------sprite interface end-----------------------------------------------
 
 //sunxi flash boot interface init 
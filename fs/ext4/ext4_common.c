@@ -44,7 +44,46 @@ int ext4fs_indir3_blkno = -1;
 struct ext2_inode *g_parent_inode;
 static int symlinknest;
 
+/*
+ * Extent tree nodes below the inode, one cached block per tree depth.
+ * Lookups for neighbouring file blocks walk the same index path, and
+ * a whole file read only moves on to the next node of each level, so
+ * keeping the last node seen at each depth saves re-reading it.
+ */
+static char *ext4fs_extent_block[EXT4_EXT_MAX_DEPTH];
+static unsigned long long ext4fs_extent_blkno[EXT4_EXT_MAX_DEPTH];
+static int ext4fs_extent_size;
+
+static void ext4fs_extent_cache_free(void)
+{
+	int i;
+
+	for (i = 0; i < EXT4_EXT_MAX_DEPTH; i++) {
+		free(ext4fs_extent_block[i]);
+		ext4fs_extent_block[i] = NULL;
+		ext4fs_extent_blkno[i] = 0;
+	}
+	ext4fs_extent_size = 0;
+}
+
 #if defined(CONFIG_EXT4_WRITE)
+/* drop cached extent nodes overlapping a write of size bytes at off */
+static void ext4fs_extent_cache_discard(uint64_t off, uint32_t size)
+{
+	uint64_t blkoff;
+	int i;
+
+	if (!ext4fs_extent_size)
+		return;
+
+	for (i = 0; i < EXT4_EXT_MAX_DEPTH; i++) {
+		blkoff = ext4fs_extent_blkno[i] * ext4fs_extent_size;
+		if (ext4fs_extent_blkno[i] && off < blkoff + ext4fs_extent_size &&
+		    off + size > blkoff)
+			ext4fs_extent_blkno[i] = 0;
+	}
+}
+
 uint32_t ext4fs_div_roundup(uint32_t size, uint32_t n)
 {
 	uint32_t res = size / n;
@@ -70,6 +109,8 @@ void put_ext4(uint64_t off, void *buf, uint32_t size)
 	if (fs->dev_desc == NULL)
 		return;
 
+	ext4fs_extent_cache_discard(off, size);
+
 	if ((startblock + (size >> log2blksz)) >
 	    (part_offset + fs->total_sect)) {
 		printf("part_offset is " LBAFU "\n", part_offset);
@@ -80,28 +121,28 @@ void put_ext4(uint64_t off, void *buf, uint32_t size)
 
 	if (remainder) {
 		if (fs->dev_desc->block_read) {
-			fs->dev_desc->block_read(fs->dev_desc->dev,
-						 startblock, 1, sec_buf);
+			block_dread(fs->dev_desc,
+				    startblock, 1, sec_buf);
 			temp_ptr = sec_buf;
 			memcpy((temp_ptr + remainder),
 			       (unsigned char *)buf, size);
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock, 1, sec_buf);
+			block_dwrite(fs->dev_desc,
+				     startblock, 1, sec_buf);
 		}
 	} else {
 		if (size >> log2blksz != 0) {
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock,
-						  size >> log2blksz,
-						  (unsigned long *)buf);
+			block_dwrite(fs->dev_desc,
+				     startblock,
+				     size >> log2blksz,
+				     (unsigned long *)buf);
 		} else {
-			fs->dev_desc->block_read(fs->dev_desc->dev,
-						 startblock, 1, sec_buf);
+			block_dread(fs->dev_desc,
+				    startblock, 1, sec_buf);
 			temp_ptr = sec_buf;
 			memcpy(temp_ptr, buf, size);
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock, 1,
-						  (unsigned long *)sec_buf);
+			block_dwrite(fs->dev_desc,
+				     startblock, 1,
+				     (unsigned long *)sec_buf);
 		}
 	}
 }
@@ -1403,14 +1444,51 @@ void ext4fs_allocate_blocks(struct ext2_inode *file_inode,
 
 #endif
 
+/* read an extent tree node at depth 'depth' through the node cache */
+static struct ext4_extent_header *ext4fs_read_extent_block
+	(struct ext2_data *data, unsigned long long block, int depth)
+{
+	struct ext4_extent_header *ext_block;
+	int blksz = EXT2_BLOCK_SIZE(data);
+	int log2_blksz = LOG2_BLOCK_SIZE(data) - get_fs()->dev_desc->log2blksz;
+
+	if (depth < 0 || depth >= EXT4_EXT_MAX_DEPTH)
+		return 0;
+
+	if (blksz != ext4fs_extent_size) {
+		ext4fs_extent_cache_free();
+		ext4fs_extent_size = blksz;
+	}
+	if (ext4fs_extent_block[depth] == NULL) {
+		ext4fs_extent_block[depth] = zalloc(blksz);
+		if (ext4fs_extent_block[depth] == NULL)
+			return 0;
+	}
+
+	ext_block = (struct ext4_extent_header *)ext4fs_extent_block[depth];
+	if (ext4fs_extent_blkno[depth] == block)
+		return ext_block;
+
+	ext4fs_extent_blkno[depth] = 0;
+	if (!ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
+			    (char *)ext_block))
+		return 0;
+
+	if (le16_to_cpu(ext_block->eh_magic) != EXT4_EXT_MAGIC ||
+	    le16_to_cpu(ext_block->eh_depth) != depth)
+		return 0;
+
+	ext4fs_extent_blkno[depth] = block;
+
+	return ext_block;
+}
+
 static struct ext4_extent_header *ext4fs_get_extent_block
-	(struct ext2_data *data, char *buf,
-		struct ext4_extent_header *ext_block,
-		uint32_t fileblock, int log2_blksz)
+	(struct ext2_data *data, struct ext4_extent_header *ext_block,
+		uint32_t fileblock)
 {
 	struct ext4_extent_idx *index;
 	unsigned long long block;
-	int blksz = EXT2_BLOCK_SIZE(data);
 	int i;
 
 	while (1) {
@@ -1434,14 +1512,195 @@ static struct ext4_extent_header *ext4fs_get_extent_block
 		block = le16_to_cpu(index[i].ei_leaf_hi);
 		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
 
-		if (ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
-				   buf))
-			ext_block = (struct ext4_extent_header *)buf;
-		else
+		ext_block = ext4fs_read_extent_block(data, block,
+				le16_to_cpu(ext_block->eh_depth) - 1);
+		if (!ext_block)
 			return 0;
 	}
 }
 
+/* state of an extent run read, offsets are bytes */
+struct ext4_extent_run {
+	char *buf;			/* destination of file offset pos */
+	unsigned long long pos;
+	unsigned long long end;		/* end of the requested range */
+	unsigned long long done;	/* buf is filled up to here */
+	unsigned long long run_pos;	/* pending device read: file offset */
+	unsigned long long run_dev;	/* and partition byte offset */
+	unsigned int run_len;
+};
+
+/* keep single reads well inside ext4fs_devread()'s int byte count */
+#define EXT4_EXT_RUN_MAX	(1U << 30)
+
+static int ext4fs_extent_run_flush(struct ext4_extent_run *run)
+{
+	int log2blksz = get_fs()->dev_desc->log2blksz;
+	int status;
+
+	if (!run->run_len)
+		return 0;
+
+	status = ext4fs_devread((lbaint_t)(run->run_dev >> log2blksz),
+				run->run_dev & ((1 << log2blksz) - 1),
+				run->run_len,
+				run->buf + (run->run_pos - run->pos));
+	run->run_len = 0;
+
+	return status ? 0 : -EIO;
+}
+
+static void ext4fs_extent_run_zero(struct ext4_extent_run *run,
+				   unsigned long long to)
+{
+	if (to > run->done)
+		memset(run->buf + (run->done - run->pos), 0, to - run->done);
+	run->done = to;
+}
+
+/* queue file bytes [from, to) stored at partition byte offset dev */
+static int ext4fs_extent_run_add(struct ext4_extent_run *run,
+				 unsigned long long from,
+				 unsigned long long to,
+				 unsigned long long dev)
+{
+	unsigned int len;
+
+	ext4fs_extent_run_zero(run, from);
+
+	while (from < to) {
+		len = min(to - from, (unsigned long long)EXT4_EXT_RUN_MAX);
+		if (run->run_len && run->run_pos + run->run_len == from &&
+		    run->run_dev + run->run_len == dev &&
+		    run->run_len + len <= EXT4_EXT_RUN_MAX) {
+			run->run_len += len;
+		} else {
+			if (ext4fs_extent_run_flush(run))
+				return -EIO;
+			run->run_pos = from;
+			run->run_dev = dev;
+			run->run_len = len;
+		}
+		from += len;
+		dev += len;
+	}
+	run->done = to;
+
+	return 0;
+}
+
+static int ext4fs_extent_walk(struct ext2_data *data,
+			      struct ext4_extent_header *ext_block,
+			      struct ext4_extent_run *run)
+{
+	struct ext4_extent_header *child;
+	struct ext4_extent_idx *index;
+	struct ext4_extent *extent;
+	unsigned long long blksz = EXT2_BLOCK_SIZE(data);
+	unsigned long long from, to, start;
+	unsigned long long block;
+	int entries = le16_to_cpu(ext_block->eh_entries);
+	int depth = le16_to_cpu(ext_block->eh_depth);
+	unsigned int len;
+	int i, ret;
+
+	if (depth == 0) {
+		extent = (struct ext4_extent *)(ext_block + 1);
+		for (i = 0; i < entries && run->done < run->end; i++) {
+			len = le16_to_cpu(extent[i].ee_len);
+			/* uninitialized extents read as zeros, like holes */
+			if (len > EXT4_EXT_INIT_MAX_LEN)
+				continue;
+
+			from = le32_to_cpu(extent[i].ee_block) * blksz;
+			to = from + len * blksz;
+			if (to <= run->done)
+				continue;
+			if (from >= run->end)
+				break;
+
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+					le32_to_cpu(extent[i].ee_start_lo);
+			start *= blksz;
+			if (from < run->done) {
+				start += run->done - from;
+				from = run->done;
+			}
+			if (to > run->end)
+				to = run->end;
+
+			ret = ext4fs_extent_run_add(run, from, to, start);
+			if (ret)
+				return ret;
+		}
+		return 0;
+	}
+
+	index = (struct ext4_extent_idx *)(ext_block + 1);
+	for (i = 0; i < entries && run->done < run->end; i++) {
+		/* index i covers file blocks up to the next index */
+		if (i + 1 < entries &&
+		    le32_to_cpu(index[i + 1].ei_block) * blksz <= run->done)
+			continue;
+		if (le32_to_cpu(index[i].ei_block) * blksz >= run->end)
+			break;
+
+		block = le16_to_cpu(index[i].ei_leaf_hi);
+		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
+
+		child = ext4fs_read_extent_block(data, block, depth - 1);
+		if (!child) {
+			printf("invalid extent block\n");
+			return -EINVAL;
+		}
+
+		ret = ext4fs_extent_walk(data, child, run);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Read len bytes at pos of an extent mapped file.  The extent tree is
+ * walked once for the whole range, every physically contiguous run is
+ * read with one ext4fs_devread() straight into buf and holes are
+ * zeroed.  Returns 0 on success or a negative error.
+ */
+int ext4fs_read_extents(struct ext2_inode *inode, unsigned long long pos,
+			unsigned int len, char *buf)
+{
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent_run run;
+	int ret;
+
+	ext_block = (struct ext4_extent_header *)inode->b.blocks.dir_blocks;
+	if (le16_to_cpu(ext_block->eh_magic) != EXT4_EXT_MAGIC ||
+	    le16_to_cpu(ext_block->eh_depth) > EXT4_EXT_MAX_DEPTH) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+
+	memset(&run, 0, sizeof(run));
+	run.buf = buf;
+	run.pos = pos;
+	run.done = pos;
+	run.end = pos + len;
+
+	ret = ext4fs_extent_walk(ext4fs_root, ext_block, &run);
+	if (!ret)
+		ret = ext4fs_extent_run_flush(&run);
+	if (ret)
+		return ret;
+
+	/* past the last extent */
+	ext4fs_extent_run_zero(&run, run.end);
+
+	return 0;
+}
+
 static int ext4fs_blockgroup
 	(struct ext2_data *data, int group, struct ext2_block_group *blkgrp)
 {
@@ -1511,20 +1770,16 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		char *buf = zalloc(blksz);
-		if (!buf)
-			return -ENOMEM;
 		struct ext4_extent_header *ext_block;
 		struct ext4_extent *extent;
 		int i = -1;
 		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, buf,
+			ext4fs_get_extent_block(ext4fs_root,
 						(struct ext4_extent_header *)
 						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
+						fileblock);
 		if (!ext_block) {
 			printf("invalid extent block\n");
-			free(buf);
 			return -EINVAL;
 		}
 
@@ -1537,20 +1792,16 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 		} while (fileblock >= le32_to_cpu(extent[i].ee_block));
 		if (--i >= 0) {
 			fileblock -= le32_to_cpu(extent[i].ee_block);
-			if (fileblock >= le16_to_cpu(extent[i].ee_len)) {
-				free(buf);
+			if (fileblock >= le16_to_cpu(extent[i].ee_len))
 				return 0;
-			}
 
 			start = le16_to_cpu(extent[i].ee_start_hi);
 			start = (start << 32) +
 					le32_to_cpu(extent[i].ee_start_lo);
-			free(buf);
 			return fileblock + start;
 		}
 
 		printf("Extent Error\n");
-		free(buf);
 		return -1;
 	}
 
@@ -1853,6 +2104,7 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
  */
 void ext4fs_reinit_global(void)
 {
+	ext4fs_extent_cache_free();
 	if (ext4fs_indir1_block != NULL) {
 		free(ext4fs_indir1_block);
 		ext4fs_indir1_block = NULL;
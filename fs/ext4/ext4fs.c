@@ -67,6 +67,13 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 	if (len > filesize)
 		len = filesize;
 
+	/* extent mapped files are read one contiguous run at a time */
+	if (le32_to_cpu(node->inode.flags) & EXT4_EXTENTS_FL) {
+		if (ext4fs_read_extents(&node->inode, pos, len, buf))
+			return -1;
+		return len;
+	}
+
 	blockcnt = ((len + pos) + blocksize - 1) / blocksize;
 
 	for (i = pos / blocksize; i < blockcnt; i++) {
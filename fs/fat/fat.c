@@ -48,10 +48,194 @@ static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 	if (!cur_dev || !cur_dev->block_read)
 		return -1;
 
-	return cur_dev->block_read(cur_dev->dev,
-			cur_part_info.start + block, nr_blocks, buf);
+	return block_dread(cur_dev,
+			   cur_part_info.start + block, nr_blocks, buf);
 }
 
+#ifndef CONFIG_BLOCK_CACHE
+/*
+ * Read cache for the boot sector, FAT and directory blocks. It is kept
+ * across fatload/fatls calls, so loading several files from the same
+ * partition walks the FAT and the directories from memory. Lines are
+ * single blocks keyed by device and absolute LBA and replaced LRU.
+ * Blocks missing from a request are fetched with one read per run, a
+ * FAT miss also pulls in the following FAT blocks.
+ */
+struct fat_cache_line {
+	block_dev_desc_t *dev;
+	lbaint_t lba;
+	ulong age;
+};
+
+static struct {
+	struct fat_cache_line line[CONFIG_FS_FAT_CACHE_BLOCKS];
+	__u8 *data;		/* CONFIG_FS_FAT_CACHE_BLOCKS blocks */
+	__u8 *stage;		/* FAT_CACHE_STAGE_BLOCKS blocks */
+	ulong blksz;
+	ulong tick;
+} fat_cache;
+
+void fat_cache_invalidate(void)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_FS_FAT_CACHE_BLOCKS; i++)
+		fat_cache.line[i].dev = NULL;
+}
+
+/* drop the cached copies of blocks [block, block + nr_blocks) */
+static void __maybe_unused fat_cache_discard(__u32 block, __u32 nr_blocks)
+{
+	lbaint_t lba = cur_part_info.start + block;
+	int i;
+
+	for (i = 0; i < CONFIG_FS_FAT_CACHE_BLOCKS; i++) {
+		struct fat_cache_line *line = &fat_cache.line[i];
+
+		if (line->dev == cur_dev && line->lba >= lba &&
+		    line->lba < lba + nr_blocks)
+			line->dev = NULL;
+	}
+}
+
+static int fat_cache_setup(void)
+{
+	if (!cur_dev)
+		return -1;
+	if (fat_cache.data && fat_cache.blksz == cur_dev->blksz)
+		return 0;
+
+	free(fat_cache.data);
+	free(fat_cache.stage);
+	fat_cache_invalidate();
+	fat_cache.blksz = cur_dev->blksz;
+	fat_cache.data = memalign(ARCH_DMA_MINALIGN,
+				  CONFIG_FS_FAT_CACHE_BLOCKS * fat_cache.blksz);
+	fat_cache.stage = memalign(ARCH_DMA_MINALIGN,
+				   FAT_CACHE_STAGE_BLOCKS * fat_cache.blksz);
+	if (!fat_cache.data || !fat_cache.stage) {
+		free(fat_cache.data);
+		free(fat_cache.stage);
+		fat_cache.data = NULL;
+		fat_cache.stage = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+static __u8 *fat_cache_find(lbaint_t lba)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_FS_FAT_CACHE_BLOCKS; i++) {
+		struct fat_cache_line *line = &fat_cache.line[i];
+
+		if (line->dev == cur_dev && line->lba == lba) {
+			line->age = ++fat_cache.tick;
+			return fat_cache.data + i * fat_cache.blksz;
+		}
+	}
+
+	return NULL;
+}
+
+static void fat_cache_insert(lbaint_t lba, const __u8 *buf)
+{
+	struct fat_cache_line *victim = &fat_cache.line[0];
+	int i;
+
+	for (i = 0; i < CONFIG_FS_FAT_CACHE_BLOCKS; i++) {
+		struct fat_cache_line *line = &fat_cache.line[i];
+
+		if (line->dev == cur_dev && line->lba == lba) {
+			victim = line;
+			break;
+		}
+		if (!line->dev) {
+			victim = line;
+			continue;
+		}
+		if (victim->dev && line->age < victim->age)
+			victim = line;
+	}
+
+	victim->dev = cur_dev;
+	victim->lba = lba;
+	victim->age = ++fat_cache.tick;
+	memcpy(fat_cache.data + (victim - fat_cache.line) * fat_cache.blksz,
+	       buf, fat_cache.blksz);
+}
+
+/*
+ * disk_read() through the cache. Up to 'ahead' blocks following the
+ * request are read and cached along with the last missing run, as long as
+ * they are not cached already. Requests too big to be worth caching go
+ * straight to the disk. Returns nr_blocks, or -1 on error.
+ */
+static int fat_cache_read(__u32 block, __u32 nr_blocks, void *buf, __u32 ahead)
+{
+	__u8 *dst = buf;
+	__u32 i, run, extra;
+	__u8 *hit;
+
+	if (nr_blocks > FAT_CACHE_STAGE_BLOCKS || fat_cache_setup())
+		return disk_read(block, nr_blocks, buf);
+
+	for (i = 0; i < nr_blocks; i += run) {
+		hit = fat_cache_find(cur_part_info.start + block + i);
+		if (hit) {
+			memcpy(dst + i * fat_cache.blksz, hit, fat_cache.blksz);
+			run = 1;
+			continue;
+		}
+
+		/* coalesce the missing blocks into one read */
+		for (run = 1; i + run < nr_blocks; run++) {
+			if (fat_cache_find(cur_part_info.start + block + i + run))
+				break;
+		}
+		extra = 0;
+		if (i + run == nr_blocks) {
+			while (extra < ahead &&
+			       run + extra < FAT_CACHE_STAGE_BLOCKS &&
+			       !fat_cache_find(cur_part_info.start + block +
+					       nr_blocks + extra))
+				extra++;
+		}
+
+		if (disk_read(block + i, run + extra, fat_cache.stage) !=
+		    run + extra) {
+			if (!extra)
+				return -1;
+			/* the read ahead may run off the partition */
+			extra = 0;
+			if (disk_read(block + i, run, fat_cache.stage) != run)
+				return -1;
+		}
+		memcpy(dst + i * fat_cache.blksz, fat_cache.stage,
+		       run * fat_cache.blksz);
+		for (extra += run; extra; extra--)
+			fat_cache_insert(cur_part_info.start + block + i +
+					 extra - 1,
+					 fat_cache.stage +
+					 (extra - 1) * fat_cache.blksz);
+	}
+
+	return nr_blocks;
+}
+#else
+/* block_dread() already caches the metadata blocks, do not keep them twice */
+static void __maybe_unused fat_cache_discard(__u32 block, __u32 nr_blocks)
+{
+}
+
+static int fat_cache_read(__u32 block, __u32 nr_blocks, void *buf, __u32 ahead)
+{
+	return disk_read(block, nr_blocks, buf);
+}
+#endif
+
 int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
@@ -65,6 +249,16 @@ int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
 		return -1;
 	}
 
+#ifndef CONFIG_BLOCK_CACHE
+	/* a volume that changed under us drops what was cached from it */
+	if (fat_cache.data && fat_cache.blksz == dev_desc->blksz) {
+		__u8 *cached = fat_cache_find(info->start);
+
+		if (cached && memcmp(cached, buffer, dev_desc->blksz))
+			fat_cache_invalidate();
+	}
+#endif
+
 	/* Check if it's actually a DOS volume */
 	if (memcmp(buffer + DOS_BOOT_MAGIC_OFFSET, "\x55\xAA", 2)) {
 		cur_dev = NULL;
@@ -199,7 +393,11 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 
 		startblock += mydata->fat_sect;	/* Offset from start of disk */
 
-		if (disk_read(startblock, getsize, bufptr) < 0) {
+		/* the rest of the chain is likely in the next FAT blocks */
+		if (fat_cache_read(startblock, getsize, bufptr,
+				   min((__u32)FAT_CACHE_READAHEAD,
+				       fatlength - bufnum * FATBUFBLOCKS -
+				       getsize)) < 0) {
 			debug("Error reading FAT blocks\n");
 			return ret;
 		}
@@ -314,6 +512,27 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * get_cluster() for directory clusters, which go through the cache.
+ */
+static int
+get_dir_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer,
+		unsigned long size)
+{
+	__u32 startsect;
+
+	if (clustnum == 0 || size % mydata->sect_size)
+		return get_cluster(mydata, clustnum, buffer, size);
+
+	startsect = mydata->data_begin + clustnum * mydata->clust_size;
+	if (fat_cache_read(startsect, size / mydata->sect_size, buffer, 0) < 0) {
+		debug("Error reading directory cluster %u\n", clustnum);
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  * Read at most 'maxsize' bytes from 'pos' in the file associated with 'dentptr'
  * into 'buffer'.
@@ -507,8 +726,9 @@ get_vfatname(fsdata *mydata, int curclust, __u8 *cluster,
 			return -1;
 		}
 
-		if (get_cluster(mydata, curclust, get_contents_vfatname_block,
-				mydata->clust_size * mydata->sect_size) != 0) {
+		if (get_dir_cluster(mydata, curclust,
+				    get_contents_vfatname_block,
+				    mydata->clust_size * mydata->sect_size) != 0) {
 			debug("Error: reading directory block\n");
 			return -1;
 		}
@@ -589,8 +809,8 @@ static dir_entry *get_dentfromdir(fsdata *mydata, int startsect,
 
 		int i;
 
-		if (get_cluster(mydata, curclust, get_dentfromdir_block,
-				mydata->clust_size * mydata->sect_size) != 0) {
+		if (get_dir_cluster(mydata, curclust, get_dentfromdir_block,
+				    mydata->clust_size * mydata->sect_size) != 0) {
 			debug("Error: reading directory block\n");
 			return NULL;
 		}
@@ -753,7 +973,7 @@ read_bootsectandvi(boot_sector *bs, volume_info *volinfo, int *fatsize)
 		return -1;
 	}
 
-	if (disk_read(0, 1, block) < 0) {
+	if (fat_cache_read(0, 1, block, 0) < 0) {
 		debug("Error: reading block\n");
 		goto fail;
 	}
@@ -918,11 +1138,11 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 			debug("FAT read sect=%d, clust_size=%d, DIRENTSPERBLOCK=%zd\n",
 				cursect, mydata->clust_size, DIRENTSPERBLOCK);
 
-			if (disk_read(cursect,
+			if (fat_cache_read(cursect,
 					(mydata->fatsize == 32) ?
 					(mydata->clust_size) :
 					PREFETCH_BLOCKS,
-					do_fat_read_at_block) < 0) {
+					do_fat_read_at_block, 0) < 0) {
 				debug("Error: reading rootdir block\n");
 				goto exit;
 			}
@@ -192,6 +192,13 @@ enum bootstage_id {
 
 	BOOTSTAGE_ID_ACCUM_LCD,
 
+	/* sunxi boot0 and boot path */
+	BOOTSTAGE_ID_DRAM_INIT,
+	BOOTSTAGE_ID_TOC1_LOAD,
+	BOOTSTAGE_ID_SPL_EXIT,
+	BOOTSTAGE_ID_ACCUM_FLASH_READ,
+	BOOTSTAGE_ID_ACCUM_VERIFY,
+
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
 	BOOTSTAGE_ID_COUNT = BOOTSTAGE_ID_USER + CONFIG_BOOTSTAGE_USER_COUNT,
@@ -205,6 +212,38 @@ enum bootstage_id {
  */
 ulong timer_get_boot_us(void);
 
+#ifndef USE_HOSTCC
+/*
+ * Layout of the records in memory and of bootstage_stash(), shared with
+ * a boot stage before U-Boot that stashes its own records for
+ * bootstage_unstash() to pick up, and with tools/bootstage_report.py.
+ */
+struct bootstage_record {
+	ulong time_us;
+	uint32_t start_us;
+	const char *name;
+	int flags;		/* see enum bootstage_flags */
+	enum bootstage_id id;
+};
+
+enum {
+	BOOTSTAGE_VERSION	= 0,
+	BOOTSTAGE_MAGIC		= 0xb00757a3,
+};
+
+/*
+ * A stash is this header, then the records, then the name of each record
+ * as a nul-terminated string.  The name pointers in the records mean
+ * nothing there.
+ */
+struct bootstage_hdr {
+	uint32_t version;	/* BOOTSTAGE_VERSION */
+	uint32_t count;		/* Number of records */
+	uint32_t size;		/* Total data size (non-zero if valid) */
+	uint32_t magic;		/* BOOTSTAGE_MAGIC */
+};
+#endif
+
 #if !defined(CONFIG_SPL_BUILD) && !defined(USE_HOSTCC)
 /*
  * Board code can implement show_boot_progress() if needed.
@@ -642,6 +642,7 @@ void	serial_putc_raw(const char);
 void	serial_puts   (const char *);
 int	serial_getc   (void);
 int	serial_tstc   (void);
+void	serial_flush  (void);
 
 void	_serial_setbrg (const int);
 void	_serial_putc   (const char, const int);
@@ -819,6 +820,10 @@ char *	strmhz(char *buf, unsigned long hz);
 /* lib/crc32.c */
 #include <u-boot/crc.h>
 
+/* lib/add_sum.c */
+uint add_sum_generic(void *buffer, uint length);
+uint add_sum_neon(void *buffer, uint length);
+
 /* lib/rand.c */
 #define RAND_MAX -1U
 void srand(unsigned int seed);
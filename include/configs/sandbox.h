@@ -23,6 +23,11 @@
 
 #define CONFIG_BOOTSTAGE
 #define CONFIG_BOOTSTAGE_REPORT
+#define CONFIG_CMD_BOOTSTAGE
+#define CONFIG_BOOTSTAGE_USER_COUNT	96
+#define CONFIG_BOOTSTAGE_INITCALL
+#define CONFIG_BOOTSTAGE_STASH		0x00200000
+#define CONFIG_BOOTSTAGE_STASH_SIZE	0x4000
 #define CONFIG_DM
 #define CONFIG_CMD_DEMO
 #define CONFIG_CMD_DM
@@ -55,6 +60,8 @@
 #define CONFIG_CMD_PART
 #define CONFIG_DOS_PARTITION
 #define CONFIG_HOST_MAX_DEVICES 4
+#define CONFIG_BLOCK_CACHE
+#define CONFIG_CMD_BLOCK_CACHE
 #define CONFIG_CMD_FS_GENERIC
 
 #define CONFIG_SYS_VSNPRINTF
@@ -71,6 +78,9 @@
  * Size of malloc() pool, although we don't actually use this yet.
  */
 #define CONFIG_SYS_MALLOC_LEN		(32 << 20)	/* 32MB  */
+#define CONFIG_SYS_MALLOC_STATS
+#define CONFIG_CMD_MALLOC
+#define CONFIG_CPU_JOB			/* no second core, jobs run inline */
 
 #define CONFIG_SYS_HUSH_PARSER
 #define CONFIG_SYS_LONGHELP			/* #undef to save memory */
@@ -126,8 +136,14 @@
 /* include default commands */
 #include <config_cmd_default.h>
 
-/* We don't have networking support yet */
-#undef CONFIG_CMD_NET
+/* Networking on the host's loopback interface, see README.sandbox */
+#define CONFIG_SANDBOX_ETH_RAW
+#define CONFIG_IPADDR			127.0.0.1
+#define CONFIG_SERVERIP			127.0.0.1
+#define CONFIG_NETMASK			255.0.0.0
+#define CONFIG_IP_DEFRAG
+#define CONFIG_TFTP_TSIZE
+#define CONFIG_TFTP_WINDOWSIZE		16
 #undef CONFIG_CMD_NFS
 
 #define CONFIG_CMD_HASH
@@ -182,6 +198,7 @@
 #define CONFIG_BZIP2
 #define CONFIG_LZO
 #define CONFIG_LZMA
+#define CONFIG_DECOMP_STREAM
 
 #define CONFIG_TPM_TIS_SANDBOX
 
@@ -63,6 +63,7 @@
 #define	CONFIG_SUNXI				/* which is sunxi family */
 #define CONFIG_ARCH_SUN50IW2P1
 #define CONFIG_ARM_A53
+#define CONFIG_CMD_TEST_ACCEL		/* ut_hash_accel for the SHA/CRC32 kernels */
 
 //#define CONFIG_SUNXI_SECURE_STORAGE
 //#define CONFIG_SUNXI_SECURE_SYSTEM
@@ -298,8 +299,8 @@
 	"init=${init} loglevel=${loglevel} partitions=${partitions}\0" \
 	"setargs_mmc=setenv bootargs console=${console} root=${mmc_root}" \
 	"init=${init} loglevel=${loglevel} partitions=${partitions}\0" \
-	"boot_normal=sunxi_flash read 4007f800 boot;boota 4007f800\0" \
-	"boot_recovery=sunxi_flash read 4007f800 recovery;boota 4007f800\0" \
+	"boot_normal=boota boot\0" \
+	"boot_recovery=boota recovery\0" \
 	"boot_fastboot=fastboot\0"
 
 #define CONFIG_SUNXI_SPRITE_ENV_SETTINGS	\
@@ -73,6 +73,11 @@
 //#define CONFIG_SUNXI_SECURE_STORAGE
 //#define CONFIG_SUNXI_SECURE_SYSTEM
 //#define CONFIG_SUNXI_HDCP_IN_SECURESTORAGE
+#define CONFIG_SHA_HW_ACCEL				/* SHA1/SHA256 of common/hash.c on the SS */
+#define CONFIG_SHA_PROG_HW_ACCEL
+//#define CONFIG_AES
+//#define CONFIG_AES_HW_ACCEL			/* AES-128-CBC of lib/aes.c on the SS, needs CONFIG_AES */
+//#define CONFIG_CMD_AES
 
 
 #define CONFIG_SYS_SRAM_BASE             (0x0)
@@ -121,6 +126,7 @@
  * 1MB = 0x100000, 0x100000 = 1024 * 1024
  */
 #define CONFIG_SYS_MALLOC_LEN		(CONFIG_ENV_SIZE + (128 << 20))
+#define CONFIG_SYS_MALLOC_STATS		/* malloc/free counters and time */
 
 
 
@@ -234,6 +240,9 @@
 #define CONFIG_SYS_NS16550_COM2		SUNXI_UART1_BASE
 #define CONFIG_SYS_NS16550_COM3		SUNXI_UART2_BASE
 #define CONFIG_SYS_NS16550_COM4		SUNXI_UART3_BASE
+#define CONFIG_SYS_NS16550_TX_BUFFER	(16 << 10)	/* console output ring, drained by the uart irq */
+#define CONFIG_SYS_NS16550_TX_FIFO	64
+#define CONFIG_SYS_NS16550_TX_IRQ	AW_IRQ_UART0	/* asm/arch/intc.h */
 
 #define CONFIG_CONS_INDEX			1			/* which serial channel for console */
 
@@ -308,8 +317,8 @@
 	"init=${init} loglevel=${loglevel} partitions=${partitions}\0" \
 	"setargs_mmc=setenv bootargs console=${console} root=${mmc_root}" \
 	"init=${init} loglevel=${loglevel} partitions=${partitions}\0" \
-	"boot_normal=sunxi_flash read 4007f800 boot;boota 4007f800\0" \
-	"boot_recovery=sunxi_flash read 4007f800 recovery;boota 4007f800\0" \
+	"boot_normal=boota boot\0" \
+	"boot_recovery=boota recovery\0" \
 	"boot_fastboot=fastboot\0"
 
 #define CONFIG_SUNXI_SPRITE_ENV_SETTINGS	\
@@ -379,17 +388,24 @@
 
 
 #define CONFIG_CMD_BOOTA		/* boot android image */
+#define CONFIG_DECOMP_STREAM		/* boota unpacks gzip/lzop kernels while reading */
+#define CONFIG_LZO
+#define CONFIG_SYS_BOOTM_LEN		(32 << 20)
 #define CONFIG_CMD_RUN			/* run a command */
 #define CONFIG_CMD_BOOTD		/* boot the default command */
+#define CONFIG_CMD_MALLOC		/* heap and buffer pool statistics */
 #define CONFIG_CMD_FDT
 
 #ifndef CONFIG_SUN8IW11P1_NOR
 #define CONFIG_CMD_FAT			/* with this we can access bootfs in nand */
+#define CONFIG_BLOCK_CACHE		/* cache filesystem metadata reads */
+#define CONFIG_CMD_BLOCK_CACHE
 #define CONFIG_CMD_IRQ
 #define CONFIG_CMD_ELF
 #define CONFIG_CMD_MEMORY
 #define CONFIG_CMD_FASTBOOT
 #define CONFIG_CMD_SUNXI_SPRITE
+#define CONFIG_SPRITE_VERIFY_SAMPLED	/* card burn reads back samples, not whole partitions */
 #define CONFIG_CMD_SUNXI_TIMER
 #define CONFIG_CMD_SUNXI_EFEX
 #define CONFIG_CMD_SUNXI_SHUTDOWN
@@ -413,6 +429,7 @@
 #define CONFIG_MMC_SUNXI_USE_DMA
 #define CONFIG_STORAGE_EMMC
 #define CONFIG_MMC_LOGICAL_OFFSET   (20 * 1024 * 1024/512)
+//#define CONFIG_SUNXI_SPRITE_WRITE_COMBINE	/* merge small sprite writes, eMMC packed commands */
 #endif
 
 #ifdef CONFIG_SUNXI_MODULE_NAND
@@ -460,8 +477,32 @@
 #define CONFIG_CMD_PING
 #define CONFIG_CMD_NFS
 
+/* windowed TFTP with blocks of several frames, USB does not drop them */
+#define CONFIG_IP_DEFRAG
+#define CONFIG_TFTP_BLOCKSIZE		8192
+#define CONFIG_TFTP_WINDOWSIZE		16
+
 #endif
 
 //#define CONFIG_SYS_DCACHE_OFF
 
+/*
+ * flash init on cpu1 while cpu0 brings up the display. opt-in: the cpu1
+ * power-up in smp.c has not been run on a board yet, check it with
+ * ut_cpu_job before turning these on
+ */
+//#define CONFIG_CPU_JOB
+//#define CONFIG_ARMV7_SET_CORTEX_SMPEN
+//#define CONFIG_SYS_ARM_CACHE_SHAREABLE
+#define CONFIG_CMD_TEST_ACCEL		/* ut_add_sum etc. for the NEON kernels */
+
+/* boot time records from boot0 on, see tools/bootstage_report.py */
+#define CONFIG_BOOTSTAGE
+#define CONFIG_CMD_BOOTSTAGE
+#define CONFIG_BOOTSTAGE_USER_COUNT	96
+#define CONFIG_BOOTSTAGE_INITCALL
+#define CONFIG_BOOTSTAGE_STASH		(CONFIG_SYS_SDRAM_BASE + 0x2dfc000)	/* below the boot package */
+#define CONFIG_BOOTSTAGE_STASH_SIZE	0x4000
+#define CONFIG_BOOTSTAGE_UNSTASH
+
 #endif /* __CONFIG_H */
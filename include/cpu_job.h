@@ -0,0 +1,94 @@
+/*
+ * Boot-time jobs on a second cpu core
+ *
+ * The boot cpu hands independent pieces of init work to one secondary
+ * core and waits for them later.  Without a second core (not configured,
+ * not supported by the SoC, or it failed to come up) the jobs simply run
+ * on the boot cpu when they are submitted.
+ *
+ * While the second core runs, the heap, the console and the DMA channel
+ * table are serialised with cpu_job_lock(); nothing else is.  A job must not touch the
+ * controllers, pin banks or clock registers the boot cpu is using at the
+ * same time, must not enable interrupts and must not submit jobs itself.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef __CPU_JOB_H
+#define __CPU_JOB_H
+
+/* jobs queued for the second core at most, a power of two */
+#define CPU_JOB_RING		8
+
+typedef int (*cpu_job_fn)(void *arg);
+
+struct cpu_job {
+	const char	*name;
+	cpu_job_fn	fn;
+	void		*arg;
+	int		ret;		/* what fn returned */
+	ulong		time_us;	/* time fn took */
+	volatile int	done;
+};
+
+/* Recursive spin lock, only taken while the second core runs */
+struct cpu_job_lock {
+	volatile int	owner;		/* cpu holding it, -1 when free */
+	int		depth;
+};
+
+#define CPU_JOB_LOCK_INIT	{ .owner = -1 }
+
+#ifdef CONFIG_CPU_JOB
+/**
+ * cpu_job_start() - bring up the second core
+ *
+ * @return 0 if it runs, or was running already, -ve if jobs will run
+ *	   on the boot cpu
+ */
+int cpu_job_start(void);
+
+/**
+ * cpu_job_stop() - wait for all jobs and put the second core back to reset
+ */
+void cpu_job_stop(void);
+
+/**
+ * cpu_job_submit() - queue a job for the second core
+ *
+ * @job:	Job to fill in, must stay around until cpu_job_wait() returns
+ * @name:	Name for messages
+ * @fn:		Function to run
+ * @arg:	Argument for @fn
+ */
+void cpu_job_submit(struct cpu_job *job, const char *name, cpu_job_fn fn,
+		    void *arg);
+
+/**
+ * cpu_job_wait() - wait until a job has finished
+ *
+ * @return what the job function returned
+ */
+int cpu_job_wait(struct cpu_job *job);
+
+/**
+ * cpu_job_join() - wait until all queued jobs have finished
+ */
+void cpu_job_join(void);
+
+void cpu_job_lock(struct cpu_job_lock *lock);
+void cpu_job_unlock(struct cpu_job_lock *lock);
+
+/*
+ * SoC hooks.  cpu_job_arch_boot() starts a secondary core at @main with
+ * the stack @stack_top, 0 when it was released from reset;
+ * cpu_job_arch_off() waits until it has left @main and puts it back into
+ * reset.  The defaults have no second core.
+ */
+int cpu_job_arch_boot(void (*main)(void), void *stack_top);
+void cpu_job_arch_off(void);
+#else
+static inline void cpu_job_lock(struct cpu_job_lock *lock) {}
+static inline void cpu_job_unlock(struct cpu_job_lock *lock) {}
+#endif
+
+#endif /* __CPU_JOB_H */
@@ -0,0 +1,68 @@
+/*
+ * Decompression of data that arrives in pieces
+ *
+ * The compressed data is handed over in chunks of any size as they come
+ * from the storage or the network, and the output is written straight to
+ * its final place, so only the chunk being worked on needs to be in
+ * memory besides the output.  The decompressors keep a bounded amount of
+ * state: the 32KB deflate window, one lzop block of at most
+ * DECOMP_STREAM_LZO_BLOCK bytes when it straddles two chunks, and the
+ * LZMA probabilities.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __DECOMP_STREAM_H
+#define __DECOMP_STREAM_H
+
+/* largest lzop block we take, what lzop itself writes */
+#define DECOMP_STREAM_LZO_BLOCK	(256 * 1024)
+
+struct decomp_stream;
+
+/**
+ * decomp_stream_detect() - find the compression from the first bytes
+ *
+ * Only formats with a magic number are recognised: gzip and lzop.
+ *
+ * @buf:	Start of the data
+ * @len:	Bytes at @buf
+ * @return IH_COMP_GZIP, IH_COMP_LZO, or IH_COMP_NONE
+ */
+int decomp_stream_detect(const void *buf, ulong len);
+
+/**
+ * decomp_stream_start() - set up a decompressor
+ *
+ * @comp:	Compression used (IH_COMP_...)
+ * @dst:	Where the output goes
+ * @dst_len:	Room at @dst
+ * @return the stream, or NULL when @comp is not supported or there is
+ *	   no memory
+ */
+struct decomp_stream *decomp_stream_start(int comp, void *dst, ulong dst_len);
+
+/**
+ * decomp_stream_write() - decompress the next piece of input
+ *
+ * Input after the end of the compressed data is ignored.
+ *
+ * @ds:		Stream
+ * @buf:	Compressed data
+ * @len:	Bytes at @buf
+ * @return 0 if OK, -ENOSPC if the output does not fit, -EINVAL if the
+ *	   data is corrupt, -ENOMEM
+ */
+int decomp_stream_write(struct decomp_stream *ds, const void *buf, ulong len);
+
+/**
+ * decomp_stream_finish() - end a stream and free it
+ *
+ * @ds:		Stream, may be NULL
+ * @lenp:	Returns the number of bytes written to the output, may be NULL
+ * @return 0 if the compressed data was complete and decompressed without
+ *	   error, -ve otherwise
+ */
+int decomp_stream_finish(struct decomp_stream *ds, ulong *lenp);
+
+#endif /* __DECOMP_STREAM_H */
@@ -33,6 +33,13 @@
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
 
+/* metadata read cache, in blocks */
+#ifndef CONFIG_FS_FAT_CACHE_BLOCKS
+#define CONFIG_FS_FAT_CACHE_BLOCKS	256
+#endif
+#define FAT_CACHE_STAGE_BLOCKS	64	/* biggest read that is cached */
+#define FAT_CACHE_READAHEAD	32	/* FAT blocks read ahead on a miss */
+
 
 /* Filesystem identifiers */
 #define FAT12_SIGN	"FAT12   "
@@ -0,0 +1,25 @@
+/*
+ * Header file for AES hardware acceleration
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef __HW_AES_H
+#define __HW_AES_H
+
+/**
+ * AES-128-CBC with a zero IV on the crypto hardware, the same operation
+ * as aes_cbc_encrypt_blocks()/aes_cbc_decrypt_blocks().
+ *
+ * @param key_exp	Expanded key from aes_expand_key(); the first
+ *			AES_KEY_LENGTH bytes are the key itself
+ * @param src		Source data
+ * @param dst		Destination buffer, may be the same as src
+ * @param num_aes_blocks	Number of AES blocks
+ * @param enc		1 to encrypt, 0 to decrypt
+ * @return 0 when done, non-zero if the hardware could not take the
+ *	   request; dst is left untouched then and the caller falls
+ *	   back to software
+ */
+int hw_aes_cbc_crypt(u8 *key_exp, u8 *src, u8 *dst, u32 num_aes_blocks,
+		     int enc);
+#endif
@@ -7,6 +7,7 @@
  */
 #ifndef __HW_SHA_H
 #define __HW_SHA_H
+#include <hash.h>
 
 
 /**
@@ -34,4 +35,16 @@ void hw_sha256(const uchar * in_addr, uint buflen,
  */
 void hw_sha1(const uchar * in_addr, uint buflen,
 			uchar * out_addr, uint chunk_size);
+
+/*
+ * Progressive hashing on hardware which can carry the hash state from one
+ * call to the next, see struct hash_algo for the meaning of the arguments.
+ */
+int hw_sha_init(struct hash_algo *algo, void **ctxp);
+
+int hw_sha_update(struct hash_algo *algo, void *ctx, const void *buf,
+			unsigned int size, int is_last);
+
+int hw_sha_finish(struct hash_algo *algo, void *ctx, void *dest_buf,
+			int size);
 #endif
@@ -940,6 +940,48 @@ void mem_malloc_init(ulong start, ulong size);
 void *malloc_noncache(uint num_bytes);
 void  free_noncache(void *p);
 
+/*
+ * Large DMA aligned I/O buffers: free_pool() keeps the buffer for the
+ * next malloc_pool() instead of giving it back to malloc.  The idle
+ * buffers go back to malloc through malloc_pool_release(), which
+ * malloc() also calls before it fails, and which returns the bytes
+ * given back.
+ */
+struct malloc_pool_info {
+	unsigned int	slabs;		/* buffers held by the pool */
+	unsigned int	busy;		/* of which handed out */
+	unsigned long	bytes;		/* held by the pool */
+	unsigned long	peak;		/* most bytes ever held */
+	unsigned long	reused;		/* requests served by an idle buffer */
+	unsigned long	allocated;	/* requests that took a new buffer */
+	unsigned long	untracked;	/* pool table full, plain memalign() */
+};
+
+void *malloc_pool(uint num_bytes);
+void  free_pool(void *p);
+ulong malloc_pool_release(void);
+void  malloc_pool_get_info(struct malloc_pool_info *info);
+
+#ifdef CONFIG_SYS_MALLOC_STATS
+struct malloc_stats_info {
+	unsigned long	heap_size;	/* size of the malloc area */
+	unsigned long	heap_top;	/* taken from the area by sbrk() */
+	unsigned long	heap_peak;	/* most ever taken by sbrk() */
+	unsigned long	in_use;		/* allocated chunks, with overhead */
+	unsigned long	free;		/* free chunks and what is left */
+	unsigned long	largest_free;	/* biggest block malloc() can return */
+	unsigned long	free_chunks;	/* free chunks in the bins */
+	unsigned long	mallocs;
+	unsigned long	frees;
+	unsigned long	failures;
+	unsigned long	malloc_us;	/* time spent in malloc() */
+	unsigned long	free_us;	/* time spent in free() */
+};
+
+void malloc_get_stats(struct malloc_stats_info *info);
+void malloc_clear_stats(void);
+#endif
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
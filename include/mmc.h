@@ -44,6 +44,7 @@
 #define MMC_MODE_DDR_52MHz	(1 << 6) /* can run at 52Mhz with DDR mode -- HSDDR52_DDR50 */
 #define MMC_MODE_HS200      (1 << 7) /* can run at 200/208MHz with SDR mode -- HS200_SDR104*/
 #define MMC_MODE_HS400      (1 << 8) /* can run at 200MHz with DDR mode -- HS400 */
+#define MMC_MODE_SG         (1 << 9) /* host takes MMC_DATA_SG requests */
 
 #define SD_DATA_4BIT	0x00040000
 
@@ -53,6 +54,10 @@
 
 #define MMC_DATA_READ		1
 #define MMC_DATA_WRITE		2
+#define MMC_DATA_SG		4 /* data->sg lists the buffers of data->blocks */
+
+/* most buffers one MMC_DATA_SG command carries */
+#define MMC_SG_MAX		64
 
 #define NO_CARD_ERR		-16 /* No SD/MMC card inserted */
 #define UNUSABLE_ERR		-17 /* Unusable Card */
@@ -404,10 +409,17 @@ struct mmc_cmd {
 	uint flags; /*wjq*/
 };
 
+/* one piece of a scatter-gather transfer, buf must be 4 byte aligned */
+struct mmc_sg {
+	void *buf;
+	uint blocks;
+};
+
 struct mmc_data {
 	union {
 		char *dest;
 		const char *src; /* src buffers don't get written to */
+		const struct mmc_sg *sg; /* with MMC_DATA_SG */
 	};
 	uint flags;
 	uint blocks;
@@ -433,6 +445,18 @@ struct mmc_ops {
 	int (*get_detail_errno)(struct mmc *mmc);
 
 	int (*update_phase)(struct mmc *mmc);
+
+	/*
+		optional, split a data command in two halves so the dma can run
+		in the background, see mmc_bread_start(). send_cmd_done only
+		polls, it must not touch the data phase
+	*/
+	int (*send_cmd_start)(struct mmc *mmc,
+			struct mmc_cmd *cmd, struct mmc_data *data);
+	int (*send_cmd_wait)(struct mmc *mmc,
+			struct mmc_cmd *cmd, struct mmc_data *data);
+	int (*send_cmd_done)(struct mmc *mmc,
+			struct mmc_cmd *cmd, struct mmc_data *data);
 };
 
 
@@ -645,6 +669,12 @@ struct mmc {
 	u32 pll_clock;
 	u32 msglevel;
 	u32 do_tuning;
+
+	/* outstanding transfer started by mmc_bread_start()/mmc_bwrite_start() */
+	struct mmc_cmd async_cmd;
+	struct mmc_data async_data;
+	ulong async_result;
+	int async_busy;
 };
 
 struct mmc_ext_csd {
@@ -729,6 +759,17 @@ void mmc_destroy(struct mmc *mmc);
 int mmc_initialize(bd_t *bis);
 int mmc_init(struct mmc *mmc);
 int mmc_read(struct mmc *mmc, u64 src, uchar *dst, int size);
+int mmc_bread_start(int dev_num, lbaint_t start, lbaint_t blkcnt, void *dst);
+int mmc_bwrite_start(int dev_num, lbaint_t start, lbaint_t blkcnt, const void *src);
+int mmc_async_done(int dev_num);
+ulong mmc_async_wait(int dev_num);
+ulong mmc_bread_sg(int dev_num, lbaint_t start, const struct mmc_sg *sg, uint sg_len);
+ulong mmc_bwrite_sg(int dev_num, lbaint_t start, const struct mmc_sg *sg, uint sg_len);
+int mmc_packed_write_max(int dev_num);
+int mmc_bwrite_packed(int dev_num, const lbaint_t *start,
+			const struct mmc_sg *run, uint count);
+/* hold back the FDT writes of mmc_init() until called with 0 */
+void mmc_defer_fdt_update(int defer);
 void mmc_set_clock(struct mmc *mmc, uint clock);
 struct mmc *find_mmc_device(int dev_num);
 int mmc_set_dev(int dev_num);
@@ -73,6 +73,7 @@ int plb2800_eth_initialize(bd_t *bis);
 int ppc_4xx_eth_initialize (bd_t *bis);
 int rtl8139_initialize(bd_t *bis);
 int rtl8169_initialize(bd_t *bis);
+int sandbox_eth_raw_initialize(bd_t *bis);
 int scc_initialize(bd_t *bis);
 int sh_eth_initialize(bd_t *bis);
 int skge_initialize(bd_t *bis);
@@ -177,3 +177,20 @@ void NS16550_putc(NS16550_t com_port, char c);
 char NS16550_getc(NS16550_t com_port);
 int NS16550_tstc(NS16550_t com_port);
 void NS16550_reinit(NS16550_t com_port, int baud_divisor);
+
+#if defined(CONFIG_SYS_NS16550_TX_BUFFER) && !defined(CONFIG_SPL_BUILD)
+#define NS16550_TX_BUFFERED
+
+/* Buffered output on one port, see CONFIG_SYS_NS16550_TX_BUFFER */
+struct ns16550_tx_stats {
+	unsigned int	size;		/* size of the ring */
+	unsigned int	peak;		/* most bytes it ever held */
+	unsigned long	bytes;		/* bytes that went through it */
+	unsigned long	stalls;		/* writes that had to wait for room */
+};
+
+void NS16550_tx_buffer(NS16550_t com_port);
+void NS16550_tx_interrupt(NS16550_t com_port);
+void NS16550_flush(NS16550_t com_port);
+void NS16550_tx_stats(struct ns16550_tx_stats *stats);
+#endif
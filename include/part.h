@@ -192,6 +192,73 @@ static inline int get_device_and_partition(const char *ifname,
 { *dev_desc = NULL; return -1; }
 #endif
 
+/* drivers/block/blkcache.c */
+#ifdef CONFIG_BLOCK_CACHE
+struct block_cache_stats {
+	unsigned long	hits;		/* blocks served from the cache */
+	unsigned long	misses;		/* blocks read from the device */
+	unsigned long	readahead;	/* blocks read ahead of a request */
+	unsigned long	bypass;		/* blocks of reads too big to cache */
+	unsigned long	invalidations;
+	unsigned int	sets;
+	unsigned int	ways;
+	unsigned int	max_read;
+	unsigned int	window;		/* read-ahead in blocks */
+	unsigned long	blksz;
+};
+
+unsigned long blkcache_read(block_dev_desc_t *dev_desc, lbaint_t start,
+			    lbaint_t blkcnt, void *buffer);
+void blkcache_invalidate(int if_type, int dev);
+int blkcache_configure(unsigned int sets, unsigned int ways,
+		       unsigned int max_read, unsigned int window);
+void blkcache_get_stats(struct block_cache_stats *stats);
+void blkcache_clear_stats(void);
+#else
+static inline void blkcache_invalidate(int if_type, int dev) {}
+#endif
+
+/* fs/fat/fat.c, which leaves its own cache out when the block cache is on */
+#if defined(CONFIG_FS_FAT) && !defined(CONFIG_BLOCK_CACHE)
+void fat_cache_invalidate(void);
+#else
+static inline void fat_cache_invalidate(void) {}
+#endif
+
+/*
+ * Drivers call this when a device changes below the filesystems: a raw
+ * write, a rescan or a switch of the hardware partition.  Both the block
+ * cache and the FAT cache drop what they hold.
+ */
+static inline void block_dev_invalidate(int if_type, int dev)
+{
+	blkcache_invalidate(if_type, dev);
+	fat_cache_invalidate();
+}
+
+/*
+ * Filesystem and partition code reads and writes through these, so the
+ * block cache sees the traffic when it is enabled.
+ */
+static inline unsigned long block_dread(block_dev_desc_t *dev_desc,
+					lbaint_t start, lbaint_t blkcnt,
+					void *buffer)
+{
+#ifdef CONFIG_BLOCK_CACHE
+	return blkcache_read(dev_desc, start, blkcnt, buffer);
+#else
+	return dev_desc->block_read(dev_desc->dev, start, blkcnt, buffer);
+#endif
+}
+
+static inline unsigned long block_dwrite(block_dev_desc_t *dev_desc,
+					 lbaint_t start, lbaint_t blkcnt,
+					 const void *buffer)
+{
+	blkcache_invalidate(dev_desc->if_type, dev_desc->dev);
+	return dev_desc->block_write(dev_desc->dev, start, blkcnt, buffer);
+}
+
 #ifdef CONFIG_MAC_PARTITION
 /* disk/part_mac.c */
 int get_partition_info_mac (block_dev_desc_t * dev_desc, int part, disk_partition_t *info);
@@ -40,6 +40,7 @@ extern struct serial_device serial1_device;
 
 extern struct serial_device eserial1_device;
 extern struct serial_device eserial2_device;
+extern int ns16550_tx_buffer_init(void);
 
 extern void serial_register(struct serial_device *);
 extern void serial_initialize(void);
@@ -108,10 +108,7 @@ extern int checkboard(void);
 extern int sprite_uichar_init(int char_size);
 extern void sprite_uichar_printf(const char * str, ...);
 
-#if defined(CONFIG_USE_NEON_SIMD)
 extern int  arm_neon_init(void);
-extern uint add_sum_neon(void *buffer, uint length);
-#endif
 
 extern void respond_physical_key_action(void);
 extern int check_physical_key_early(void);
@@ -120,6 +117,7 @@ extern void sunxi_set_fel_flag(void);
 extern void sunxi_clear_fel_flag(void);
 
 extern int sunxi_verify_signature(void *buff, uint len, const char *cert_name);
+extern int sunxi_verify_hash(const u8 *hash_of_file, const char *cert_name);
 extern int sunxi_verify_rotpk_hash(void *input_hash_buf, int len);
 
 extern void sunxi_dump(void *addr, unsigned int size);
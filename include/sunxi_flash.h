@@ -34,9 +34,15 @@ extern uint sunxi_sprite_size(void);
 extern int  sunxi_sprite_read(uint start_block,uint nblock,void * buffer);
 extern int  sunxi_sprite_write(uint start_block,uint nblock,void * buffer);
 extern int  sunxi_sprite_flush(void);
+extern int  sunxi_sprite_sync(void);
 extern int  sunxi_sprite_phyread(unsigned int start_block, unsigned int nblock, void *buffer);
 extern int  sunxi_sprite_phywrite(unsigned int start_block, unsigned int nblock, void *buffer);
 extern int sunxi_sprite_force_erase(void);
+extern int  sunxi_sprite_discard(uint start_block, uint nblock, uint *skip_space);
+extern int  sunxi_sprite_submit_read(uint start_block, uint nblock, void *buffer);
+extern int  sunxi_sprite_submit_write(uint start_block, uint nblock, void *buffer);
+extern int  sunxi_sprite_query(void);
+extern int  sunxi_sprite_complete(void);
 extern int sunxi_sprite_mmc_phywrite(unsigned int start_block, unsigned int nblock, void *buffer);
 extern int sunxi_sprite_mmc_phyread(unsigned int start_block, unsigned int nblock, void *buffer);
 extern int sunxi_sprite_mmc_phyerase(unsigned int start_block, unsigned int nblock, void *skip);
@@ -49,6 +55,10 @@ extern int  sunxi_flash_init (int type);
 extern uint sunxi_flash_size (void);
 extern int  sunxi_flash_exit (int force);
 extern int  sunxi_flash_read (unsigned int start_block, unsigned int nblock, void *buffer);
+extern int  sunxi_flash_submit_read(unsigned int start_block, unsigned int nblock, void *buffer);
+extern int  sunxi_flash_submit_write(unsigned int start_block, unsigned int nblock, void *buffer);
+extern int  sunxi_flash_query(void);
+extern int  sunxi_flash_complete(void);
 extern int  sunxi_flash_write(unsigned int start_block, unsigned int nblock, void *buffer);
 extern int  sunxi_flash_flush(void);
 extern int  sunxi_flash_phyread(unsigned int start_block, unsigned int nblock, void *buffer);
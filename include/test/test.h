@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2013 Google, Inc.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __TEST_TEST_H
+#define __TEST_TEST_H
+
+#include <linker_lists.h>
+
+/*
+ * struct unit_test_state - Entire state of a unit test run
+ *
+ * This is often abreviated to uts.
+ *
+ * @fail_count: Number of tests that failed
+ */
+struct unit_test_state {
+	int fail_count;
+};
+
+/**
+ * struct unit_test - Information about a unit test
+ *
+ * @name: Name of test
+ * @func: Function to call to perform test
+ */
+struct unit_test {
+	const char *name;
+	int (*func)(struct unit_test_state *uts);
+};
+
+/* Declare a new unit test in the list of @_suite */
+#define UNIT_TEST(_name, _suite)					\
+	ll_entry_declare(struct unit_test, _name, _suite) = {		\
+		.name = #_name,						\
+		.func = _name,						\
+	}
+
+/* Run every test declared in @_suite */
+#define UNIT_TEST_SUITE_RUN(_suite)					\
+	ut_run_list(#_suite, ll_entry_start(struct unit_test, _suite),	\
+		    ll_entry_count(struct unit_test, _suite))
+
+/**
+ * ut_run_list() - Run a list of unit tests
+ *
+ * Each test is run even when an earlier one failed.
+ *
+ * @category: Name of the tests, for the report
+ * @tests: First test to run
+ * @count: Number of tests
+ * @return CMD_RET_SUCCESS if all passed, CMD_RET_FAILURE otherwise
+ */
+int ut_run_list(const char *category, struct unit_test *tests, int count);
+
+/**
+ * ut_fail() - Record failure of a unit test
+ *
+ * @uts: Test state
+ * @fname: Filename where the error occured
+ * @line: Line number where the error occured
+ * @func: Function name where the error occured
+ * @cond: The condition that failed
+ */
+void ut_fail(struct unit_test_state *uts, const char *fname, int line,
+	     const char *func, const char *cond);
+
+/**
+ * ut_failf() - Record failure of a unit test
+ *
+ * @uts: Test state
+ * @fname: Filename where the error occured
+ * @line: Line number where the error occured
+ * @func: Function name where the error occured
+ * @cond: The condition that failed
+ * @fmt: printf() format string for the error, followed by args
+ */
+void ut_failf(struct unit_test_state *uts, const char *fname, int line,
+	      const char *func, const char *cond, const char *fmt, ...)
+			__attribute__ ((format (__printf__, 6, 7)));
+
+#endif /* __TEST_TEST_H */
@@ -13,6 +13,9 @@
 uint32_t crc32 (uint32_t, const unsigned char *, uint);
 uint32_t crc32_wd (uint32_t, const unsigned char *, uint, uint);
 uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
+/* table driven C version, and the CPU specific one (defaults to it) */
+uint32_t crc32_no_comp_generic (uint32_t, const unsigned char *, uint);
+uint32_t crc32_no_comp_arch (uint32_t, const unsigned char *, uint);
 
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
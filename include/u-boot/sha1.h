@@ -52,6 +52,21 @@ sha1_context;
  */
 void sha1_starts( sha1_context *ctx );
 
+/**
+ * \brief	   SHA-1 compression of whole 64-byte blocks
+ *
+ * sha1_blocks() is the fastest version for this CPU,
+ * sha1_blocks_generic() is plain C.
+ *
+ * \param ctx	   SHA-1 context
+ * \param data	   @blocks * 64 bytes of input
+ * \param blocks   number of blocks
+ */
+void sha1_blocks(sha1_context *ctx, const unsigned char *data,
+		 unsigned int blocks);
+void sha1_blocks_generic(sha1_context *ctx, const unsigned char *data,
+			 unsigned int blocks);
+
 /**
  * \brief	   SHA-1 process buffer
  *
@@ -16,6 +16,15 @@ void sha256_starts(sha256_context * ctx);
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length);
 void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 
+/*
+ * Run the compression function over @blocks 64-byte blocks. sha256_blocks()
+ * is the fastest version for this CPU, sha256_blocks_generic() is plain C.
+ */
+void sha256_blocks(sha256_context *ctx, const uint8_t *data,
+		   unsigned int blocks);
+void sha256_blocks_generic(sha256_context *ctx, const uint8_t *data,
+			   unsigned int blocks);
+
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
@@ -0,0 +1,45 @@
+/*
+ * 32-bit additive checksum used by the sunxi boot and burn images
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+
+/*
+ * Sum of the buffer as little-endian 32-bit words, a trailing partial
+ * word is zero padded. The buffer must be word aligned.
+ */
+uint add_sum_generic(void *buffer, uint length)
+{
+	const u32 *buf = buffer;
+	const u8 *tail;
+	uint count = length >> 2;
+	uint sum = 0, last = 0;
+
+	while (count >= 4) {
+		sum += buf[0] + buf[1] + buf[2] + buf[3];
+		buf += 4;
+		count -= 4;
+	}
+	while (count--)
+		sum += *buf++;
+
+	tail = (const u8 *)buf;
+	switch (length & 3) {
+	case 3:
+		last |= tail[2] << 16;
+	case 2:
+		last |= tail[1] << 8;
+	case 1:
+		last |= tail[0];
+	}
+
+	return sum + last;
+}
+
+/* overridden by the SIMD version where the CPU has one */
+uint __weak add_sum_neon(void *buffer, uint length)
+{
+	return add_sum_generic(buffer, length);
+}
@@ -28,6 +28,9 @@
 #include <string.h>
 #endif
 #include "aes.h"
+#if defined(CONFIG_AES_HW_ACCEL) && !defined(USE_HOSTCC)
+#include <hw_aes.h>
+#endif
 
 /* forward s-box */
 static const u8 sbox[256] = {
@@ -609,6 +612,10 @@ void aes_cbc_encrypt_blocks(u8 *key_exp, u8 *src, u8 *dst, u32 num_aes_blocks)
 	u8 *cbc_chain_data = zero_key;
 	u32 i;
 
+#if defined(CONFIG_AES_HW_ACCEL) && !defined(USE_HOSTCC)
+	if (!hw_aes_cbc_crypt(key_exp, src, dst, num_aes_blocks, 1))
+		return;
+#endif
 	for (i = 0; i < num_aes_blocks; i++) {
 		debug("encrypt_object: block %d of %d\n", i, num_aes_blocks);
 		debug_print_vector("AES Src", AES_KEY_LENGTH, src);
@@ -635,6 +642,10 @@ void aes_cbc_decrypt_blocks(u8 *key_exp, u8 *src, u8 *dst, u32 num_aes_blocks)
 	u8 cbc_chain_data[AES_KEY_LENGTH] = { 0 };
 	u32 i;
 
+#if defined(CONFIG_AES_HW_ACCEL) && !defined(USE_HOSTCC)
+	if (!hw_aes_cbc_crypt(key_exp, src, dst, num_aes_blocks, 0))
+		return;
+#endif
 	for (i = 0; i < num_aes_blocks; i++) {
 		debug("encrypt_object: block %d of %d\n", i, num_aes_blocks);
 		debug_print_vector("AES Src", AES_KEY_LENGTH, src);
@@ -171,12 +171,45 @@ const uint32_t * ZEXPORT get_crc_table()
 #  define DO_CRC(x) crc = tab[((crc >> 24) ^ (x)) & 255] ^ (crc << 8)
 # endif
 
+/*
+ * Slice-by-8: the eight lookups for two words do not depend on each
+ * other, which beats one dependent lookup per byte on in-order cores
+ * without CRC instructions. The 8K of tables is built on first use.
+ */
+#if !defined(CONFIG_SPL_BUILD) && __BYTE_ORDER == __LITTLE_ENDIAN
+#define CRC32_SLICE_BY_8
+
+/* crc_slice[k][n] is the crc of byte n followed by k zero bytes */
+local uint32_t crc_slice[8][256];
+local int crc_slice_empty = 1;
+
+local void make_crc_slice(void)
+{
+    uint32_t c;
+    int n, k;
+
+#ifdef DYNAMIC_CRC_TABLE
+    if (crc_table_empty)
+      make_crc_table();
+#endif
+    for (n = 0; n < 256; n++) {
+	 c = crc_table[n];
+	 crc_slice[0][n] = c;
+	 for (k = 1; k < 8; k++) {
+	      c = crc_table[c & 255] ^ (c >> 8);
+	      crc_slice[k][n] = c;
+	 }
+    }
+    crc_slice_empty = 0;
+}
+#endif
+
 /* ========================================================================= */
 
 /* No ones complement version. JFFS2 (and other things ?)
  * don't use ones compliment in their CRC calculations.
  */
-uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+uint32_t ZEXPORT crc32_no_comp_generic(uint32_t crc, const Bytef *buf, uInt len)
 {
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
@@ -195,6 +228,20 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 	 b = (uint32_t *)p;
     }
 
+#ifdef CRC32_SLICE_BY_8
+    if (crc_slice_empty)
+      make_crc_slice();
+    for (; len >= 8; len -= 8, b += 2) {
+	 uint32_t lo = b[0] ^ crc;
+	 uint32_t hi = b[1];
+
+	 crc = crc_slice[7][lo & 255] ^ crc_slice[6][(lo >> 8) & 255] ^
+	       crc_slice[5][(lo >> 16) & 255] ^ crc_slice[4][lo >> 24] ^
+	       crc_slice[3][hi & 255] ^ crc_slice[2][(hi >> 8) & 255] ^
+	       crc_slice[1][(hi >> 16) & 255] ^ crc_slice[0][hi >> 24];
+    }
+#endif
+
     rem_len = len & 3;
     len = len >> 2;
     for (--b; len; --len) {
@@ -218,6 +265,23 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 }
 #undef DO_CRC
 
+#ifndef USE_HOSTCC
+/* overridden where the CPU has CRC32 instructions */
+uint32_t __weak crc32_no_comp_arch(uint32_t crc, const Bytef *buf, uInt len)
+{
+	return crc32_no_comp_generic(crc, buf, len);
+}
+#endif
+
+uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+{
+#ifndef USE_HOSTCC
+	return crc32_no_comp_arch(crc, buf, len);
+#else
+	return crc32_no_comp_generic(crc, buf, len);
+#endif
+}
+
 uint32_t ZEXPORT crc32 (uint32_t crc, const Bytef *p, uInt len)
 {
      return crc32_no_comp(crc ^ 0xffffffffL, p, len) ^ 0xffffffffL;
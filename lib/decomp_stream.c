@@ -0,0 +1,503 @@
+/*
+ * Decompression of data that arrives in pieces, see decomp_stream.h
+ *
+ * Headers and lzop blocks are parsed straight from the input when they
+ * are whole in one piece; only those that straddle two pieces are
+ * gathered in a buffer first.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <decomp_stream.h>
+#include <image.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <asm/errno.h>
+#include <asm/unaligned.h>
+#include <u-boot/zlib.h>
+#include <linux/lzo.h>
+#include <lzma/LzmaTypes.h>
+#include <lzma/LzmaDec.h>
+
+/* gzip header, as in gunzip.c */
+#define HEAD_CRC		2
+#define EXTRA_FIELD		4
+#define ORIG_NAME		8
+#define COMMENT			0x10
+#define RESERVED		0xe0
+#define DEFLATED		8
+
+/* lzop header */
+#define LZOP_VERSION_LEVEL	0x0940	/* from here a level byte and mtime_high */
+#define LZOP_HAS_FILTER		0x00000800
+
+#define LZMA_HEADER_SIZE	(LZMA_PROPS_SIZE + 8)
+
+static const uchar lzop_magic[] = {
+	0x89, 0x4c, 0x5a, 0x4f, 0x00, 0x0d, 0x0a, 0x1a, 0x0a
+};
+
+enum {
+	DS_DONE,		/* end of the compressed data seen */
+	DS_SKIP,		/* drop ->skip bytes, then go to ->next */
+	DS_COPY,		/* no compression */
+
+	DS_GZ_HEAD,
+	DS_GZ_XLEN,
+	DS_GZ_NAME,
+	DS_GZ_COMMENT,
+	DS_GZ_HCRC,
+	DS_GZ_BODY,
+
+	DS_LZO_HEAD,
+	DS_LZO_FLAGS,
+	DS_LZO_NAMELEN,
+	DS_LZO_DLEN,
+	DS_LZO_SLEN,
+	DS_LZO_DATA,
+
+	DS_LZMA_HEAD,
+	DS_LZMA_BODY,
+};
+
+struct decomp_stream {
+	int		comp;
+	int		state;
+	int		next;		/* state after DS_SKIP */
+	int		err;		/* first error, sticks */
+	uchar		*dst;
+	ulong		dst_len;
+	ulong		out;		/* bytes written to dst */
+
+	ulong		need;		/* bytes the state works on */
+	ulong		have;		/* of which gathered so far */
+	ulong		skip;
+	uchar		hdr[32];	/* gathers short headers */
+	uchar		*buf;		/* gathers lzop blocks */
+
+	uint		flags;		/* gzip or lzop header flags */
+	uint		version;	/* lzop version */
+	u32		dlen, slen;	/* lzop block */
+
+#ifdef CONFIG_GZIP
+	z_stream	zs;
+#endif
+#ifdef CONFIG_LZMA
+	CLzmaDec	lzma;
+	SizeT		lzma_size;	/* from the header, (SizeT)-1 if unknown */
+	ELzmaStatus	lzma_status;
+#endif
+};
+
+/*
+ * Get the ->need bytes the current state works on: from the input if
+ * they are all there, or else gathered over several calls.  Returns NULL
+ * while more input is needed, or with ->err set.
+ */
+static const uchar *ds_gather(struct decomp_stream *ds, const uchar **src,
+			      ulong *len)
+{
+	const uchar *p;
+	uchar *to = ds->hdr;
+	ulong n;
+
+	if (!ds->have && *len >= ds->need) {
+		p = *src;
+		*src += ds->need;
+		*len -= ds->need;
+		return p;
+	}
+
+	if (ds->need > sizeof(ds->hdr)) {
+		if (!ds->buf)
+			ds->buf = malloc(DECOMP_STREAM_LZO_BLOCK);
+		if (!ds->buf) {
+			ds->err = -ENOMEM;
+			return NULL;
+		}
+		to = ds->buf;
+	}
+	n = min(*len, ds->need - ds->have);
+	memcpy(to + ds->have, *src, n);
+	ds->have += n;
+	*src += n;
+	*len -= n;
+	if (ds->have < ds->need)
+		return NULL;
+	ds->have = 0;
+
+	return to;
+}
+
+static void ds_expect(struct decomp_stream *ds, int state, ulong need)
+{
+	ds->state = state;
+	ds->need = need;
+}
+
+static void ds_skip(struct decomp_stream *ds, ulong skip, int next)
+{
+	ds->state = skip ? DS_SKIP : next;
+	ds->skip = skip;
+	ds->next = next;
+}
+
+#ifdef CONFIG_GZIP
+/* Drop a zero terminated string, returns 1 when its end was seen */
+static int gz_skip_string(const uchar **src, ulong *len)
+{
+	const uchar *end = memchr(*src, 0, *len);
+	ulong n = end ? end - *src + 1 : *len;
+
+	*src += n;
+	*len -= n;
+
+	return end != NULL;
+}
+
+static int gz_write(struct decomp_stream *ds, const uchar **src, ulong *len)
+{
+	const uchar *p;
+	int r;
+
+	switch (ds->state) {
+	case DS_GZ_HEAD:
+		p = ds_gather(ds, src, len);
+		if (!p)
+			break;
+		if (p[0] != 0x1f || p[1] != 0x8b || p[2] != DEFLATED ||
+		    (p[3] & RESERVED))
+			return -EINVAL;
+		ds->flags = p[3];
+		ds_expect(ds, DS_GZ_XLEN, 2);
+		break;
+	case DS_GZ_XLEN:
+		if (!(ds->flags & EXTRA_FIELD)) {
+			ds->state = DS_GZ_NAME;
+			break;
+		}
+		p = ds_gather(ds, src, len);
+		if (p)
+			ds_skip(ds, p[0] | (p[1] << 8), DS_GZ_NAME);
+		break;
+	case DS_GZ_NAME:
+		if (!(ds->flags & ORIG_NAME) || gz_skip_string(src, len))
+			ds->state = DS_GZ_COMMENT;
+		break;
+	case DS_GZ_COMMENT:
+		if (!(ds->flags & COMMENT) || gz_skip_string(src, len))
+			ds->state = DS_GZ_HCRC;
+		break;
+	case DS_GZ_HCRC:
+		ds_skip(ds, ds->flags & HEAD_CRC ? 2 : 0, DS_GZ_BODY);
+		break;
+	case DS_GZ_BODY:
+		ds->zs.next_in = (uchar *)*src;
+		ds->zs.avail_in = *len;
+		ds->zs.next_out = ds->dst + ds->out;
+		ds->zs.avail_out = ds->dst_len - ds->out;
+		r = inflate(&ds->zs, Z_NO_FLUSH);
+		ds->out = ds->zs.next_out - ds->dst;
+		*src = ds->zs.next_in;
+		*len = ds->zs.avail_in;
+		if (r == Z_STREAM_END) {
+			/* the crc and length trailer is not checked, as gunzip() */
+			ds->state = DS_DONE;
+			break;
+		}
+		if (r == Z_MEM_ERROR)
+			return -ENOMEM;
+		if (r != Z_OK && r != Z_BUF_ERROR)
+			return -EINVAL;
+		/* input left means inflate() stopped for lack of room */
+		if (*len)
+			return ds->zs.avail_out ? -EINVAL : -ENOSPC;
+		break;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_GZIP */
+
+#ifdef CONFIG_LZO
+/*
+ * The lzop container: a header, then blocks of the uncompressed length,
+ * the compressed length, a checksum and the data, ended by a zero length.
+ * The header is parsed and the checksum skipped as lzop_decompress() does.
+ */
+static int lzo_write(struct decomp_stream *ds, const uchar **src, ulong *len)
+{
+	const uchar *p;
+	size_t n;
+	int r;
+
+	p = ds_gather(ds, src, len);
+	if (!p)
+		return 0;
+
+	switch (ds->state) {
+	case DS_LZO_HEAD:
+		/* magic, version, library version, needed version, method */
+		if (memcmp(p, lzop_magic, sizeof(lzop_magic)))
+			return -EINVAL;
+		ds->version = get_unaligned_be16(p + sizeof(lzop_magic));
+		ds_expect(ds, DS_LZO_FLAGS,
+			  (ds->version >= LZOP_VERSION_LEVEL) + 4);
+		break;
+	case DS_LZO_FLAGS:
+		/* level, flags */
+		ds->flags = get_unaligned_be32(p + ds->need - 4);
+		/* filter, mode, mtime, length of the name */
+		ds_expect(ds, DS_LZO_NAMELEN,
+			  (ds->flags & LZOP_HAS_FILTER ? 4 : 0) + 8 +
+			  (ds->version >= LZOP_VERSION_LEVEL ? 4 : 0) + 1);
+		break;
+	case DS_LZO_NAMELEN:
+		/* the name and the header checksum */
+		ds_skip(ds, p[ds->need - 1] + 4, DS_LZO_DLEN);
+		ds->need = 4;
+		break;
+	case DS_LZO_DLEN:
+		ds->dlen = get_unaligned_be32(p);
+		if (!ds->dlen) {
+			ds->state = DS_DONE;
+			break;
+		}
+		ds_expect(ds, DS_LZO_SLEN, 8);
+		break;
+	case DS_LZO_SLEN:
+		ds->slen = get_unaligned_be32(p);
+		if (!ds->slen || ds->slen > ds->dlen ||
+		    ds->dlen > DECOMP_STREAM_LZO_BLOCK)
+			return -EINVAL;
+		if (ds->dlen > ds->dst_len - ds->out)
+			return -ENOSPC;
+		ds_expect(ds, DS_LZO_DATA, ds->slen);
+		break;
+	case DS_LZO_DATA:
+		/* lzop stores a block that does not compress as it is */
+		if (ds->slen == ds->dlen) {
+			memcpy(ds->dst + ds->out, p, ds->dlen);
+		} else {
+			n = ds->dlen;
+			r = lzo1x_decompress_safe(p, ds->slen, ds->dst + ds->out,
+						  &n);
+			if (r != LZO_E_OK || n != ds->dlen)
+				return -EINVAL;
+		}
+		ds->out += ds->dlen;
+		ds_expect(ds, DS_LZO_DLEN, 4);
+		break;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_LZO */
+
+#ifdef CONFIG_LZMA
+static void *lzma_alloc(void *p, size_t size) { return malloc(size); }
+static void lzma_free(void *p, void *address) { free(address); }
+static ISzAlloc lzma_allocator = { lzma_alloc, lzma_free };
+
+/*
+ * The .lzma header: properties and the uncompressed size.  The output
+ * itself is the dictionary, as in lzmaBuffToBuffDecompress().
+ */
+static int lzma_write(struct decomp_stream *ds, const uchar **src, ulong *len)
+{
+	const uchar *p;
+	SizeT in, limit;
+	int full;
+	u64 size;
+	SRes res;
+
+	switch (ds->state) {
+	case DS_LZMA_HEAD:
+		p = ds_gather(ds, src, len);
+		if (!p)
+			break;
+		size = get_unaligned_le64(p + LZMA_PROPS_SIZE);
+		if (size == ~0ULL)
+			ds->lzma_size = (SizeT)-1;
+		else if (size > ds->dst_len)
+			return -ENOSPC;
+		else
+			ds->lzma_size = size;
+
+		res = LzmaDec_AllocateProbs(&ds->lzma, p, LZMA_PROPS_SIZE,
+					    &lzma_allocator);
+		if (res != SZ_OK)
+			return res == SZ_ERROR_MEM ? -ENOMEM : -EINVAL;
+		LzmaDec_Init(&ds->lzma);
+		ds->lzma.dic = ds->dst;
+		ds->lzma.dicBufSize = ds->dst_len;
+		ds->state = DS_LZMA_BODY;
+		break;
+	case DS_LZMA_BODY:
+		limit = ds->lzma_size == (SizeT)-1 ? ds->dst_len : ds->lzma_size;
+		/* with the output full only an end mark may follow */
+		full = ds->out == limit;
+		in = *len;
+		res = LzmaDec_DecodeToDic(&ds->lzma, limit, *src, &in,
+					  full ? LZMA_FINISH_END : LZMA_FINISH_ANY,
+					  &ds->lzma_status);
+		ds->out = ds->lzma.dicPos;
+		*src += in;
+		*len -= in;
+		if (res != SZ_OK)
+			return full ? -ENOSPC : -EINVAL;
+		if (ds->lzma_status == LZMA_STATUS_FINISHED_WITH_MARK ||
+		    ds->out == ds->lzma_size)
+			ds->state = DS_DONE;
+		else if (*len && full)
+			return -ENOSPC;
+		else if (*len && ds->out != limit)
+			return -EINVAL;
+		break;
+	}
+
+	return 0;
+}
+#endif /* CONFIG_LZMA */
+
+int decomp_stream_detect(const void *buf, ulong len)
+{
+	const uchar *p = buf;
+
+	if (len >= 3 && p[0] == 0x1f && p[1] == 0x8b && p[2] == DEFLATED)
+		return IH_COMP_GZIP;
+	if (len >= sizeof(lzop_magic) &&
+	    !memcmp(p, lzop_magic, sizeof(lzop_magic)))
+		return IH_COMP_LZO;
+
+	return IH_COMP_NONE;
+}
+
+struct decomp_stream *decomp_stream_start(int comp, void *dst, ulong dst_len)
+{
+	struct decomp_stream *ds;
+
+	ds = calloc(1, sizeof(*ds));
+	if (!ds)
+		return NULL;
+	ds->comp = comp;
+	ds->dst = dst;
+	ds->dst_len = dst_len;
+
+	switch (comp) {
+	case IH_COMP_NONE:
+		ds->state = DS_COPY;
+		return ds;
+#ifdef CONFIG_GZIP
+	case IH_COMP_GZIP:
+		ds->zs.zalloc = gzalloc;
+		ds->zs.zfree = gzfree;
+		if (inflateInit2(&ds->zs, -MAX_WBITS) != Z_OK)
+			break;
+		ds_expect(ds, DS_GZ_HEAD, 10);
+		return ds;
+#endif
+#ifdef CONFIG_LZO
+	case IH_COMP_LZO:
+		ds_expect(ds, DS_LZO_HEAD, sizeof(lzop_magic) + 7);
+		return ds;
+#endif
+#ifdef CONFIG_LZMA
+	case IH_COMP_LZMA:
+		LzmaDec_Construct(&ds->lzma);
+		ds_expect(ds, DS_LZMA_HEAD, LZMA_HEADER_SIZE);
+		return ds;
+#endif
+	default:
+		debug("decomp_stream: compression %d not supported\n", comp);
+		break;
+	}
+	free(ds);
+
+	return NULL;
+}
+
+int decomp_stream_write(struct decomp_stream *ds, const void *buf, ulong len)
+{
+	const uchar *src = buf;
+	int ret = 0;
+
+	while (len && !ds->err && !ret && ds->state != DS_DONE) {
+		if (ds->state == DS_SKIP) {
+			ulong n = min(len, ds->skip);
+
+			src += n;
+			len -= n;
+			ds->skip -= n;
+			if (!ds->skip)
+				ds->state = ds->next;
+			continue;
+		}
+
+		switch (ds->comp) {
+		case IH_COMP_NONE:
+			if (len > ds->dst_len - ds->out) {
+				ret = -ENOSPC;
+				break;
+			}
+			memcpy(ds->dst + ds->out, src, len);
+			ds->out += len;
+			len = 0;
+			break;
+#ifdef CONFIG_GZIP
+		case IH_COMP_GZIP:
+			ret = gz_write(ds, &src, &len);
+			break;
+#endif
+#ifdef CONFIG_LZO
+		case IH_COMP_LZO:
+			ret = lzo_write(ds, &src, &len);
+			break;
+#endif
+#ifdef CONFIG_LZMA
+		case IH_COMP_LZMA:
+			ret = lzma_write(ds, &src, &len);
+			break;
+#endif
+		}
+	}
+	if (ret && !ds->err)
+		ds->err = ret;
+	WATCHDOG_RESET();
+
+	return ds->err;
+}
+
+int decomp_stream_finish(struct decomp_stream *ds, ulong *lenp)
+{
+	int ret;
+
+	if (!ds)
+		return -EINVAL;
+
+	ret = ds->err;
+	if (!ret && ds->state != DS_DONE && ds->state != DS_COPY) {
+#ifdef CONFIG_LZMA
+		/* a stream of unknown size may end without an end mark */
+		if (ds->state != DS_LZMA_BODY ||
+		    ds->lzma_status != LZMA_STATUS_MAYBE_FINISHED_WITHOUT_MARK)
+#endif
+			ret = -EINVAL;
+	}
+	if (lenp)
+		*lenp = ds->out;
+
+#ifdef CONFIG_GZIP
+	if (ds->comp == IH_COMP_GZIP)
+		inflateEnd(&ds->zs);
+#endif
+#ifdef CONFIG_LZMA
+	if (ds->comp == IH_COMP_LZMA)
+		LzmaDec_FreeProbs(&ds->lzma, &lzma_allocator);
+#endif
+	free(ds->buf);
+	free(ds);
+
+	return ret;
+}
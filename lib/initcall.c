@@ -9,6 +9,30 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#ifdef CONFIG_BOOTSTAGE_INITCALL
+#define INITCALL_MARKS		64
+
+/*
+ * A bootstage record for each initcall after relocation, named by its
+ * link address so that the report tool can look it up in System.map.
+ * Before relocation there is no BSS to keep the names in.
+ */
+static void initcall_mark(char *addr)
+{
+	static char names[INITCALL_MARKS][28];
+	static int count;
+
+	if (!(gd->flags & GD_FLG_RELOC) || count == INITCALL_MARKS)
+		return;
+	snprintf(names[count], sizeof(names[0]), "initcall %lx", (ulong)addr);
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, names[count++]);
+}
+#else
+static inline void initcall_mark(char *addr)
+{
+}
+#endif
+
 int initcall_run_list(const init_fnc_t init_sequence[])
 {
 	const init_fnc_t *init_fnc_ptr;
@@ -19,6 +43,7 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 		if (gd->flags & GD_FLG_RELOC)
 			reloc_ofs = gd->reloc_off;
 		debug("initcall: %p\n", (char *)*init_fnc_ptr - reloc_ofs);
+		initcall_mark((char *)*init_fnc_ptr - reloc_ofs);
 		if ((*init_fnc_ptr)()) {
 			printf("initcall sequence %p failed at call %p\n",
 			       init_sequence,
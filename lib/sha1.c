@@ -227,6 +227,26 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	ctx->state[4] += E;
 }
 
+void sha1_blocks_generic(sha1_context *ctx, const unsigned char *data,
+			 unsigned int blocks)
+{
+	while (blocks--) {
+		sha1_process(ctx, data);
+		data += 64;
+	}
+}
+
+#ifndef USE_HOSTCC
+/* overridden where the CPU has SHA-1 instructions */
+void __weak sha1_blocks(sha1_context *ctx, const unsigned char *data,
+			unsigned int blocks)
+{
+	sha1_blocks_generic(ctx, data, blocks);
+}
+#else
+#define sha1_blocks	sha1_blocks_generic
+#endif
+
 /*
  * SHA-1 process buffer
  */
@@ -250,16 +270,16 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_blocks (ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_blocks (ctx, input, ilen / 64);
+		input += ilen & ~63;
+		ilen &= 63;
 	}
 
 	if (ilen > 0) {
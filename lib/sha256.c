@@ -181,6 +181,26 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	ctx->state[7] += H;
 }
 
+void sha256_blocks_generic(sha256_context *ctx, const uint8_t *data,
+			   unsigned int blocks)
+{
+	while (blocks--) {
+		sha256_process(ctx, data);
+		data += 64;
+	}
+}
+
+#ifndef USE_HOSTCC
+/* overridden where the CPU has SHA-256 instructions */
+void __weak sha256_blocks(sha256_context *ctx, const uint8_t *data,
+			  unsigned int blocks)
+{
+	sha256_blocks_generic(ctx, data, blocks);
+}
+#else
+#define sha256_blocks	sha256_blocks_generic
+#endif
+
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 {
 	uint32_t left, fill;
@@ -199,16 +219,16 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (left && length >= fill) {
 		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
+		sha256_blocks(ctx, ctx->buffer, 1);
 		length -= fill;
 		input += fill;
 		left = 0;
 	}
 
-	while (length >= 64) {
-		sha256_process(ctx, input);
-		length -= 64;
-		input += 64;
+	if (length >= 64) {
+		sha256_blocks(ctx, input, length / 64);
+		input += length & ~63;
+		length &= 63;
 	}
 
 	if (length)
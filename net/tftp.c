@@ -9,6 +9,7 @@
 #include <common.h>
 #include <command.h>
 #include <net.h>
+#include <asm/io.h>
 #include "tftp.h"
 #include "bootp.h"
 #ifdef CONFIG_SYS_DIRECT_FLASH_TFTP
@@ -130,6 +131,50 @@ static char tftp_filename[MAX_LEN];
 static unsigned short TftpBlkSize = TFTP_BLOCK_SIZE;
 static unsigned short TftpBlkSizeOption = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * Downloads are windowed (RFC 7440): the server sends TftpWindowSize
+ * blocks per ACK, and a window of 1 is the lock-step RFC 1350 transfer.
+ * Blocks are stored at their place in memory as they come, so a window
+ * arriving out of order needs no buffering, only a bit per block.
+ */
+#define TFTP_WINDOWSIZE_MAX	64
+
+static unsigned short TftpWindowSize;
+/* block number that completes the window opened by our last ACK */
+static ulong	TftpNextAck;
+/* bit n set: block TftpLastBlock + 1 + n is already stored */
+static unsigned long long TftpWindowMap;
+/* the short block that ends the file has been stored */
+static int	TftpEndSeen;
+static ulong	TftpEndBlock;
+/* blocks received twice, reported at the end */
+static ulong	TftpDupBlocks;
+
+#ifdef CONFIG_TFTP_WINDOWSIZE
+static unsigned short TftpWindowSizeOption = CONFIG_TFTP_WINDOWSIZE;
+
+/*
+ * Shortest retransmit timeout, ms.  The samples come from get_timer(),
+ * so a LAN round trip reads as 0 or 1 ms; keep well clear of that and of
+ * a server that is briefly busy (RFC 6298 uses 1s, stacks go to 200ms).
+ */
+#define TFTP_RTO_MIN		200UL
+
+/*
+ * Retransmit timeout of a download, from the time between our ACK and
+ * the next block (RFC 6298, Karn's rule for resent ACKs).  TftpSRTT is
+ * kept in ms << 3 and TftpRTTVar in ms << 2.  TftpTimeoutMSecs stays the
+ * upper bound and the timeout used until the first sample.
+ */
+static ulong	TftpSRTT;
+static ulong	TftpRTTVar;
+static ulong	TftpRTO;
+static ulong	TftpAckTime;
+static int	TftpAckTimed;
+#else
+#define TftpRTO		TftpTimeoutMSecs
+#endif
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -184,7 +229,10 @@ store_block(int block, uchar *src, unsigned len)
 	} else
 #endif /* CONFIG_SYS_DIRECT_FLASH_TFTP */
 	{
-		(void)memcpy((void *)(load_addr + offset), src, len);
+		void *ptr = map_sysmem(load_addr + offset, len);
+
+		memcpy(ptr, src, len);
+		unmap_sysmem(ptr);
 	}
 #ifdef CONFIG_MCAST_TFTP
 	if (Multicast)
@@ -201,6 +249,10 @@ static void new_transfer(void)
 	TftpLastBlock = 0;
 	TftpBlockWrap = 0;
 	TftpBlockWrapOffset = 0;
+	TftpNextAck = TftpWindowSize;
+	TftpWindowMap = 0;
+	TftpEndSeen = 0;
+	TftpDupBlocks = 0;
 #ifdef CONFIG_CMD_TFTPPUT
 	TftpFinalBlock = 0;
 #endif
@@ -220,9 +272,12 @@ static int load_block(unsigned block, uchar *dst, unsigned len)
 	/* We may want to get the final block from the previous set */
 	ulong offset = ((int)block - 1) * len + TftpBlockWrapOffset;
 	ulong tosend = len;
+	void *ptr;
 
 	tosend = min(NetBootFileXferSize - offset, tosend);
-	(void)memcpy(dst, (void *)(save_addr + offset), tosend);
+	ptr = map_sysmem(save_addr + offset, tosend);
+	memcpy(dst, ptr, tosend);
+	unmap_sysmem(ptr);
 	debug("%s: block=%d, offset=%ld, len=%d, tosend=%ld\n", __func__,
 		block, offset, len, tosend);
 	return tosend;
@@ -234,11 +289,11 @@ static void TftpTimeout(void);
 
 /**********************************************************************/
 
-static void show_block_marker(void)
+static void show_block_marker(ulong block)
 {
 #ifdef CONFIG_TFTP_TSIZE
 	if (TftpTsize) {
-		ulong pos = TftpBlock * TftpBlkSize + TftpBlockWrapOffset;
+		ulong pos = block * TftpBlkSize + TftpBlockWrapOffset;
 
 		while (TftpNumchars < pos * 50 / TftpTsize) {
 			putc('#');
@@ -247,9 +302,9 @@ static void show_block_marker(void)
 	} else
 #endif
 	{
-		if (((TftpBlock - 1) % 10) == 0)
+		if (((block - 1) % 10) == 0)
 			putc('#');
-		else if ((TftpBlock % (10 * HASHES_PER_LINE)) == 0)
+		else if ((block % (10 * HASHES_PER_LINE)) == 0)
 			puts("\n\t ");
 	}
 }
@@ -268,6 +323,7 @@ static void restart(const char *msg)
 	NetStartAgain();
 }
 
+#if defined(CONFIG_CMD_TFTPPUT) || defined(CONFIG_MCAST_TFTP)
 /*
  * Check if the block number has wrapped, and update progress
  *
@@ -286,9 +342,10 @@ static void update_block_number(void)
 		TftpBlockWrapOffset += TftpBlkSize * TFTP_SEQUENCE_SIZE;
 		TftpTimeoutCount = 0; /* we've done well, reset thhe timeout */
 	} else {
-		show_block_marker();
+		show_block_marker(TftpBlock);
 	}
 }
+#endif
 
 /* The TFTP get or put is complete */
 static void tftp_complete(void)
@@ -305,11 +362,120 @@ static void tftp_complete(void)
 		puts("\n\t ");	/* Line up with "Loading: " */
 		print_size(NetBootFileXferSize /
 			time_start * 1000, "/s");
+		if (TftpWindowSize > 1)
+			printf(", window %d, %lu blocks resent",
+			       TftpWindowSize, TftpDupBlocks);
 	}
 	puts("\ndone\n");
 	net_set_state(NETLOOP_SUCCESS);
 }
 
+#ifdef CONFIG_TFTP_WINDOWSIZE
+/* Start timing the ACK about to be sent */
+static void tftp_time_ack(void)
+{
+	TftpAckTime = get_timer(0);
+	TftpAckTimed = 1;
+}
+
+/* A new block came: fold the time since our ACK into the timeout */
+static void tftp_rtt_sample(void)
+{
+	long rtt, err;
+
+	if (!TftpAckTimed)
+		return;
+	TftpAckTimed = 0;
+	rtt = get_timer(TftpAckTime);
+
+	if (!TftpSRTT && !TftpRTTVar) {
+		TftpSRTT = rtt << 3;
+		TftpRTTVar = rtt << 1;
+	} else {
+		err = rtt - (TftpSRTT >> 3);
+		TftpSRTT += err;
+		if (err < 0)
+			err = -err;
+		TftpRTTVar += err - (TftpRTTVar >> 2);
+	}
+	TftpRTO = (TftpSRTT >> 3) + TftpRTTVar;
+	TftpRTO = min(max(TftpRTO, TFTP_RTO_MIN), TftpTimeoutMSecs);
+	debug("TFTP rtt %ld ms, timeout %lu ms\n", rtt, TftpRTO);
+}
+#else
+static inline void tftp_time_ack(void) {}
+static inline void tftp_rtt_sample(void) {}
+#endif
+
+/* ACK all blocks up to TftpLastBlock, which opens the next window */
+static void tftp_send_ack(void)
+{
+	TftpBlock = TftpLastBlock;
+	TftpNextAck = (TftpLastBlock + TftpWindowSize) & 0xffff;
+	tftp_time_ack();
+	TftpSend();
+}
+
+/*
+ * A data block of a download.  Blocks of the current window are stored
+ * in whatever order they come, blocks seen before are dropped.  The
+ * window is acked when it is complete, or when its last block arrives
+ * with a hole before it: the server then resends from the hole on.
+ */
+static void tftp_data_block(uchar *data, unsigned len)
+{
+	ulong delta = (TftpBlock - TftpLastBlock) & 0xffff;
+	unsigned long long bit;
+
+	if (delta == 0 || delta > TftpWindowSize) {
+		/* resent by the server before our ACK got there */
+		TftpDupBlocks++;
+		TftpBlock = TftpLastBlock;
+		return;
+	}
+
+	bit = 1ULL << (delta - 1);
+	if (TftpWindowMap & bit) {
+		TftpDupBlocks++;
+	} else {
+		tftp_rtt_sample();
+		TftpWindowMap |= bit;
+		store_block(TftpLastBlock + delta - 1, data, len);
+		if (len < TftpBlkSize) {
+			TftpEndSeen = 1;
+			TftpEndBlock = TftpBlock;
+		}
+	}
+	TftpTimeoutCountMax = TIMEOUT_COUNT;
+
+	/* move past the blocks that are now in order */
+	while (TftpWindowMap & 1) {
+		TftpWindowMap >>= 1;
+		TftpLastBlock = (TftpLastBlock + 1) & 0xffff;
+		if (TftpLastBlock == 0) {
+			TftpBlockWrap++;
+			TftpBlockWrapOffset += TftpBlkSize * TFTP_SEQUENCE_SIZE;
+		} else {
+			show_block_marker(TftpLastBlock);
+		}
+		TftpTimeoutCount = 0;
+	}
+
+	if (TftpEndSeen && TftpLastBlock == TftpEndBlock) {
+		tftp_send_ack();
+		tftp_complete();
+		return;
+	}
+
+	if (((TftpLastBlock - TftpNextAck) & 0xffff) < TFTP_WINDOWSIZE_MAX ||
+	    TftpBlock == TftpNextAck ||
+	    (TftpEndSeen && TftpBlock == TftpEndBlock))
+		tftp_send_ack();
+	else
+		TftpBlock = TftpLastBlock;	/* what a timeout acks */
+	NetSetTimeout(TftpRTO, TftpTimeout);
+}
+
 static void
 TftpSend(void)
 {
@@ -359,6 +525,12 @@ TftpSend(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, TftpBlkSizeOption, 0);
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		/* only downloads are windowed */
+		if (TftpState == STATE_SEND_RRQ && TftpWindowSizeOption > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, TftpWindowSizeOption, 0);
+#endif
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!ProhibitMcast) {
@@ -431,6 +603,54 @@ TftpSend(void)
 			 TftpOurPort, len);
 }
 
+#ifdef CONFIG_MCAST_TFTP
+/* A data block of a multicast download, ahead of TftpHandler */
+static void mcast_data_block(uchar *data, unsigned len)
+{
+	if (TftpBlock == TftpLastBlock) {
+		/*
+		 *	Same block again; ignore it.
+		 */
+		return;
+	}
+
+	TftpLastBlock = TftpBlock;
+	TftpTimeoutCountMax = TIMEOUT_COUNT;
+	NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
+
+	store_block(TftpBlock - 1, data, len);
+
+	/* if I am the MasterClient, actively calculate what my next
+	 * needed block is; else I'm passive; not ACKING
+	 */
+	if (len < TftpBlkSize)  {
+		TftpEndingBlock = TftpBlock;
+	} else if (MasterClient) {
+		TftpBlock = PrevBitmapHole =
+			ext2_find_next_zero_bit(
+				Bitmap,
+				(Mapsize*8),
+				PrevBitmapHole);
+		if (TftpBlock > ((Mapsize*8) - 1)) {
+			printf("tftpfile too big\n");
+			/* try to double it and retry */
+			Mapsize <<= 1;
+			mcast_cleanup();
+			NetStartAgain();
+			return;
+		}
+		TftpLastBlock = TftpBlock;
+	}
+	TftpSend();
+
+	if (MasterClient && (TftpBlock >= TftpEndingBlock)) {
+		puts("\nMulticast tftp done\n");
+		mcast_cleanup();
+		net_set_state(NETLOOP_SUCCESS);
+	}
+}
+#endif
+
 #ifdef CONFIG_CMD_TFTPPUT
 static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 			 IPaddr_t sip, unsigned src, uchar *pkt, unsigned len)
@@ -505,7 +725,7 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		TftpRemotePort = src;
 		TftpOurPort = 1024 + (get_timer(0) % 3072);
 		new_transfer();
-		TftpSend(); /* Send ACK(0) */
+		tftp_send_ack(); /* Send ACK(0) */
 		break;
 #endif
 
@@ -535,10 +755,27 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 				debug("size = %s, %d\n",
 					 (char *)pkt+i+6, TftpTsize);
 			}
+#endif
+#ifdef CONFIG_TFTP_WINDOWSIZE
+			if (strcmp((char *)pkt+i, "windowsize") == 0) {
+				TftpWindowSize = simple_strtoul((char *)pkt+i+11,
+								NULL, 10);
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt+i+11, TftpWindowSize);
+			}
 #endif
 		}
+		/* never more than we asked for */
+		if (TftpWindowSize < 1 || TftpWriting)
+			TftpWindowSize = 1;
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		if (TftpWindowSize > TftpWindowSizeOption)
+			TftpWindowSize = TftpWindowSizeOption;
+#endif
 #ifdef CONFIG_MCAST_TFTP
 		parse_multicast_oack((char *)pkt, len-1);
+		if (Multicast)
+			TftpWindowSize = 1;
 		if ((Multicast) && (!MasterClient))
 			TftpState = STATE_DATA;	/* passive.. */
 		else
@@ -550,6 +787,11 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			TftpBlock++;
 		}
 #endif
+		if (!TftpWriting) {
+			/* ACK(0) opens the first window */
+			TftpNextAck = TftpWindowSize;
+			tftp_time_ack();
+		}
 		TftpSend(); /* Send ACK or first data block */
 		break;
 	case TFTP_DATA:
@@ -558,7 +800,10 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		len -= 2;
 		TftpBlock = ntohs(*(__be16 *)pkt);
 
-		update_block_number();
+#ifdef CONFIG_MCAST_TFTP
+		if (Multicast)
+			update_block_number();
+#endif
 
 		if (TftpState == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
@@ -575,7 +820,8 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 				TftpLastBlock = TftpBlock - 1;
 			} else
 #endif
-			if (TftpBlock != 1) {	/* Assertion */
+			/* Assertion: block 1, or one after it in the window */
+			if (TftpBlock == 0 || TftpBlock > TftpWindowSize) {
 				printf("\nTFTP error: "
 				       "First block is not block 1 (%ld)\n"
 				       "Starting again\n\n",
@@ -585,61 +831,13 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			}
 		}
 
-		if (TftpBlock == TftpLastBlock) {
-			/*
-			 *	Same block again; ignore it.
-			 */
-			break;
-		}
-
-		TftpLastBlock = TftpBlock;
-		TftpTimeoutCountMax = TIMEOUT_COUNT;
-		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
-
-		store_block(TftpBlock - 1, pkt + 2, len);
-
-		/*
-		 *	Acknowledge the block just received, which will prompt
-		 *	the remote for the next one.
-		 */
 #ifdef CONFIG_MCAST_TFTP
-		/* if I am the MasterClient, actively calculate what my next
-		 * needed block is; else I'm passive; not ACKING
-		 */
 		if (Multicast) {
-			if (len < TftpBlkSize)  {
-				TftpEndingBlock = TftpBlock;
-			} else if (MasterClient) {
-				TftpBlock = PrevBitmapHole =
-					ext2_find_next_zero_bit(
-						Bitmap,
-						(Mapsize*8),
-						PrevBitmapHole);
-				if (TftpBlock > ((Mapsize*8) - 1)) {
-					printf("tftpfile too big\n");
-					/* try to double it and retry */
-					Mapsize <<= 1;
-					mcast_cleanup();
-					NetStartAgain();
-					return;
-				}
-				TftpLastBlock = TftpBlock;
-			}
+			mcast_data_block(pkt + 2, len);
+			break;
 		}
 #endif
-		TftpSend();
-
-#ifdef CONFIG_MCAST_TFTP
-		if (Multicast) {
-			if (MasterClient && (TftpBlock >= TftpEndingBlock)) {
-				puts("\nMulticast tftp done\n");
-				mcast_cleanup();
-				net_set_state(NETLOOP_SUCCESS);
-			}
-		} else
-#endif
-		if (len < TftpBlkSize)
-			tftp_complete();
+		tftp_data_block(pkt + 2, len);
 		break;
 
 	case TFTP_ERROR:
@@ -678,7 +876,15 @@ TftpTimeout(void)
 		restart("Retry count exceeded");
 	} else {
 		puts("T ");
-		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
+#ifdef CONFIG_TFTP_WINDOWSIZE
+		/* back off, and take no sample from the resent packet */
+		TftpRTO = min(TftpRTO * 2, TftpTimeoutMSecs);
+		TftpAckTimed = 0;
+#endif
+		NetSetTimeout(TftpRTO, TftpTimeout);
+		/* the ACK we resend makes the server start the window again */
+		if (TftpState == STATE_DATA && !TftpWriting)
+			TftpNextAck = (TftpLastBlock + TftpWindowSize) & 0xffff;
 		if (TftpState != STATE_RECV_WRQ)
 			TftpSend();
 	}
@@ -708,6 +914,27 @@ void TftpStart(enum proto_t protocol)
 		TftpTimeoutMSecs = 1000;
 	}
 
+#ifdef CONFIG_TFTP_WINDOWSIZE
+	ep = getenv("tftpwindowsize");
+	if (ep != NULL)
+		TftpWindowSizeOption = simple_strtol(ep, NULL, 10);
+
+	if (TftpWindowSizeOption < 1)
+		TftpWindowSizeOption = 1;
+	if (TftpWindowSizeOption > TFTP_WINDOWSIZE_MAX) {
+		printf("TFTP window size %d too large, using %d\n",
+		       TftpWindowSizeOption, TFTP_WINDOWSIZE_MAX);
+		TftpWindowSizeOption = TFTP_WINDOWSIZE_MAX;
+	}
+
+	TftpSRTT = 0;
+	TftpRTTVar = 0;
+	TftpRTO = TftpTimeoutMSecs;
+	TftpAckTimed = 0;
+
+	debug("TFTP windowsize = %i\n", TftpWindowSizeOption);
+#endif
+
 	debug("TFTP blocksize = %i, timeout = %ld ms\n",
 		TftpBlkSizeOption, TftpTimeoutMSecs);
 
@@ -809,6 +1036,9 @@ void TftpStart(enum proto_t protocol)
 	memset(NetServerEther, 0, 6);
 	/* Revert TftpBlkSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	/* lock-step unless the server takes the windowsize option */
+	TftpWindowSize = 1;
+	TftpNextAck = 1;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -835,10 +1065,17 @@ TftpStartServer(void)
 	TftpTimeoutCountMax = TIMEOUT_COUNT;
 	TftpTimeoutCount = 0;
 	TftpTimeoutMSecs = TIMEOUT;
+#ifdef CONFIG_TFTP_WINDOWSIZE
+	TftpSRTT = 0;
+	TftpRTTVar = 0;
+	TftpRTO = TftpTimeoutMSecs;
+	TftpAckTimed = 0;
+#endif
 	NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
 
 	/* Revert TftpBlkSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	TftpWindowSize = 1;
 	TftpBlock = 0;
 	TftpOurPort = WELL_KNOWN_PORT;
 
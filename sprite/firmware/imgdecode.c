@@ -45,6 +45,10 @@ typedef struct tag_IMAGE_HANDLE
 
 	ImageItem_t *ItemTable;		//item信息表
 
+	uint        *ItemHash;		//按subType建立的散列索引，存放item序号+1，0表示空位
+
+	uint         ItemHashMask;	//散列表大小-1
+
 //	RC_ENDECODE_IF_t rc_if_decode[IF_CNT];//解密接口
 
 //	BOOL			bWithEncpy; // 是否加密
@@ -55,18 +59,197 @@ typedef struct tag_IMAGE_HANDLE
 
 typedef struct tag_ITEM_HANDLE{
 	uint	index;					//在ItemTable中的索引
-	uint    reserved[3];
-//	long long pos;
+	uint    reserved;
+	long long pos;					//Img_ReadItemData顺序读取的位置
 }ITEM_HANDLE;
 
 #define ITEM_PHOENIX_TOOLS 	  "PXTOOLS "
 
+#define IMG_BOUNCE_SIZE		(64 * 1024)		//调用者buffer不对齐时，经过这个大小的buffer中转
+
 uint img_file_start;			//固件的起始位置
 //------------------------------------------------------------------------------------------------------------
 //image解析插件的接口
 //------------------------------------------------------------------------------------------------------------
 
 
+//------------------------------------------------------------------------------------------------------------
+//
+// 函数说明
+//     subType的散列值(FNV-1a)
+//
+//------------------------------------------------------------------------------------------------------------
+static uint __Img_HashSubType(const u8 *subType)
+{
+	uint hash = 2166136261u;
+	int  i;
+
+	for (i = 0; i < SUBTYPE_LEN; i++)
+	{
+		hash ^= subType[i];
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+//------------------------------------------------------------------------------------------------------------
+//
+// 函数说明
+//     打开固件时建立一次索引，以后查找item不用再逐个比较
+//
+// 其他
+//     subType相同的item，和原来的顺序查找一样，返回排在前面的那个
+//
+//------------------------------------------------------------------------------------------------------------
+static int __Img_BuildIndex(IMAGE_HANDLE *pImage)
+{
+	uint size = 16;
+	uint i, slot;
+
+	while (size < pImage->ImageHead.itemcount * 2)
+	{
+		size <<= 1;
+	}
+	pImage->ItemHash = (uint *)malloc(size * sizeof(uint));
+	if (NULL == pImage->ItemHash)
+	{
+		return -1;
+	}
+	memset(pImage->ItemHash, 0, size * sizeof(uint));
+	pImage->ItemHashMask = size - 1;
+
+	for (i = 0; i < pImage->ImageHead.itemcount; i++)
+	{
+		slot = __Img_HashSubType(pImage->ItemTable[i].subType) & pImage->ItemHashMask;
+		while (pImage->ItemHash[slot])
+		{
+			slot = (slot + 1) & pImage->ItemHashMask;
+		}
+		pImage->ItemHash[slot] = i + 1;
+	}
+
+	return 0;
+}
+//------------------------------------------------------------------------------------------------------------
+//
+// 函数说明
+//     返回item序号，找不到时返回INVALID_INDEX
+//
+//------------------------------------------------------------------------------------------------------------
+static uint __Img_FindItem(IMAGE_HANDLE *pImage, char *subType)
+{
+	uint slot, index;
+
+	slot = __Img_HashSubType((u8 *)subType) & pImage->ItemHashMask;
+	while ((index = pImage->ItemHash[slot]) != 0)
+	{
+		if (!memcmp(subType, pImage->ItemTable[index - 1].subType, SUBTYPE_LEN))
+		{
+			return index - 1;
+		}
+		slot = (slot + 1) & pImage->ItemHashMask;
+	}
+
+	return INVALID_INDEX;
+}
+//------------------------------------------------------------------------------------------------------------
+//
+// 函数说明
+//     item数据在卡上的起始扇区
+//
+//------------------------------------------------------------------------------------------------------------
+static uint __Img_ItemStart(IMAGE_HANDLE *pImage, uint index)
+{
+	long long offset;
+
+	offset = pImage->ItemTable[index].offsetHi;
+	offset <<= 32;
+	offset |= pImage->ItemTable[index].offsetLo;
+
+	return (uint)(offset/512) + img_file_start;
+}
+//------------------------------------------------------------------------------------------------------------
+//
+// 函数说明
+//     从start扇区读出bytes字节
+//
+// 参数说明
+//     buffer_size : 调用者buffer的大小
+//
+// 其他
+//     buffer按ARCH_DMA_MINALIGN对齐时数据直接dma到buffer中，不对齐时经过中转buffer拷贝;
+//     最后不足一个扇区的数据，buffer放得下整个扇区时也直接读入，否则单独读出再拷贝
+//
+//------------------------------------------------------------------------------------------------------------
+static int __Img_ReadData(uint start, void *buffer, uint bytes, uint buffer_size)
+{
+	char *dst = (char *)buffer;
+	char *bounce = NULL;
+	uint  sectors, this_sectors;
+	uint  tail;
+	int   ret = -1;
+
+	if (!bytes)
+	{
+		return -1;
+	}
+	sectors = bytes >> 9;
+	tail    = bytes & 511;
+	if (tail && (buffer_size >= ((bytes + 511) & (~511))))
+	{
+		sectors ++;
+		tail = 0;
+	}
+	if (!((ulong)dst & (ARCH_DMA_MINALIGN - 1)))
+	{
+		if (sectors && (sunxi_flash_read(start, sectors, dst) != sectors))
+		{
+			return -1;
+		}
+		start += sectors;
+		dst   += sectors << 9;
+		sectors = 0;
+		if (!tail)
+		{
+			return 0;
+		}
+	}
+	bounce = (char *)malloc_pool(IMG_BOUNCE_SIZE);
+	if (NULL == bounce)
+	{
+		printf("sunxi sprite error : fail to get memory for temp data\n");
+
+		return -1;
+	}
+	while (sectors)
+	{
+		this_sectors = min(sectors, (uint)(IMG_BOUNCE_SIZE >> 9));
+		if (sunxi_flash_read(start, this_sectors, bounce) != this_sectors)
+		{
+			goto __read_data_err;
+		}
+		memcpy(dst, bounce, this_sectors << 9);
+		start   += this_sectors;
+		dst     += this_sectors << 9;
+		sectors -= this_sectors;
+	}
+	if (tail)
+	{
+		if (sunxi_flash_read(start, 1, bounce) != 1)
+		{
+			goto __read_data_err;
+		}
+		memcpy(dst, bounce, tail);
+	}
+	ret = 0;
+
+__read_data_err:
+	free_pool(bounce);
+
+	return ret;
+}
+
+
 //------------------------------------------------------------------------------------------------------------
 //
 // 函数说明
@@ -95,7 +278,7 @@ HIMAGE 	Img_Open	(char * ImageFile)
 		return NULL;
 	}
 	debug("img start = 0x%x\n", img_file_start);
-	pImage = (IMAGE_HANDLE *)malloc(sizeof(IMAGE_HANDLE));
+	pImage = (IMAGE_HANDLE *)memalign(ARCH_DMA_MINALIGN, sizeof(IMAGE_HANDLE));
 	if (NULL == pImage)
 	{
 		printf("sunxi sprite error: fail to malloc memory for img head\n");
@@ -127,7 +310,7 @@ HIMAGE 	Img_Open	(char * ImageFile)
 	//为索引表开辟空间
 	//------------------------------------------------
 	ItemTableSize = pImage->ImageHead.itemcount * sizeof(ImageItem_t);
-	pImage->ItemTable = (ImageItem_t*)malloc(ItemTableSize);
+	pImage->ItemTable = (ImageItem_t*)memalign(ARCH_DMA_MINALIGN, ItemTableSize);
 	if (NULL == pImage->ItemTable)
 	{
 		printf("sunxi sprite error: fail to malloc memory for item table\n");
@@ -143,6 +326,15 @@ HIMAGE 	Img_Open	(char * ImageFile)
 
 		goto _img_open_fail_;
 	}
+	//------------------------------------------------
+	//建立item索引
+	//------------------------------------------------
+	if(__Img_BuildIndex(pImage))
+	{
+		printf("sunxi sprite error: fail to malloc memory for item index\n");
+
+		goto _img_open_fail_;
+	}
 
 	return pImage;
 
@@ -212,7 +404,6 @@ HIMAGEITEM 	Img_OpenItem	(HIMAGE hImage, char * MainType, char * subType)
 {
 	IMAGE_HANDLE* pImage = (IMAGE_HANDLE *)hImage;
 	ITEM_HANDLE * pItem  = NULL;
-	uint          i;
 
 	if (NULL == pImage || NULL == MainType || NULL == subType)
 	{
@@ -226,42 +417,11 @@ HIMAGEITEM 	Img_OpenItem	(HIMAGE hImage, char * MainType, char * subType)
 
 		return NULL;
 	}
-	pItem->index = INVALID_INDEX;
-
-	for (i = 0; i < pImage->ImageHead.itemcount ; i++)
+	pItem->index = __Img_FindItem(pImage, subType);
+	pItem->pos   = 0;
+	if (INVALID_INDEX != pItem->index)
 	{
-//		int nCmp = memcmp(ITEM_PHOENIX_TOOLS, MainType, MAINTYPE_LEN);
-//
-//		if (nCmp == 0)//
-//		{
-//			if (memcmp(MainType, pImage->ItemTable[i].mainType, MAINTYPE_LEN) == 0 )
-//			{
-//				pItem->index = i;
-//
-//				return pItem;
-//			}
-//		}
-//		else
-//		{
-//			nCmp = memcmp(MainType, pImage->ItemTable[i].mainType, MAINTYPE_LEN);
-//			if(nCmp == 0)
-//			{
-//				nCmp = memcmp(subType,  pImage->ItemTable[i].subType,  SUBTYPE_LEN);
-//				if( nCmp == 0)
-//				{
-//					pItem->index = i;
-//
-//					return pItem;
-//				}
-//			}
-//		}
-		if(!memcmp(subType,  pImage->ItemTable[i].subType,  SUBTYPE_LEN))
-		{
-			pItem->index = i;
-			//debug("try to malloc %x\n", (uint)pItem);
-
-			return pItem;
-		}
+		return pItem;
 	}
 
 	printf("sunxi sprite error : cannot find item %s %s\n", MainType, subType);
@@ -328,8 +488,6 @@ uint Img_GetItemStart	(HIMAGE hImage, HIMAGEITEM hItem)
 {
 	IMAGE_HANDLE* pImage = (IMAGE_HANDLE *)hImage;
 	ITEM_HANDLE * pItem  = (ITEM_HANDLE  *)hItem;
-	long long       start;
-	long long		offset;
 
 	if (NULL == pItem)
 	{
@@ -337,12 +495,8 @@ uint Img_GetItemStart	(HIMAGE hImage, HIMAGEITEM hItem)
 
 		return 0;
 	}
-	offset = pImage->ItemTable[pItem->index].offsetHi;
-	offset <<= 32;
-	offset |= pImage->ItemTable[pItem->index].offsetLo;
-	start = offset/512;
 
-	return ((uint)start + img_file_start);
+	return __Img_ItemStart(pImage, pItem->index);
 }
 //------------------------------------------------------------------------------------------------------------
 //
@@ -359,15 +513,11 @@ uint Img_GetItemStart	(HIMAGE hImage, HIMAGEITEM hItem)
 //    无
 //
 //------------------------------------------------------------------------------------------------------------
-#if 0
 uint Img_ReadItem(HIMAGE hImage, HIMAGEITEM hItem, void *buffer, uint buffer_size)
 {
 	IMAGE_HANDLE* pImage = (IMAGE_HANDLE *)hImage;
 	ITEM_HANDLE * pItem  = (ITEM_HANDLE  *)hItem;
-	long long     start;
-	long long	  offset;
 	uint	      file_size;
-	void          *tmp;
 
 	if (NULL == pItem)
 	{
@@ -389,46 +539,36 @@ uint Img_ReadItem(HIMAGE hImage, HIMAGEITEM hItem, void *buffer, uint buffer_siz
 
 		return 0;
 	}
-	if(file_size > 2 * 1024 * 1024)
-	{
-		printf("sunxi sprite error : this function cant be used to read data over 2M bytes\n");
-
-		return 0;
-	}
-	file_size = (file_size + 1023) & (~(1024 - 1));
-	offset = pImage->ItemTable[pItem->index].offsetHi;
-	offset <<= 32;
-	offset |= pImage->ItemTable[pItem->index].offsetLo;
-	start = offset/512;
-
-	debug("malloc size = %d\n", file_size);
-	tmp = malloc(file_size);
-	if(!tmp)
-	{
-		printf("sunxi sprite error : fail to get memory for temp data\n");
-
-		return 0;
-	}
-	if(!sunxi_flash_read((uint)start + img_file_start, file_size/512, tmp))
+	if(__Img_ReadData(__Img_ItemStart(pImage, pItem->index), buffer, file_size, buffer_size))
 	{
 		printf("sunxi sprite error : read item data failed\n");
-		free(tmp);
 
 		return 0;
 	}
-	memcpy(buffer, tmp, buffer_size);
-	free(tmp);
 
-	return buffer_size;
+	return file_size;
 }
-#else
-uint Img_ReadItem(HIMAGE hImage, HIMAGEITEM hItem, void *buffer, uint buffer_size)
+//------------------------------------------------------------------------------------------------------------
+//
+// 函数说明
+//     从item的当前位置顺序读取数据，没有大小限制，大的item可以用同一个buffer分多次读出
+//
+// 参数说明
+//     length : 本次最多读取的字节数，除了item的最后一笔数据，必须是512的整数倍
+//
+// 返回值
+//     返回实际读取数据的长度，item已经读完时返回0
+//
+// 其他
+//    无
+//
+//------------------------------------------------------------------------------------------------------------
+uint Img_ReadItemData(HIMAGE hImage, HIMAGEITEM hItem, void *buffer, uint length)
 {
 	IMAGE_HANDLE* pImage = (IMAGE_HANDLE *)hImage;
 	ITEM_HANDLE * pItem  = (ITEM_HANDLE  *)hItem;
-	long long     start;
-	long long	  offset;
-	uint	      file_size;
+	long long     rest;
+	uint          this_len;
 
 	if (NULL == pItem)
 	{
@@ -436,36 +576,35 @@ uint Img_ReadItem(HIMAGE hImage, HIMAGEITEM hItem, void *buffer, uint buffer_siz
 
 		return 0;
 	}
-	if(pImage->ItemTable[pItem->index].filelenHi)
+	rest = Img_GetItemSize(hImage, hItem) - pItem->pos;
+	if(rest <= 0)
 	{
-		printf("sunxi sprite error : the item too big\n");
-
 		return 0;
 	}
-	file_size = pImage->ItemTable[pItem->index].filelenLo;
-	file_size = (file_size + 1023) & (~(1024 - 1));
-	debug("file size=%d, buffer size=%d\n", file_size, buffer_size);
-	if(file_size > buffer_size)
+	if(rest > length)
 	{
-		printf("sunxi sprite error : buffer is smaller than data size\n");
+		this_len = length & (~511);
+		if(!this_len)
+		{
+			printf("sunxi sprite error : item must be read in 512 bytes at least\n");
 
-		return 0;
+			return 0;
+		}
 	}
-	offset = pImage->ItemTable[pItem->index].offsetHi;
-	offset <<= 32;
-	offset |= pImage->ItemTable[pItem->index].offsetLo;
-	start = offset/512;
-
-	if(!sunxi_flash_read((uint)start + img_file_start, file_size/512, buffer))
+	else
+	{
+		this_len = (uint)rest;
+	}
+	if(__Img_ReadData(__Img_ItemStart(pImage, pItem->index) + (uint)(pItem->pos>>9), buffer, this_len, length))
 	{
 		printf("sunxi sprite error : read item data failed\n");
 
 		return 0;
 	}
+	pItem->pos += this_len;
 
-	return file_size;
+	return this_len;
 }
-#endif
 //------------------------------------------------------------------------------------------------------------
 //
 // 函数说明
@@ -875,6 +1014,11 @@ void  Img_Close	(HIMAGE hImage)
 		free(pImage->ItemTable);
 		pImage->ItemTable = NULL;
 	}
+	if (NULL != pImage->ItemHash)
+	{
+		free(pImage->ItemHash);
+		pImage->ItemHash = NULL;
+	}
 
 	memset(pImage, 0, sizeof(IMAGE_HANDLE));
 	free(pImage);
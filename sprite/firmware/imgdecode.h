@@ -54,6 +54,8 @@ extern   uint 			Img_GetItemStart(HIMAGE hImage, HIMAGEITEM hItem);
 
 extern   uint 			Img_ReadItem	(HIMAGE hImage, HIMAGEITEM hItem, void *buffer, uint buffer_size);
 
+extern   uint 			Img_ReadItemData(HIMAGE hImage, HIMAGEITEM hItem, void *buffer, uint length);
+
 extern   int 			Img_CloseItem	(HIMAGE hImage, HIMAGEITEM hItem);
 
 extern   void 	 		Img_Close		(HIMAGE hImage);
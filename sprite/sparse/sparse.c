@@ -23,7 +23,8 @@
  */
 #include <config.h>
 #include <common.h>
-#include <sparse_format.h>
+#include <malloc.h>
+#include <sunxi_flash.h>
 #include "sparse.h"
 #include "../sprite_verify.h"
 
@@ -32,14 +33,8 @@
 #define   SPARSE_FORMAT_TYPE_CHUNK_DATA       0xff02
 #define   SPARSE_FORMAT_TYPE_CHUNK_FILL_DATA       0xff03
 
-static uint  android_format_checksum;
-static uint  sparse_format_type;
-static uint  chunk_count;
-static int  last_rest_size;
-static int  chunk_length;
-static uint  flash_start;
-static sparse_header_t globl_header;
-static uint  total_chunks;
+static void __sparse_release(sparse_stream_t *stream);
+
 /*
 ************************************************************************************************************
 *
@@ -47,16 +42,16 @@ static uint  total_chunks;
 *
 *    函数名称：
 *
-*    参数列表：
+*    参数列表：stream       : 由调用者提供，保存解析状态
 *
 *    返回值  ：
 *
-*    说明    ：
+*    说明    ：检查sparse文件头，并初始化stream，数据默认用sunxi_sprite_write写入
 *
 *
 ************************************************************************************************************
 */
-int unsparse_probe(char *source, uint length, uint android_format_flash_start)
+int unsparse_probe(sparse_stream_t *stream, char *source, uint length, uint android_format_flash_start)
 {
 	sparse_header_t *header = (sparse_header_t*) source;
 
@@ -75,20 +70,68 @@ int unsparse_probe(char *source, uint length, uint android_format_flash_start)
 
 		return ANDROID_FORMAT_BAD;
 	}
-	android_format_checksum  = 0;
-	last_rest_size = 0;
-	chunk_count = 0;
-	chunk_length = 0;
-	sparse_format_type = SPARSE_FORMAT_TYPE_TOTAL_HEAD;
-	flash_start = android_format_flash_start;
-	total_chunks = header->total_chunks;
+	if ((!header->blk_sz) || (header->blk_sz & 511) || (header->blk_sz > SPARSE_CARRY_MAX))
+	{
+		printf("sparse: unsupported block size %d\n", header->blk_sz);
+
+		return ANDROID_FORMAT_BAD;
+	}
+	//上一次的流没有正常结束时，先释放它的fill buffer
+	__sparse_release(stream);
+	memset(stream, 0, sizeof(sparse_stream_t));
+	stream->state = SPARSE_FORMAT_TYPE_TOTAL_HEAD;
+	stream->flash_start = android_format_flash_start;
+	stream->write = sunxi_sprite_write;
+	stream->discard = sunxi_sprite_discard;
 
 	return ANDROID_FORMAT_DETECT;
 }
 /*
 ************************************************************************************************************
 *
-*                                             DRAM_Write
+*                                             __sparse_gather
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：完整的头部数据，数据不够时返回NULL
+*
+*    说明    ：文件头，chunk头和fill值可能被buffer边界截断，截断时先收集到stream中
+*
+*
+************************************************************************************************************
+*/
+static void *__sparse_gather(sparse_stream_t *stream, char **pbuf, uint *length, uint need)
+{
+	void *head;
+	uint  size;
+
+	if((!stream->hold_size) && (*length >= need))
+	{
+		head     = *pbuf;
+		*pbuf   += need;
+		*length -= need;
+
+		return head;
+	}
+	size = min(need - stream->hold_size, *length);
+	memcpy(stream->hold + stream->hold_size, *pbuf, size);
+	stream->hold_size += size;
+	*pbuf   += size;
+	*length -= size;
+	if(stream->hold_size < need)
+	{
+		return NULL;
+	}
+	stream->hold_size = 0;
+
+	return stream->hold;
+}
+/*
+************************************************************************************************************
+*
+*                                             __sparse_flash_write
 *
 *    函数名称：
 *
@@ -101,191 +144,335 @@ int unsparse_probe(char *source, uint length, uint android_format_flash_start)
 *
 ************************************************************************************************************
 */
-int  unsparse_direct_write(void *pbuf, uint length)
+static int __sparse_flash_write(sparse_stream_t *stream, void *buffer, uint bytes)
 {
-	int   unenough_length;
-	int   this_rest_size;
-	int   tmp_down_size;
-	char *tmp_buf, *tmp_dest_buf;
-	chunk_header_t   *chunk;
-    //首先计算传进的数据的校验和
-	android_format_checksum += add_sum(pbuf, length);
+	uint nblock = bytes>>9;
 
-    this_rest_size = last_rest_size + length;
-    tmp_buf = (char *)pbuf - last_rest_size;
-	last_rest_size = 0;
+	if(!stream->write(stream->flash_start, nblock, buffer))
+	{
+		printf("sparse: flash write failed\n");
 
-    while(this_rest_size > 0)
-    {
-		switch(sparse_format_type)
+		return -1;
+	}
+	stream->flash_start += nblock;
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             __sparse_fill_write
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：用图案buffer分批写入，图案不变时buffer不用重新填充
+*
+*
+************************************************************************************************************
+*/
+static int __sparse_fill_write(sparse_stream_t *stream, uint start, uint nblock, u32 value)
+{
+	uint  once_sectors = SPARSE_FILL_BUFF_SIZE>>9;
+	uint  this_sectors;
+	u32  *pattern;
+	int   i;
+
+	if((!stream->fill_buf) || (stream->fill_value != value))
+	{
+		if(!stream->fill_buf)
 		{
-			case SPARSE_FORMAT_TYPE_TOTAL_HEAD:
+			stream->fill_buf = (u8 *)memalign(ARCH_DMA_MINALIGN, SPARSE_FILL_BUFF_SIZE);
+			if(!stream->fill_buf)
 			{
-				memcpy(&globl_header, tmp_buf, sizeof(sparse_header_t));
-            	this_rest_size -= sizeof(sparse_header_t);
-            	tmp_buf += sizeof(sparse_header_t);
+				printf("sparse: unable to malloc memory for fill chunk\n");
+
+				return -1;
+			}
+		}
+		pattern = (u32 *)stream->fill_buf;
+		for(i=0;i<SPARSE_FILL_BUFF_SIZE/sizeof(u32);i++)
+		{
+			pattern[i] = value;
+		}
+		stream->fill_value = value;
+	}
+	while(nblock)
+	{
+		this_sectors = min(nblock, once_sectors);
+		if(!stream->write(start, this_sectors, stream->fill_buf))
+		{
+			printf("sparse: flash write failed\n");
 
-                sparse_format_type = SPARSE_FORMAT_TYPE_CHUNK_HEAD;
+			return -1;
+		}
+		start  += this_sectors;
+		nblock -= this_sectors;
+	}
 
-				break;
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             __sparse_fill_data
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：0值的大块区域先尝试擦除(emmc)或跳过(已擦除的nand)，
+*              不支持时和非0值一样写入图案
+*
+*
+************************************************************************************************************
+*/
+static int __sparse_fill_data(sparse_stream_t *stream, u32 value)
+{
+	uint sectors = stream->chunk.chunk_sz * (stream->header.blk_sz>>9);
+	uint skip_space[1+2*2] = {0};
+	int  k, ret = -1;
+
+	if((!value) && (sectors >= SPARSE_DISCARD_MIN))
+	{
+		ret = stream->discard(stream->flash_start, sectors, skip_space);
+	}
+	if(ret == 1)
+	{
+		//擦除组没有对齐的头尾部分，还需要写0
+		for(k=0;k<2;k++)
+		{
+			if((skip_space[0] & (1<<k)) &&
+			   __sparse_fill_write(stream, skip_space[2*k+1], skip_space[2*k+2], 0))
+			{
+				return -1;
 			}
-			case SPARSE_FORMAT_TYPE_CHUNK_HEAD:
+		}
+	}
+	else if(ret)
+	{
+		if(__sparse_fill_write(stream, stream->flash_start, sectors, value))
+		{
+			return -1;
+		}
+	}
+	stream->flash_start += sectors;
+	stream->state = SPARSE_FORMAT_TYPE_CHUNK_HEAD;
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             __sparse_chunk_start
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：根据chunk头决定下一个状态
+*
+*
+************************************************************************************************************
+*/
+static int __sparse_chunk_start(sparse_stream_t *stream)
+{
+	chunk_header_t *chunk = &stream->chunk;
+	uint blk_sz = stream->header.blk_sz;
+
+	printf("chunk %d(%d)\n", stream->chunk_count ++, stream->header.total_chunks);
+	switch (chunk->chunk_type)
+	{
+		case CHUNK_TYPE_RAW:
+			if (chunk->total_sz != (chunk->chunk_sz * blk_sz + sizeof(chunk_header_t)))
 			{
-				if(this_rest_size < sizeof(chunk_header_t))
-				{
-					printf("sparse: chunk head data is not enough\n");
-					last_rest_size = this_rest_size;
-					tmp_dest_buf = (char *)pbuf - this_rest_size;
-		    		memcpy(tmp_dest_buf, tmp_buf, this_rest_size);
-					this_rest_size = 0;
+				printf("sparse: bad chunk size for chunk %d, type Raw\n", stream->chunk_count);
 
-		    		break;
-				}
-				chunk = (chunk_header_t *)tmp_buf;
-				/* move to next chunk */
-				tmp_buf += sizeof(chunk_header_t);        //此时tmp_buf已经指向下一个chunk或者data起始地址
-				this_rest_size -= sizeof(chunk_header_t); //剩余的数据长度
-				chunk_length = chunk->chunk_sz * globl_header.blk_sz;   //当前数据块需要写入的数据长度
-				printf("chunk %d(%d)\n", chunk_count ++, total_chunks);
-
-				switch (chunk->chunk_type)
-				{
-					case CHUNK_TYPE_RAW:
-
-						if (chunk->total_sz != (chunk_length + sizeof(chunk_header_t)))
-						{
-							printf("sparse: bad chunk size for chunk %d, type Raw\n", chunk_count);
-
-							return -1;
-						}
-						//这里不处理数据部分，转到下一个状态
-						sparse_format_type = SPARSE_FORMAT_TYPE_CHUNK_DATA;
-
-		                            break;
-
-                                        case CHUNK_TYPE_FILL:
-                                            if(chunk->total_sz != sizeof(chunk_header_t) + sizeof(u32))
-                                            {
-                                                printf("spase : bad chunk size for chunk ,type FILL \n");
-                                                return -1;
-                                            }
-                                           sparse_format_type = SPARSE_FORMAT_TYPE_CHUNK_FILL_DATA;
-                                                                                  
-                                                break;
-					case CHUNK_TYPE_DONT_CARE:
-						if (chunk->total_sz != sizeof(chunk_header_t))
-						{
-							printf("sparse: bogus DONT CARE chunk\n");
-
-							return -1;
-						}
-						flash_start += (chunk_length>>9);
-						sparse_format_type = SPARSE_FORMAT_TYPE_CHUNK_HEAD;
-
-						break;
-
-					default:
-						printf("sparse: unknown chunk ID %x\n", chunk->chunk_type);
+				return -1;
+			}
+			stream->chunk_rest = chunk->chunk_sz * blk_sz;
+			stream->state = stream->chunk_rest ? SPARSE_FORMAT_TYPE_CHUNK_DATA : SPARSE_FORMAT_TYPE_CHUNK_HEAD;
 
-						return -1;
+			break;
+
+		case CHUNK_TYPE_FILL:
+			if (chunk->total_sz != (sizeof(chunk_header_t) + sizeof(u32)))
+			{
+				printf("sparse: bad chunk size for chunk %d, type FILL\n", stream->chunk_count);
+
+				return -1;
+			}
+			stream->state = SPARSE_FORMAT_TYPE_CHUNK_FILL_DATA;
+
+			break;
+
+		case CHUNK_TYPE_DONT_CARE:
+			if (chunk->total_sz != sizeof(chunk_header_t))
+			{
+				printf("sparse: bogus DONT CARE chunk\n");
+
+				return -1;
+			}
+			stream->flash_start += chunk->chunk_sz * (blk_sz>>9);
+			stream->state = SPARSE_FORMAT_TYPE_CHUNK_HEAD;
+
+			break;
+
+		default:
+			printf("sparse: unknown chunk ID %x\n", chunk->chunk_type);
+
+			return -1;
+	}
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             __sparse_raw_data
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：RAW数据直接从调用者的buffer写入flash，一个chunk在一个buffer内只写一次;
+*              buffer结尾不足一个block的数据放到carry，和下一个buffer开头的数据拼成一个block写入
+*
+*
+************************************************************************************************************
+*/
+static int __sparse_raw_data(sparse_stream_t *stream, char **pbuf, uint *length)
+{
+	uint blk_sz = stream->header.blk_sz;
+	uint size;
+
+	if(stream->carry_size)
+	{
+		size = min(blk_sz - stream->carry_size, *length);
+		memcpy(stream->carry + stream->carry_size, *pbuf, size);
+		stream->carry_size += size;
+		*pbuf   += size;
+		*length -= size;
+		if(stream->carry_size < blk_sz)
+		{
+			return 0;
+		}
+		if(__sparse_flash_write(stream, stream->carry, blk_sz))
+		{
+			return -1;
+		}
+		stream->carry_size  = 0;
+		stream->chunk_rest -= blk_sz;
+	}
+	size  = min(stream->chunk_rest, *length);
+	size -= size % blk_sz;
+	if(size)
+	{
+		if(__sparse_flash_write(stream, *pbuf, size))
+		{
+			return -1;
+		}
+		*pbuf   += size;
+		*length -= size;
+		stream->chunk_rest -= size;
+	}
+	if(stream->chunk_rest && *length)
+	{
+		//这里剩余的数据一定不足一个block
+		memcpy(stream->carry, *pbuf, *length);
+		stream->carry_size = *length;
+		*pbuf   += *length;
+		*length  = 0;
+	}
+	if(!stream->chunk_rest)
+	{
+		stream->state = SPARSE_FORMAT_TYPE_CHUNK_HEAD;
+	}
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             __sparse_write
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：
+*
+*
+************************************************************************************************************
+*/
+static int __sparse_write(sparse_stream_t *stream, char *tmp_buf, uint length)
+{
+	void *head;
+	u32   value;
+
+    while(length > 0)
+    {
+		switch(stream->state)
+		{
+			case SPARSE_FORMAT_TYPE_TOTAL_HEAD:
+			{
+				head = __sparse_gather(stream, &tmp_buf, &length, sizeof(sparse_header_t));
+				if(head)
+				{
+					memcpy(&stream->header, head, sizeof(sparse_header_t));
+					stream->state = SPARSE_FORMAT_TYPE_CHUNK_HEAD;
 				}
+
 				break;
 			}
-			case SPARSE_FORMAT_TYPE_CHUNK_DATA:
+			case SPARSE_FORMAT_TYPE_CHUNK_HEAD:
 			{
-				//首先判断数据是否足够当前chunk所需,如果不足，则计算出还需要的数据长度
-				unenough_length = (chunk_length >= this_rest_size)? (chunk_length - this_rest_size):0;
-				if(!unenough_length)
+				head = __sparse_gather(stream, &tmp_buf, &length, sizeof(chunk_header_t));
+				if(head)
 				{
-					//数据足够，直接写入
-					if(!sunxi_sprite_write(flash_start, chunk_length>>9, tmp_buf))
+					memcpy(&stream->chunk, head, sizeof(chunk_header_t));
+					if(__sparse_chunk_start(stream))
 					{
-						printf("sparse: flash write failed\n");
-
 						return -1;
 					}
-					if(chunk_length & 511)
-					{
-						printf("data is not sector align 0\n");
-
-						return -1;
-					}
-					flash_start += (chunk_length>>9);
-					tmp_buf += chunk_length;
-					this_rest_size -= chunk_length;
-					chunk_length = 0;
-
-					sparse_format_type = SPARSE_FORMAT_TYPE_CHUNK_HEAD;
 				}
-				else  //存在缺失数据的情况
-				{
-					if(this_rest_size < 8 * 1024) //先看已有数据是否不足8k
-					{
-						//当不足时，把这笔数据放到下一笔数据的前部，等待下一次处理
-						tmp_dest_buf = (char *)pbuf - this_rest_size;
-						memcpy(tmp_dest_buf, tmp_buf, this_rest_size);
-                        last_rest_size = this_rest_size;
-						this_rest_size = 0;
 
-						break;
-					}
-					//当已有数据超过16k时
-					//当缺失数据长度不足4k时,可能只缺几十个字节
-					if(unenough_length < 4 * 1024)
-					{
-						//采用拼接方法，先烧写部分已有数据，然后在下一次把未烧写的已有数据和缺失数据一起烧录
-						tmp_down_size = this_rest_size + unenough_length - 4 * 1024;
-					}
-					else //这里处理缺失数据超过8k(包含)的情况,同时已有数据也超过16k
-					{
-						//直接烧录当前全部数据;
-						tmp_down_size = this_rest_size & (~(512 -1));  //扇区对齐
-					}
-					if(!sunxi_sprite_write(flash_start, tmp_down_size>>9, tmp_buf))
-					{
-						printf("sparse: flash write failed\n");
+				break;
+			}
+			case SPARSE_FORMAT_TYPE_CHUNK_DATA:
+			{
+				if(__sparse_raw_data(stream, &tmp_buf, &length))
+				{
+					return -1;
+				}
 
-						return -1;
-					}
-					if(tmp_down_size & 511)
+				break;
+			}
+			case SPARSE_FORMAT_TYPE_CHUNK_FILL_DATA:
+			{
+				head = __sparse_gather(stream, &tmp_buf, &length, sizeof(u32));
+				if(head)
+				{
+					memcpy(&value, head, sizeof(u32));
+					if(__sparse_fill_data(stream, value))
 					{
-						printf("data is not sector align 1\n");
-
 						return -1;
 					}
-					tmp_buf += tmp_down_size;
-					flash_start += (tmp_down_size>>9);
-					chunk_length -= tmp_down_size;
-					this_rest_size -= tmp_down_size;
-					tmp_dest_buf = (char *)pbuf - this_rest_size;
-					memcpy(tmp_dest_buf, tmp_buf, this_rest_size);
-					last_rest_size = this_rest_size;
-					this_rest_size = 0;
-
-					sparse_format_type = SPARSE_FORMAT_TYPE_CHUNK_DATA;
 				}
 
 				break;
 			}
-                        case SPARSE_FORMAT_TYPE_CHUNK_FILL_DATA:
-                        {
-                                if(this_rest_size >= 4)
-                                {
-                                        this_rest_size -= sizeof(u32);
-                                        tmp_buf += sizeof(u32);
-                                        flash_start += (chunk_length>>9);
-                                        sparse_format_type = SPARSE_FORMAT_TYPE_CHUNK_HEAD;
-                                }
-                                else
-                                {
-                                       tmp_dest_buf = (char *)pbuf - this_rest_size;
-                                        memcpy(tmp_dest_buf,tmp_buf,this_rest_size);
-                                       last_rest_size = this_rest_size;
-                                       this_rest_size = 0;
-                                       sparse_format_type = SPARSE_FORMAT_TYPE_CHUNK_FILL_DATA;
-                                }
-                                break;
-                        }
 			default:
 			{
 				printf("sparse: unknown status\n");
@@ -300,6 +487,113 @@ int  unsparse_direct_write(void *pbuf, uint length)
 /*
 ************************************************************************************************************
 *
+*                                             __sparse_release
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：
+*
+*
+************************************************************************************************************
+*/
+static void __sparse_release(sparse_stream_t *stream)
+{
+	if(stream->fill_buf)
+	{
+		free(stream->fill_buf);
+		stream->fill_buf = NULL;
+	}
+}
+/*
+************************************************************************************************************
+*
+*                                             unsparse_direct_write
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：可以用任意大小的buffer分多次调用，buffer用完后调用者即可复用
+*
+*
+************************************************************************************************************
+*/
+int  unsparse_direct_write(sparse_stream_t *stream, void *pbuf, uint length)
+{
+    //首先计算传进的数据的校验和
+	stream->checksum += add_sum(pbuf, length);
+	if(__sparse_write(stream, (char *)pbuf, length))
+	{
+		__sparse_release(stream);
+
+		return -1;
+	}
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             unsparse_finish
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：所有数据写完后调用，检查镜像是否完整
+*
+*
+************************************************************************************************************
+*/
+int unsparse_finish(sparse_stream_t *stream)
+{
+	__sparse_release(stream);
+	if((stream->state != SPARSE_FORMAT_TYPE_CHUNK_HEAD) || stream->hold_size || stream->carry_size)
+	{
+		printf("sparse: image is truncated in chunk %d(%d)\n", stream->chunk_count, stream->header.total_chunks);
+
+		return -1;
+	}
+	if(stream->chunk_count != stream->header.total_chunks)
+	{
+		printf("sparse: only %d of %d chunks found\n", stream->chunk_count, stream->header.total_chunks);
+
+		return -1;
+	}
+
+	return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             unsparse_abort
+*
+*    函数名称：
+*
+*    参数列表：
+*
+*    返回值  ：
+*
+*    说明    ：下载中途出错退出时调用，只释放stream占用的资源，不检查镜像
+*
+*
+************************************************************************************************************
+*/
+void unsparse_abort(sparse_stream_t *stream)
+{
+	__sparse_release(stream);
+}
+/*
+************************************************************************************************************
+*
 *                                             unsparse_checksum
 *
 *    函数名称：
@@ -313,9 +607,9 @@ int  unsparse_direct_write(void *pbuf, uint length)
 *
 ************************************************************************************************************
 */
-uint unsparse_checksum(void)
+uint unsparse_checksum(sparse_stream_t *stream)
 {
-	return android_format_checksum;
+	return stream->checksum;
 }
 
 
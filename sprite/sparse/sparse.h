@@ -24,15 +24,52 @@
 #ifndef __SUNXI_SPRITE_SPARSE_H__
 #define __SUNXI_SPRITE_SPARSE_H__
 
+#include <sparse_format.h>
 
 #define   ANDROID_FORMAT_UNKNOW    (0)
 #define   ANDROID_FORMAT_BAD       (-1)
 #define   ANDROID_FORMAT_DETECT    (1)
 
+//RAW数据跨buffer时最多暂存一个block，blk_sz不能超过这个值
+#define   SPARSE_CARRY_MAX         (4096)
+//非0的FILL chunk用这个大小的图案buffer分批写入
+#define   SPARSE_FILL_BUFF_SIZE    (1024 * 1024)
+//0值FILL chunk达到这个扇区数才用擦除代替写入
+#define   SPARSE_DISCARD_MIN       (2048)
 
-extern int  unsparse_probe(char *source, unsigned int length, unsigned int flash_start);
-extern int  unsparse_direct_write(void *pbuf, unsigned int length);
-extern unsigned int unsparse_checksum(void);
+/*
+ * one sparse image being written. all the decoder state lives here so the
+ * card and fastboot download paths can each keep their own stream. data is
+ * written straight from the caller's buffers, only the block split by a
+ * buffer boundary is gathered in @carry.
+ * efex does not use it: every efex packet carries its own flash address,
+ * the PC tool sends the partitions already expanded.
+ */
+typedef struct sparse_stream
+{
+	u8     carry[SPARSE_CARRY_MAX] __aligned(ARCH_DMA_MINALIGN);
+	uint   carry_size;
+	uint   state;
+	sparse_header_t  header;
+	chunk_header_t   chunk;
+	u8     hold[sizeof(sparse_header_t)];	//跨buffer的文件头/chunk头/fill值
+	uint   hold_size;
+	uint   chunk_rest;						//当前RAW chunk剩余的字节数
+	uint   chunk_count;
+	uint   flash_start;
+	uint   checksum;
+	u8    *fill_buf;						//按需分配，unsparse_finish/unsparse_abort或出错时释放
+	u32    fill_value;						//fill_buf中当前的图案
+	int  (*write)(uint start_block, uint nblock, void *buffer);
+	int  (*discard)(uint start_block, uint nblock, uint *skip_space);
+}
+sparse_stream_t;
+
+extern int  unsparse_probe(sparse_stream_t *stream, char *source, unsigned int length, unsigned int flash_start);
+extern int  unsparse_direct_write(sparse_stream_t *stream, void *pbuf, unsigned int length);
+extern int  unsparse_finish(sparse_stream_t *stream);
+extern void unsparse_abort(sparse_stream_t *stream);
+extern unsigned int unsparse_checksum(sparse_stream_t *stream);
 
 
 #endif /* __SUNXI_SPRITE_SPARSE_H__ */
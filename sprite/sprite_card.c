@@ -24,6 +24,7 @@
 #include <config.h>
 #include <common.h>
 #include <malloc.h>
+#include <div64.h>
 #include "sparse/sparse.h"
 #include <asm/arch/queue.h>
 #include <sunxi_mbr.h>
@@ -40,21 +41,259 @@
 #include <mmc.h>
 #include <sys_config.h>
 #include <private_boot0.h>
-#define  SPRITE_CARD_HEAD_BUFF		   (32 * 1024)
 #if defined (CONFIG_SUNXI_SPINOR)
 #define  SPRITE_CARD_ONCE_DATA_DEAL    (2 * 1024 * 1024)
 #else
 #define  SPRITE_CARD_ONCE_DATA_DEAL    (16 * 1024 * 1024)
 #endif
 #define  SPRITE_CARD_ONCE_SECTOR_DEAL  (SPRITE_CARD_ONCE_DATA_DEAL/512)
+//读卡和写flash流水线的buffer个数，卡读取下一笔数据时flash写入上一笔
+#ifdef CONFIG_SPRITE_CARD_PIPE_DEPTH
+#define  SPRITE_CARD_PIPE_DEPTH        CONFIG_SPRITE_CARD_PIPE_DEPTH
+#else
+#define  SPRITE_CARD_PIPE_DEPTH        (2)
+#endif
+
+typedef struct
+{
+	s64    bytes;						//已写入的字节数
+	ulong  start;						//开始时间(ms)
+	ulong  read_wait;					//等待卡数据的时间(ms)
+	ulong  write;						//写flash的时间(ms)
+}
+sprite_card_stat_t;
 
 static void *imghd = NULL;
 static void *imgitemhd = NULL;
+static uchar *card_pipe_buff[SPRITE_CARD_PIPE_DEPTH];
+static sparse_stream_t card_sparse;
+#ifdef CONFIG_SPRITE_VERIFY_SAMPLED
+//写入时计算校验和，校验时只抽样回读
+static sprite_verify_stream_t card_verify;
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
 //extern int sunxi_flash_mmc_phywipe(unsigned long start_block, unsigned long nblock, unsigned long *skip);
-static int __download_normal_part(dl_one_part_info *part_info,  uchar *source_buff);
+static int __download_normal_part(dl_one_part_info *part_info);
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  __card_pipe_alloc
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  申请流水线buffer，按cache line对齐，避免卡dma和cpu访问相邻数据冲突
+*
+*
+************************************************************************************************************
+*/
+static int __card_pipe_alloc(void)
+{
+	int i;
+
+	for(i=0;i<SPRITE_CARD_PIPE_DEPTH;i++)
+	{
+		card_pipe_buff[i] = (uchar *)malloc_pool(SPRITE_CARD_ONCE_DATA_DEAL);
+		if(!card_pipe_buff[i])
+		{
+			printf("sunxi sprite err: unable to malloc memory for card pipe buffer %d\n", i);
+
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void __card_pipe_free(void)
+{
+	int i;
+
+	for(i=0;i<SPRITE_CARD_PIPE_DEPTH;i++)
+	{
+		if(card_pipe_buff[i])
+		{
+			free_pool(card_pipe_buff[i]);
+			card_pipe_buff[i] = NULL;
+		}
+	}
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  __card_pipe_stat_show
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  打印一个分区的烧写速度
+*
+*
+************************************************************************************************************
+*/
+static void __card_pipe_stat_show(char *name, sprite_card_stat_t *stat)
+{
+	ulong total = get_timer(stat->start);
+	uint  kbytes = (uint)(stat->bytes >> 10);
+	uint  speed = 0;
+
+	if(total)
+	{
+		speed = (uint)lldiv((u64)kbytes * 1000, total);
+	}
+	printf("part %s: %d KB in %ld ms (%d KB/s), card read stall %ld ms, flash write %ld ms\n",
+		name, kbytes, total, speed, stat->read_wait, stat->write);
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  __download_pipe
+*
+*    parmeters     :  imgfile_start       : 分区数据在卡上的起始扇区
+*                     partstart_by_sector : 分区在flash上的起始扇区
+*                     partdata_by_byte    : 分区数据字节数
+*                     partdata_format     : 不为空时，用第一笔数据判断是否sparse格式并返回
+*                     verify              : 不为空时，非sparse数据写入后计算校验和并抽样
+*
+*    return        :
+*
+*    note          :  流水线方式烧写分区数据，第n笔数据写入flash时，第n+1笔数据
+*                     已经通过卡的dma读入另一个buffer
+*
+*
+************************************************************************************************************
+*/
+static int __download_pipe(char *name, uint imgfile_start, uint partstart_by_sector, s64 partdata_by_byte, int *partdata_format, sprite_verify_stream_t *verify)
+{
+	sprite_card_stat_t stat;
+	s64  rest_bytes = partdata_by_byte;
+	uint this_bytes, this_sectors;
+	uint next_bytes, next_sectors = 0;
+	int  format = ANDROID_FORMAT_UNKNOW;
+	int  index = 0;
+	u8  *down_buffer;
+	ulong time;
+	int  ret;
+
+	memset(&stat, 0, sizeof(sprite_card_stat_t));
+	stat.start = get_timer(0);
+	//读出第一笔数据
+	this_bytes   = (rest_bytes > SPRITE_CARD_ONCE_DATA_DEAL) ? SPRITE_CARD_ONCE_DATA_DEAL : (uint)rest_bytes;
+	this_sectors = (this_bytes + 511)>>9;
+	down_buffer  = card_pipe_buff[0];
+	if(sunxi_flash_read(imgfile_start, this_sectors, down_buffer) != this_sectors)
+	{
+		printf("sunxi sprite error : read sdcard block %d, total %d failed\n", imgfile_start, this_sectors);
+
+		return -1;
+	}
+	imgfile_start += this_sectors;
+	stat.read_wait = get_timer(stat.start);
+	//尝试查看是否sparse格式
+	if(partdata_format)
+	{
+		format = unsparse_probe(&card_sparse, (char *)down_buffer, this_bytes, partstart_by_sector);
+		*partdata_format = format;
+	}
+
+	while(1)
+	{
+		rest_bytes -= this_bytes;
+		//启动下一笔数据的读取，放到下一个buffer
+		next_bytes = (rest_bytes > SPRITE_CARD_ONCE_DATA_DEAL) ? SPRITE_CARD_ONCE_DATA_DEAL : (uint)rest_bytes;
+		if(next_bytes)
+		{
+			next_sectors = (next_bytes + 511)>>9;
+			index = (index + 1) % SPRITE_CARD_PIPE_DEPTH;
+			if(sunxi_flash_submit_read(imgfile_start, next_sectors, card_pipe_buff[index]))
+			{
+				printf("sunxi sprite error : read sdcard block %d, total %d failed\n", imgfile_start, next_sectors);
+
+				goto __download_pipe_err;
+			}
+		}
+		//写入当前这笔数据
+		time = get_timer(0);
+		if(format == ANDROID_FORMAT_DETECT)
+		{
+			ret = unsparse_direct_write(&card_sparse, down_buffer, this_bytes);
+		}
+		else
+		{
+			ret = (sunxi_sprite_write(partstart_by_sector, this_sectors, down_buffer) == this_sectors) ? 0 : -1;
+			if((!ret) && verify)
+			{
+				sunxi_sprite_verify_stream_add(verify, partstart_by_sector, down_buffer, this_bytes);
+			}
+			partstart_by_sector += this_sectors;
+		}
+		stat.write += get_timer(time);
+		if(ret)
+		{
+			printf("sunxi sprite error: download %s data error %s, sectors 0x%x\n",
+				(format == ANDROID_FORMAT_DETECT) ? "sparse" : "raw", name, this_sectors);
+			if(next_bytes)
+			{
+				sunxi_flash_complete();
+			}
+
+			goto __download_pipe_err;
+		}
+		stat.bytes += this_bytes;
+		if(!next_bytes)
+		{
+			break;
+		}
+		//等待下一笔数据读完
+		time = get_timer(0);
+		if(sunxi_flash_complete() != next_sectors)
+		{
+			printf("sunxi sprite error : read sdcard block %d, total %d failed\n", imgfile_start, next_sectors);
+
+			goto __download_pipe_err;
+		}
+		stat.read_wait += get_timer(time);
+		imgfile_start += next_sectors;
+		down_buffer    = card_pipe_buff[index];
+		this_bytes     = next_bytes;
+		this_sectors   = next_sectors;
+	}
+	if((format == ANDROID_FORMAT_DETECT) && unsparse_finish(&card_sparse))
+	{
+		printf("sunxi sprite error: download sparse data error %s\n", name);
+
+		return -1;
+	}
+	//合并写缓存里的数据写下去之后才算下载成功
+	if(sunxi_sprite_sync())
+	{
+		printf("sunxi sprite error: flush %s data failed\n", name);
+
+		return -1;
+	}
+	__card_pipe_stat_show(name, &stat);
+
+	return 0;
+
+__download_pipe_err:
+	//出错退出时同样要释放sparse流，否则fill buffer会泄漏
+	if(format == ANDROID_FORMAT_DETECT)
+	{
+		unsparse_abort(&card_sparse);
+	}
+
+	return -1;
+}
 /*
 ************************************************************************************************************
 *
@@ -188,7 +427,7 @@ int sprite_card_fetch_mbr(void  *img_mbr)
 *
 ************************************************************************************************************
 */
-static int __download_udisk(dl_one_part_info *part_info,  uchar *source_buff)
+static int __download_udisk(dl_one_part_info *part_info)
 {
     HIMAGEITEM imgitemhd = NULL;
 	u32  flash_sector;
@@ -232,7 +471,7 @@ static int __download_udisk(dl_one_part_info *part_info,  uchar *source_buff)
 	printf("UDISK low is 0x%x Sectors\n", part_info->lenlo);
 	printf("UDISK high is 0x%x Sectors\n", part_info->lenhi);
 
-	ret = __download_normal_part(part_info, source_buff);
+	ret = __download_normal_part(part_info);
 __download_udisk_err1:
 	ret1 = Img_CloseItem(imghd, imgitemhd);
 	if(ret1 != 0 )
@@ -260,30 +499,24 @@ __download_udisk_err1:
 *
 ************************************************************************************************************
 */
-static int __download_normal_part(dl_one_part_info *part_info,  uchar *source_buff)
+static int __download_normal_part(dl_one_part_info *part_info)
 {
 	uint partstart_by_sector;		//分区起始扇区
-	uint tmp_partstart_by_sector;
 
 	s64  partsize_by_byte;			//分区大小(字节单位)
 
 	s64  partdata_by_byte;			//需要下载的分区数据(字节单位)
-	s64  tmp_partdata_by_bytes;
-
-	uint onetime_read_sectors;		//一次读写的扇区数
-	uint first_write_bytes;
 
 	uint imgfile_start;				//分区数据所在的扇区
-	uint tmp_imgfile_start;
 
-	u8 *down_buffer       = source_buff + SPRITE_CARD_HEAD_BUFF;
+	int  partdata_format = ANDROID_FORMAT_UNKNOW;
 
-	int  partdata_format;
+	sprite_verify_stream_t *verify = NULL;
 
 	int  ret = -1;
 	//*******************************************************************
 	//获取分区起始扇区
-	tmp_partstart_by_sector = partstart_by_sector = part_info->addrlo;
+	partstart_by_sector = part_info->addrlo;
 	//获取分区大小，字节数
 	partsize_by_byte     = part_info->lenlo;
 	partsize_by_byte   <<= 9;
@@ -312,18 +545,6 @@ static int __download_normal_part(dl_one_part_info *part_info,  uchar *source_bu
 
 		goto __download_normal_part_err1;
 	}
-	//准备读取分区镜像数据
-	tmp_partdata_by_bytes = partdata_by_byte;
-	if(tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL)
-	{
-		onetime_read_sectors = SPRITE_CARD_ONCE_SECTOR_DEAL;
-		first_write_bytes    = SPRITE_CARD_ONCE_DATA_DEAL;
-	}
-	else
-	{
-		onetime_read_sectors = (tmp_partdata_by_bytes + 511)>>9;
-		first_write_bytes    = (uint)tmp_partdata_by_bytes;
-	}
 	//开始获取分区数据
 	imgfile_start = Img_GetItemStart(imghd, imgitemhd);
 	if(!imgfile_start)
@@ -332,117 +553,18 @@ static int __download_normal_part(dl_one_part_info *part_info,  uchar *source_bu
 
 		goto __download_normal_part_err1;
 	}
-	tmp_imgfile_start = imgfile_start;
-	//读出第一笔固件中的分区数据，大小为buffer字节数
-	if(sunxi_flash_read(tmp_imgfile_start, onetime_read_sectors, down_buffer) != onetime_read_sectors)
+#ifdef CONFIG_SPRITE_VERIFY_SAMPLED
+	if(part_info->verify)
+	{
+		verify = &card_verify;
+		sunxi_sprite_verify_stream_init(verify);
+	}
+#endif
+	//读卡和写flash流水线方式烧写，第一笔数据用于判断是否sparse格式
+	if(__download_pipe((char *)part_info->dl_filename, imgfile_start, partstart_by_sector, partdata_by_byte, &partdata_format, verify))
 	{
-		printf("sunxi sprite error : read sdcard block %d, total %d failed\n", tmp_imgfile_start, onetime_read_sectors);
-
 		goto __download_normal_part_err1;
 	}
-	//下一个要读出的数据
-	tmp_imgfile_start += onetime_read_sectors;
-	//尝试查看是否sparse格式
-    partdata_format = unsparse_probe((char *)down_buffer, first_write_bytes, partstart_by_sector);		//判断数据格式
-    if(partdata_format != ANDROID_FORMAT_DETECT)
-    {
-    	//写入第一笔数据
-    	if(sunxi_sprite_write(tmp_partstart_by_sector, onetime_read_sectors, down_buffer) != onetime_read_sectors)
-		{
-			printf("sunxi sprite error: download rawdata error %s\n", part_info->dl_filename);
-
-			goto __download_normal_part_err1;
-		}
-    	tmp_partdata_by_bytes   -= first_write_bytes;
-		tmp_partstart_by_sector += onetime_read_sectors;
-
-		while(tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL)
-		{
-			//继续读出固件中的分区数据，大小为buffer字节数
-			if(sunxi_flash_read(tmp_imgfile_start, SPRITE_CARD_ONCE_SECTOR_DEAL, down_buffer) != SPRITE_CARD_ONCE_SECTOR_DEAL)
-			{
-				printf("sunxi sprite error : read sdcard block %d, total %d failed\n", tmp_imgfile_start, SPRITE_CARD_ONCE_SECTOR_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			//写入flash
-			if(sunxi_sprite_write(tmp_partstart_by_sector, SPRITE_CARD_ONCE_SECTOR_DEAL, down_buffer) != SPRITE_CARD_ONCE_SECTOR_DEAL)
-			{
-				printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n", part_info->dl_filename, tmp_partstart_by_sector, SPRITE_CARD_ONCE_SECTOR_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			tmp_imgfile_start       += SPRITE_CARD_ONCE_SECTOR_DEAL;
-			tmp_partdata_by_bytes   -= SPRITE_CARD_ONCE_DATA_DEAL;
-			tmp_partstart_by_sector += SPRITE_CARD_ONCE_SECTOR_DEAL;
-		}
-		if(tmp_partdata_by_bytes > 0)
-		{
-			uint rest_sectors = (tmp_partdata_by_bytes + 511)>>9;
-			//继续读出固件中的分区数据，大小为buffer字节数
-			if(sunxi_flash_read(tmp_imgfile_start, rest_sectors, down_buffer) != rest_sectors)
-			{
-				printf("sunxi sprite error : read sdcard block %d, total %d failed\n", tmp_imgfile_start, rest_sectors);
-
-				goto __download_normal_part_err1;
-			}
-			//写入flash
-			if(sunxi_sprite_write(tmp_partstart_by_sector, rest_sectors, down_buffer) != rest_sectors)
-			{
-				printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n", part_info->dl_filename, tmp_partstart_by_sector, rest_sectors);
-
-				goto __download_normal_part_err1;
-			}
-		}
-    }
-    else
-    {
-    	if(unsparse_direct_write(down_buffer, first_write_bytes))
-    	{
-    		printf("sunxi sprite error: download sparse error %s\n", part_info->dl_filename);
-
-    		goto __download_normal_part_err1;
-    	}
-    	tmp_partdata_by_bytes   -= first_write_bytes;
-
-		while(tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL)
-		{
-			//继续读出固件中的分区数据，大小为buffer字节数
-			if(sunxi_flash_read(tmp_imgfile_start, SPRITE_CARD_ONCE_SECTOR_DEAL, down_buffer) != SPRITE_CARD_ONCE_SECTOR_DEAL)
-			{
-				printf("sunxi sprite error : read sdcard block 0x%x, total 0x%x failed\n", tmp_imgfile_start, SPRITE_CARD_ONCE_SECTOR_DEAL);
-
-				goto __download_normal_part_err1;
-			}
-			//写入flash
-			if(unsparse_direct_write(down_buffer, SPRITE_CARD_ONCE_DATA_DEAL))
-			{
-				printf("sunxi sprite error: download sparse error %s\n", part_info->dl_filename);
-
-				goto __download_normal_part_err1;
-			}
-			tmp_imgfile_start       += SPRITE_CARD_ONCE_SECTOR_DEAL;
-			tmp_partdata_by_bytes   -= SPRITE_CARD_ONCE_DATA_DEAL;
-		}
-		if(tmp_partdata_by_bytes > 0)
-		{
-			uint rest_sectors = (tmp_partdata_by_bytes + 511)>>9;
-			//继续读出固件中的分区数据，大小为buffer字节数
-			if(sunxi_flash_read(tmp_imgfile_start, rest_sectors, down_buffer) != rest_sectors)
-			{
-				printf("sunxi sprite error : read sdcard block 0x%x, total 0x%x failed\n", tmp_imgfile_start, rest_sectors);
-
-				goto __download_normal_part_err1;
-			}
-			//写入flash
-			if(unsparse_direct_write(down_buffer, tmp_partdata_by_bytes))
-			{
-				printf("sunxi sprite error: download sparse error %s\n", part_info->dl_filename);
-
-				goto __download_normal_part_err1;
-			}
-		}
-    }
 
     tick_printf("successed in writting part %s\n", part_info->name);
     ret = 0;
@@ -476,7 +598,11 @@ static int __download_normal_part(dl_one_part_info *part_info,  uchar *source_bu
 	        }
 	        if(partdata_format == ANDROID_FORMAT_DETECT)
 	        {
-	        	active_verify = sunxi_sprite_part_sparsedata_verify();
+	        	active_verify = sunxi_sprite_part_sparsedata_verify(&card_sparse);
+	        }
+	        else if(verify)
+	        {
+	        	active_verify = sunxi_sprite_verify_stream_check(verify);
 	        }
 	    	else
 	    	{
@@ -533,27 +659,20 @@ __download_normal_part_err1:
 *
 ************************************************************************************************************
 */
-static int __download_sysrecover_part(dl_one_part_info *part_info,  uchar *source_buff)
+static int __download_sysrecover_part(dl_one_part_info *part_info)
 {
 	uint partstart_by_sector;		//分区起始扇区
-	uint tmp_partstart_by_sector;
 
 	s64  partsize_by_byte;			//分区大小(字节单位)
 
 	s64  partdata_by_byte;			//需要下载的分区数据(字节单位)
-	s64  tmp_partdata_by_bytes;
-
-	uint onetime_read_sectors;		//一次读写的扇区数
 
 	uint imgfile_start;				//分区数据所在的扇区
-	uint tmp_imgfile_start;
-
-	u8 *down_buffer       = source_buff + SPRITE_CARD_HEAD_BUFF;
 
 	int  ret = -1;
 	//*******************************************************************
 	//获取分区起始扇区
-	tmp_partstart_by_sector = partstart_by_sector = part_info->addrlo;
+	partstart_by_sector = part_info->addrlo;
 	//获取分区大小，字节数
 	partsize_by_byte     = part_info->lenlo;
 	partsize_by_byte   <<= 9;
@@ -574,16 +693,6 @@ static int __download_sysrecover_part(dl_one_part_info *part_info,  uchar *sourc
 
 		goto __download_sysrecover_part_err1;
 	}
-	//准备读取分区镜像数据
-	tmp_partdata_by_bytes = partdata_by_byte;
-	if(tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL)
-	{
-		onetime_read_sectors = SPRITE_CARD_ONCE_SECTOR_DEAL;
-	}
-	else
-	{
-		onetime_read_sectors = (tmp_partdata_by_bytes + 511)>>9;
-	}
 	//开始获取分区数据
 	imgfile_start = sprite_card_firmware_start();
 	if(!imgfile_start)
@@ -592,45 +701,9 @@ static int __download_sysrecover_part(dl_one_part_info *part_info,  uchar *sourc
 
 		goto __download_sysrecover_part_err1;
 	}
-	tmp_imgfile_start = imgfile_start;
-
-	while(tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL)
+	if(__download_pipe((char *)part_info->dl_filename, imgfile_start, partstart_by_sector, partdata_by_byte, NULL, NULL))
 	{
-		//继续读出固件中的分区数据，大小为buffer字节数
-		if(sunxi_flash_read(tmp_imgfile_start, onetime_read_sectors, down_buffer) != onetime_read_sectors)
-		{
-			printf("sunxi sprite error : read sdcard block %d, total %d failed\n", tmp_imgfile_start, onetime_read_sectors);
-
-			goto __download_sysrecover_part_err1;
-		}
-		//写入flash
-		if(sunxi_sprite_write(tmp_partstart_by_sector, onetime_read_sectors, down_buffer) != onetime_read_sectors)
-		{
-			printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n", part_info->dl_filename, tmp_partstart_by_sector, onetime_read_sectors);
-
-			goto __download_sysrecover_part_err1;
-		}
-		tmp_imgfile_start       += onetime_read_sectors;
-		tmp_partdata_by_bytes   -= onetime_read_sectors*512;
-		tmp_partstart_by_sector += onetime_read_sectors;
-	}
-	if(tmp_partdata_by_bytes > 0)
-	{
-		uint rest_sectors = (tmp_partdata_by_bytes + 511)/512;
-		//继续读出固件中的分区数据，大小为buffer字节数
-		if(sunxi_flash_read(tmp_imgfile_start, rest_sectors, down_buffer) != rest_sectors)
-		{
-			printf("sunxi sprite error : read sdcard block %d, total %d failed\n", tmp_imgfile_start, rest_sectors);
-
-			goto __download_sysrecover_part_err1;
-		}
-		//写入flash
-		if(sunxi_sprite_write(tmp_partstart_by_sector, rest_sectors, down_buffer) != rest_sectors)
-		{
-			printf("sunxi sprite error: download rawdata error %s, start 0x%x, sectors 0x%x\n", part_info->dl_filename, tmp_partstart_by_sector, rest_sectors);
-
-			goto __download_sysrecover_part_err1;
-		}
+		goto __download_sysrecover_part_err1;
 	}
     ret = 0;
 
@@ -665,7 +738,6 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 	int 				ret  = -1;
 	int 				ret1;
 	int 				  i  = 0;
-    uchar *down_buff         = NULL;
     int					rate;
 
 	if(!dl_map->download_count)
@@ -683,8 +755,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 		return -1;
 	}
  	//申请内存
-    down_buff = (uchar *)malloc(SPRITE_CARD_ONCE_DATA_DEAL + SPRITE_CARD_HEAD_BUFF);
-    if(!down_buff)
+    if(__card_pipe_alloc())
     {
     	printf("sunxi sprite err: unable to malloc memory for sunxi_sprite_deal_part\n");
 
@@ -695,7 +766,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
     	tick_printf("begin to download part %s\n", part_info->name);
     	if(!strncmp("UDISK", (char*)part_info->name, strlen("UDISK")))
 		{
-			ret1 = __download_udisk(part_info, down_buff);
+			ret1 = __download_udisk(part_info);
 			if(ret1 < 0)
 			{
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download_udisk failed\n");
@@ -709,7 +780,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 		}//如果是sysrecovery分区，烧录完整分区镜像
 		else if(!strncmp("sysrecovery", (char*)part_info->name, strlen("sysrecovery")))
 		{
-			ret1 = __download_sysrecover_part(part_info, down_buff);
+			ret1 = __download_sysrecover_part(part_info);
 			if(ret1 != 0)
 			{
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download sysrecovery failed\n");
@@ -723,7 +794,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 			{
 				//需要烧录此分区
 				printf("NEED down private part\n");
-				ret1 = __download_normal_part(part_info, down_buff);
+				ret1 = __download_normal_part(part_info);
 				if(ret1 != 0)
 				{
 					printf("sunxi sprite err: sunxi_sprite_deal_part, download private failed\n");
@@ -738,7 +809,7 @@ int sunxi_sprite_deal_part(sunxi_download_info *dl_map)
 		}
 		else
 		{
-			ret1 = __download_normal_part(part_info, down_buff);
+			ret1 = __download_normal_part(part_info);
 			if(ret1 != 0)
 			{
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download normal failed\n");
@@ -757,10 +828,7 @@ __sunxi_sprite_deal_part_err1:
 
 __sunxi_sprite_deal_part_err2:
 
-    if(down_buff)
-    {
-    	free(down_buff);
-    }
+    __card_pipe_free();
 
     return ret;
 }
@@ -1146,7 +1214,7 @@ int card_erase(int erase, void *mbr_buffer)
 	{
 		return 0;
 	}
-	erase_buffer = (char *)malloc(CARD_ERASE_BLOCK_BYTES);
+	erase_buffer = (char *)malloc_pool(CARD_ERASE_BLOCK_BYTES);
 	if(!erase_buffer)
 	{
 		printf("card erase fail: unable to malloc memory for card erase\n");
@@ -1213,7 +1281,7 @@ int card_erase(int erase, void *mbr_buffer)
 					if(!sunxi_sprite_mmc_phywrite(from, nr, erase_buffer))
 					{
 						printf("card erase fail in erasing part %s\n", mbr->array[i].name);
-						free(erase_buffer);
+						free_pool(erase_buffer);
 						return -1;
 					}
 				}
@@ -1225,7 +1293,7 @@ int card_erase(int erase, void *mbr_buffer)
 			if(!sunxi_sprite_write(erase_head_addr, erase_head_sectors, erase_buffer))
 			{
 				printf("card erase fail in erasing part %s\n", mbr->array[i].name);
-				free(erase_buffer);
+				free_pool(erase_buffer);
 				return -1;
 			}
 			printf("erase prat's head from sector 0x%x to 0x%x\n", erase_head_addr, erase_head_addr + erase_head_sectors);
@@ -1236,15 +1304,20 @@ int card_erase(int erase, void *mbr_buffer)
 				if(!sunxi_sprite_write(erase_tail_addr, erase_tail_sectors, erase_buffer))
 				{
 					printf("card erase fail in erasing part %s\n", mbr->array[i].name);
-					free(erase_buffer);
+					free_pool(erase_buffer);
 					return -1;
 				}
 				printf("erase part's tail from sector 0x%x to 0x%x\n", erase_tail_addr, erase_tail_addr + erase_tail_sectors);
 			}
 		}
 	}
+	free_pool(erase_buffer);
+	if(sunxi_sprite_sync())
+	{
+		printf("card erase fail in flushing the erased heads and tails\n");
+		return -1;
+	}
 	printf("card erase all\n");
-	free(erase_buffer);
 
 	//while((*(volatile unsigned int *)0) != 1);
 	//tick_printf("erase all part end\n");
@@ -1448,7 +1521,6 @@ int sunxi_sprite_deal_part_from_sysrevoery(sunxi_download_info *dl_map)
 	int 				ret  = -1;
 	int 				ret1;
 	int 				  i  = 0;
-    uchar *down_buff         = NULL;
     int					rate;
 
 	if(!dl_map->download_count)
@@ -1469,8 +1541,7 @@ int sunxi_sprite_deal_part_from_sysrevoery(sunxi_download_info *dl_map)
 	}
 */
  	//申请内存
-    down_buff = (uchar *)malloc(SPRITE_CARD_ONCE_DATA_DEAL + SPRITE_CARD_HEAD_BUFF);
-    if(!down_buff)
+    if(__card_pipe_alloc())
     {
     	printf("sunxi sprite err: unable to malloc memory for sunxi_sprite_deal_part\n");
 
@@ -1506,7 +1577,7 @@ int sunxi_sprite_deal_part_from_sysrevoery(sunxi_download_info *dl_map)
 	    }
 		else
 		{
-			ret1 = __download_normal_part(part_info, down_buff);
+			ret1 = __download_normal_part(part_info);
 			if(ret1 != 0)
 			{
 				printf("sunxi sprite err: sunxi_sprite_deal_part, download normal failed\n");
@@ -1524,10 +1595,7 @@ __sunxi_sprite_deal_part_err1:
 
 __sunxi_sprite_deal_part_err2:
 
-    if(down_buff)
-    {
-    	free(down_buff);
-    }
+    __card_pipe_free();
 
     return ret;
 }
@@ -1576,23 +1644,13 @@ int __imagehd(HIMAGE tmp_himage)
 */
 #ifdef CONFIG_SUNXI_SPINOR
 extern int sunxi_sprite_setdata_finish(void);
-static int __download_fullimg_part(uchar *source_buff)
+static int __download_fullimg_part(void)
 {
-    uint tmp_partstart_by_sector;
-
-    s64  partdata_by_byte;                  //Dèòa????μ?・???êy?Y(×??úμ￥??)
-    s64  tmp_partdata_by_bytes;
-
-    uint onetime_read_sectors;              //ò?′??áD′μ?éè??êy
-    uint first_write_bytes;
+    s64  partdata_by_byte;
 
-    uint imgfile_start;                     //・???êy?Y?ù?úμ?éè??
-    uint tmp_imgfile_start;
-
-    u8 *down_buffer           = source_buff + SPRITE_CARD_HEAD_BUFF;
+    uint imgfile_start;
 
     int  ret = -1;
-    tmp_partstart_by_sector = 0;
     imgitemhd = Img_OpenItem(imghd, "12345678", "FULLIMG_00000000");
     if(!imgitemhd)
     {
@@ -1607,17 +1665,6 @@ static int __download_fullimg_part(uchar *source_buff)
     }
     printf("partdata hi 0x%x\n", (uint)(partdata_by_byte>>32));
     printf("partdata lo 0x%x\n", (uint)partdata_by_byte);
-    tmp_partdata_by_bytes = partdata_by_byte;
-    if(tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL)
-    {
-        onetime_read_sectors = SPRITE_CARD_ONCE_SECTOR_DEAL;
-        first_write_bytes    = SPRITE_CARD_ONCE_DATA_DEAL;
-    }
-    else
-    {
-        onetime_read_sectors = (tmp_partdata_by_bytes + 511)>>9;
-        first_write_bytes    = (uint)tmp_partdata_by_bytes;
-    }
     imgfile_start = Img_GetItemStart(imghd, imgitemhd);
     if(!imgfile_start)
     {
@@ -1625,54 +1672,9 @@ static int __download_fullimg_part(uchar *source_buff)
 
         goto __download_fullimg_part_err1;
     }
-    tmp_imgfile_start = imgfile_start;
-    if(sunxi_flash_read(tmp_imgfile_start, onetime_read_sectors, down_buffer) != onetime_read_sectors)
-    {
-        printf("sunxi sprite error : read sdcard block %d, total %d failed\n", tmp_imgfile_start, onetime_read_sectors);
-		goto __download_fullimg_part_err1;
-    }
-    tmp_imgfile_start += onetime_read_sectors;
-    if(sunxi_sprite_write(tmp_partstart_by_sector, onetime_read_sectors, down_buffer) != onetime_read_sectors)
+    if(__download_pipe("FULLIMG", imgfile_start, 0, partdata_by_byte, NULL, NULL))
     {
-		printf("sunxi sprite error: download rawdata error FULLIMG\n");
         goto __download_fullimg_part_err1;
-	}
-    tmp_partdata_by_bytes   -= first_write_bytes;
-    tmp_partstart_by_sector  += onetime_read_sectors;
-
-    while(tmp_partdata_by_bytes >= SPRITE_CARD_ONCE_DATA_DEAL)
-    {
-        if(sunxi_flash_read(tmp_imgfile_start, SPRITE_CARD_ONCE_SECTOR_DEAL, down_buffer) != SPRITE_CARD_ONCE_SECTOR_DEAL)
-        {
-            printf("sunxi sprite error : read sdcard block %d, total %d failed\n", tmp_imgfile_start, SPRITE_CARD_ONCE_SECTOR_DEAL);
-
-            goto __download_fullimg_part_err1;
-        }
-        //D′è?flash
-        if(sunxi_sprite_write(tmp_partstart_by_sector, SPRITE_CARD_ONCE_SECTOR_DEAL, down_buffer) != SPRITE_CARD_ONCE_SECTOR_DEAL)
-        {
-			printf("sunxi sprite error: download rawdata error FULLIMG, start 0x%x, sectors 0x%x\n",  tmp_partstart_by_sector, SPRITE_CARD_ONCE_SECTOR_DEAL);
-			goto __download_fullimg_part_err1;
-        }
-        tmp_imgfile_start       += SPRITE_CARD_ONCE_SECTOR_DEAL;
-        tmp_partdata_by_bytes   -= SPRITE_CARD_ONCE_DATA_DEAL;
-        tmp_partstart_by_sector += SPRITE_CARD_ONCE_SECTOR_DEAL;
-    }
-    if(tmp_partdata_by_bytes > 0)
-    {
-        uint rest_sectors = (tmp_partdata_by_bytes + 511)>>9;
-        if(sunxi_flash_read(tmp_imgfile_start, rest_sectors, down_buffer) != rest_sectors)
-        {
-            printf("sunxi sprite error : read sdcard block %d, total %d failed\n", tmp_imgfile_start, rest_sectors);
-
-            goto __download_fullimg_part_err1;
-        }
-        if(sunxi_sprite_write(tmp_partstart_by_sector, rest_sectors, down_buffer) != rest_sectors)
-        {
-            printf("sunxi sprite error: download rawdata error FULLIMG, start 0x%x, sectors 0x%x\n",  tmp_partstart_by_sector, rest_sectors);
-
-            goto __download_fullimg_part_err1;
-        }
     }
     printf("successed in writting part FULLIMG\n");
     ret = 0;
@@ -1690,22 +1692,20 @@ int sunxi_sprite_deal_fullimg(void)
 {
     int  ret  = -1;
     int  ret1;
-    uchar  *down_buff         = NULL;
 
     if(sunxi_sprite_init(1))
     {
         printf("sunxi sprite err: init flash err\n");
         return -1;
     }
-    down_buff = (uchar *)malloc(SPRITE_CARD_ONCE_DATA_DEAL + SPRITE_CARD_HEAD_BUFF);
-    if(!down_buff)
+    if(__card_pipe_alloc())
     {
         printf("sunxi sprite err: unable to malloc memory for sunxi_sprite_deal_part\n");
 
         goto __sunxi_sprite_deal_fullimg_err1;
     }
 
-    ret1 = __download_fullimg_part(down_buff);
+    ret1 = __download_fullimg_part();
     if(ret1 != 0)
     {
         printf("sunxi sprite err: sunxi_sprite_deal_part, download normal failed\n");
@@ -1722,10 +1722,7 @@ int sunxi_sprite_deal_fullimg(void)
 __sunxi_sprite_deal_fullimg_err1:
 	sunxi_sprite_exit(1);
 __sunxi_sprite_deal_fullimg_err2:
-    if(down_buff)
-    {
-        free(down_buff);
-    }
+    __card_pipe_free();
     return ret;
 }
 #endif
@@ -172,6 +172,13 @@ int sunxi_sprite_restore_part_data(void *buffer)
 	{
 		printf("there is no private part need rewrite\n");
 	}
+	//合并写缓存里的数据写下去才算恢复成功
+	if(sunxi_sprite_sync())
+	{
+		printf("sunxi sprite error : flush private data error\n");
+
+		goto __sunxi_sprite_restore_part_data_fail;
+	}
 	ret = 0;
 
 __sunxi_sprite_restore_part_data_fail:
@@ -282,6 +289,11 @@ int sunxi_sprite_erase_private_key(void *buffer)
 		}
 
 	}
+	if(sunxi_sprite_sync())
+	{
+		printf("sunxi_sprite_erase_private_key err: flush failed\n");
+		return -1;
+	}
 	printf("erase private key successed \n");
 	return 0;
 }
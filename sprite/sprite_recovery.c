@@ -225,7 +225,7 @@ int sprite_form_sysrecovery(void)
 	//启动动画显示
 	sprite_cartoon_create();
 	
-	src_buf = (char *)malloc(1024 * 1024);
+	src_buf = (char *)malloc_pool(1024 * 1024);
 	if (!src_buf)
 	{
 		printf("sprite update error: fail to get memory for tmpdata\n");
@@ -331,7 +331,7 @@ int sprite_form_sysrecovery(void)
     }
 	if (src_buf)
 	{
-		free(src_buf);
+		free_pool(src_buf);
 	}
 	//处理烧写完成后重启
 	sunxi_board_restart(0);
@@ -344,7 +344,7 @@ _update_error_:
     }
     if (src_buf)
 	{
-		free(src_buf);
+		free_pool(src_buf);
 	}
 	printf("sprite update error: current card sprite failed\n");
 	printf("now hold the machine\n");
@@ -25,6 +25,7 @@
 #include <common.h>
 #include <malloc.h>
 #include "sparse/sparse.h"
+#include "sprite_verify.h"
 #include <sunxi_mbr.h>
 #include <sunxi_board.h>
 
@@ -48,40 +49,8 @@
 */
 uint add_sum(void *buffer, uint length)
 {
-#ifndef CONFIG_USE_NEON_SIMD
-	unsigned int *buf;
-	unsigned int count;
-	unsigned int sum;
-
-	count = length >> 2;                         // 以 字（4bytes）为单位计数
-	sum = 0;
-	buf = (unsigned int *)buffer;
-	while(count--)
-	{
-		sum += *buf++;                         // 依次累加，求得校验和
-	};
-
-	switch(length & 0x03)
-	{
-		case 0:
-			return sum;
-		case 1:
-			sum += (*buf & 0x000000ff);
-			break;
-		case 2:
-			sum += (*buf & 0x0000ffff);
-			break;
-		case 3:
-			sum += (*buf & 0x00ffffff);
-			break;
-	}
-#else
-	uint sum;
-
-	sum = add_sum_neon(buffer, length);
-#endif
-
-	return sum;
+	//armv7上使用NEON实现，没有NEON时自动退回到C实现
+	return add_sum_neon(buffer, length);
 }
 /*
 ************************************************************************************************************
@@ -107,7 +76,7 @@ uint sunxi_sprite_part_rawdata_verify(uint base_start, long long base_bytes)
 	uint crt_start;
 	char *tmp_buf = NULL;
 
-	tmp_buf = (char *)malloc(VERIFY_ONCE_BYTES);
+	tmp_buf = (char *)malloc_pool(VERIFY_ONCE_BYTES);
 	if(!tmp_buf)
 	{
 		printf("sunxi sprite err: unable to malloc memory for verify\n");
@@ -158,7 +127,7 @@ uint sunxi_sprite_part_rawdata_verify(uint base_start, long long base_bytes)
 __rawdata_verify_err:
 	if(tmp_buf)
 	{
-		free(tmp_buf);
+		free_pool(tmp_buf);
 	}
 
 	return checksum;
@@ -180,52 +149,163 @@ __rawdata_verify_err:
 *
 ************************************************************************************************************
 */
-uint sunxi_sprite_part_sparsedata_verify(void)
+uint sunxi_sprite_part_sparsedata_verify(struct sparse_stream *stream)
 {
-	return unsparse_checksum();
+	return unsparse_checksum(stream);
 }
 /*
 ************************************************************************************************************
 *
 *                                             function
 *
-*    name          :
+*    name          :  sunxi_sprite_verify_stream_init
 *
 *    parmeters     :
 *
 *    return        :
 *
+*    note          :  边写边校验: 写入时计算全部数据的校验和，并记录一部分写入数据的抽样，
+*                     写完后只回读抽样比较，不再回读整个分区
+*
+*
+************************************************************************************************************
+*/
+void sunxi_sprite_verify_stream_init(sprite_verify_stream_t *stream)
+{
+	memset(stream, 0, sizeof(sprite_verify_stream_t));
+	stream->stride = 1;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_sprite_verify_stream_add
+*
+*    parmeters     :  start  : 数据写入的扇区
+*                     buffer : 刚写入flash的数据
+*
+*    return        :
+*
+*    note          :  抽样表满了以后，隔一个丢一个，抽样间隔加倍，抽样始终均匀分布在整个分区
+*
+*
+************************************************************************************************************
+*/
+void sunxi_sprite_verify_stream_add(sprite_verify_stream_t *stream, uint start, void *buffer, uint bytes)
+{
+	sprite_verify_sample_t *sample;
+	uint sample_bytes;
+	int  i;
+
+	if((stream->count ++) % stream->stride)
+	{
+		stream->checksum += add_sum(buffer, bytes);
+
+		return;
+	}
+	if(stream->sample_count == SPRITE_VERIFY_SAMPLE_MAX)
+	{
+		for(i=0;i<SPRITE_VERIFY_SAMPLE_MAX/2;i++)
+		{
+			stream->sample[i] = stream->sample[2 * i];
+		}
+		stream->sample_count = SPRITE_VERIFY_SAMPLE_MAX/2;
+		stream->stride *= 2;
+		if((stream->count - 1) % stream->stride)
+		{
+			stream->checksum += add_sum(buffer, bytes);
+
+			return;
+		}
+	}
+	sample_bytes = min(bytes, (uint)SPRITE_VERIFY_SAMPLE_BYTES) & ~511;
+	if(sample_bytes)
+	{
+		sample = &stream->sample[stream->sample_count ++];
+		sample->start   = start;
+		sample->sectors = sample_bytes>>9;
+		sample->sum     = add_sum(buffer, sample_bytes);
+		stream->checksum += sample->sum;
+	}
+	stream->checksum += add_sum((char *)buffer + sample_bytes, bytes - sample_bytes);
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_sprite_verify_stream_check
+*
+*    parmeters     :
+*
+*    return        :  和sunxi_sprite_part_rawdata_verify一样，返回整个分区数据的校验和，
+*                     抽样回读出错时返回0
+*
 *    note          :
 *
 *
 ************************************************************************************************************
 */
-uint sunxi_sprite_generate_checksum(void *buffer, uint length, uint src_sum)
+uint sunxi_sprite_verify_stream_check(sprite_verify_stream_t *stream)
 {
-#ifndef CONFIG_USE_NEON_SIMD
-	uint *buf;
-	uint count;
-	uint sum;
+	sprite_verify_sample_t *sample;
+	char *tmp_buf;
+	uint checksum = stream->checksum;
+	int  i;
 
-	/* 生成校验和 */
-	count = length >> 2;                       // 以 字（4bytes）为单位计数
-	sum = 0;
-	buf = (__u32 *)buffer;
-	do
+	tmp_buf = (char *)malloc_pool(SPRITE_VERIFY_SAMPLE_BYTES);
+	if(!tmp_buf)
+	{
+		printf("sunxi sprite err: unable to malloc memory for verify\n");
+
+		return 0;
+	}
+	for(i=0;i<stream->sample_count;i++)
 	{
-		sum += *buf++;                         // 依次累加，求得校验和
-		sum += *buf++;                         // 依次累加，求得校验和
-		sum += *buf++;                         // 依次累加，求得校验和
-		sum += *buf++;                         // 依次累加，求得校验和
-	}while( ( count -= 4 ) > (4-1) );
+		sample = &stream->sample[i];
+		if(sunxi_sprite_read(sample->start, sample->sectors, tmp_buf) != sample->sectors)
+		{
+			printf("sunxi sprite: read flash error when verify\n");
+			checksum = 0;
+
+			break;
+		}
+		if(add_sum(tmp_buf, sample->sectors<<9) != sample->sum)
+		{
+			printf("sunxi sprite: sector 0x%x read back differs from the written data\n", sample->start);
+			checksum = 0;
+
+			break;
+		}
+	}
+	printf("sunxi sprite: %d samples read back for verify\n", stream->sample_count);
+	free_pool(tmp_buf);
 
-	while( count-- > 0 )
-		sum += *buf++;
-#else
+	return checksum;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :
+*
+*
+************************************************************************************************************
+*/
+uint sunxi_sprite_generate_checksum(void *buffer, uint length, uint src_sum)
+{
 	uint sum;
 
-	sum = add_sum_neon(buffer, length);
-#endif
+	/* 生成校验和 */
+	sum = add_sum(buffer, length & ~0x03);
 	sum = sum - src_sum + STAMP_VALUE;
 
     return sum;
@@ -248,30 +328,10 @@ uint sunxi_sprite_generate_checksum(void *buffer, uint length, uint src_sum)
 */
 int sunxi_sprite_verify_checksum(void *buffer, uint length, uint src_sum)
 {
-#ifndef CONFIG_USE_NEON_SIMD
-	uint *buf;
-	uint count;
 	uint sum;
 
 	/* 生成校验和 */
-	count = length >> 2;                       // 以 字（4bytes）为单位计数
-	sum = 0;
-	buf = (__u32 *)buffer;
-	do
-	{
-		sum += *buf++;                         // 依次累加，求得校验和
-		sum += *buf++;                         // 依次累加，求得校验和
-		sum += *buf++;                         // 依次累加，求得校验和
-		sum += *buf++;                         // 依次累加，求得校验和
-	}while( ( count -= 4 ) > (4-1) );
-
-	while( count-- > 0 )
-		sum += *buf++;
-#else
-	uint sum;
-
-	sum = add_sum_neon(buffer, length);
-#endif
+	sum = add_sum(buffer, length & ~0x03);
 	sum = sum - src_sum + STAMP_VALUE;
 
 	debug("src sum=%x, check sum=%x\n", src_sum, sum);
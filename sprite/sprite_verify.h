@@ -31,7 +31,34 @@ extern uint add_sum(void *buffer, uint length);
 
 extern uint sunxi_sprite_part_rawdata_verify(uint base_start, long long base_bytes);
 
-extern uint sunxi_sprite_part_sparsedata_verify(void);
+//边写边计算校验和时，写完后只回读这么多个抽样
+#define  SPRITE_VERIFY_SAMPLE_MAX     (64)
+#define  SPRITE_VERIFY_SAMPLE_BYTES   (1024 * 1024)
+
+typedef struct
+{
+	uint  start;						//抽样的起始扇区
+	uint  sectors;
+	uint  sum;							//写入时的校验和
+}
+sprite_verify_sample_t;
+
+typedef struct
+{
+	uint  checksum;						//所有写入数据的校验和
+	uint  count;						//写入的次数
+	uint  stride;						//每stride次写入抽样一次
+	uint  sample_count;
+	sprite_verify_sample_t sample[SPRITE_VERIFY_SAMPLE_MAX];
+}
+sprite_verify_stream_t;
+
+extern void sunxi_sprite_verify_stream_init(sprite_verify_stream_t *stream);
+extern void sunxi_sprite_verify_stream_add(sprite_verify_stream_t *stream, uint start, void *buffer, uint bytes);
+extern uint sunxi_sprite_verify_stream_check(sprite_verify_stream_t *stream);
+
+struct sparse_stream;
+extern uint sunxi_sprite_part_sparsedata_verify(struct sparse_stream *stream);
 
 extern uint sunxi_sprite_generate_checksum(void *buffer, uint length, uint src_sum);
 
@@ -0,0 +1,104 @@
+/*
+ * (C) Copyright 2007-2016
+ * Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+ *
+ * boot0的bootstage记录, 跳转前按bootstage_stash()的格式放到
+ * CONFIG_BOOTSTAGE_STASH, uboot再用bootstage_unstash()接过去
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <boot0_helper.h>
+
+#ifdef CONFIG_BOOTSTAGE_STASH
+
+#define BOOT0_STAGE_MAX		8
+
+static struct bootstage_record boot0_stage[BOOT0_STAGE_MAX];
+static int boot0_stage_count;
+
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  boot0_stage_mark
+*
+*    parmeters     :  id: bootstage编号, name: 记录的名字, 要一直有效到boot0_stage_stash
+*
+*    return        :
+*
+*    note          :  时间取avs cnt1, 和uboot的timer_get_boot_us()是同一个计数器
+*
+************************************************************************************************************
+*/
+void boot0_stage_mark(enum bootstage_id id, const char *name)
+{
+	struct bootstage_record *rec;
+
+	if (boot0_stage_count == BOOT0_STAGE_MAX)
+	{
+		return;
+	}
+	rec = &boot0_stage[boot0_stage_count++];
+	rec->time_us = timer_get_us();
+	if (!rec->time_us)
+	{
+		rec->time_us = 1;	/* 0表示没有记录 */
+	}
+	rec->start_us = 0;
+	rec->name = name;
+	rec->flags = 0;
+	rec->id = id;
+}
+
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  boot0_stage_stash
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  在关掉MMU之后调用, 直接写到dram里. 放不下的时候不留stash.
+*
+************************************************************************************************************
+*/
+void boot0_stage_stash(void)
+{
+	struct bootstage_hdr *hdr = (struct bootstage_hdr *)CONFIG_BOOTSTAGE_STASH;
+	char *ptr = (char *)(hdr + 1);
+	char *end = (char *)CONFIG_BOOTSTAGE_STASH + CONFIG_BOOTSTAGE_STASH_SIZE;
+	int i, len;
+
+	hdr->magic = 0;
+	len = boot0_stage_count * sizeof(boot0_stage[0]);
+	if (ptr + len > end)
+	{
+		return;
+	}
+	memcpy(ptr, boot0_stage, len);
+	ptr += len;
+
+	for (i = 0; i < boot0_stage_count; i++)
+	{
+		len = strlen(boot0_stage[i].name) + 1;
+		if (ptr + len > end)
+		{
+			return;
+		}
+		memcpy(ptr, boot0_stage[i].name, len);
+		ptr += len;
+	}
+
+	hdr->version = BOOTSTAGE_VERSION;
+	hdr->count = boot0_stage_count;
+	hdr->size = ptr - (char *)hdr;
+	hdr->magic = BOOTSTAGE_MAGIC;
+}
+
+#endif
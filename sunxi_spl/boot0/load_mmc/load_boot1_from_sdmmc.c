@@ -39,6 +39,325 @@ extern __s32 check_sum( __u32 *mem_base, __u32 size );
 
 extern const boot0_file_head_t  BT0_head;
 
+#define  TOC1_HEAD_SECTORS      64
+#define  TOC1_MAX_RANGES        32
+#define  TOC1_ADD_SUM_WORD      (5)            //add_sum在toc1 head中的字偏移
+#define  TOC1_READ_CHUNK        (256)          //大的读操作按128K分段
+
+/*
+ * boot package reader: load_fip() reads every item straight from the card
+ * to its load address through toc1_flash_read(). reads are split into
+ * TOC1_READ_CHUNK pieces that run on the mmc dma while the package sum of
+ * the previous piece is taken, so even a single big item overlaps its
+ * sum. the parts of the package no item covers are read the same way at
+ * the end, and a package sum that does not match the TOC1 head fails the
+ * boot.
+ */
+static struct
+{
+	int   active;
+	int   card_no;
+	int   error;
+	u32   start_sector;                   //package在卡上的起始扇区
+	u32   valid_len;
+	u32   src_sum;
+	u32   sum;
+
+	int   busy;                           //是否有读操作正在进行
+	u32   pend_sector;
+	u32   pend_cnt;
+	void *pend_buff;
+
+	int   ranges_nr;                      //已经计算过校验和的扇区区间, 按起始扇区排序
+	u32   range[TOC1_MAX_RANGES][2];
+}
+toc1_reader;
+
+static unsigned long toc1_sync_result;
+
+/* controllers without an asynchronous read just read at once */
+int __attribute__((weak)) mmc_bread_start(int dev_num, unsigned long start, unsigned blkcnt, void *dst)
+{
+	toc1_sync_result = mmc_bread(dev_num, start, blkcnt, dst);
+
+	return (toc1_sync_result == blkcnt) ? 0 : -1;
+}
+
+unsigned long __attribute__((weak)) mmc_async_wait(int dev_num)
+{
+	return toc1_sync_result;
+}
+
+/* additive sum of package sectors [sector, sector + cnt), add_sum itself counts as STAMP_VALUE */
+static u32 toc1_sum(const u32 *buf, u32 sector, u32 cnt)
+{
+	u32 word = sector * 128;
+	u32 end  = (sector + cnt) * 128;
+	u32 count;
+	u32 sum = 0;
+
+	if(end > (toc1_reader.valid_len >> 2))
+	{
+		end = toc1_reader.valid_len >> 2;
+	}
+	if(word >= end)
+	{
+		return 0;
+	}
+	if(word <= TOC1_ADD_SUM_WORD && TOC1_ADD_SUM_WORD < end)
+	{
+		sum = STAMP_VALUE - buf[TOC1_ADD_SUM_WORD - word];
+	}
+
+	count = end - word;
+	while(count >= 4)
+	{
+		sum += buf[0] + buf[1] + buf[2] + buf[3];
+		buf += 4;
+		count -= 4;
+	}
+	while(count--)
+	{
+		sum += *buf++;
+	}
+
+	return sum;
+}
+
+/* remember that [start, end) is summed, neighbouring ranges are merged */
+static int toc1_add_range(u32 start, u32 end)
+{
+	int i, j, k;
+
+	for(i=0;i<toc1_reader.ranges_nr && toc1_reader.range[i][1] < start;i++)
+		;
+	for(j=i;j<toc1_reader.ranges_nr && toc1_reader.range[j][0] <= end;j++)
+	{
+		if(toc1_reader.range[j][0] < start)
+			start = toc1_reader.range[j][0];
+		if(toc1_reader.range[j][1] > end)
+			end = toc1_reader.range[j][1];
+	}
+	if(j == i)
+	{
+		if(toc1_reader.ranges_nr == TOC1_MAX_RANGES)
+		{
+			printf("PANIC : toc1 reader, too many boot package pieces\n");
+			return -1;
+		}
+		for(k=toc1_reader.ranges_nr;k>i;k--)
+		{
+			toc1_reader.range[k][0] = toc1_reader.range[k-1][0];
+			toc1_reader.range[k][1] = toc1_reader.range[k-1][1];
+		}
+		toc1_reader.ranges_nr ++;
+	}
+	else
+	{
+		for(k=j;k<toc1_reader.ranges_nr;k++)
+		{
+			toc1_reader.range[k-j+i+1][0] = toc1_reader.range[k][0];
+			toc1_reader.range[k-j+i+1][1] = toc1_reader.range[k][1];
+		}
+		toc1_reader.ranges_nr -= j - i - 1;
+	}
+	toc1_reader.range[i][0] = start;
+	toc1_reader.range[i][1] = end;
+
+	return 0;
+}
+
+/* add the sectors of a finished read that are not summed yet */
+static void toc1_account(u32 sector, u32 cnt, const u8 *buff)
+{
+	u32 cur = sector;
+	u32 end = sector + cnt;
+	int i;
+
+	for(i=0;i<toc1_reader.ranges_nr && cur < end;i++)
+	{
+		if(toc1_reader.range[i][1] <= cur)
+			continue;
+		if(toc1_reader.range[i][0] >= end)
+			break;
+		if(toc1_reader.range[i][0] > cur)
+		{
+			toc1_reader.sum += toc1_sum((const u32 *)(buff + (cur - sector) * 512), cur, toc1_reader.range[i][0] - cur);
+		}
+		cur = toc1_reader.range[i][1];
+	}
+	if(cur < end)
+	{
+		toc1_reader.sum += toc1_sum((const u32 *)(buff + (cur - sector) * 512), cur, end - cur);
+	}
+	if(toc1_add_range(sector, sector + cnt))
+	{
+		toc1_reader.error = -1;
+	}
+}
+
+/*
+ * read [sector, sector + cnt) of the package to buff in pieces of at most
+ * TOC1_READ_CHUNK sectors. the sum of each piece is taken while the next
+ * one is read, the last piece is left in flight.
+ */
+static int toc1_pipe_read(u32 sector, u32 cnt, u8 *buff)
+{
+	u32   this_cnt;
+	u32   prev_sector, prev_cnt;
+	void *prev_buff;
+
+	while(cnt)
+	{
+		this_cnt = (cnt > TOC1_READ_CHUNK) ? TOC1_READ_CHUNK : cnt;
+		prev_sector = prev_cnt = 0;
+		prev_buff = NULL;
+		if(toc1_reader.busy)
+		{
+			toc1_reader.busy = 0;
+			if(mmc_async_wait(toc1_reader.card_no) != toc1_reader.pend_cnt)
+			{
+				printf("PANIC : toc1 reader, read sector %d error\n", toc1_reader.pend_sector);
+				toc1_reader.error = -1;
+				return -1;
+			}
+			prev_sector = toc1_reader.pend_sector;
+			prev_cnt    = toc1_reader.pend_cnt;
+			prev_buff   = toc1_reader.pend_buff;
+		}
+		if(mmc_bread_start(toc1_reader.card_no, toc1_reader.start_sector + sector, this_cnt, buff))
+		{
+			printf("PANIC : toc1 reader, start read sector %d error\n", sector);
+			toc1_reader.error = -1;
+			return -1;
+		}
+		toc1_reader.busy        = 1;
+		toc1_reader.pend_sector = sector;
+		toc1_reader.pend_cnt    = this_cnt;
+		toc1_reader.pend_buff   = buff;
+
+		//上一段数据的校验和与本次读操作并行进行
+		if(prev_cnt)
+		{
+			toc1_account(prev_sector, prev_cnt, prev_buff);
+		}
+		sector += this_cnt;
+		buff   += this_cnt * 512;
+		cnt    -= this_cnt;
+	}
+
+	return toc1_reader.error;
+}
+
+int toc1_flash_read(u32 start_sector, u32 blkcnt, void *buff)
+{
+	if(!toc1_reader.active || toc1_reader.error)
+	{
+		return 0;
+	}
+	if(toc1_pipe_read(start_sector, blkcnt, buff))
+	{
+		printf("PANIC : toc1_flash_read() error\n");
+		return 0;
+	}
+
+	return blkcnt;
+}
+
+int toc1_flash_sync(void)
+{
+	if(!toc1_reader.active)
+	{
+		return -1;
+	}
+	if(toc1_reader.busy)
+	{
+		toc1_reader.busy = 0;
+		if(mmc_async_wait(toc1_reader.card_no) != toc1_reader.pend_cnt)
+		{
+			printf("PANIC : toc1_flash_sync() error\n");
+			toc1_reader.error = -1;
+			return -1;
+		}
+		toc1_account(toc1_reader.pend_sector, toc1_reader.pend_cnt, toc1_reader.pend_buff);
+	}
+
+	return toc1_reader.error;
+}
+
+/* read what no item covered into the package buffer, check the sum and close the card */
+int toc1_flash_finish(void)
+{
+	u8  *tmp_buff = (u8 *)CONFIG_BOOTPKG_STORE_IN_DRAM_BASE;
+	u32  total = (toc1_reader.valid_len + 511)/512;
+	u32  range[TOC1_MAX_RANGES][2];
+	u32  gap[TOC1_MAX_RANGES + 1][2];
+	int  ranges_nr, gaps_nr = 0;
+	u32  cur = 0, end;
+	int  i;
+
+	if(!toc1_reader.active || toc1_reader.error)
+	{
+		goto __ERROR_EXIT;
+	}
+	//找出没有item覆盖的区间, 正在读的那段也算覆盖, 它的校验和与这些区间的读并行进行
+	ranges_nr = toc1_reader.ranges_nr;
+	memcpy(range, toc1_reader.range, sizeof(range));
+	if(toc1_reader.busy && toc1_add_range(toc1_reader.pend_sector, toc1_reader.pend_sector + toc1_reader.pend_cnt))
+	{
+		goto __ERROR_EXIT;
+	}
+	for(i=0;i<=toc1_reader.ranges_nr && cur < total;i++)
+	{
+		end = (i < toc1_reader.ranges_nr) ? toc1_reader.range[i][0] : total;
+		if(end > total)
+		{
+			end = total;
+		}
+		if(end > cur)
+		{
+			gap[gaps_nr][0] = cur;
+			gap[gaps_nr][1] = end;
+			gaps_nr ++;
+		}
+		if(i < toc1_reader.ranges_nr && toc1_reader.range[i][1] > cur)
+		{
+			cur = toc1_reader.range[i][1];
+		}
+	}
+	toc1_reader.ranges_nr = ranges_nr;
+	memcpy(toc1_reader.range, range, sizeof(range));
+
+	for(i=0;i<gaps_nr;i++)
+	{
+		if(toc1_pipe_read(gap[i][0], gap[i][1] - gap[i][0], tmp_buff + gap[i][0] * 512))
+		{
+			printf("PANIC : toc1_flash_finish() error --1--\n");
+			goto __ERROR_EXIT;
+		}
+	}
+	if(toc1_flash_sync())
+	{
+		goto __ERROR_EXIT;
+	}
+	if(toc1_reader.sum != toc1_reader.src_sum)
+	{
+		printf("sum=%x\n", toc1_reader.sum);
+		printf("src_sum=%x\n", toc1_reader.src_sum);
+		printf("PANIC : toc1_flash_finish() error --2--,boot package sum error\n");
+		goto __ERROR_EXIT;
+	}
+	printf("Succeed in loading uboot from sdmmc flash.\n");
+	toc1_reader.active = 0;
+	sunxi_mmc_exit(toc1_reader.card_no, BT0_head.prvt_head.storage_gpio, 16);
+	return 0;
+
+__ERROR_EXIT:
+	toc1_reader.active = 0;
+	sunxi_mmc_exit(toc1_reader.card_no, BT0_head.prvt_head.storage_gpio, 16);
+	return -1;
+}
+
 
 typedef struct _boot_sdcard_info_t
 {
@@ -85,7 +404,7 @@ void update_flash_para(void)
 int load_toc1_from_sdmmc(char *buf)
 {
 	u8  *tmp_buff = (u8 *)CONFIG_BOOTPKG_STORE_IN_DRAM_BASE;
-	uint head_size;
+	uint head_size, head_sectors;
 	sbrom_toc1_head_info_t	*toc1_head;
 	int  card_no;
 	int ret =0;
@@ -114,7 +433,7 @@ int load_toc1_from_sdmmc(char *buf)
 		goto __ERROR_EXIT;;
 	}
 	//read 64 sectors 
-	ret = mmc_bread(card_no, start_sector, 64, tmp_buff);
+	ret = mmc_bread(card_no, start_sector, TOC1_HEAD_SECTORS, tmp_buff);
 	if(!ret)
 	{
 		printf("PANIC : sunxi_flash_init() error --1--\n");
@@ -126,19 +445,31 @@ int load_toc1_from_sdmmc(char *buf)
 		printf("PANIC : sunxi_flash_init() error --2--,toc1 magic error\n");
 		goto __ERROR_EXIT;
 	}
-	head_size = toc1_head->valid_len;
-	if(head_size > 64 * 512)
+	//only the item table is needed here, load_fip() reads the items to their load addresses
+	head_size = sizeof(sbrom_toc1_head_info_t) + toc1_head->items_nr * sizeof(sbrom_toc1_item_info_t);
+	head_sectors = (head_size + 511)/512;
+	if(head_sectors > TOC1_HEAD_SECTORS)
 	{
-		tmp_buff += 64*512;
-		ret = mmc_bread(card_no, start_sector + 64, (head_size - 64*512 + 511)/512, tmp_buff);
+		ret = mmc_bread(card_no, start_sector + TOC1_HEAD_SECTORS, head_sectors - TOC1_HEAD_SECTORS, tmp_buff + TOC1_HEAD_SECTORS * 512);
 		if(!ret)
 		{
 			printf("PANIC : sunxi_flash_init() error --3--\n");
 			goto __ERROR_EXIT;
 		}
 	}
-	printf("Succeed in loading uboot from sdmmc flash.\n");
-	sunxi_mmc_exit( card_no, BT0_head.prvt_head.storage_gpio, 16 );
+	else
+	{
+		head_sectors = TOC1_HEAD_SECTORS;
+	}
+
+	memset(&toc1_reader, 0, sizeof(toc1_reader));
+	toc1_reader.card_no      = card_no;
+	toc1_reader.start_sector = start_sector;
+	toc1_reader.valid_len    = toc1_head->valid_len;
+	toc1_reader.src_sum      = toc1_head->add_sum;
+	toc1_account(0, head_sectors, tmp_buff);
+	toc1_reader.active       = 1;
+	//the card stays open for load_fip(), toc1_flash_finish() closes it
 	return 0;
 
 __ERROR_EXIT:
@@ -64,6 +64,7 @@ void main( void )
 	int use_monitor = 0;
 
 	timer_init();
+	boot0_stage_mark(BOOTSTAGE_ID_START_SPL, "boot0");
 	sunxi_serial_init( BT0_head.prvt_head.uart_port, (void *)BT0_head.prvt_head.uart_ctrl, 6 );
 	set_debugmode_flag();
 	printf("HELLO! BOOT0 is starting!\n");
@@ -86,6 +87,7 @@ void main( void )
 		goto __boot0_entry_err0;
 	}
 
+	boot0_stage_mark(BOOTSTAGE_ID_DRAM_INIT, "dram_init");
 #ifdef FPGA_PLATFORM
 	dram_size = mctl_init((void *)BT0_head.prvt_head.dram_para);
 #else
@@ -104,6 +106,7 @@ void main( void )
 	handler_super_standby();
 
 	mmu_setup(dram_size);
+	boot0_stage_mark(BOOTSTAGE_ID_TOC1_LOAD, "toc1_load");
 	status = load_boot1();
 	if(status == 0 )
 	{
@@ -125,6 +128,8 @@ void main( void )
 		//update dram para before jmp to boot1
 		set_dram_para((void *)&BT0_head.prvt_head.dram_para, dram_size, boot_cpu);
 		printf("Jump to secend Boot.\n");
+		boot0_stage_mark(BOOTSTAGE_ID_SPL_EXIT, "boot0_exit");
+		boot0_stage_stash();
         if(use_monitor)
 		{
 			boot0_jmp_monitor();
@@ -13,10 +13,21 @@ extern void boot0_jmp_other(unsigned int addr);
 extern void boot0_jmp_monitor(void);
 extern void reset_pll( void );
 extern int load_fip(int *use_monitor);
+extern int toc1_flash_read(u32 start_sector, u32 blkcnt, void *buff);
+extern int toc1_flash_sync(void);
+extern int toc1_flash_finish(void);
 extern void set_debugmode_flag(void);
 extern void set_pll( void );
 extern void update_flash_para(void);
 
+#ifdef CONFIG_BOOTSTAGE_STASH
+extern void boot0_stage_mark(enum bootstage_id id, const char *name);
+extern void boot0_stage_stash(void);
+#else
+#define boot0_stage_mark(id, name)	do { } while (0)
+#define boot0_stage_stash()		do { } while (0)
+#endif
+
 
 extern int printf(const char *fmt, ...);
 extern void * memcpy(void * dest,const void *src,size_t count);
@@ -0,0 +1,23 @@
+#include "../../root/repo/sunxi_spl/boot0/load_mmc/load_boot1_from_sdmmc.c"
+#include <stdlib.h>
+u8 dram[16<<20]; static u8 card[8<<20];
+boot0_file_head_t BT0_head;
+int sunxi_mmc_init(int a, int b, void*c, int d, void*e){return 0;} int sunxi_mmc_exit(int a, void*b, int c){return 0;}
+int set_mmc_para(int a, void*b){return 0;}
+unsigned long mmc_bread(int d, unsigned long s, unsigned n, void*b){memcpy(b, card+s*512, n*512); return n;}
+static unsigned long pend; static int starts;
+int mmc_bread_start(int d, unsigned long s, unsigned n, void*b){ starts++; memcpy(b, card+s*512, n*512); pend=n; return 0;}
+unsigned long mmc_async_wait(int d){ return pend; }
+int main(int argc,char**argv){
+ int corrupt = argc>1;
+ u8 *pkg = card + UBOOT_START_SECTOR_IN_SDMMC*512; u32 len = 0x10000 + 900000 + 300; len=(len+3)&~3;
+ for(u32 i=0;i<len;i++) pkg[i]=rand();
+ sbrom_toc1_head_info_t *h=(void*)pkg; sbrom_toc1_item_info_t *it=(void*)(pkg+sizeof(*h));
+ h->magic=TOC_MAIN_INFO_MAGIC; h->items_nr=1; h->valid_len=len; strcpy(it->name,"u-boot"); it->data_offset=0x10000; it->data_len=900000;
+ h->add_sum=STAMP_VALUE; u32 s=0; for(u32 i=0;i<len/4;i++) s+=((u32*)pkg)[i]; h->add_sum=s;
+ if(corrupt) pkg[len-5]^=1;
+ if(load_boot1()) {puts("load fail");return 1;}
+ if(toc1_flash_read(it->data_offset/512,(it->data_len+511)/512,CONFIG_SYS_TEXT_BASE)!=(it->data_len+511)/512){puts("read fail");return 1;}
+ int r=toc1_flash_finish();
+ printf("finish %d starts %d match %d\n", r, starts, !memcmp(CONFIG_SYS_TEXT_BASE, pkg+0x10000, 900000));
+ return 0;}
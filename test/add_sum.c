@@ -0,0 +1,82 @@
+/*
+ * Compare the sunxi image checksum kernels with a byte-wise reference
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/ut.h>
+#ifdef CONFIG_ARM
+#include <asm/armv7.h>
+#endif
+
+#define TEST_BUFFER_SIZE	4096
+
+static u8 *test_buf;
+
+static uint add_sum_reference(const u8 *buf, uint length)
+{
+	uint sum = 0;
+	uint i;
+
+	for (i = 0; i < length; i++)
+		sum += buf[i] << ((i & 3) * 8);
+
+	return sum;
+}
+
+/* every tail length, and lengths around the 64-byte vector step */
+static int add_sum_test_lengths(struct unit_test_state *uts)
+{
+	uint offset, length, expect;
+
+	for (offset = 0; offset < 64; offset += 4) {
+		for (length = 0; offset + length < TEST_BUFFER_SIZE;
+		     length += (length < 260) ? 1 : 61) {
+			expect = add_sum_reference(test_buf + offset, length);
+			ut_assertf(add_sum_generic(test_buf + offset,
+						   length) == expect,
+				   "offset %u length %u", offset, length);
+			ut_assertf(add_sum_neon(test_buf + offset,
+						length) == expect,
+				   "offset %u length %u", offset, length);
+		}
+	}
+
+	return 0;
+}
+UNIT_TEST(add_sum_test_lengths, add_sum_test);
+
+static int do_ut_add_sum(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	uint i, seed = 0x5eed;
+	int ret;
+
+	test_buf = memalign(ARCH_DMA_MINALIGN, TEST_BUFFER_SIZE);
+	if (!test_buf) {
+		printf("ut_add_sum: out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+	for (i = 0; i < TEST_BUFFER_SIZE; i++) {
+		seed = seed * 1103515245 + 12345;
+		test_buf[i] = seed >> 16;
+	}
+
+#ifdef CONFIG_ARM
+	/* otherwise add_sum_neon() is the C version again */
+	printf("%s: neon %s\n", __func__,
+	       arm_neon_state == 0 ? "enabled" : "not available");
+#endif
+	ret = UNIT_TEST_SUITE_RUN(add_sum_test);
+	free(test_buf);
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	ut_add_sum,	1,	1,	do_ut_add_sum,
+	"Compare add_sum kernels with a byte-wise reference", ""
+);
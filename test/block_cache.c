@@ -0,0 +1,187 @@
+/*
+ * Block device read cache against a RAM backed device
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <part.h>
+#include <test/ut.h>
+
+#define TEST_BLKSZ	512
+#define TEST_BLOCKS	64
+
+static u8 *test_disk;
+static u8 *test_buf;
+static unsigned long test_reads;	/* block_read calls */
+
+static unsigned long test_block_read(int dev, lbaint_t start,
+				     lbaint_t blkcnt, void *buffer)
+{
+	test_reads++;
+	if (start + blkcnt > TEST_BLOCKS)
+		return 0;
+	memcpy(buffer, test_disk + start * TEST_BLKSZ, blkcnt * TEST_BLKSZ);
+
+	return blkcnt;
+}
+
+static unsigned long test_block_write(int dev, lbaint_t start,
+				      lbaint_t blkcnt, const void *buffer)
+{
+	if (start + blkcnt > TEST_BLOCKS)
+		return 0;
+	memcpy(test_disk + start * TEST_BLKSZ, buffer, blkcnt * TEST_BLKSZ);
+
+	return blkcnt;
+}
+
+static block_dev_desc_t test_dev = {
+	.if_type	= IF_TYPE_UNKNOWN,
+	.dev		= 0,
+	.lba		= TEST_BLOCKS,
+	.blksz		= TEST_BLKSZ,
+	.log2blksz	= 9,
+	.block_read	= test_block_read,
+	.block_write	= test_block_write,
+};
+
+/* each test starts with nothing cached and no reads counted */
+static void test_start(void)
+{
+	blkcache_invalidate(IF_TYPE_UNKNOWN, -1);
+	test_reads = 0;
+}
+
+/* read through the cache and compare with the backing store */
+static int test_read(lbaint_t start, lbaint_t blkcnt)
+{
+	if (block_dread(&test_dev, start, blkcnt, test_buf) != blkcnt)
+		return -1;
+
+	return memcmp(test_buf, test_disk + start * TEST_BLKSZ,
+		      blkcnt * TEST_BLKSZ);
+}
+
+/* a repeated read is served from the cache */
+static int block_cache_test_repeat(struct unit_test_state *uts)
+{
+	test_start();
+	ut_assertok(test_read(10, 2));
+	ut_assertok(test_read(10, 2));
+	ut_assertok(test_read(11, 1));
+	ut_asserteq(1, test_reads);
+
+	return 0;
+}
+UNIT_TEST(block_cache_test_repeat, block_cache_test);
+
+/* continuing the last read pulls in the read-ahead window */
+static int block_cache_test_read_ahead(struct unit_test_state *uts)
+{
+	lbaint_t i;
+
+	test_start();
+	ut_assertok(test_read(11, 1));
+	ut_assertok(test_read(12, 1));
+	ut_asserteq(2, test_reads);
+	for (i = 13; i < 17; i++)
+		ut_assertok(test_read(i, 1));
+	ut_asserteq(2, test_reads);
+
+	/* the window stops at the end of the device */
+	ut_assertok(test_read(TEST_BLOCKS - 3, 1));
+	ut_assertok(test_read(TEST_BLOCKS - 2, 1));
+	ut_assertok(test_read(TEST_BLOCKS - 1, 1));
+	ut_asserteq(4, test_reads);
+
+	return 0;
+}
+UNIT_TEST(block_cache_test_read_ahead, block_cache_test);
+
+/* long reads go straight to the device */
+static int block_cache_test_bypass(struct unit_test_state *uts)
+{
+	test_start();
+	ut_assertok(test_read(0, 8));
+	ut_assertok(test_read(0, 8));
+	ut_asserteq(2, test_reads);
+
+	return 0;
+}
+UNIT_TEST(block_cache_test_bypass, block_cache_test);
+
+/* a write drops what was cached */
+static int block_cache_test_write(struct unit_test_state *uts)
+{
+	test_start();
+	ut_assertok(test_read(20, 1));
+	memset(test_buf, 0xa5, TEST_BLKSZ);
+	ut_asserteq(1, block_dwrite(&test_dev, 20, 1, test_buf));
+	ut_assertok(test_read(20, 1));
+	ut_asserteq(2, test_reads);
+
+	return 0;
+}
+UNIT_TEST(block_cache_test_write, block_cache_test);
+
+/* random short reads, mostly for the replacement */
+static int block_cache_test_random(struct unit_test_state *uts)
+{
+	lbaint_t start, blkcnt;
+	uint i, seed = 0x5eed;
+
+	test_start();
+	for (i = 0; i < 1000; i++) {
+		seed = seed * 1103515245 + 12345;
+		start = (seed >> 16) % (TEST_BLOCKS - 4);
+		blkcnt = 1 + (seed >> 8) % 4;
+		ut_assertf(test_read(start, blkcnt) == 0,
+			   "read " LBAFU "+" LBAFU, start, blkcnt);
+	}
+
+	return 0;
+}
+UNIT_TEST(block_cache_test_random, block_cache_test);
+
+static int do_ut_block_cache(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	struct block_cache_stats saved;
+	uint i, seed = 0x5eed;
+	int ret;
+
+	test_disk = malloc(TEST_BLOCKS * TEST_BLKSZ);
+	test_buf = malloc(TEST_BLOCKS * TEST_BLKSZ);
+	if (!test_disk || !test_buf) {
+		printf("ut_block_cache: out of memory\n");
+		free(test_disk);
+		free(test_buf);
+		return CMD_RET_FAILURE;
+	}
+	for (i = 0; i < TEST_BLOCKS * TEST_BLKSZ; i++) {
+		seed = seed * 1103515245 + 12345;
+		test_disk[i] = seed >> 16;
+	}
+
+	blkcache_get_stats(&saved);
+	/* 4 sets of 2 ways, reads up to 4 blocks, 4 blocks read-ahead */
+	blkcache_configure(4, 2, 4, 4);
+
+	ret = UNIT_TEST_SUITE_RUN(block_cache_test);
+
+	blkcache_invalidate(IF_TYPE_UNKNOWN, -1);
+	blkcache_configure(saved.sets, saved.ways, saved.max_read,
+			   saved.window);
+	free(test_disk);
+	free(test_buf);
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	ut_block_cache,	1,	1,	do_ut_block_cache,
+	"Check the block device read cache", ""
+);
@@ -0,0 +1,134 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2016 Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+#
+# Check of tools/bootstage_report.py against a sample stash
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# To run this:
+#
+# ./test/bootstage/test-report.py
+#
+# The stash is built here the way bootstage_stash() lays it out on a
+# 32-bit little-endian board, with the boot0 marks that
+# CONFIG_BOOTSTAGE_UNSTASH takes over, initcall records and an
+# accumulated record.
+
+from __future__ import print_function
+
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+base_path = os.path.dirname(os.path.abspath(sys.argv[0]))
+report = os.path.join(base_path, '../../tools/bootstage_report.py')
+
+BOOTSTAGE_MAGIC = 0xb00757a3
+
+# (time_us, start_us, name, id), the ids do not matter to the tool
+SAMPLE = [
+    (1, 0, 'reset', 0),
+    (1000, 0, 'boot0', 200),
+    (51000, 0, 'dram_init', 201),
+    (81000, 0, 'toc1_load', 202),
+    (131000, 0, 'boot0_exit', 203),
+    (150000, 0, 'board_init_f', 154),
+    (200000, 0, 'board_init_r', 170),
+    (210000, 0, 'initcall 4a001234', 204),
+    (260000, 0, 'initcall 4a005678', 205),
+    (300000, 0, 'main_loop', 180),
+    (900000, 0, 'start_kernel', 185),
+    (250000, 1, 'sunxi_flash read 1048576 bytes', 206),
+]
+
+SYSTEM_MAP = '''\
+4a001234 T initr_sunxi_flash
+4a005678 t initr_display
+4a009999 D some_data
+'''
+
+
+def make_stash(fname, sample):
+    """Write a 32-bit little-endian stash of sample"""
+    recs = b''
+    names = b''
+    for time_us, start_us, name, rec_id in sample:
+        recs += struct.pack('<IIIii', time_us, start_us, 0, 0, rec_id)
+        names += name.encode('latin-1') + b'\0'
+    size = 16 + len(recs) + len(names)
+    hdr = struct.pack('<4I', 0, len(sample), size, BOOTSTAGE_MAGIC)
+    with open(fname, 'wb') as fd:
+        fd.write(hdr + recs + names)
+        # the stash area is bigger than what was written
+        fd.write(b'\xff' * 64)
+
+
+def run(args):
+    """Run the report tool, return its exit status and output"""
+    proc = subprocess.Popen([sys.executable, report] + args,
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    out = proc.communicate()[0].decode('latin-1')
+    return proc.returncode, out
+
+
+def check(name, cond, out):
+    if not cond:
+        print(out)
+        raise ValueError("Test '%s' failed" % name)
+    print('%s: ok' % name)
+
+
+def run_tests(tmpdir):
+    stash = os.path.join(tmpdir, 'stash.bin')
+    slower = os.path.join(tmpdir, 'slower.bin')
+    sysmap = os.path.join(tmpdir, 'System.map')
+    make_stash(stash, SAMPLE)
+    # the display initcall takes 50ms longer
+    make_stash(slower, [(t + 50000 if t > 260000 and not s else t, s, n, i)
+                        for t, s, n, i in SAMPLE])
+    with open(sysmap, 'w') as fd:
+        fd.write(SYSTEM_MAP)
+
+    ret, out = run(['-m', sysmap, stash])
+    check('table', ret == 0 and 'reset' not in out and
+          'initr_sunxi_flash' in out and 'initr_display' in out, out)
+    check('accumulated rate', '(4096 KiB/s)' in out, out)
+
+    ret, out = run(['-m', sysmap, '-f', stash])
+    check('folded', ret == 0 and 'boot0;dram_init 30000' in out.split('\n')
+          and 'board_init_r;initr_display 40000' in out.split('\n'), out)
+
+    ret, out = run(['-m', sysmap, '-c', stash])
+    lines = out.split('\n')
+    check('csv', ret == 0 and 'main_loop,300000,600000' in lines, out)
+    check('nesting', 'boot0;dram_init,51000,30000' in lines and
+          'board_init_r;initr_sunxi_flash,210000,50000' in lines, out)
+
+    ret, out = run(['-m', sysmap, '-b', stash, stash])
+    check('same as baseline', ret == 0, out)
+
+    ret, out = run(['-m', sysmap, '-b', stash, slower])
+    check('slower than baseline', ret == 1 and
+          'board_init_r;initr_display' in out and '<- slower' in out, out)
+
+    with open(stash, 'r+b') as fd:
+        fd.write(b'\0' * 16)
+    ret, out = run([stash])
+    check('no stash', ret != 0 and 'no bootstage stash' in out, out)
+
+
+def main():
+    tmpdir = tempfile.mkdtemp()
+    try:
+        run_tests(tmpdir)
+    finally:
+        shutil.rmtree(tmpdir)
+    print('\nTests passed')
+
+
+if __name__ == '__main__':
+    main()
@@ -19,6 +19,9 @@
 
 #include <linux/lzo.h>
 
+#include <decomp_stream.h>
+#include <image.h>
+
 static const char plain[] =
 	"I am a highly compressable bit of text.\n"
 	"I am a highly compressable bit of text.\n"
@@ -224,6 +227,56 @@ static int uncompress_using_lzo(void *in, unsigned long in_size,
 	return (ret != LZO_E_OK);
 }
 
+#ifdef CONFIG_DECOMP_STREAM
+/* feed the input in pieces this small, so every header straddles some */
+#define STREAM_PIECE		7
+
+static int uncompress_using_stream(int comp, void *in, unsigned long in_size,
+				   void *out, unsigned long out_max,
+				   unsigned long *out_size)
+{
+	struct decomp_stream *ds;
+	unsigned long done, n;
+	int ret = 0;
+
+	ds = decomp_stream_start(comp, out, out_max);
+	if (!ds)
+		return -1;
+	for (done = 0; done < in_size && !ret; done += n) {
+		n = min(in_size - done, (unsigned long)STREAM_PIECE);
+		ret = decomp_stream_write(ds, in + done, n);
+	}
+	if (decomp_stream_finish(ds, out_size))
+		ret = -1;
+
+	return ret;
+}
+
+static int uncompress_using_gzip_stream(void *in, unsigned long in_size,
+					void *out, unsigned long out_max,
+					unsigned long *out_size)
+{
+	return uncompress_using_stream(IH_COMP_GZIP, in, in_size, out,
+				       out_max, out_size);
+}
+
+static int uncompress_using_lzma_stream(void *in, unsigned long in_size,
+					void *out, unsigned long out_max,
+					unsigned long *out_size)
+{
+	return uncompress_using_stream(IH_COMP_LZMA, in, in_size, out,
+				       out_max, out_size);
+}
+
+static int uncompress_using_lzo_stream(void *in, unsigned long in_size,
+				       void *out, unsigned long out_max,
+				       unsigned long *out_size)
+{
+	return uncompress_using_stream(IH_COMP_LZO, in, in_size, out,
+				       out_max, out_size);
+}
+#endif
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -323,6 +376,14 @@ static int do_test_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 	err += run_test("bzip2", compress_using_bzip2, uncompress_using_bzip2);
 	err += run_test("lzma", compress_using_lzma, uncompress_using_lzma);
 	err += run_test("lzo", compress_using_lzo, uncompress_using_lzo);
+#ifdef CONFIG_DECOMP_STREAM
+	err += run_test("gzip stream", compress_using_gzip,
+			uncompress_using_gzip_stream);
+	err += run_test("lzma stream", compress_using_lzma,
+			uncompress_using_lzma_stream);
+	err += run_test("lzo stream", compress_using_lzo,
+			uncompress_using_lzo_stream);
+#endif
 
 	printf("test_compression %s\n", err == 0 ? "ok" : "FAILED");
 
@@ -0,0 +1,112 @@
+/*
+ * Boot-time jobs: inline without a second core (sandbox), through the
+ * ring and against the boot cpu on the same lock when there is one
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <cpu_job.h>
+#include <test/ut.h>
+
+#define TEST_JOBS	12	/* more than the ring holds */
+#define TEST_ADDS	20000	/* locked increments per job and by the boot cpu */
+
+static struct cpu_job_lock test_lock = CPU_JOB_LOCK_INIT;
+static volatile int test_runs;
+static volatile ulong test_count;
+static volatile int test_go;
+
+/* a read-modify-write that loses updates unless the lock is held */
+static void test_add(void)
+{
+	ulong count;
+
+	/* the lock nests */
+	cpu_job_lock(&test_lock);
+	cpu_job_lock(&test_lock);
+	count = test_count;
+	test_count = count + 1;
+	cpu_job_unlock(&test_lock);
+	cpu_job_unlock(&test_lock);
+}
+
+static int test_job(void *arg)
+{
+	int i;
+
+	/* the first job holds up the ring until the boot cpu has filled it */
+	if (arg == NULL) {
+		while (!test_go)
+			;
+	}
+	for (i = 0; i < TEST_ADDS; i++)
+		test_add();
+	cpu_job_lock(&test_lock);
+	test_runs++;
+	cpu_job_unlock(&test_lock);
+
+	return (int)(ulong)arg;
+}
+
+static int cpu_job_test_run(struct unit_test_state *uts)
+{
+	struct cpu_job job[TEST_JOBS];
+	int smp, i, j, early = -1, wrong = -1;
+
+	smp = (cpu_job_start() == 0);
+#ifdef CONFIG_SANDBOX
+	/* sandbox has no second core */
+	ut_assert(!smp);
+#endif
+	printf("%s: %s\n", __func__, smp ? "second core" : "inline");
+
+	test_runs = 0;
+	test_count = 0;
+	test_go = !smp;
+	for (i = 0; i < TEST_JOBS; i++) {
+		/* with the first job stuck, the jobs stay in the full ring */
+		if (smp && i == CPU_JOB_RING) {
+			for (j = 0; j < CPU_JOB_RING; j++) {
+				if (job[j].done && early < 0)
+					early = j;
+			}
+			test_go = 1;
+		}
+		cpu_job_submit(&job[i], "test", test_job, (void *)(ulong)i);
+		/* without a second core the job runs right away */
+		if (!smp && !job[i].done && early < 0)
+			early = i;
+	}
+	/* the boot cpu takes the lock while the jobs run */
+	for (i = 0; i < TEST_ADDS; i++)
+		test_add();
+	cpu_job_join();
+
+	for (i = 0; i < TEST_JOBS; i++) {
+		if (cpu_job_wait(&job[i]) != i && wrong < 0)
+			wrong = i;
+	}
+	cpu_job_stop();
+
+	ut_assertf(early < 0, "job %d ran %s", early,
+		   smp ? "early" : "late");
+	ut_assertf(wrong < 0, "job %d returned %d", wrong, job[wrong].ret);
+	ut_asserteq(TEST_JOBS, test_runs);
+	ut_asserteq((TEST_JOBS + 1) * TEST_ADDS, test_count);
+
+	return 0;
+}
+UNIT_TEST(cpu_job_test_run, cpu_job_test);
+
+static int do_ut_cpu_job(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	return UNIT_TEST_SUITE_RUN(cpu_job_test);
+}
+
+U_BOOT_CMD(
+	ut_cpu_job,	1,	1,	do_ut_cpu_job,
+	"Check the boot-time job runner", ""
+);
@@ -101,7 +101,7 @@ int dm_test_main(void)
 		ut_assertok(dm_test_destroy(dms));
 	}
 
-	printf("Failures: %d\n", dms->fail_count);
+	printf("Failures: %d\n", dms->uts.fail_count);
 
 	return 0;
 }
@@ -0,0 +1,194 @@
+/*
+ * Compare the CPU specific SHA-1/SHA-256/CRC32 kernels with the C ones
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <u-boot/crc.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <test/ut.h>
+#ifdef CONFIG_ARM
+#include <asm/armv7.h>
+#endif
+
+#define TEST_BUFFER_SIZE	4096
+#define TEST_MAX_BLOCKS		16
+
+static u8 *test_buf;
+
+/* the FIPS 180 examples, the message is hashed @repeat times in a row */
+static const struct {
+	const char *msg;
+	uint repeat;
+	u8 sha1[SHA1_SUM_LEN];
+	u8 sha256[SHA256_SUM_LEN];
+} sha_known[] = {
+	{
+		"abc", 1,
+		{ 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+		  0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d },
+		{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		  0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		  0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+	}, {
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+		{ 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae,
+		  0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1 },
+		{ 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+		  0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		  0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+		  0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+	}, {
+		/* one million 'a' */
+		"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 10000,
+		{ 0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4, 0xf6, 0x1e,
+		  0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31, 0x65, 0x34, 0x01, 0x6f },
+		{ 0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+		  0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+		  0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+		  0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0 },
+	},
+};
+
+static uint32_t crc32_reference(uint32_t crc, const u8 *buf, uint length)
+{
+	int bit;
+
+	while (length--) {
+		crc ^= *buf++;
+		for (bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+	}
+
+	return crc;
+}
+
+/* unaligned data, and runs of blocks as sha*_update() passes them */
+static int hash_accel_test_sha_blocks(struct unit_test_state *uts)
+{
+	sha1_context sha1_fast, sha1_ref;
+	sha256_context sha256_fast, sha256_ref;
+	uint offset, blocks;
+
+	for (offset = 0; offset < 8; offset++) {
+		for (blocks = 1; blocks <= TEST_MAX_BLOCKS; blocks++) {
+			sha1_starts(&sha1_fast);
+			sha1_starts(&sha1_ref);
+			sha1_blocks(&sha1_fast, test_buf + offset, blocks);
+			sha1_blocks_generic(&sha1_ref, test_buf + offset,
+					    blocks);
+			ut_assertf(!memcmp(sha1_fast.state, sha1_ref.state,
+					   sizeof(sha1_ref.state)),
+				   "sha1 offset %u blocks %u", offset, blocks);
+
+			sha256_starts(&sha256_fast);
+			sha256_starts(&sha256_ref);
+			sha256_blocks(&sha256_fast, test_buf + offset, blocks);
+			sha256_blocks_generic(&sha256_ref, test_buf + offset,
+					      blocks);
+			ut_assertf(!memcmp(sha256_fast.state, sha256_ref.state,
+					   sizeof(sha256_ref.state)),
+				   "sha256 offset %u blocks %u", offset,
+				   blocks);
+		}
+	}
+
+	return 0;
+}
+UNIT_TEST(hash_accel_test_sha_blocks, hash_accel_test);
+
+static int hash_accel_test_sha_known(struct unit_test_state *uts)
+{
+	sha1_context sha1;
+	sha256_context sha256;
+	u8 output[SHA256_SUM_LEN];
+	uint i, n, len;
+
+	for (i = 0; i < ARRAY_SIZE(sha_known); i++) {
+		len = strlen(sha_known[i].msg);
+
+		sha1_starts(&sha1);
+		sha256_starts(&sha256);
+		for (n = 0; n < sha_known[i].repeat; n++) {
+			sha1_update(&sha1, (const u8 *)sha_known[i].msg, len);
+			sha256_update(&sha256, (const u8 *)sha_known[i].msg,
+				      len);
+		}
+
+		sha1_finish(&sha1, output);
+		ut_assertf(!memcmp(output, sha_known[i].sha1, SHA1_SUM_LEN),
+			   "sha1 vector %u", i);
+		sha256_finish(&sha256, output);
+		ut_assertf(!memcmp(output, sha_known[i].sha256,
+				   SHA256_SUM_LEN),
+			   "sha256 vector %u", i);
+	}
+
+	return 0;
+}
+UNIT_TEST(hash_accel_test_sha_known, hash_accel_test);
+
+static int hash_accel_test_crc32(struct unit_test_state *uts)
+{
+	uint offset, length;
+	uint32_t expect;
+
+	/* the usual check value */
+	ut_asserteq(0xcbf43926, crc32(0, (const u8 *)"123456789", 9));
+
+	for (offset = 0; offset < 8; offset++) {
+		for (length = 0; offset + length < TEST_BUFFER_SIZE;
+		     length += (length < 300) ? 1 : 509) {
+			expect = crc32_reference(0x12345678, test_buf + offset,
+						 length);
+			ut_assertf(crc32_no_comp(0x12345678, test_buf + offset,
+						 length) == expect,
+				   "offset %u length %u", offset, length);
+			ut_assertf(crc32_no_comp_generic(0x12345678,
+							 test_buf + offset,
+							 length) == expect,
+				   "generic offset %u length %u", offset,
+				   length);
+		}
+	}
+
+	return 0;
+}
+UNIT_TEST(hash_accel_test_crc32, hash_accel_test);
+
+static int do_ut_hash_accel(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	uint i, seed = 0xc0ffee;
+	int ret;
+
+	test_buf = memalign(ARCH_DMA_MINALIGN, TEST_BUFFER_SIZE);
+	if (!test_buf) {
+		printf("ut_hash_accel: out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+	for (i = 0; i < TEST_BUFFER_SIZE; i++) {
+		seed = seed * 1103515245 + 12345;
+		test_buf[i] = seed >> 16;
+	}
+
+#ifdef CONFIG_ARM
+	/* without NEON the fast entry points run the C versions */
+	printf("%s: neon %s\n", __func__,
+	       arm_neon_state == 0 ? "enabled" : "not available");
+#endif
+	ret = UNIT_TEST_SUITE_RUN(hash_accel_test);
+	free(test_buf);
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	ut_hash_accel,	1,	1,	do_ut_hash_accel,
+	"Compare SHA-1/SHA-256/CRC32 kernels with the C versions", ""
+);
@@ -0,0 +1,120 @@
+/*
+ * I/O buffer pool and malloc statistics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/ut.h>
+
+#define TEST_BUFFERS	4
+
+/* start from an empty pool, with @before the counts at that point */
+static void test_pool_start(struct malloc_pool_info *before)
+{
+	malloc_pool_release();
+	malloc_pool_get_info(before);
+}
+
+/* 1M..4M and then 5M buffers, all of them idle in the pool afterwards */
+static int test_pool_fill(void *buf[])
+{
+	void *p;
+	int i;
+
+	for (i = 0; i < TEST_BUFFERS; i++) {
+		buf[i] = malloc_pool((i + 1) << 20);
+		if (!buf[i])
+			return -1;
+		memset(buf[i], i, (i + 1) << 20);
+	}
+	for (i = 0; i < TEST_BUFFERS; i++)
+		free_pool(buf[i]);
+	p = malloc_pool(5 << 20);
+	free_pool(p);
+
+	return p ? 0 : -1;
+}
+
+/* buffers are aligned, and the smallest big enough idle one is reused */
+static int malloc_pool_test_reuse(struct unit_test_state *uts)
+{
+	struct malloc_pool_info before, after;
+	void *buf[TEST_BUFFERS];
+	void *p;
+	int i;
+
+	test_pool_start(&before);
+	ut_assertok(test_pool_fill(buf));
+	for (i = 0; i < TEST_BUFFERS; i++)
+		ut_assert(!((ulong)buf[i] & (ARCH_DMA_MINALIGN - 1)));
+
+	/* the smallest idle buffer that is big enough comes back */
+	p = malloc_pool((3 << 20) - 100);
+	free_pool(p);
+	ut_asserteq_ptr(buf[2], p);
+	p = malloc_pool(1);
+	free_pool(p);
+	ut_asserteq_ptr(buf[0], p);
+
+	malloc_pool_get_info(&after);
+	ut_asserteq(5, after.allocated - before.allocated);
+	ut_asserteq(2, after.reused - before.reused);
+	ut_asserteq(before.slabs + 5, after.slabs);
+	ut_asserteq(0, after.busy);
+	ut_asserteq(before.bytes + (15 << 20), after.bytes);
+
+	return 0;
+}
+UNIT_TEST(malloc_pool_test_reuse, malloc_pool_test);
+
+/* malloc() takes the idle buffers back rather than fail */
+static int malloc_pool_test_release(struct unit_test_state *uts)
+{
+	struct malloc_pool_info before, after;
+	struct malloc_stats_info stats;
+	void *buf[TEST_BUFFERS];
+	void *p;
+
+	test_pool_start(&before);
+	ut_assertok(test_pool_fill(buf));
+	malloc_get_stats(&stats);
+	p = malloc(stats.largest_free + (1 << 20));
+	free(p);
+	ut_assert(p != NULL);
+	malloc_pool_get_info(&after);
+	ut_asserteq(before.slabs, after.slabs);
+	ut_asserteq(0, after.busy);
+
+	malloc_pool_release();
+	malloc_pool_get_info(&after);
+	ut_asserteq(before.slabs, after.slabs);
+	ut_asserteq(before.bytes, after.bytes);
+
+	/* the pool buffers are back in the heap as one free block */
+	malloc_get_stats(&stats);
+	ut_assert(stats.largest_free >= (5 << 20));
+	ut_assert(stats.free <= stats.heap_size);
+	ut_assert(stats.mallocs && stats.frees);
+
+	return 0;
+}
+UNIT_TEST(malloc_pool_test_release, malloc_pool_test);
+
+static int do_ut_malloc_pool(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	int ret;
+
+	ret = UNIT_TEST_SUITE_RUN(malloc_pool_test);
+	malloc_pool_release();
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	ut_malloc_pool,	1,	1,	do_ut_malloc_pool,
+	"Check the I/O buffer pool and malloc statistics", ""
+);
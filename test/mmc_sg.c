@@ -0,0 +1,101 @@
+/*
+ * Read an MMC range through mmc_bread_sg() and compare it with a plain
+ * mmc_bread() of the same blocks.  The card is only read.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <test/ut.h>
+
+/* odd piece sizes, so no piece ends on a descriptor or cache boundary */
+static const uint test_sg_blocks[] = { 1, 7, 64, 3, 181, 2, 254 };
+
+#define TEST_SG_PIECES	ARRAY_SIZE(test_sg_blocks)
+
+static struct mmc *test_mmc;
+static int test_dev;
+static lbaint_t test_start;
+
+static int mmc_sg_test_read(struct unit_test_state *uts)
+{
+	struct mmc_sg sg[TEST_SG_PIECES];
+	u8 *ref;
+	uint i, total = 0, bl_len = test_mmc->read_bl_len;
+	ulong offset;
+	int ret = -1;
+
+	for (i = 0; i < TEST_SG_PIECES; i++)
+		total += test_sg_blocks[i];
+
+	memset(sg, 0, sizeof(sg));
+	ref = memalign(ARCH_DMA_MINALIGN, total * bl_len);
+	for (i = 0; ref && i < TEST_SG_PIECES; i++) {
+		sg[i].blocks = test_sg_blocks[i];
+		sg[i].buf = memalign(ARCH_DMA_MINALIGN, sg[i].blocks * bl_len);
+		if (!sg[i].buf)
+			break;
+		/* dirty cache lines that must not survive the dma */
+		memset(sg[i].buf, 0xa5, sg[i].blocks * bl_len);
+	}
+	if (!ref || i < TEST_SG_PIECES) {
+		ut_fail(uts, __FILE__, __LINE__, __func__, "out of memory");
+		goto out;
+	}
+
+	if (mmc_bread(test_dev, test_start, total, ref) != total) {
+		ut_fail(uts, __FILE__, __LINE__, __func__, "plain read");
+		goto out;
+	}
+	if (mmc_bread_sg(test_dev, test_start, sg, TEST_SG_PIECES) != total) {
+		ut_fail(uts, __FILE__, __LINE__, __func__, "sg read");
+		goto out;
+	}
+
+	for (i = 0, offset = 0; i < TEST_SG_PIECES; i++) {
+		if (memcmp(sg[i].buf, ref + offset, sg[i].blocks * bl_len)) {
+			ut_failf(uts, __FILE__, __LINE__, __func__, "compare",
+				 "piece %u (%u blocks at +%lu)", i,
+				 sg[i].blocks, offset / bl_len);
+			goto out;
+		}
+		offset += sg[i].blocks * bl_len;
+	}
+	ret = 0;
+
+out:
+	for (i = 0; i < TEST_SG_PIECES; i++)
+		free(sg[i].buf);
+	free(ref);
+
+	return ret;
+}
+UNIT_TEST(mmc_sg_test_read, mmc_sg_test);
+
+static int do_ut_mmc_sg(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	if (argc != 3)
+		return CMD_RET_USAGE;
+	test_dev = simple_strtoul(argv[1], NULL, 10);
+	test_start = simple_strtoul(argv[2], NULL, 16);
+
+	test_mmc = find_mmc_device(test_dev);
+	if (!test_mmc || mmc_init(test_mmc)) {
+		printf("ut_mmc_sg: no mmc %d\n", test_dev);
+		return CMD_RET_FAILURE;
+	}
+	printf("%s: %s host sg\n", __func__,
+	       (test_mmc->cfg->host_caps & MMC_MODE_SG) ? "with" : "without");
+
+	return UNIT_TEST_SUITE_RUN(mmc_sg_test);
+}
+
+U_BOOT_CMD(
+	ut_mmc_sg,	3,	1,	do_ut_mmc_sg,
+	"Compare an MMC scatter-gather read with a plain one",
+	"<dev> <start block, hex>"
+);
@@ -0,0 +1,300 @@
+/*
+ * Known answers for the AES modes of the security system (sunxi_aes_*)
+ *
+ * Every vector is run on a cache line aligned buffer, which the SS reads
+ * directly, and on a misaligned one, which goes through the bounce
+ * buffer.  The data is fed in two updates so the IV, counter and tweak
+ * carried in the context are checked as well.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <aes.h>
+#include <hw_aes.h>
+#include <asm/arch/ss.h>
+#include <test/ut.h>
+
+#define TEST_AES_MAX	512
+
+static u8 *test_buf;
+
+static const u8 key_fips197[32] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+	0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+};
+
+static const u8 pt_fips197[16] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+	0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+};
+
+static const u8 ct_fips197_128[16] = {
+	0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+	0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a,
+};
+
+static const u8 ct_fips197_256[16] = {
+	0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+	0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89,
+};
+
+/* SP 800-38A */
+static const u8 key_sp800[16] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+	0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+static const u8 pt_sp800[64] = {
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+	0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+	0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+	0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+	0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+	0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+	0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+
+static const u8 iv_sp800_cbc[16] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static const u8 ct_sp800_cbc[64] = {
+	0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+	0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+	0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+	0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+	0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b,
+	0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+	0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09,
+	0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+};
+
+/* the 128 bit counter wraps to zero after the second block */
+static const u8 iv_ctr_wrap[16] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+};
+
+static const u8 ct_ctr_wrap[64] = {
+	0xba, 0x76, 0xaa, 0x54, 0xd5, 0xb5, 0x60, 0x67,
+	0xc1, 0xa7, 0x90, 0x3b, 0x3f, 0xdd, 0xfa, 0x89,
+	0x24, 0xdf, 0x0c, 0x56, 0x5c, 0xf4, 0x2a, 0x68,
+	0x97, 0x87, 0x13, 0xb6, 0x7a, 0xd1, 0x24, 0xfd,
+	0x4d, 0x3f, 0x77, 0x4a, 0xb9, 0xe4, 0x7d, 0xa2,
+	0xdb, 0xb9, 0x31, 0x5e, 0xa3, 0x11, 0x06, 0x80,
+	0xa1, 0x8d, 0x59, 0x05, 0xeb, 0xfe, 0x25, 0xa8,
+	0x03, 0xdf, 0x27, 0xc2, 0x21, 0x1e, 0x58, 0xd6,
+};
+
+/* IEEE 1619 vector 2: data unit 0x3333333333 */
+static const u8 key_xts_2[32] = {
+	0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+	0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22, 0x22,
+};
+
+static const u8 iv_xts_2[16] = {
+	0x33, 0x33, 0x33, 0x33, 0x33,
+};
+
+static const u8 pt_xts_2[32] = {
+	0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+	0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+	0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+	0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44,
+};
+
+static const u8 ct_xts_2[32] = {
+	0xc4, 0x54, 0x18, 0x5e, 0x6a, 0x16, 0x93, 0x6e,
+	0x39, 0x33, 0x40, 0x38, 0xac, 0xef, 0x83, 0x8b,
+	0xfb, 0x18, 0x6f, 0xff, 0x74, 0x80, 0xad, 0xc4,
+	0x28, 0x93, 0x82, 0xec, 0xd6, 0xd3, 0x94, 0xf0,
+};
+
+/*
+ * IEEE 1619 vector 4: a 512 byte sector of 00..ff twice, data unit 0.
+ * Only the first and the last ciphertext block are kept, the last one
+ * has the tweak multiplied by alpha 31 times.
+ */
+static const u8 key_xts_4[32] = {
+	0x27, 0x18, 0x28, 0x18, 0x28, 0x45, 0x90, 0x45,
+	0x23, 0x53, 0x60, 0x28, 0x74, 0x71, 0x35, 0x26,
+	0x31, 0x41, 0x59, 0x26, 0x53, 0x58, 0x97, 0x93,
+	0x23, 0x84, 0x62, 0x64, 0x33, 0x83, 0x27, 0x95,
+};
+
+static const u8 ct_xts_4_first[16] = {
+	0x27, 0xa7, 0x47, 0x9b, 0xef, 0xa1, 0xd4, 0x76,
+	0x48, 0x9f, 0x30, 0x8c, 0xd4, 0xcf, 0xa6, 0xe2,
+};
+
+static const u8 ct_xts_4_last[16] = {
+	0x0a, 0x28, 0x2d, 0xf9, 0x20, 0x14, 0x7b, 0xea,
+	0xbe, 0x42, 0x1e, 0xe5, 0x31, 0x9d, 0x05, 0x68,
+};
+
+static const struct {
+	const char *name;
+	int mode;
+	const u8 *key;
+	u32 key_len;
+	const u8 *iv;
+	const u8 *pt;
+	const u8 *ct;
+	u32 len;
+	u32 first;	/* bytes of the first update */
+} aes_known[] = {
+	{ "ecb-128", SS_AES_MODE_ECB, key_fips197, 16, NULL,
+	  pt_fips197, ct_fips197_128, 16, 16 },
+	{ "ecb-256", SS_AES_MODE_ECB, key_fips197, 32, NULL,
+	  pt_fips197, ct_fips197_256, 16, 16 },
+	{ "cbc", SS_AES_MODE_CBC, key_sp800, 16, iv_sp800_cbc,
+	  pt_sp800, ct_sp800_cbc, 64, 16 },
+	{ "ctr wrap", SS_AES_MODE_CTR, key_sp800, 16, iv_ctr_wrap,
+	  pt_sp800, ct_ctr_wrap, 64, 16 },
+	{ "xts", SS_AES_MODE_XTS, key_xts_2, 32, iv_xts_2,
+	  pt_xts_2, ct_xts_2, 32, 16 },
+};
+
+/* run @len bytes of @src through a fresh context in two updates */
+static int test_aes_run(int mode, int decrypt, const u8 *key, u32 key_len,
+			const u8 *iv, const u8 *src, u8 *dst, u32 len,
+			u32 first)
+{
+	sunxi_aes_ctx_t ctx;
+
+	if (sunxi_aes_init(&ctx, mode, decrypt, key, key_len, iv))
+		return -1;
+	if (sunxi_aes_update(&ctx, src, dst, first))
+		return -1;
+
+	return sunxi_aes_update(&ctx, src + first, dst + first, len - first);
+}
+
+/* offset 0 is cache line aligned, 4 goes through the bounce buffer */
+static int ss_aes_test_known(struct unit_test_state *uts)
+{
+	uint i, offset;
+	u8 *data;
+
+	for (offset = 0; offset <= 4; offset += 4) {
+		data = test_buf + offset;
+		for (i = 0; i < ARRAY_SIZE(aes_known); i++) {
+			memcpy(data, aes_known[i].pt, aes_known[i].len);
+			ut_assertf(!test_aes_run(aes_known[i].mode,
+						 SS_AES_ENCRYPT,
+						 aes_known[i].key,
+						 aes_known[i].key_len,
+						 aes_known[i].iv, data, data,
+						 aes_known[i].len,
+						 aes_known[i].first) &&
+				   !memcmp(data, aes_known[i].ct,
+					   aes_known[i].len),
+				   "%s encrypt offset %u", aes_known[i].name,
+				   offset);
+
+			memcpy(data, aes_known[i].ct, aes_known[i].len);
+			ut_assertf(!test_aes_run(aes_known[i].mode,
+						 SS_AES_DECRYPT,
+						 aes_known[i].key,
+						 aes_known[i].key_len,
+						 aes_known[i].iv, data, data,
+						 aes_known[i].len,
+						 aes_known[i].first) &&
+				   !memcmp(data, aes_known[i].pt,
+					   aes_known[i].len),
+				   "%s decrypt offset %u", aes_known[i].name,
+				   offset);
+		}
+	}
+
+	return 0;
+}
+UNIT_TEST(ss_aes_test_known, ss_aes_test);
+
+/* a whole sector, the tweak carried over three updates */
+static int ss_aes_test_xts_sector(struct unit_test_state *uts)
+{
+	u8 iv[SS_AES_BLOCK_SIZE];
+	u8 *ct = test_buf + TEST_AES_MAX;
+	sunxi_aes_ctx_t ctx;
+	uint i;
+
+	for (i = 0; i < TEST_AES_MAX; i++)
+		test_buf[i] = i;
+	memset(iv, 0, sizeof(iv));
+
+	ut_assertok(sunxi_aes_init(&ctx, SS_AES_MODE_XTS, SS_AES_ENCRYPT,
+				   key_xts_4, 32, iv));
+	ut_assertok(sunxi_aes_update(&ctx, test_buf, ct, 16));
+	ut_assertok(sunxi_aes_update(&ctx, test_buf + 16, ct + 16, 240));
+	ut_assertok(sunxi_aes_update(&ctx, test_buf + 256, ct + 256, 256));
+	ut_assert(!memcmp(ct, ct_xts_4_first, 16));
+	ut_assert(!memcmp(ct + TEST_AES_MAX - 16, ct_xts_4_last, 16));
+
+	ut_assertok(test_aes_run(SS_AES_MODE_XTS, SS_AES_DECRYPT, key_xts_4,
+				 32, iv, ct, ct, TEST_AES_MAX, 64));
+	for (i = 0; i < TEST_AES_MAX; i++)
+		ut_assertf(ct[i] == (u8)i, "decrypt differs at %u", i);
+
+	return 0;
+}
+UNIT_TEST(ss_aes_test_xts_sector, ss_aes_test);
+
+#ifdef CONFIG_AES_HW_ACCEL
+/* lib/aes.c on the SS against the software rounds, zero IV */
+static int ss_aes_test_cbc_accel(struct unit_test_state *uts)
+{
+	u8 key_exp[AES_EXPAND_KEY_LENGTH];
+	u8 chain[AES_BLOCK_LENGTH];
+	u8 expect[sizeof(pt_sp800)];
+	uint i, j;
+
+	aes_expand_key((u8 *)key_sp800, key_exp);
+	memset(chain, 0, sizeof(chain));
+	for (i = 0; i < sizeof(pt_sp800); i += AES_BLOCK_LENGTH) {
+		for (j = 0; j < AES_BLOCK_LENGTH; j++)
+			chain[j] ^= pt_sp800[i + j];
+		aes_encrypt(chain, key_exp, expect + i);
+		memcpy(chain, expect + i, AES_BLOCK_LENGTH);
+	}
+
+	memcpy(test_buf, pt_sp800, sizeof(pt_sp800));
+	ut_assertok(hw_aes_cbc_crypt(key_exp, test_buf, test_buf,
+				     sizeof(pt_sp800) / AES_BLOCK_LENGTH, 1));
+	ut_assert(!memcmp(test_buf, expect, sizeof(expect)));
+
+	return 0;
+}
+UNIT_TEST(ss_aes_test_cbc_accel, ss_aes_test);
+#endif
+
+static int do_ut_ss_aes(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	int ret;
+
+	test_buf = memalign(ARCH_DMA_MINALIGN, 2 * TEST_AES_MAX);
+	if (!test_buf) {
+		printf("ut_ss_aes: out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+	ret = UNIT_TEST_SUITE_RUN(ss_aes_test);
+	free(test_buf);
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	ut_ss_aes,	1,	1,	do_ut_ss_aes,
+	"Check the AES modes of the security system with known answers",
+	""
+);
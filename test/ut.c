@@ -0,0 +1,47 @@
+/*
+ * Simple unit test library
+ *
+ * Copyright (c) 2013 Google, Inc
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <test/test.h>
+
+void ut_fail(struct unit_test_state *uts, const char *fname, int line,
+	     const char *func, const char *cond)
+{
+	printf("%s:%d, %s(): %s\n", fname, line, func, cond);
+	uts->fail_count++;
+}
+
+void ut_failf(struct unit_test_state *uts, const char *fname, int line,
+	      const char *func, const char *cond, const char *fmt, ...)
+{
+	va_list args;
+
+	printf("%s:%d, %s(): %s: ", fname, line, func, cond);
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+	putc('\n');
+	uts->fail_count++;
+}
+
+int ut_run_list(const char *category, struct unit_test *tests, int count)
+{
+	struct unit_test_state uts;
+	struct unit_test *test;
+
+	memset(&uts, '\0', sizeof(uts));
+	printf("Running %d %s tests\n", count, category);
+	for (test = tests; test < tests + count; test++) {
+		printf("Test: %s\n", test->name);
+		test->func(&uts);
+	}
+	printf("Failures: %d\n", uts.fail_count);
+
+	return uts.fail_count ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
@@ -0,0 +1,261 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2016 Allwinner Technology Co., Ltd. <www.allwinnertech.com>
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+
+"""Turn a bootstage stash into a boot timeline
+
+The input is the memory written by 'bootstage stash' (or by boot0, see
+CONFIG_BOOTSTAGE_UNSTASH in the README), saved to a file.  Each mark
+lasts until the next one.  Marks are nested for the report: the boot0
+steps under 'boot0' and the 'initcall <address>' records under
+'board_init_r', with the address looked up in System.map when one is
+given.
+
+Output is a table with a bar per stage (the default), the folded stacks
+that flamegraph.pl takes (-f, use its --flamechart option to keep the
+time order) or CSV (-c).  With -b the durations are compared with a
+baseline stash instead and the exit status is 1 if a stage got slower by
+more than the threshold, for use in a CI job:
+
+    ./u-boot -c "bootstage stash; sb save hostfs - stash.bin 200000 4000"
+    tools/bootstage_report.py -m System.map -b baseline.bin stash.bin
+"""
+
+from __future__ import print_function
+
+from optparse import OptionParser
+import re
+import struct
+import sys
+
+BOOTSTAGE_MAGIC = 0xb00757a3
+BOOTSTAGE_VERSION = 0
+
+# struct bootstage_record on 32-bit and 64-bit targets
+LAYOUTS = {
+    32: 'IIIii',
+    64: 'QI4xQii',
+}
+
+# boot0 marks, see sunxi_spl/boot0/main/boot0_main.c
+BOOT0_STEPS = ('dram_init', 'toc1_load', 'boot0_exit')
+
+BAR_WIDTH = 40
+
+
+class Record(object):
+    def __init__(self, time_us, start_us, name, flags, rec_id):
+        self.time_us = time_us
+        self.start_us = start_us
+        self.name = name
+        self.flags = flags
+        self.id = rec_id
+        self.path = [name]
+        self.duration = 0
+
+    def is_accum(self):
+        return self.start_us != 0
+
+
+def parse_names(data, offset, end, count):
+    """Return the count nul-terminated strings from offset, or None"""
+    names = []
+    for _ in range(count):
+        nul = data.find(b'\0', offset, end)
+        if nul < 0:
+            return None
+        names.append(data[offset:nul].decode('latin-1'))
+        offset = nul + 1
+    if offset != end:
+        return None
+    return names
+
+
+def read_stash(fname, word_size=None):
+    """Read a stash file and return its records"""
+    with open(fname, 'rb') as fd:
+        data = fd.read()
+    for endian in '<>':
+        version, count, size, magic = struct.unpack(endian + '4I',
+                                                    data[:16])
+        if magic == BOOTSTAGE_MAGIC:
+            break
+    else:
+        raise ValueError('%s: no bootstage stash' % fname)
+    if version != BOOTSTAGE_VERSION:
+        raise ValueError('%s: version %d unknown' % (fname, version))
+    if size > len(data):
+        raise ValueError('%s: stash of %d bytes is cut short at %d' %
+                         (fname, size, len(data)))
+
+    sizes = [word_size] if word_size else sorted(LAYOUTS)
+    for bits in sizes:
+        fmt = endian + LAYOUTS[bits]
+        rec_size = struct.calcsize(fmt)
+        names = parse_names(data, 16 + count * rec_size, size, count)
+        if names is not None:
+            break
+    else:
+        raise ValueError('%s: record layout not recognised' % fname)
+
+    records = []
+    for i in range(count):
+        time_us, start_us, _, flags, rec_id = struct.unpack_from(
+            fmt, data, 16 + i * rec_size)
+        # record[0] keeps a placeholder time of 1 in U-Boot
+        if rec_id == 0 and time_us <= 1 and not start_us:
+            continue
+        records.append(Record(time_us, start_us, names[i], flags, rec_id))
+    return records
+
+
+def read_map(fname):
+    """Return a dict of address to symbol from System.map"""
+    syms = {}
+    with open(fname) as fd:
+        for line in fd:
+            fields = line.split()
+            if len(fields) == 3 and fields[1] in 'Tt':
+                syms[int(fields[0], 16)] = fields[2]
+    return syms
+
+
+def nest(records, syms):
+    """Work out the stack of each mark and how long it lasts"""
+    marks = sorted([r for r in records if not r.is_accum()],
+                   key=lambda r: r.time_us)
+    for rec in marks:
+        m = re.match(r'initcall ([0-9a-f]+)$', rec.name)
+        if m:
+            addr = int(m.group(1), 16)
+            func = syms.get(addr, syms.get(addr & ~1, rec.name))
+            rec.path = ['board_init_r', func]
+        elif rec.name in BOOT0_STEPS:
+            rec.path = ['boot0', rec.name]
+    for rec, nxt in zip(marks, marks[1:]):
+        rec.duration = nxt.time_us - rec.time_us
+    return marks
+
+
+def stage_times(marks):
+    """Total duration of each stack, in order of first appearance"""
+    order = []
+    times = {}
+    for rec in marks:
+        key = ';'.join(rec.path)
+        if key not in times:
+            order.append(key)
+            times[key] = 0
+        times[key] += rec.duration
+    return order, times
+
+
+def show_table(marks, accums):
+    total = sum(r.duration for r in marks) or 1
+    print('%11s %11s  %-*s  %s' % ('Mark', 'Elapsed', BAR_WIDTH, '', 'Stage'))
+    for rec in marks:
+        bar = '#' * int(round(rec.duration * BAR_WIDTH / float(total)))
+        print('%11d %11d  %-*s  %s%s' % (rec.time_us, rec.duration,
+                                         BAR_WIDTH, bar,
+                                         '  ' * (len(rec.path) - 1),
+                                         rec.path[-1]))
+    if accums:
+        print('\nAccumulated time:')
+        for rec in accums:
+            line = '%11s %11d  %s' % ('', rec.time_us, rec.name)
+            m = re.search(r'(\d+) bytes', rec.name)
+            if m and rec.time_us:
+                line += ' (%d KiB/s)' % (int(m.group(1)) * 1000000 //
+                                         1024 // rec.time_us)
+            print(line)
+
+
+def show_folded(marks):
+    order, times = stage_times(marks)
+    for key in order:
+        if times[key]:
+            print('%s %d' % (key, times[key]))
+
+
+def show_csv(marks, accums):
+    print('stage,mark_us,elapsed_us')
+    for rec in marks:
+        print('%s,%d,%d' % (';'.join(rec.path), rec.time_us, rec.duration))
+    for rec in accums:
+        print('%s,,%d' % (rec.name, rec.time_us))
+
+
+def compare(marks, base_marks, threshold, min_us):
+    """Print the stages that changed, return True if one got too slow"""
+    order, times = stage_times(marks)
+    _, base = stage_times(base_marks)
+    slower = False
+    print('%11s %11s %8s  %s' % ('Base', 'Now', 'Change', 'Stage'))
+    for key in order:
+        now = times[key]
+        was = base.get(key)
+        if was is None:
+            print('%11s %11d %8s  %s' % ('-', now, 'new', key))
+            continue
+        change = (now - was) * 100.0 / was if was else 0.0
+        flag = ''
+        if now - was > min_us and change > threshold:
+            flag = '  <- slower'
+            slower = True
+        if abs(now - was) > min_us or flag:
+            print('%11d %11d %+7.1f%%  %s%s' % (was, now, change, key, flag))
+    total, base_total = sum(times.values()), sum(base.values())
+    print('%11d %11d %+7.1f%%  total' % (base_total, total,
+          (total - base_total) * 100.0 / (base_total or 1)))
+    return slower
+
+
+def main():
+    parser = OptionParser(usage='%prog [options] <stash file>')
+    parser.add_option('-m', '--map', dest='map',
+                      help='System.map to name the initcalls')
+    parser.add_option('-f', '--folded', action='store_true',
+                      help='print folded stacks for flamegraph.pl')
+    parser.add_option('-c', '--csv', action='store_true',
+                      help='print the stages as CSV')
+    parser.add_option('-b', '--baseline', dest='baseline',
+                      help='compare with this stash')
+    parser.add_option('-t', '--threshold', type='float', default=10.0,
+                      help='percentage a stage may grow (default %default)')
+    parser.add_option('--min-us', type='int', default=1000,
+                      help='ignore changes up to this many us '
+                      '(default %default)')
+    parser.add_option('-w', '--word-size', type='int',
+                      help='32 or 64, guessed by default')
+    (options, args) = parser.parse_args()
+    if len(args) != 1:
+        parser.error('need one stash file')
+
+    try:
+        records = read_stash(args[0], options.word_size)
+        base = None
+        if options.baseline:
+            base = read_stash(options.baseline, options.word_size)
+    except (IOError, ValueError) as err:
+        sys.exit(str(err))
+    syms = read_map(options.map) if options.map else {}
+    marks = nest(records, syms)
+    accums = [r for r in records if r.is_accum()]
+
+    if base is not None:
+        return 1 if compare(marks, nest(base, syms), options.threshold,
+                            options.min_us) else 0
+    if options.folded:
+        show_folded(marks)
+    elif options.csv:
+        show_csv(marks, accums)
+    else:
+        show_table(marks, accums)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -25,95 +25,90 @@
 #include "buf_queue.h"
 #include <malloc.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 //extern __u32 NAND_GetPageSize(void);
 extern __u32 NAND_GetLogicPageSize(void);
 
+#define BUF_QUEUE_MIN_LEN       16
+#define BUF_QUEUE_MAX_BYTES     (32 << 20)
 
-int                buf_queue_init_flag = 0;
-int                buf_queue_max_len  = 80;
-int                buf_queue_page_size = 8*1024;
-int                buf_queue_current_len = 0;
-u8*                buf_queue_base_buf = NULL;
 
-buf_node_t *       buf_queue_head = NULL;
-buf_node_t *       buf_queue_tail = NULL;
+static int          buf_queue_init_flag = 0;
+static buf_queue_t  buf_queue;
 
+//round down to a power of 2
+static uint buf_queue_pow2(uint n)
+{
+    uint len = 1;
 
+    while(len <= n/2)
+    {
+        len <<= 1;
+    }
+
+    return len;
+}
 
 int buf_queue_init(void)
 {
-    int i = 0;
+    uint i;
+    uint ring_bytes;
 
     if(buf_queue_init_flag)
     {
         printf("sunxi efex queue error: already init\n");
         return -1;
     }
-    
-    //init queue page size and max len by storage type
+
+    //init queue page size by storage type
     int storage_type = uboot_spare_head.boot_data.storage_type;
     if(storage_type == 0)
     {
-        buf_queue_page_size = NAND_GetLogicPageSize();
-        buf_queue_max_len = 80;
+        buf_queue.page_size = NAND_GetLogicPageSize();
     }
     else
     {
-        buf_queue_page_size = 64*1024;
-        buf_queue_max_len = 20;
+        buf_queue.page_size = 64*1024;
     }
-    printf("buf queue page size = %d\n", buf_queue_page_size);
 
-    buf_queue_base_buf = NULL;
-    buf_queue_head = buf_queue_tail = NULL;
+    //ring size follows the dram: 1/32 of it, at most 32M
+    ring_bytes = min((uint)(gd->ram_size/32), (uint)BUF_QUEUE_MAX_BYTES);
+    buf_queue.max_len = buf_queue_pow2(max(ring_bytes/buf_queue.page_size, (uint)BUF_QUEUE_MIN_LEN));
 
-    //malloc queue base buff
-    buf_queue_base_buf = ( u8*) malloc(buf_queue_page_size*buf_queue_max_len);
-    if(buf_queue_base_buf == NULL) 
+    buf_queue.element = (buf_element_t*) malloc(buf_queue.max_len * sizeof(buf_element_t));
+    buf_queue.base_buf = NULL;
+    while(buf_queue.element != NULL)
     {
-        printf("sunxi usb efex queue error: malloc memory fail size 0x%x\n",
-            buf_queue_page_size*buf_queue_max_len);
-        return -1;
-    }
-
-    //create cycle queue
-    buf_element_t element;
-    memset(&element, 0 , sizeof(element));
-    for(i = 0; i < buf_queue_max_len ; i++)
-    {
-        //malloc page memory from queue base_buf
-        element.buff = buf_queue_base_buf+i*buf_queue_page_size ;
-  
-        //malloc node memory
-        buf_node_t *node = ( buf_node_t*) malloc(sizeof(buf_node_t));
-        if(node == NULL) 
+        buf_queue.base_buf = (u8*) malloc_pool(buf_queue.page_size*buf_queue.max_len);
+        if((buf_queue.base_buf != NULL) || (buf_queue.max_len == BUF_QUEUE_MIN_LEN))
         {
-             printf("sunxi usb efex queue error: malloc memory fail size 0x%zu\n",sizeof(buf_node_t));
-            return -1;
+            break;
         }
-        node->element= element;
-        node->next = NULL;
-        
-        if(buf_queue_tail == NULL)
-        {
-            //queue is empty
-            buf_queue_head = buf_queue_tail = node ;
-        }
-        else
+        //not that much malloc space, try a smaller ring
+        buf_queue.max_len >>= 1;
+    }
+    if(buf_queue.base_buf == NULL)
+    {
+        printf("sunxi usb efex queue error: malloc memory fail size 0x%x\n",
+            buf_queue.page_size*buf_queue.max_len);
+        if(buf_queue.element)
         {
-            buf_queue_tail->next = node;
-            buf_queue_tail = buf_queue_tail->next;
+            free(buf_queue.element);
+            buf_queue.element = NULL;
         }
+        return -1;
     }
+    printf("buf queue page size = %d, pages = %d\n", buf_queue.page_size, buf_queue.max_len);
 
-    //set cycle queue 
-    buf_queue_tail->next = buf_queue_head;
-    
-    //set head and tail point to the same node when begin
-    buf_queue_head = buf_queue_tail;
-    
-    //set current len to zero
-    buf_queue_current_len = 0;
+    for(i = 0; i < buf_queue.max_len; i++)
+    {
+        buf_queue.element[i].addr = 0;
+        buf_queue.element[i].sector_num = 0;
+        buf_queue.element[i].buff = buf_queue.base_buf + i*buf_queue.page_size;
+    }
+    buf_queue.head = 0;
+    buf_queue.tail = 0;
 
     //set init flag
     buf_queue_init_flag = 1;
@@ -122,100 +117,109 @@ int buf_queue_init(void)
 
 int buf_queue_exit(void)
 {
-    buf_node_t *tmp = NULL;
-    int free_cnt = buf_queue_max_len;
-    //free base buf
-    if(buf_queue_base_buf)
+    if(buf_queue.base_buf)
     {
-        free(buf_queue_base_buf);
-        buf_queue_base_buf = NULL;
+        free_pool(buf_queue.base_buf);
+        buf_queue.base_buf = NULL;
     }
-    //free node buf
-    while(buf_queue_head != NULL)
+    if(buf_queue.element)
     {
-        tmp = buf_queue_head;
-        
-        //move to next node
-        buf_queue_head = buf_queue_head->next;
-
-        //free queue node memory
-        free(tmp);
-        
-        //check 
-        free_cnt--;
-        if(free_cnt == 0) break;
+        free(buf_queue.element);
+        buf_queue.element = NULL;
     }
-
-    buf_queue_head = buf_queue_tail = NULL;
-    buf_queue_current_len = 0;
+    buf_queue.head = buf_queue.tail = 0;
     buf_queue_init_flag = 0;
     return 0;
-    
 }
 
 int buf_queue_empty(void)
 {
-    return buf_queue_current_len == 0 ?1:0;
+    return buf_queue.head == buf_queue.tail ? 1:0;
 }
 
 int buf_queue_full(void)
 {
-    return buf_queue_current_len == buf_queue_max_len?1:0;
+    return buf_queue.head - buf_queue.tail == buf_queue.max_len ? 1:0;
 }
 
 int buf_queue_free_size(void)
 {
-    return buf_queue_max_len-buf_queue_current_len;
+    return buf_queue.max_len - (buf_queue.head - buf_queue.tail);
 }
 
 int buf_queue_get_page_size(void)
 {
-    return buf_queue_page_size;
+    return buf_queue.page_size;
 }
 
+//producer: copy one page in, then publish it by moving head
 int buf_enqueue(buf_element_t* element)
 {
+    buf_element_t *pelem;
+    uint head = buf_queue.head;
+
     if(buf_queue_full())
     {
-        //printf("efex queue: full");
-        //full queue
         return -1;
     }
-    buf_element_t *pelem = NULL;
-    if(buf_queue_empty())
-    {
-        pelem = &(buf_queue_head->element);
-    }
-    else
-    {
-        pelem = &(buf_queue_tail->element);
-    }
-    
-    memcpy(pelem->buff,element->buff, element->sector_num*512);
-    pelem->addr = element->addr ;
-    pelem->sector_num = element->sector_num;
+    pelem = &buf_queue.element[head & (buf_queue.max_len - 1)];
 
-    buf_queue_tail = buf_queue_tail->next;
+    memcpy(pelem->buff, element->buff, element->sector_num*512);
+    pelem->addr = element->addr;
+    pelem->sector_num = element->sector_num;
 
-    buf_queue_current_len++;
+    //the page must be complete before the consumer can see it
+    dmb();
+    buf_queue.head = head + 1;
 
     return 0;
 }
 
-int buf_dequeue(buf_element_t* pelement)
+/*
+ * consumer: describe the pages at tail that continue each other both on
+ * flash and in the ring memory, so they can go out as one write. run->buff
+ * points into the ring and stays valid until buf_queue_release().
+ * returns the number of pages in the run, 0 when the queue is empty
+ */
+int buf_queue_peek_run(buf_element_t* run, uint max_sectors)
 {
-    if(buf_queue_empty()) return -1; //empty queue
-    //get value
-    buf_element_t *ptmp = &buf_queue_head->element;
-    pelement->addr = ptmp->addr;
-    pelement->sector_num = ptmp->sector_num;
-    memcpy(pelement->buff,ptmp->buff,ptmp->sector_num*512);
-    
-    //move head
-    buf_queue_head = buf_queue_head->next;
-    
-    buf_queue_current_len--;
-    
-    //printf("efex dequeue ok: addr0x%x, sector 0x%x \n",pelement->addr,pelement->sector_num);
-    return 0;
+    uint tail = buf_queue.tail;
+    uint head = buf_queue.head;
+    uint pages = 0;
+    buf_element_t *pelem;
+
+    dmb();
+    while(tail + pages != head)
+    {
+        pelem = &buf_queue.element[(tail + pages) & (buf_queue.max_len - 1)];
+        if(pages == 0)
+        {
+            *run = *pelem;
+        }
+        else if((pelem->buff != run->buff + run->sector_num*512)
+            || (pelem->addr != run->addr + run->sector_num)
+            || (run->sector_num + pelem->sector_num > max_sectors))
+        {
+            break;
+        }
+        else
+        {
+            run->sector_num += pelem->sector_num;
+        }
+        pages++;
+        //a short page ends the run, the next one starts a page later in memory
+        if(pelem->sector_num*512 != buf_queue.page_size)
+        {
+            break;
+        }
+    }
+
+    return pages;
+}
+
+//consumer: hand pages back to the producer
+void buf_queue_release(uint pages)
+{
+    dmb();
+    buf_queue.tail += pages;
 }
@@ -12,17 +12,27 @@ typedef struct _buf_element
     u8*  buff;         //buff address
 }buf_element_t;
 
-typedef struct _buf_node
+/*
+ * single producer / single consumer ring, head is only moved by the
+ * producer and tail only by the consumer, so no lock is needed.
+ * both are free running, the slot is index & (max_len - 1)
+ */
+typedef struct _buf_queue
 {
-    buf_element_t element;
-    struct _buf_node * next;
-}buf_node_t;
+    volatile uint  head __attribute__((aligned(ARCH_DMA_MINALIGN)));
+    volatile uint  tail __attribute__((aligned(ARCH_DMA_MINALIGN)));
+    uint           max_len;     //pages, power of 2
+    uint           page_size;   //bytes
+    u8*            base_buf;    //max_len pages back to back
+    buf_element_t* element;
+}buf_queue_t;
 
 
 int buf_queue_init(void);
 int buf_queue_exit(void);
 int buf_enqueue(buf_element_t* element);
-int buf_dequeue(buf_element_t* element);
+int buf_queue_peek_run(buf_element_t* run, uint max_sectors);
+void buf_queue_release(uint pages);
 int buf_queue_empty(void);
 int buf_queue_full(void);
 int buf_queue_free_size(void);
@@ -27,82 +27,66 @@
 #include <malloc.h>
 
 extern int sunxi_sprite_write(uint start_block, uint nblock, void *buffer);
-buf_element_t      buf_queue_element;
+
+//one flash write takes at most this much of the queue, keeps the usb loop responsive
+#define EFEX_QUEUE_RUN_SECTORS      (2048)
 
 int efex_queue_init(void)
 {
-    int page_size = 0;
     if(buf_queue_init())
     {
         return -1;
     }
-    
-   
+
     //buf_queue_get_page_size() function should be call   after buf_queue_init function
-    page_size = buf_queue_get_page_size();
-    if( page_size == 0)
+    if(buf_queue_get_page_size() == 0)
     {
         printf("efex queue init fail:make sure buf_queue_init function has be called\n");
         return -1;
     }
 
-    //alloc mem for gloab element,    this memory for efex page write
-    memset(&buf_queue_element, 0 , sizeof(buf_element_t));
-    buf_queue_element.buff = malloc(page_size);
-    if(buf_queue_element.buff == NULL) 
-    {
-        printf("efex_queue_init error: malloc memory size=0x%x fail\n",page_size);
-        return -1;
-    }
-
     return 0;
 
 }
 
 int efex_queue_exit(void)
 {
-    
-    //free global element buff
-    if(buf_queue_element.buff) 
-    {
-        free(buf_queue_element.buff);
-    }
     return buf_queue_exit();
 }
 
+/*
+ * write the pages at the head of the queue that follow each other on flash
+ * in one go, straight from the queue memory
+ */
 int efex_queue_write_one_page( void )
 {
-    if(buf_queue_empty())
+    buf_element_t run;
+    int pages;
+
+    pages = buf_queue_peek_run(&run, EFEX_QUEUE_RUN_SECTORS);
+    if(!pages)
     {
         //printf("efex enqueue empty\n");
         return 0;
     }
-    buf_dequeue(&buf_queue_element);
-    
-    if(!sunxi_sprite_write(buf_queue_element.addr, buf_queue_element.sector_num,
-        (void *)buf_queue_element.buff))
+
+    if(!sunxi_sprite_write(run.addr, run.sector_num, (void *)run.buff))
     {
-       printf("efex_queue_write_one_page error: write flash from 0x%x, sectors 0x%x failed\n", 
-        buf_queue_element.addr,buf_queue_element.sector_num);
+       printf("efex_queue_write_one_page error: write flash from 0x%x, sectors 0x%x failed\n",
+        run.addr, run.sector_num);
        return -1;
     }
+    buf_queue_release(pages);
+
     return 0;
 }
 
 int efex_queue_write_all_page( void )
 {
-    if(buf_queue_empty())
+    while(!buf_queue_empty())
     {
-        //printf("efex queue empty\n");
-        return 0;
-    }
-    while(buf_dequeue(&buf_queue_element) == 0)
-    {
-        if(!sunxi_sprite_write(buf_queue_element.addr, buf_queue_element.sector_num,
-            (void *)buf_queue_element.buff))
+        if(efex_queue_write_one_page())
         {
-            printf("efex_queue_write_one_page error: write flash from 0x%x, sectors 0x%x failed\n", 
-                buf_queue_element.addr,buf_queue_element.sector_num);
             return -1;
         }
     }
@@ -113,34 +97,32 @@ int efex_queue_write_all_page( void )
 
 int efex_save_buff_to_queue(uint flash_start, uint flash_sectors, void* buff)
 {
-    int sec_per_page;     
-    int queue_free_page;
+    int sec_per_page;
     int offset;
     buf_element_t element;
     int require_page ;
-    
+
 
     //make sure queue has enough space to save buffer
     sec_per_page     = buf_queue_get_page_size()>>9;
     require_page = (flash_sectors+sec_per_page-1)/sec_per_page;
-    
-    queue_free_page   = buf_queue_free_size();
-    if(require_page > queue_free_page) 
+
+    while(buf_queue_free_size() < require_page)
     {
-        int i = 0;
-        for(i = 0; i < require_page - queue_free_page; i++)
+        if(buf_queue_empty())
         {
-            if(efex_queue_write_one_page())
+            //bigger than the whole queue, write it at once
+            if(!sunxi_sprite_write(flash_start, flash_sectors, buff))
             {
+                printf("efex queue error: write flash from 0x%x, sectors 0x%x failed\n", flash_start, flash_sectors);
                 return -1;
             }
+            return 0;
+        }
+        if(efex_queue_write_one_page())
+        {
+            return -1;
         }
-    }
-
-    if(buf_queue_free_size() < require_page)
-    {
-        printf("efex queue error: free space not enough\n");
-        return -1;
     }
 
     //save buff to queue
@@ -165,4 +147,3 @@ int efex_save_buff_to_queue(uint flash_start, uint flash_sectors, void* buff)
 
     return 0;
 }
-
@@ -122,6 +122,12 @@ typedef struct sunxi_ubuf_s
 	uint   rx_ready_for_data;		//表示数据接收已经完成标志
 
 	uint   request_size;			//需要发送的数据长度
+
+	uchar *rx_ring_base;			//rx_ring_end不为空时，数据阶段按环形buffer接收
+	uchar *rx_ring_end;				//环形buffer大小必须是包长的整数倍
+	volatile uint rx_ring_in;		//中断中累计收到的字节数
+	volatile uint rx_ring_out;		//主循环累计取走的字节数
+	volatile uint rx_ring_pending;	//buffer满，有数据包留在fifo中
 }
 sunxi_ubuf_t;
 
@@ -140,5 +146,11 @@ extern  int sunxi_udc_set_configuration(int config_param);
 extern	int sunxi_udc_get_ep_max(void);
 extern  int sunxi_udc_get_ep_in_type(void);
 extern  int sunxi_udc_get_ep_out_type(void);
+extern  void sunxi_udc_rx_resume(void);
+
+extern  int  sunxi_udc_rx_ring_room(sunxi_ubuf_t *ubuf, uint len);
+extern  void sunxi_udc_rx_ring_put(sunxi_ubuf_t *ubuf, uint len);
+extern  void sunxi_udc_rx_ring_resume(sunxi_ubuf_t *ubuf, int (*recv_op)(void));
+extern  void sunxi_udc_rx_ring_stop(sunxi_ubuf_t *ubuf);
 
 #endif
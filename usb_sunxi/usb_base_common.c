@@ -23,6 +23,7 @@
  */
 #include "usb_base.h"
 #include "usb_module.h"
+#include <asm/arch/intc.h>
 
 extern sunxi_usb_setup_req_t     *sunxi_udev_active;
 /*
@@ -96,3 +97,115 @@ int sunxi_usb_dev_register(uint dev_name)
 
 
 
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_udc_rx_ring_room
+*
+*    parmeters     :  ubuf: 平台的接收buffer, len: fifo中数据包的长度
+*
+*    return        :  1: 可以读出这个包, 0: 环形buffer已满
+*
+*    note          :  bulk out中断中调用。buffer满时数据留在fifo里让host收NAK，
+*                     主循环腾出空间后由sunxi_udc_rx_ring_resume再读
+*
+*
+************************************************************************************************************
+*/
+int sunxi_udc_rx_ring_room(sunxi_ubuf_t *ubuf, uint len)
+{
+	if(ubuf->rx_ring_end &&
+	   (ubuf->rx_ring_in + len - ubuf->rx_ring_out > (uint)(ubuf->rx_ring_end - ubuf->rx_ring_base)))
+	{
+		ubuf->rx_ring_pending = 1;
+
+		return 0;
+	}
+
+	return 1;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_udc_rx_ring_put
+*
+*    parmeters     :  ubuf: 平台的接收buffer, len: 刚读到rx_req_buffer的长度
+*
+*    return        :
+*
+*    note          :  bulk out中断中调用，rx_req_buffer已经后移len，到尾部时绕回
+*
+*
+************************************************************************************************************
+*/
+void sunxi_udc_rx_ring_put(sunxi_ubuf_t *ubuf, uint len)
+{
+	if(!ubuf->rx_ring_end)
+	{
+		return;
+	}
+	ubuf->rx_ring_in += len;
+	if(ubuf->rx_req_buffer >= ubuf->rx_ring_end)
+	{
+		ubuf->rx_req_buffer = ubuf->rx_ring_base;
+	}
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_udc_rx_ring_resume
+*
+*    parmeters     :  ubuf: 平台的接收buffer, recv_op: 平台bulk out中断的处理函数
+*
+*    return        :
+*
+*    note          :  主循环中调用，把因为buffer满而留在fifo中的数据包读出来。
+*                     recv_op是中断里的处理函数，要关掉usb中断再调，否则双缓冲fifo的
+*                     下一个包会在中间进来，和中断同时修改rx_ring_in和rx_req_buffer
+*
+*
+************************************************************************************************************
+*/
+void sunxi_udc_rx_ring_resume(sunxi_ubuf_t *ubuf, int (*recv_op)(void))
+{
+	if(!ubuf->rx_ring_pending)
+	{
+		return;
+	}
+	irq_disable(AW_IRQ_USB_OTG);
+	if(ubuf->rx_ring_pending)
+	{
+		ubuf->rx_ring_pending = 0;
+		recv_op();
+	}
+	irq_enable(AW_IRQ_USB_OTG);
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  sunxi_udc_rx_ring_stop
+*
+*    parmeters     :  ubuf: 平台的接收buffer
+*
+*    return        :
+*
+*    note          :  数据阶段结束或者总线复位时调用，之后的包重新按命令接收到rx_base_buffer。
+*                     rx_ring_in/rx_ring_out保留，主循环看到rx_ring_end为空就不再取数据
+*
+*
+************************************************************************************************************
+*/
+void sunxi_udc_rx_ring_stop(sunxi_ubuf_t *ubuf)
+{
+	ubuf->rx_ring_end     = NULL;
+	ubuf->rx_ring_pending = 0;
+	ubuf->rx_req_buffer   = ubuf->rx_base_buffer;
+}
@@ -119,6 +119,7 @@ void sunxi_usb_irq(void *data)
 		usb_dma_set_pktlen(sunxi_udc_source.dma_recv_channal, HIGH_SPEED_EP_MAX_PACKET_SIZE);
 
 		sunxi_ubuf.rx_ready_for_data = 0;
+		sunxi_udc_rx_ring_stop(&sunxi_ubuf);
 		sunxi_udev_active->state_reset();
 
 		return ;
@@ -1008,6 +1009,26 @@ int sunxi_udc_get_ep_out_type(void)
 *
 *                                             function
 *
+*    name          :  sunxi_udc_rx_resume
+*
+*    parmeters     :
+*
+*    return        :
+*
+*    note          :  环形接收时，把因为buffer满而留在fifo中的数据包读出来
+*
+*
+************************************************************************************************************
+*/
+void sunxi_udc_rx_resume(void)
+{
+	sunxi_udc_rx_ring_resume(&sunxi_ubuf, eprx_recv_op);
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
 *    name          :
 *
 *    parmeters     :
@@ -1303,12 +1324,17 @@ static int eprx_recv_op(void)
     	if(USBC_Dev_IsReadDataReady(sunxi_udc_source.usbc_hd, USBC_EP_TYPE_RX))
 		{
 			this_len = USBC_ReadLenFromFifo(sunxi_udc_source.usbc_hd, USBC_EP_TYPE_RX);
-			if(fastboot_data_flag == 1)
+			if((fastboot_data_flag == 1) && !sunxi_udc_rx_ring_room(&sunxi_ubuf, this_len))
+			{
+				//环形buffer已满，数据留在fifo里，等sunxi_udc_rx_resume
+			}
+			else if(fastboot_data_flag == 1)
 			{
 				fifo = USBC_SelectFIFO(sunxi_udc_source.usbc_hd, SUNXI_USB_BULK_OUT_EP_INDEX);
 
 				sunxi_ubuf.rx_req_length = USBC_ReadPacket(sunxi_udc_source.usbc_hd, fifo, this_len, sunxi_ubuf.rx_req_buffer);
 				sunxi_ubuf.rx_req_buffer += this_len;
+				sunxi_udc_rx_ring_put(&sunxi_ubuf, this_len);
 
 				sunxi_usb_dbg("special read ep bytes 0x%x\n", sunxi_ubuf.rx_req_length);
 				__usb_readcomplete(sunxi_udc_source.usbc_hd, USBC_EP_TYPE_RX, 1);		//返回状态
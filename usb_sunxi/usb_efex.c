@@ -32,10 +32,13 @@
 #include <power/sunxi/pmu.h>
 #include <asm/io.h>
 #include <fdt_support.h>
+#include <sunxi_flash.h>
+#include <malloc.h>
 #include "efex_queue.h"
 
 #ifndef CONFIG_SUNXI_SPINOR
 #define _EFEX_USE_BUF_QUEUE_
+#define _EFEX_USE_PING_PONG_
 #endif
 
 #define  SUNXI_USB_EFEX_IDLE					 (0)
@@ -77,6 +80,19 @@ static  int sunxi_usb_efex_status_enable = 1;
 static u32 fullimg_size = 0;
 extern u32 total_write_bytes ;
 #endif
+#ifdef _EFEX_USE_PING_PONG_
+/*
+ * 乒乓模式：flash数据轮流收到两个bank里，一个bank收完就交给flash后台写，
+ * 回状态之后usb马上往另一个bank收下一包。写的结果在下一包回状态时报告
+ */
+static  int  efex_pingpong = 0;			//当前介质是否使用乒乓模式
+static  u8  *efex_bank[2];
+static  int  efex_bank_index = 0;		//下一包数据收到哪个bank
+static  int  efex_bank_busy = 0;		//另一个bank还在写flash
+static  uint efex_bank_sectors = 0;
+
+static int efex_bank_wait(void);
+#endif
 extern int do_bootelf(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[]);
 
 
@@ -462,6 +478,10 @@ static int __sunxi_efex_send_status(void *buffer, unsigned int buffer_size)
 static int sunxi_efex_init(void)
 {
 	sunxi_usb_dbg("sunxi_efex_init\n");
+#ifdef _EFEX_USE_PING_PONG_
+    //上一次留下的后台写还在用它的接收缓存，等它写完再重新分配
+    efex_bank_wait();
+#endif
 	memset(&trans_data, 0, sizeof(efex_trans_set_t));
 	sunxi_usb_efex_write_enable = 0;
     sunxi_usb_efex_status = SUNXI_USB_EFEX_IDLE;
@@ -498,8 +518,27 @@ static int sunxi_efex_init(void)
 #ifdef _EFEX_USE_BUF_QUEUE_
     if(efex_queue_init())
     {
+    	free(trans_data.base_send_buffer);
+    	free(trans_data.base_recv_buffer);
+		free(cmd_buf);
+
         return -1;
     }
+#endif
+#ifdef _EFEX_USE_PING_PONG_
+    //nand没有后台写，还是走队列
+    efex_pingpong = 0;
+    efex_bank_index = 0;
+    efex_bank_busy = 0;
+    if(uboot_spare_head.boot_data.storage_type != STORAGE_NAND)
+    {
+        efex_bank[0] = trans_data.base_recv_buffer + SUNXI_EFEX_RECV_MEM_SIZE/2;
+        efex_bank[1] = (u8 *)memalign(ARCH_DMA_MINALIGN, SUNXI_EFEX_RECV_MEM_SIZE/2);
+        if(efex_bank[1])
+        {
+            efex_pingpong = 1;
+        }
+    }
 #endif
     return 0;
 }
@@ -522,6 +561,16 @@ static int sunxi_efex_init(void)
 static int sunxi_efex_exit(void)
 {
 	sunxi_usb_dbg("sunxi_efex_exit\n");
+#ifdef _EFEX_USE_PING_PONG_
+    //bank 0在接收缓存里，后台写完之前不能释放
+    efex_bank_wait();
+    if(efex_pingpong)
+    {
+        free(efex_bank[1]);
+        efex_bank[1] = NULL;
+        efex_pingpong = 0;
+    }
+#endif
     if(trans_data.base_recv_buffer)
     {
     	free(trans_data.base_recv_buffer);
@@ -539,6 +588,71 @@ static int sunxi_efex_exit(void)
 #endif
     return 0;
 }
+#ifdef _EFEX_USE_PING_PONG_
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  efex_bank_wait
+*
+*    parmeters     :
+*
+*    return        :  0 : 上一个bank写成功或者没有在写
+*
+*    note          :  等待正在后台写的bank完成
+*
+*
+************************************************************************************************************
+*/
+static int efex_bank_wait(void)
+{
+    if(!efex_bank_busy)
+    {
+        return 0;
+    }
+    efex_bank_busy = 0;
+    if(sunxi_sprite_complete() != efex_bank_sectors)
+    {
+        printf("sunxi usb efex err: background flash write of 0x%x sectors failed\n", efex_bank_sectors);
+        return -1;
+    }
+
+    return 0;
+}
+/*
+************************************************************************************************************
+*
+*                                             function
+*
+*    name          :  efex_bank_submit
+*
+*    parmeters     :  当前收到数据的bank
+*
+*    return        :  0 : 提交成功，并且上一个bank也写成功
+*
+*    note          :  先等另一个bank写完(下一包要收到那里)，再把当前bank提交给flash，换bank
+*
+*
+************************************************************************************************************
+*/
+static int efex_bank_submit(uint flash_start, uint flash_sectors, void *buffer)
+{
+    int ret;
+
+    ret = efex_bank_wait();
+    if(sunxi_sprite_submit_write(flash_start, flash_sectors, buffer))
+    {
+        printf("sunxi usb efex err: write flash from 0x%x, sectors 0x%x failed\n", flash_start, flash_sectors);
+        return -1;
+    }
+    efex_bank_busy    = 1;
+    efex_bank_sectors = flash_sectors;
+    efex_bank_index  ^= 1;
+
+    return ret;
+}
+#endif
 /*
 ************************************************************************************************************
 *
@@ -987,6 +1101,12 @@ static int __sunxi_usb_efex_op_cmd(u8 *cmd_buffer)
 				else	//属于flash数据，分别表示起始扇区，扇区数
 				{
 					trans_data.act_recv_buffer   = (trans_data.base_recv_buffer + SUNXI_EFEX_RECV_MEM_SIZE/2);	 //设置接收地址
+#ifdef _EFEX_USE_PING_PONG_
+					if(efex_pingpong)
+					{
+						trans_data.act_recv_buffer = efex_bank[efex_bank_index];
+					}
+#endif
 					trans_data.recv_size         = trans->len;	//设置接收长度，字节单位
 
 					trans_data.flash_start       = trans->addr;
@@ -1746,6 +1866,14 @@ static int sunxi_efex_state_loop(void  *buffer)
 							csw.status = -1;
 							trans_data.last_err = -1;
 
+							sunxi_usb_efex_app_step = SUNXI_USB_EFEX_APPS_IDLE;
+						}
+						else if((trans_data.type & SUNXI_EFEX_TRANS_FINISH_TAG) && sunxi_sprite_sync())
+						{
+							printf("sunxi usb efex err: flush flash failed\n");
+							csw.status = -1;
+							trans_data.last_err = -1;
+
 							sunxi_usb_efex_app_step = SUNXI_USB_EFEX_APPS_IDLE;
 						}
 #ifdef CONFIG_SUNXI_SPINOR
@@ -1779,6 +1907,18 @@ static int sunxi_efex_state_loop(void  *buffer)
                         printf("efex queue error: buf_queue_write_all_page fail\n");
                         efex_write_error_flag = 1;
                     }
+#ifdef _EFEX_USE_PING_PONG_
+                    if(efex_bank_wait())
+                    {
+                        efex_write_error_flag = 1;
+                    }
+#endif
+                    //合并写缓存里还没有写下去的数据，失败要在校验时报给PC
+                    if(sunxi_sprite_sync())
+                    {
+                        printf("efex error: sunxi_sprite_sync fail\n");
+                        efex_write_error_flag = 1;
+                    }
                 }
 #endif
                 __sunxi_usb_efex_op_cmd(cmd_buf);
@@ -1886,6 +2026,16 @@ static int sunxi_efex_state_loop(void  *buffer)
                 else        //表示当前数据需要写入flash
                 {
                     sunxi_usb_dbg("SUNXI_EFEX_FLASH_MASK\n");
+#ifdef _EFEX_USE_PING_PONG_
+                    if(efex_pingpong)
+                    {
+                        if(efex_bank_submit(trans_data.flash_start, trans_data.flash_sectors, (void *)trans_data.act_recv_buffer))
+                        {
+                            trans_data.last_err = -1;
+                        }
+                    }
+                    else
+#endif
 #ifdef _EFEX_USE_BUF_QUEUE_
                     if(0 != efex_save_buff_to_queue(trans_data.flash_start,trans_data.flash_sectors,(void *)trans_data.act_recv_buffer))
                     {
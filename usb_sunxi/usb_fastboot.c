@@ -46,6 +46,19 @@ static  int sunxi_usb_fastboot_status = SUNXI_USB_FASTBOOT_IDLE;
 static  fastboot_trans_set_t  trans_data;
 
 static  uint  all_download_bytes;
+static  sparse_stream_t  fastboot_sparse;
+
+/*
+ * 流式烧写：oem stream <part> 之后，download的数据不再整体放在内存里，
+ * 而是收满一段就写到分区中，flash:<part> 只返回写入的结果
+ */
+static  char  fastboot_stream_name[32];		//为空表示没有打开流式烧写
+static  int   fastboot_stream_on;			//当前download正在流式写入
+static  int   fastboot_stream_done;			//上一次download已经流式写完，等待flash命令
+static  int   fastboot_stream_err;
+static  int   fastboot_stream_format;
+static  uint  fastboot_stream_start;
+static  uint  fastboot_stream_sectors;
 
 int     fastboot_data_flag;
 
@@ -645,11 +658,12 @@ static int __flash_to_part(char *name)
 		int  format;
 
 		printf("ready to download bytes 0x%x\n", trans_data.try_to_recv);
-		format = unsparse_probe(addr, trans_data.try_to_recv, start);
+		format = unsparse_probe(&fastboot_sparse, addr, trans_data.try_to_recv, start);
 
 		if(ANDROID_FORMAT_DETECT == format)
 		{
-			if(unsparse_direct_write(addr, trans_data.try_to_recv))
+			if(unsparse_direct_write(&fastboot_sparse, addr, trans_data.try_to_recv) ||
+			   unsparse_finish(&fastboot_sparse))
 			{
 				printf("sunxi fastboot download FAIL: failed to write partition %s \n", name);
 				sprintf(response,"FAILdownload: write partition %s err", name);
@@ -708,6 +722,260 @@ static int __flash_to_part(char *name)
 }
 
 
+/*
+*******************************************************************************
+*                     __stream_arm
+*
+* Description:
+*    打开/关闭流式烧写
+*
+* Parameters:
+*    name : 分区名，为空则关闭
+*
+* Return value:
+*    void
+*
+* note:
+*    void
+*
+*******************************************************************************
+*/
+static void __stream_arm(char *name)
+{
+	char  response[68];
+
+	while(*name == ' ' || *name == ':')
+	{
+		name ++;
+	}
+	fastboot_stream_done = 0;
+	if(!*name)
+	{
+		printf("sunxi fastboot: stream flash off\n");
+		fastboot_stream_name[0] = 0;
+		sprintf(response, "OKAY");
+	}
+	else if(gd->lockflag == SUNXI_LOCKING || gd->lockflag == SUNXI_RELOCKING)
+	{
+		printf("in lock state, sunxi fastboot flash is disabled\n");
+		sprintf(response, "FAILstream: device is locked");
+	}
+	else if((strlen(name) >= sizeof(fastboot_stream_name)) ||
+			(!sunxi_partition_get_offset_byname(name)) || (!sunxi_partition_get_size_byname(name)))
+	{
+		printf("sunxi fastboot stream FAIL: partition %s does not exist\n", name);
+		sprintf(response, "FAILstream: partition does not exist");
+	}
+	else
+	{
+		strcpy(fastboot_stream_name, name);
+		printf("sunxi fastboot: stream flash to partition '%s'\n", name);
+		sprintf(response, "OKAY");
+	}
+
+	__sunxi_fastboot_send_status(response, strlen(response));
+
+	return ;
+}
+/*
+*******************************************************************************
+*                     __stream_write
+*
+* Description:
+*    把环形buffer中取出的一段数据写到分区
+*
+* Parameters:
+*    addr   : 数据地址
+*    length : 数据长度，除最后一段外都是SUNXI_USB_FASTBOOT_STREAM_STEP
+*    offset : 这段数据在整个download中的偏移
+*
+* Return value:
+*    0 : 成功
+*
+* note:
+*    void
+*
+*******************************************************************************
+*/
+static int __stream_write(char *addr, uint length, uint offset)
+{
+	uint  data_sectors;
+
+	if(!offset)
+	{
+		fastboot_stream_format = unsparse_probe(&fastboot_sparse, addr, length, fastboot_stream_start);
+		if(ANDROID_FORMAT_DETECT != fastboot_stream_format)
+		{
+			data_sectors = (all_download_bytes + 511)/512;
+			if(data_sectors > fastboot_stream_sectors)
+			{
+				printf("sunxi fastboot download FAIL: partition %s size 0x%x is smaller than data size 0x%x\n",
+						fastboot_stream_name, fastboot_stream_sectors * 512, data_sectors * 512);
+
+				return -1;
+			}
+		}
+	}
+	if(ANDROID_FORMAT_DETECT == fastboot_stream_format)
+	{
+		return unsparse_direct_write(&fastboot_sparse, addr, length);
+	}
+
+	data_sectors = (length + 511)/512;
+	if(!sunxi_flash_write(fastboot_stream_start + offset/512, data_sectors, addr))
+	{
+		return -1;
+	}
+
+	return 0;
+}
+/*
+*******************************************************************************
+*                     __stream_drain
+*
+* Description:
+*    把环形buffer中已经收到的数据写到分区，腾出空间后继续接收
+*
+* Parameters:
+*    sunxi_ubuf : usb buffer
+*
+* Return value:
+*    1 : 整个download已经接收并写完
+*
+* note:
+*    出错后继续接收并丢弃数据，让host把这次传输走完，错误在flash命令时返回
+*
+*******************************************************************************
+*/
+static int __stream_drain(sunxi_ubuf_t *sunxi_ubuf)
+{
+	uint  out, length;
+	char *addr;
+
+	while(1)
+	{
+		//总线复位后环形buffer已经停掉，剩下的数据不再写入，由__stream_abort收尾
+		if(!sunxi_ubuf->rx_ring_end)
+		{
+			return 0;
+		}
+		out    = sunxi_ubuf->rx_ring_out;
+		length = sunxi_ubuf->rx_ring_in - out;
+		if(length > SUNXI_USB_FASTBOOT_STREAM_STEP)
+		{
+			length = SUNXI_USB_FASTBOOT_STREAM_STEP;
+		}
+		else if((length < SUNXI_USB_FASTBOOT_STREAM_STEP) && (out + length != all_download_bytes))
+		{
+			break;
+		}
+		if(!length)
+		{
+			break;
+		}
+		//out总是STEP的整数倍，环形buffer大小也是，所以一段数据不会跨过buffer末尾
+		addr = trans_data.base_recv_buffer + (out % SUNXI_USB_FASTBOOT_STREAM_RING);
+		if((!fastboot_stream_err) && __stream_write(addr, length, out))
+		{
+			printf("sunxi fastboot download FAIL: failed to write partition %s \n", fastboot_stream_name);
+			fastboot_stream_err = 1;
+		}
+		sunxi_ubuf->rx_ring_out = out + length;
+		sunxi_udc_rx_resume();
+	}
+	if(sunxi_ubuf->rx_ring_out != all_download_bytes)
+	{
+		return 0;
+	}
+	if(ANDROID_FORMAT_DETECT == fastboot_stream_format)
+	{
+		if(fastboot_stream_err)
+		{
+			unsparse_abort(&fastboot_sparse);
+		}
+		else if(unsparse_finish(&fastboot_sparse))
+		{
+			printf("sunxi fastboot download FAIL: failed to write partition %s \n", fastboot_stream_name);
+			fastboot_stream_err = 1;
+		}
+	}
+
+	return 1;
+}
+/*
+*******************************************************************************
+*                     __stream_abort
+*
+* Description:
+*    download没有传完就被总线复位或者退出打断时，结束这次流式写入
+*
+* Parameters:
+*    void
+*
+* Return value:
+*    void
+*
+* note:
+*    只在主循环中调用，不能放在复位中断里，那时__stream_drain可能正在使用sparse流
+*
+*******************************************************************************
+*/
+static void __stream_abort(void)
+{
+	printf("sunxi fastboot download FAIL: stream to partition %s is aborted\n", fastboot_stream_name);
+	if(ANDROID_FORMAT_DETECT == fastboot_stream_format)
+	{
+		unsparse_abort(&fastboot_sparse);
+	}
+	fastboot_stream_on   = 0;
+	fastboot_stream_done = 0;
+	fastboot_stream_err  = 1;
+	fastboot_stream_format = ANDROID_FORMAT_UNKNOW;
+
+	return ;
+}
+/*
+*******************************************************************************
+*                     __stream_result
+*
+* Description:
+*    flash命令返回流式写入的结果
+*
+* Parameters:
+*    name : flash命令的分区名
+*
+* Return value:
+*    void
+*
+* note:
+*    void
+*
+*******************************************************************************
+*/
+static void __stream_result(char *name)
+{
+	char  response[68];
+
+	fastboot_stream_done = 0;
+	if(strcmp(name, fastboot_stream_name))
+	{
+		printf("sunxi fastboot download FAIL: data was streamed to %s, not %s\n", fastboot_stream_name, name);
+		sprintf(response, "FAILdownload: data was streamed to another partition");
+	}
+	else if(fastboot_stream_err)
+	{
+		sprintf(response, "FAILdownload: write partition %s err", name);
+	}
+	else
+	{
+		printf("sunxi fastboot: successed in downloading partition '%s'\n", name);
+		sprintf(response, "OKAY");
+	}
+
+	__sunxi_fastboot_send_status(response, strlen(response));
+
+	return ;
+}
 /*
 *******************************************************************************
 *                     __try_to_download
@@ -735,11 +1003,33 @@ static int __try_to_download(char *download_size, char *response)
 	printf("Starting download of %d BYTES\n", trans_data.try_to_recv);
 	printf("Starting download of %d MB\n", trans_data.try_to_recv >> 20);
 
+	fastboot_stream_on   = 0;
+	fastboot_stream_done = 0;
 	if (0 == trans_data.try_to_recv)
 	{
 		/* bad user input */
 		sprintf(response, "FAILdownload: data size is 0");
 	}
+	else if (fastboot_stream_name[0])
+	{
+		if (trans_data.try_to_recv > SUNXI_USB_FASTBOOT_STREAM_MAX)
+		{
+			sprintf(response, "FAILdownload: data > stream limit");
+		}
+		else
+		{
+			fastboot_stream_on      = 1;
+			fastboot_stream_err     = 0;
+			fastboot_stream_format  = ANDROID_FORMAT_UNKNOW;
+			fastboot_stream_start   = sunxi_partition_get_offset_byname(fastboot_stream_name);
+			fastboot_stream_sectors = sunxi_partition_get_size_byname(fastboot_stream_name);
+
+			sprintf(response, "DATA%08x", trans_data.try_to_recv);
+			printf("stream download response: %s\n", response);
+
+			ret = 0;
+		}
+	}
 	else if (trans_data.try_to_recv > SUNXI_USB_FASTBOOT_BUFFER_MAX)
 	{
 		sprintf(response, "FAILdownload: data > buffer");
@@ -878,7 +1168,7 @@ static void __get_var(char *ver_name)
 	}
 	else if(!strcmp(ver_name, "max-download-size"))
 	{
-		sprintf(response + 4, "0x%08x", SUNXI_USB_FASTBOOT_BUFFER_MAX);
+		sprintf(response + 4, "0x%08x", fastboot_stream_name[0] ? SUNXI_USB_FASTBOOT_STREAM_MAX : SUNXI_USB_FASTBOOT_BUFFER_MAX);
 		printf("response: %s\n", response);
 	}
 	else
@@ -908,6 +1198,12 @@ static void __get_var(char *ver_name)
 */
 static void __oem_operation(char *operation)
 {
+	if(!strncmp(operation, "stream", 6))
+	{
+		__stream_arm(operation + 6);
+
+		return ;
+	}
 	#if 0
 	char response[68];
 	char lock_info[64];
@@ -1057,6 +1353,9 @@ static int sunxi_fastboot_init(void)
 
 	all_download_bytes = 0;
 	fastboot_data_flag = 0;
+	fastboot_stream_name[0] = 0;
+	fastboot_stream_on   = 0;
+	fastboot_stream_done = 0;
 
     trans_data.base_recv_buffer = (char *)FASTBOOT_TRANSFER_BUFFER;
 
@@ -1092,6 +1391,10 @@ static int sunxi_fastboot_init(void)
 static int sunxi_fastboot_exit(void)
 {
 	printf("sunxi_fastboot_exit\n");
+	if(fastboot_stream_on)
+	{
+		__stream_abort();
+	}
     if(trans_data.base_send_buffer)
     {
     	free(trans_data.base_send_buffer);
@@ -1119,6 +1422,8 @@ static void sunxi_fastboot_reset(void)
 {
 	sunxi_usb_fastboot_write_enable = 0;
     sunxi_usb_fastboot_status = SUNXI_USB_FASTBOOT_IDLE;
+	//总线复位打断了数据阶段，之后的包按命令接收，流式写入在主循环中收尾
+	fastboot_data_flag = 0;
 }
 /*
 ************************************************************************************************************
@@ -1333,6 +1638,11 @@ static int sunxi_fastboot_state_loop(void  *buffer)
 	switch(sunxi_usb_fastboot_status)
 	{
 		case SUNXI_USB_FASTBOOT_IDLE:
+			//正常传完时fastboot_stream_on已经清掉，这里还置着说明被总线复位打断了
+			if(fastboot_stream_on)
+			{
+				__stream_abort();
+			}
 			if(sunxi_ubuf->rx_ready_for_data == 1)
 			{
 				sunxi_usb_fastboot_status = SUNXI_USB_FASTBOOT_SETUP;
@@ -1376,7 +1686,9 @@ static int sunxi_fastboot_state_loop(void  *buffer)
 					__limited_fastboot();
 					break;
 				}
-				if(memcmp((char *)(sunxi_ubuf->rx_req_buffer + 6),"u-boot",6) == 0)
+				if(fastboot_stream_done)
+					__stream_result((char *)(sunxi_ubuf->rx_req_buffer + 6));
+				else if(memcmp((char *)(sunxi_ubuf->rx_req_buffer + 6),"u-boot",6) == 0)
 					__flash_to_uboot();
 				else
 					__flash_to_part((char *)(sunxi_ubuf->rx_req_buffer + 6));
@@ -1392,6 +1704,14 @@ static int sunxi_fastboot_state_loop(void  *buffer)
 				ret = __try_to_download((char *)(sunxi_ubuf->rx_req_buffer + 9), response);
 				if(ret >= 0)
 				{
+					if(fastboot_stream_on)
+					{
+						sunxi_ubuf->rx_ring_base    = (uchar *)trans_data.base_recv_buffer;
+						sunxi_ubuf->rx_ring_end     = sunxi_ubuf->rx_ring_base + SUNXI_USB_FASTBOOT_STREAM_RING;
+						sunxi_ubuf->rx_ring_in      = 0;
+						sunxi_ubuf->rx_ring_out     = 0;
+						sunxi_ubuf->rx_ring_pending = 0;
+					}
 					fastboot_data_flag = 1;
 					sunxi_ubuf->rx_req_buffer  = (uchar *)trans_data.base_recv_buffer;
 					sunxi_usb_fastboot_status  = SUNXI_USB_FASTBOOT_RECEIVE_DATA;
@@ -1450,7 +1770,22 @@ static int sunxi_fastboot_state_loop(void  *buffer)
 	  	case SUNXI_USB_FASTBOOT_RECEIVE_DATA:
 
 	  		//tick_printf("SUNXI_USB_FASTBOOT_RECEIVE_DATA\n");
-	  		if((fastboot_data_flag == 1) && ((char *)sunxi_ubuf->rx_req_buffer == all_download_bytes + trans_data.base_recv_buffer))	//传输完毕
+	  		if((fastboot_data_flag == 1) && fastboot_stream_on)
+	  		{
+	  			if(__stream_drain(sunxi_ubuf))
+	  			{
+	  				tick_printf("fastboot stream transfer finish\n");
+	  				fastboot_data_flag   = 0;
+	  				fastboot_stream_on   = 0;
+	  				fastboot_stream_done = 1;
+	  				sunxi_udc_rx_ring_stop(sunxi_ubuf);
+	  				sunxi_usb_fastboot_status = SUNXI_USB_FASTBOOT_IDLE;
+
+	  				sprintf(response,"OKAY");
+	  				__sunxi_fastboot_send_status(response, strlen(response));
+	  			}
+	  		}
+	  		else if((fastboot_data_flag == 1) && ((char *)sunxi_ubuf->rx_req_buffer == all_download_bytes + trans_data.base_recv_buffer))	//传输完毕
 	  		{
 	  			tick_printf("fastboot transfer finish\n");
 	  			fastboot_data_flag = 0;
@@ -53,6 +53,10 @@ char  *sunxi_usb_fastboot_dev[SUNXI_USB_FASTBOOT_DEV_MAX] = {	sunxi_fastboot_nor
 															};
 
 #define  SUNXI_USB_FASTBOOT_BUFFER_MAX               (32 * 1024 * 1024)
+//流式烧写：数据边收边写，接收buffer作为环形buffer使用
+#define  SUNXI_USB_FASTBOOT_STREAM_RING              (8 * 1024 * 1024)
+#define  SUNXI_USB_FASTBOOT_STREAM_STEP              (1024 * 1024)		//每次交给分区写入的数据量
+#define  SUNXI_USB_FASTBOOT_STREAM_MAX               (0x7ff00000)		//流式烧写时单次download的上限
 
 
 #define  SUNXI_USB_FASTBOOT_IDLE					 (0)